@@ -556,8 +556,13 @@ public:
 		: QtZipPrivate(device, ownDev),
 		status(QtZipWriter::NoError),
 		permissions(QFile::ReadOwner | QFile::WriteOwner),
-		compressionPolicy(QtZipWriter::AlwaysCompress)
+		compressionPolicy(QtZipWriter::AlwaysCompress),
+		isStreaming(false),
+		streamCrc(0),
+		streamUncompressedSize(0),
+		streamCompressedSize(0)
 	{
+		memset(&stream, 0, sizeof(z_stream));
 	}
 
 	QtZipWriter::Status status;
@@ -566,7 +571,20 @@ public:
 
 	enum EntryType { Directory, File, Symlink };
 
+	void fillHeader(FileHeader &header, EntryType type, const QString &fileName, ushort compressionMethod);
 	void addEntry(EntryType type, const QString &fileName, const QByteArray &contents);
+
+	// state of the file which contents is being written by parts
+	bool isStreaming;
+	FileHeader streamHeader;
+	z_stream stream;
+	uint streamCrc;
+	quint64 streamUncompressedSize;
+	quint64 streamCompressedSize;
+
+	bool startStreamedEntry(const QString &fileName);
+	void writeStreamedData(const char *data, qint64 size, int flush);
+	void finishStreamedEntry();
 };
 
 LocalFileHeader CentralFileHeader::toLocalHeader() const
@@ -674,6 +692,45 @@ void QtZipReaderPrivate::scanFiles()
 	}
 }
 
+void QtZipWriterPrivate::fillHeader(FileHeader &header, EntryType type, const QString &fileName, ushort compressionMethod)
+{
+	memset(&header.h, 0, sizeof(CentralFileHeader));
+	writeUInt(header.h.signature, 0x02014b50);
+
+	writeUShort(header.h.version_needed, ZIP_VERSION);
+	writeMSDosDate(header.h.last_mod_file, QDateTime::currentDateTime());
+	writeUShort(header.h.compression_method, compressionMethod);
+
+	// if bit 11 is set, the filename and comment fields must be encoded using UTF-8
+	ushort general_purpose_bits = Utf8Names; // always use utf-8
+	writeUShort(header.h.general_purpose_bits, general_purpose_bits);
+
+	const bool inUtf8 = (general_purpose_bits & Utf8Names) != 0;
+	header.file_name = inUtf8 ? fileName.toUtf8() : fileName.toLocal8Bit();
+	if (header.file_name.size() > 0xffff) {
+		qWarning("QtZip: Filename is too long, chopping it to 65535 bytes");
+		header.file_name = header.file_name.left(0xffff); // ### don't break the utf-8 sequence, if any
+	}
+	if (header.file_comment.size() + header.file_name.size() > 0xffff) {
+		qWarning("QtZip: File comment is too long, chopping it to 65535 bytes");
+		header.file_comment.truncate(0xffff - header.file_name.size()); // ### don't break the utf-8 sequence, if any
+	}
+	writeUShort(header.h.file_name_length, header.file_name.length());
+	//h.extra_field_length[2];
+
+	writeUShort(header.h.version_made, HostUnix << 8);
+	//uchar internal_file_attributes[2];
+	//uchar external_file_attributes[4];
+	quint32 mode = permissionsToMode(permissions);
+	switch (type) {
+		case File: mode |= S_IFREG; break;
+		case Directory: mode |= S_IFDIR; break;
+		case Symlink: mode |= S_IFLNK; break;
+	}
+	writeUInt(header.h.external_file_attributes, mode << 16);
+	writeUInt(header.h.offset_local_header, start_of_directory);
+}
+
 void QtZipWriterPrivate::addEntry(EntryType type, const QString &fileName, const QByteArray &contents/*, QFile::Permissions permissions, QtZip::Method m*/)
 {
 #ifndef NDEBUG
@@ -684,6 +741,9 @@ void QtZipWriterPrivate::addEntry(EntryType type, const QString &fileName, const
 	ZDEBUG() << "adding" << entryTypes[type] <<":" << fileName.toUtf8().data() << (type == 2 ? QByteArray(" -> " + contents).constData() : "");
 #endif
 
+	if (isStreaming)
+		finishStreamedEntry();
+
 	if (! (device->isOpen() || device->open(QIODevice::WriteOnly))) {
 		status = QtZipWriter::FileOpenError;
 		return;
@@ -700,16 +760,11 @@ void QtZipWriterPrivate::addEntry(EntryType type, const QString &fileName, const
 	}
 
 	FileHeader header;
-	memset(&header.h, 0, sizeof(CentralFileHeader));
-	writeUInt(header.h.signature, 0x02014b50);
-
-	writeUShort(header.h.version_needed, ZIP_VERSION);
+	fillHeader(header, type, fileName,
+		compression == QtZipWriter::AlwaysCompress ? CompressionMethodDeflated : CompressionMethodStored);
 	writeUInt(header.h.uncompressed_size, contents.length());
-	writeMSDosDate(header.h.last_mod_file, QDateTime::currentDateTime());
 	QByteArray data = contents;
 	if (compression == QtZipWriter::AlwaysCompress) {
-		writeUShort(header.h.compression_method, CompressionMethodDeflated);
-
 	   ulong len = contents.length();
 		// shamelessly copied form zlib
 		len += (len >> 12) + (len >> 14) + 11;
@@ -738,36 +793,6 @@ void QtZipWriterPrivate::addEntry(EntryType type, const QString &fileName, const
 	crc_32 = ::crc32(crc_32, (const uchar *)contents.constData(), contents.length());
 	writeUInt(header.h.crc_32, crc_32);
 
-	// if bit 11 is set, the filename and comment fields must be encoded using UTF-8
-	ushort general_purpose_bits = Utf8Names; // always use utf-8
-	writeUShort(header.h.general_purpose_bits, general_purpose_bits);
-
-	const bool inUtf8 = (general_purpose_bits & Utf8Names) != 0;
-	header.file_name = inUtf8 ? fileName.toUtf8() : fileName.toLocal8Bit();
-	if (header.file_name.size() > 0xffff) {
-		qWarning("QtZip: Filename is too long, chopping it to 65535 bytes");
-		header.file_name = header.file_name.left(0xffff); // ### don't break the utf-8 sequence, if any
-	}
-	if (header.file_comment.size() + header.file_name.size() > 0xffff) {
-		qWarning("QtZip: File comment is too long, chopping it to 65535 bytes");
-		header.file_comment.truncate(0xffff - header.file_name.size()); // ### don't break the utf-8 sequence, if any
-	}
-	writeUShort(header.h.file_name_length, header.file_name.length());
-	//h.extra_field_length[2];
-
-	writeUShort(header.h.version_made, HostUnix << 8);
-	//uchar internal_file_attributes[2];
-	//uchar external_file_attributes[4];
-	quint32 mode = permissionsToMode(permissions);
-	switch (type) {
-		case File: mode |= S_IFREG; break;
-		case Directory: mode |= S_IFDIR; break;
-		case Symlink: mode |= S_IFLNK; break;
-	}
-	writeUInt(header.h.external_file_attributes, mode << 16);
-	writeUInt(header.h.offset_local_header, start_of_directory);
-
-
 	fileHeaders.append(header);
 
 	LocalFileHeader h = header.h.toLocalHeader();
@@ -778,6 +803,115 @@ void QtZipWriterPrivate::addEntry(EntryType type, const QString &fileName, const
 	dirtyFileTree = true;
 }
 
+bool QtZipWriterPrivate::startStreamedEntry(const QString &fileName)
+{
+	ZDEBUG() << "starting file :" << fileName.toUtf8().data();
+
+	if (isStreaming)
+		finishStreamedEntry();
+
+	if (! (device->isOpen() || device->open(QIODevice::WriteOnly))) {
+		status = QtZipWriter::FileOpenError;
+		return false;
+	}
+	device->seek(start_of_directory);
+
+	// the size of the contents isn't known beforehand, so the auto policy compresses it
+	const bool compress = compressionPolicy != QtZipWriter::NeverCompress;
+	if (compress) {
+		memset(&stream, 0, sizeof(z_stream));
+		if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+			qWarning("QtZip: Z_MEM_ERROR: Not enough memory to compress file, skipping");
+			return false;
+		}
+	}
+
+	fillHeader(streamHeader, File, fileName,
+		compress ? CompressionMethodDeflated : CompressionMethodStored);
+	streamCrc = ::crc32(0, 0, 0);
+	streamUncompressedSize = 0;
+	streamCompressedSize = 0;
+	isStreaming = true;
+
+	// sizes and crc are yet unknown, the local header will be updated when the file is finished
+	LocalFileHeader h = streamHeader.h.toLocalHeader();
+	if (device->write((const char *)&h, sizeof(LocalFileHeader)) != sizeof(LocalFileHeader)
+		|| device->write(streamHeader.file_name) != streamHeader.file_name.size()) {
+		// the archive is broken from this point, so don't let the contents be written into it
+		if (compress)
+			deflateEnd(&stream);
+		isStreaming = false;
+		status = QtZipWriter::FileWriteError;
+		return false;
+	}
+	return true;
+}
+
+void QtZipWriterPrivate::writeStreamedData(const char *data, qint64 size, int flush)
+{
+	if (size > 0) {
+		streamCrc = ::crc32(streamCrc, (const uchar *)data, size);
+		streamUncompressedSize += size;
+	}
+
+	if (readUShort(streamHeader.h.compression_method) == CompressionMethodStored) {
+		if (size > 0 && device->write(data, size) != size)
+			status = QtZipWriter::FileWriteError;
+		streamCompressedSize += size;
+		return;
+	}
+
+	uchar buffer[16 * 1024];
+	stream.next_in = (Bytef *)data;
+	stream.avail_in = (uInt)size;
+	int res = Z_OK;
+	do {
+		stream.next_out = buffer;
+		stream.avail_out = sizeof(buffer);
+		res = deflate(&stream, flush);
+		if (res == Z_STREAM_ERROR) {
+			status = QtZipWriter::FileError;
+			return;
+		}
+
+		const qint64 compressedSize = sizeof(buffer) - stream.avail_out;
+		if (compressedSize > 0 && device->write((const char *)buffer, compressedSize) != compressedSize)
+			status = QtZipWriter::FileWriteError;
+		streamCompressedSize += compressedSize;
+	} while (stream.avail_out == 0 || (flush == Z_FINISH && res != Z_STREAM_END));
+}
+
+void QtZipWriterPrivate::finishStreamedEntry()
+{
+	if (!isStreaming)
+		return;
+
+	if (readUShort(streamHeader.h.compression_method) == CompressionMethodDeflated) {
+		writeStreamedData(0, 0, Z_FINISH);
+		deflateEnd(&stream);
+	}
+	isStreaming = false;
+
+	if (streamUncompressedSize > 0xffffffffu || streamCompressedSize > 0xffffffffu) {
+		qWarning("QtZip: File is too large, zip64 isn't supported");
+		status = QtZipWriter::FileError;
+	}
+	writeUInt(streamHeader.h.crc_32, streamCrc);
+	writeUInt(streamHeader.h.compressed_size, (uint)streamCompressedSize);
+	writeUInt(streamHeader.h.uncompressed_size, (uint)streamUncompressedSize);
+
+	// now, when the contents is written, update the local header with the real sizes and crc
+	const qint64 end = device->pos();
+	LocalFileHeader h = streamHeader.h.toLocalHeader();
+	device->seek(readUInt(streamHeader.h.offset_local_header));
+	if (device->write((const char *)&h, sizeof(LocalFileHeader)) != sizeof(LocalFileHeader))
+		status = QtZipWriter::FileWriteError;
+	device->seek(end);
+
+	fileHeaders.append(streamHeader);
+	start_of_directory = end;
+	dirtyFileTree = true;
+}
 //////////////////////////////  Reader
 
 /*!
@@ -1376,11 +1510,55 @@ void QtZipWriter::addSymLink(const QString &fileName, const QString &destination
 	d->addEntry(QtZipWriterPrivate::Symlink, QDir::fromNativeSeparators(fileName), QFile::encodeName(destination));
 }
 
+/*!
+	Start a file in the archive with the specified \a fileName, which contents
+	will be written by parts with writeFileData().
+	The contents is compressed on the fly, so the whole file is never held
+	in memory.
+
+	Only one file can be written at a time, adding any other entry finishes
+	the current file. The device has to be random access, because the sizes
+	of the file are written to its local header when the file is finished.
+
+	Returns false if the file couldn't be started, for example when its
+	local header couldn't be written, status() tells the reason then.
+
+	\sa writeFileData()
+	\sa finishFile()
+*/
+bool QtZipWriter::startFile(const QString &fileName)
+{
+	return d->startStreamedEntry(QDir::fromNativeSeparators(fileName));
+}
+
+/*!
+	Append \a data to the contents of the file started with startFile().
+	Nothing is written once the writer is in an error state, check status()
+	after the file is finished.
+*/
+void QtZipWriter::writeFileData(const QByteArray &data)
+{
+	if (!d->isStreaming || data.isEmpty() || d->status != QtZipWriter::NoError)
+		return;
+
+	d->writeStreamedData(data.constData(), data.size(), Z_NO_FLUSH);
+}
+
+/*!
+	Finish the file started with startFile().
+*/
+void QtZipWriter::finishFile()
+{
+	d->finishStreamedEntry();
+}
+
 /*!
    Closes the zip file.
 */
 void QtZipWriter::close()
 {
+	d->finishStreamedEntry();
+
 	if (!(d->device->openMode() & QIODevice::WriteOnly)) {
 		d->device->close();
 		return;
@@ -89,6 +89,10 @@ public:
 
 	void addSymLink(const QString &fileName, const QString &destination);
 
+	bool startFile(const QString &fileName);
+	void writeFileData(const QByteArray &data);
+	void finishFile();
+
 	void close();
 private:
 	QtZipWriterPrivate *d;
@@ -0,0 +1,148 @@
+#include "batch_runner.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QProcess>
+#include <QTextStream>
+
+#include <algorithm>
+
+
+class BatchRunner::Implementation
+{
+public:
+    Implementation(BatchRunner* _q, const QStringList& _workerArguments, int _jobs);
+
+    /**
+     * @brief Запустить обработчики для следующих проектов из очереди
+     */
+    void startNext();
+
+    /**
+     * @brief Обработать завершение обработчика проекта
+     */
+    void finishProject(QProcess* _process, const QString& _project, bool _isSucceed);
+
+
+    BatchRunner* q = nullptr;
+
+    const QStringList workerArguments;
+    const int jobs = 1;
+
+    /**
+     * @brief Проекты, ожидающие обработки
+     */
+    QStringList queue;
+
+    /**
+     * @brief Количество работающих в данный момент обработчиков
+     */
+    int runningJobs = 0;
+
+    /**
+     * @brief Проекты, которые не удалось обработать
+     */
+    QStringList failedProjects;
+
+    /**
+     * @brief Общее количество проектов
+     */
+    int projectsCount = 0;
+
+    /**
+     * @brief Таймер общего времени обработки
+     */
+    QElapsedTimer timer;
+};
+
+BatchRunner::Implementation::Implementation(BatchRunner* _q, const QStringList& _workerArguments,
+                                            int _jobs)
+    : q(_q)
+    , workerArguments(_workerArguments)
+    , jobs(std::max(1, _jobs))
+{
+}
+
+void BatchRunner::Implementation::startNext()
+{
+    while (runningJobs < jobs && !queue.isEmpty()) {
+        const auto project = queue.takeFirst();
+        ++runningJobs;
+
+        //
+        // Обработчики выводят результаты целыми строками, поэтому их вывод можно пробрасывать
+        // напрямую, не опасаясь, что строки разных проектов перемешаются
+        //
+        auto process = new QProcess(q);
+        process->setProcessChannelMode(QProcess::ForwardedChannels);
+        QObject::connect(process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
+                         q, [this, process, project](int _exitCode, QProcess::ExitStatus _status) {
+                             finishProject(process, project,
+                                           _status == QProcess::NormalExit && _exitCode == 0);
+                         });
+        QObject::connect(process, &QProcess::errorOccurred, q,
+                         [this, process, project](QProcess::ProcessError _error) {
+                             if (_error == QProcess::FailedToStart) {
+                                 finishProject(process, project, false);
+                             }
+                         });
+        process->start(QCoreApplication::applicationFilePath(),
+                       QStringList(workerArguments) << project);
+    }
+
+    if (runningJobs > 0) {
+        return;
+    }
+
+    //
+    // Все проекты обработаны, выводим итоги
+    //
+    QTextStream output(stdout);
+    output << "batch" << '\t' << "total" << '\t' << QString("%1 ms").arg(timer.elapsed()) << '\n';
+    output << "batch" << '\t' << "succeed" << '\t'
+           << QString("%1/%2").arg(projectsCount - failedProjects.size()).arg(projectsCount)
+           << '\n';
+    for (const auto& project : std::as_const(failedProjects)) {
+        output << "batch" << '\t' << "failed" << '\t' << project << '\n';
+    }
+    output.flush();
+
+    emit q->finished(failedProjects.isEmpty() ? 0 : 1);
+}
+
+void BatchRunner::Implementation::finishProject(QProcess* _process, const QString& _project,
+                                                bool _isSucceed)
+{
+    _process->disconnect(q);
+    _process->deleteLater();
+
+    if (!_isSucceed) {
+        failedProjects.append(QFileInfo(_project).fileName());
+    }
+
+    --runningJobs;
+    startNext();
+}
+
+
+// ****
+
+
+BatchRunner::BatchRunner(const QStringList& _workerArguments, int _jobs, QObject* _parent)
+    : QObject(_parent)
+    , d(new Implementation(this, _workerArguments, _jobs))
+{
+}
+
+BatchRunner::~BatchRunner() = default;
+
+void BatchRunner::run(const QStringList& _projects)
+{
+    d->queue = _projects;
+    d->projectsCount = _projects.size();
+    d->failedProjects.clear();
+    d->timer.start();
+
+    d->startNext();
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <QObject>
+
+
+/**
+ * @brief Запускатель параллельной обработки проектов в отдельных процессах
+ * @note Хранилища и соединение с базой данных в corelib общие для всего процесса, поэтому
+ *       каждый проект обрабатывается отдельным процессом-обработчиком
+ */
+class BatchRunner : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @param _workerArguments Аргументы процесса-обработчика, к которым добавляется путь проекта
+     * @param _jobs Количество одновременно работающих обработчиков
+     */
+    BatchRunner(const QStringList& _workerArguments, int _jobs, QObject* _parent = nullptr);
+    ~BatchRunner() override;
+
+    /**
+     * @brief Обработать заданные проекты
+     */
+    void run(const QStringList& _projects);
+
+signals:
+    /**
+     * @brief Обработка всех проектов завершена
+     * @param _exitCode 0, если все проекты обработаны успешно
+     */
+    void finished(int _exitCode);
+
+private:
+    class Implementation;
+    QScopedPointer<Implementation> d;
+};
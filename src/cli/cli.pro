@@ -0,0 +1,40 @@
+TEMPLATE = app
+TARGET = starccli
+
+CONFIG += c++1z
+CONFIG += console
+CONFIG -= app_bundle
+QT += concurrent widgets sql
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+DESTDIR = ../_build/
+
+INCLUDEPATH += ..
+
+#
+# Подключаем библиотеку corelib
+#
+mac {
+    CORELIBDIR = ../_build/starcapp.app/Contents/Frameworks
+} else {
+    CORELIBDIR = ../_build
+}
+LIBS += -L$$CORELIBDIR/ -lcorelib
+INCLUDEPATH += $$PWD/../corelib
+DEPENDPATH += $$PWD/../corelib
+#
+
+#
+# Модели документов проекта собираем тем же фасадом, что и в основном приложении
+#
+SOURCES += \
+    ../core/management_layer/content/project/project_models_facade.cpp \
+    batch_runner.cpp \
+    main.cpp \
+    project_processor.cpp
+
+HEADERS += \
+    ../core/management_layer/content/project/project_models_facade.h \
+    batch_runner.h \
+    project_processor.h
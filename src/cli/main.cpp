@@ -0,0 +1,136 @@
+#include "batch_runner.h"
+#include "project_processor.h"
+
+#include <utils/helpers/extension_helper.h>
+#include <utils/logging.h>
+
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QDir>
+#include <QFontDatabase>
+#include <QThread>
+#include <QTimer>
+
+
+/**
+ * @brief Загрузить шрифты, используемые в шаблонах документов
+ */
+void loadFonts()
+{
+    const QStringList fonts = {
+        "arial",
+        "arial-bold",
+        "arial-italic",
+        "arial-bold-italic",
+        "courier-new",
+        "courier-new-bold",
+        "courier-new-italic",
+        "courier-new-bold-italic",
+        "courier-prime",
+        "courier-prime-bold",
+        "courier-prime-italic",
+        "courier-prime-bold-italic",
+        "mallanna-regular",
+        "muktamalar-bold",
+        "muktamalar-regular",
+        "noto-sans",
+        "noto-sans-light",
+        "noto-sans-medium",
+        "roboto-bold",
+        "roboto-light",
+        "roboto-medium",
+        "roboto-regular",
+        "times-new-roman",
+        "times-new-roman-bold",
+        "times-new-roman-italic",
+        "times-new-roman-bold-italic",
+    };
+    for (const auto& font : fonts) {
+        QFontDatabase::addApplicationFont(":/fonts/" + font);
+    }
+}
+
+/**
+ * @brief Экспортируем проекты без интерфейса
+ *
+ * Каждый проект обрабатывается в отдельном процессе, а для каждого этапа обработки выводится
+ * строка вида "<проект>\t<этап>\t<длительность>", поэтому вывод можно сравнивать между запусками
+ */
+int main(int argc, char* argv[])
+{
+    //
+    // Окна не нужны, но экспортерам нужна система шрифтов, поэтому используем платформу,
+    // которая ничего не выводит на экран
+    //
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+
+    QApplication application(argc, argv);
+    //
+    // ... используем те же настройки, что и основное приложение
+    //
+    QApplication::setApplicationName("Story Architect");
+    QApplication::setOrganizationName("Story Apps");
+    QApplication::setOrganizationDomain("storyapps.dev");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Export Story Architect projects and build their reports");
+    parser.addHelpOption();
+    const QCommandLineOption outputOption(
+        { "o", "output" }, "Folder to save results to, each project gets its own subfolder.",
+        "folder", QDir::currentPath());
+    parser.addOption(outputOption);
+    const QCommandLineOption formatsOption(
+        { "f", "formats" }, "Comma separated export formats: pdf, docx, fdx, fountain, md.",
+        "formats",
+        QStringList({ ExtensionHelper::pdf(), ExtensionHelper::msOfficeOpenXml(),
+                      ExtensionHelper::fountain() })
+            .join(','));
+    parser.addOption(formatsOption);
+    const QCommandLineOption noReportsOption("no-reports", "Don't build statistics reports.");
+    parser.addOption(noReportsOption);
+    const QCommandLineOption jobsOption({ "j", "jobs" },
+                                        "Number of projects processed in parallel.", "count",
+                                        QString::number(QThread::idealThreadCount()));
+    parser.addOption(jobsOption);
+    QCommandLineOption workerOption("worker", "Process a single project in the current process.");
+    workerOption.setFlags(QCommandLineOption::HiddenFromHelp);
+    parser.addOption(workerOption);
+    parser.addPositionalArgument("projects", "Project files to process.", "<project>...");
+    parser.process(application);
+
+    const auto projects = parser.positionalArguments();
+    if (projects.isEmpty()) {
+        parser.showHelp(1);
+    }
+
+    ProjectProcessor::Options options;
+    options.outputFolder = QDir(parser.value(outputOption)).absolutePath();
+    options.formats = parser.value(formatsOption).split(',', Qt::SkipEmptyParts);
+    options.buildReports = !parser.isSet(noReportsOption);
+
+    //
+    // Единственный проект обрабатываем прямо в текущем процессе
+    //
+    if (parser.isSet(workerOption) || projects.size() == 1) {
+        Log::init(Log::Level::Warning, {});
+        loadFonts();
+
+        ProjectProcessor processor(options);
+        return processor.process(projects.constFirst()) ? 0 : 1;
+    }
+
+    //
+    // А несколько проектов раздаём параллельно работающим обработчикам
+    //
+    QStringList workerArguments = { "--worker", "--output", options.outputFolder, "--formats",
+                                    options.formats.join(',') };
+    if (!options.buildReports) {
+        workerArguments.append("--no-reports");
+    }
+    BatchRunner runner(workerArguments, parser.value(jobsOption).toInt());
+    QObject::connect(&runner, &BatchRunner::finished, &application, &QApplication::exit);
+    QTimer::singleShot(0, &runner, [&runner, projects] { runner.run(projects); });
+    return application.exec();
+}
@@ -0,0 +1,600 @@
+#include "project_processor.h"
+
+#include <business_layer/export/audioplay/audioplay_docx_exporter.h>
+#include <business_layer/export/audioplay/audioplay_export_options.h>
+#include <business_layer/export/audioplay/audioplay_fountain_exporter.h>
+#include <business_layer/export/audioplay/audioplay_pdf_exporter.h>
+#include <business_layer/export/comic_book/comic_book_docx_exporter.h>
+#include <business_layer/export/comic_book/comic_book_export_options.h>
+#include <business_layer/export/comic_book/comic_book_fountain_exporter.h>
+#include <business_layer/export/comic_book/comic_book_pdf_exporter.h>
+#include <business_layer/export/novel/novel_docx_exporter.h>
+#include <business_layer/export/novel/novel_export_options.h>
+#include <business_layer/export/novel/novel_markdown_exporter.h>
+#include <business_layer/export/novel/novel_pdf_exporter.h>
+#include <business_layer/export/screenplay/screenplay_docx_exporter.h>
+#include <business_layer/export/screenplay/screenplay_export_options.h>
+#include <business_layer/export/screenplay/screenplay_fdx_exporter.h>
+#include <business_layer/export/screenplay/screenplay_fountain_exporter.h>
+#include <business_layer/export/screenplay/screenplay_pdf_exporter.h>
+#include <business_layer/export/stageplay/stageplay_docx_exporter.h>
+#include <business_layer/export/stageplay/stageplay_export_options.h>
+#include <business_layer/export/stageplay/stageplay_fountain_exporter.h>
+#include <business_layer/export/stageplay/stageplay_pdf_exporter.h>
+#include <business_layer/model/audioplay/audioplay_information_model.h>
+#include <business_layer/model/audioplay/text/audioplay_text_model.h>
+#include <business_layer/model/comic_book/comic_book_information_model.h>
+#include <business_layer/model/comic_book/text/comic_book_text_model.h>
+#include <business_layer/model/novel/novel_information_model.h>
+#include <business_layer/model/novel/text/novel_text_model.h>
+#include <business_layer/model/screenplay/screenplay_information_model.h>
+#include <business_layer/model/screenplay/text/screenplay_text_model.h>
+#include <business_layer/model/stageplay/stageplay_information_model.h>
+#include <business_layer/model/stageplay/text/stageplay_text_model.h>
+#include <business_layer/model/structure/structure_model.h>
+#include <business_layer/model/structure/structure_model_item.h>
+#include <business_layer/reports/audioplay/audioplay_cast_report.h>
+#include <business_layer/reports/audioplay/audioplay_dialogues_report.h>
+#include <business_layer/reports/audioplay/audioplay_gender_report.h>
+#include <business_layer/reports/audioplay/audioplay_location_report.h>
+#include <business_layer/reports/audioplay/audioplay_scene_report.h>
+#include <business_layer/reports/audioplay/audioplay_summary_report.h>
+#include <business_layer/reports/comic_book/comic_book_summary_report.h>
+#include <business_layer/reports/novel/novel_summary_report.h>
+#include <business_layer/reports/screenplay/screenplay_cast_report.h>
+#include <business_layer/reports/screenplay/screenplay_dialogues_report.h>
+#include <business_layer/reports/screenplay/screenplay_gender_report.h>
+#include <business_layer/reports/screenplay/screenplay_location_report.h>
+#include <business_layer/reports/screenplay/screenplay_scene_report.h>
+#include <business_layer/reports/screenplay/screenplay_summary_report.h>
+#include <business_layer/reports/stageplay/stageplay_summary_report.h>
+#include <core/management_layer/content/project/project_models_facade.h>
+#include <data_layer/database.h>
+#include <data_layer/storage/document_image_storage.h>
+#include <data_layer/storage/document_storage.h>
+#include <data_layer/storage/storage_facade.h>
+#include <domain/document_object.h>
+#include <utils/helpers/extension_helper.h>
+#include <utils/helpers/platform_helper.h>
+
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QSet>
+#include <QSharedPointer>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QUuid>
+
+#include <functional>
+
+
+namespace {
+
+/**
+ * @brief Типы документов, которые умеет обрабатывать обработчик
+ */
+const QVector<Domain::DocumentObjectType> kTextDocumentTypes = {
+    Domain::DocumentObjectType::ScreenplayText, Domain::DocumentObjectType::ComicBookText,
+    Domain::DocumentObjectType::AudioplayText,  Domain::DocumentObjectType::StageplayText,
+    Domain::DocumentObjectType::NovelText,
+};
+
+/**
+ * @brief Сделать снимок проекта в заданный файл
+ * @note Проект открывается только для чтения, а снимок делается средствами SQLite в рамках одной
+ *       читающей транзакции, поэтому он согласован, даже если в этот момент приложение пишет в
+ *       проект, и учитывает ещё не перенесённые из журнала упреждающей записи данные
+ */
+bool snapshotProject(const QString& _projectPath, const QString& _snapshotPath)
+{
+    const auto connectionName
+        = QString("project_snapshot_%1").arg(QUuid::createUuid().toString(QUuid::WithoutBraces));
+    bool isSucceed = false;
+    {
+        auto database = QSqlDatabase::addDatabase("QSQLITE", connectionName);
+        database.setDatabaseName(_projectPath);
+        database.setConnectOptions("QSQLITE_OPEN_READONLY");
+        if (database.open()) {
+            QSqlQuery query(database);
+            query.prepare("VACUUM INTO ?");
+            query.addBindValue(_snapshotPath);
+            isSucceed = query.exec();
+        }
+        database.close();
+    }
+    QSqlDatabase::removeDatabase(connectionName);
+    return isSucceed;
+}
+
+/**
+ * @brief Удалён ли документ заданного элемента структуры, т.е. находится ли он в корзине
+ */
+bool isRemoved(BusinessLayer::StructureModelItem* _item)
+{
+    if (_item == nullptr) {
+        return true;
+    }
+
+    for (auto parent = _item->parent(); parent != nullptr; parent = parent->parent()) {
+        if (parent->type() == Domain::DocumentObjectType::RecycleBin) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Вывести строку с результатом этапа обработки
+ */
+void printResult(const QString& _project, const QString& _stage, const QString& _result)
+{
+    QTextStream output(stdout);
+    output << _project << '\t' << _stage << '\t' << _result << '\n';
+    output.flush();
+}
+
+/**
+ * @brief Сформировать параметры экспорта, общие для документов всех типов
+ */
+template<typename Options, typename Model>
+Options exportOptionsFor(Model* _model, const QString& _filePath)
+{
+    Options options;
+    options.filePath = _filePath;
+
+    const auto informationModel = _model->informationModel();
+    options.templateId = informationModel->templateId();
+    options.header = informationModel->header();
+    options.printHeaderOnTitlePage = informationModel->printHeaderOnTitlePage();
+    options.footer = informationModel->footer();
+    options.printFooterOnTitlePage = informationModel->printFooterOnTitlePage();
+    return options;
+}
+
+/**
+ * @brief Создать экспортер документа заданного типа в заданный формат
+ * @return nullptr, если документ заданного типа нельзя экспортировать в заданный формат
+ */
+BusinessLayer::AbstractExporter* createExporter(Domain::DocumentObjectType _type,
+                                                const QString& _format)
+{
+    using namespace BusinessLayer;
+
+    const bool isPdf = _format == ExtensionHelper::pdf();
+    const bool isDocx = _format == ExtensionHelper::msOfficeOpenXml();
+    const bool isFountain = _format == ExtensionHelper::fountain();
+
+    switch (_type) {
+    case Domain::DocumentObjectType::ScreenplayText: {
+        if (isPdf) {
+            return new ScreenplayPdfExporter;
+        } else if (isDocx) {
+            return new ScreenplayDocxExporter;
+        } else if (isFountain) {
+            return new ScreenplayFountainExporter;
+        } else if (_format == ExtensionHelper::finalDraft()) {
+            return new ScreenplayFdxExporter;
+        }
+        break;
+    }
+
+    case Domain::DocumentObjectType::ComicBookText: {
+        if (isPdf) {
+            return new ComicBookPdfExporter;
+        } else if (isDocx) {
+            return new ComicBookDocxExporter;
+        } else if (isFountain) {
+            return new ComicBookFountainExporter;
+        }
+        break;
+    }
+
+    case Domain::DocumentObjectType::AudioplayText: {
+        if (isPdf) {
+            return new AudioplayPdfExporter;
+        } else if (isDocx) {
+            return new AudioplayDocxExporter;
+        } else if (isFountain) {
+            return new AudioplayFountainExporter;
+        }
+        break;
+    }
+
+    case Domain::DocumentObjectType::StageplayText: {
+        if (isPdf) {
+            return new StageplayPdfExporter;
+        } else if (isDocx) {
+            return new StageplayDocxExporter;
+        } else if (isFountain) {
+            return new StageplayFountainExporter;
+        }
+        break;
+    }
+
+    case Domain::DocumentObjectType::NovelText: {
+        if (isPdf) {
+            return new NovelPdfExporter;
+        } else if (isDocx) {
+            return new NovelDocxExporter;
+        } else if (_format == ExtensionHelper::markdown()) {
+            return new NovelMarkdownExporter;
+        }
+        break;
+    }
+
+    default: {
+        break;
+    }
+    }
+
+    return nullptr;
+}
+
+/**
+ * @brief Создать отчёты для документа заданного типа
+ */
+QVector<QPair<QString, QSharedPointer<BusinessLayer::AbstractReport>>> createReports(
+    Domain::DocumentObjectType _type)
+{
+    using namespace BusinessLayer;
+
+    switch (_type) {
+    case Domain::DocumentObjectType::ScreenplayText: {
+        return {
+            { "summary", QSharedPointer<AbstractReport>(new ScreenplaySummaryReport) },
+            { "scenes", QSharedPointer<AbstractReport>(new ScreenplaySceneReport) },
+            { "locations", QSharedPointer<AbstractReport>(new ScreenplayLocationReport) },
+            { "cast", QSharedPointer<AbstractReport>(new ScreenplayCastReport) },
+            { "dialogues", QSharedPointer<AbstractReport>(new ScreenplayDialoguesReport) },
+            { "gender", QSharedPointer<AbstractReport>(new ScreenplayGenderReport) },
+        };
+    }
+
+    case Domain::DocumentObjectType::ComicBookText: {
+        return {
+            { "summary", QSharedPointer<AbstractReport>(new ComicBookSummaryReport) },
+        };
+    }
+
+    case Domain::DocumentObjectType::AudioplayText: {
+        return {
+            { "summary", QSharedPointer<AbstractReport>(new AudioplaySummaryReport) },
+            { "scenes", QSharedPointer<AbstractReport>(new AudioplaySceneReport) },
+            { "locations", QSharedPointer<AbstractReport>(new AudioplayLocationReport) },
+            { "cast", QSharedPointer<AbstractReport>(new AudioplayCastReport) },
+            { "dialogues", QSharedPointer<AbstractReport>(new AudioplayDialoguesReport) },
+            { "gender", QSharedPointer<AbstractReport>(new AudioplayGenderReport) },
+        };
+    }
+
+    case Domain::DocumentObjectType::StageplayText: {
+        return {
+            { "summary", QSharedPointer<AbstractReport>(new StageplaySummaryReport) },
+        };
+    }
+
+    case Domain::DocumentObjectType::NovelText: {
+        return {
+            { "summary", QSharedPointer<AbstractReport>(new NovelSummaryReport) },
+        };
+    }
+
+    default: {
+        return {};
+    }
+    }
+}
+
+} // namespace
+
+
+class ProjectProcessor::Implementation
+{
+public:
+    explicit Implementation(const Options& _options);
+
+    /**
+     * @brief Выполнить этап обработки, выведя его длительность
+     * @return Удалось ли выполнить этап
+     */
+    bool runStage(const QString& _stage, std::function<bool()> _stageFunction);
+
+    /**
+     * @brief Загрузить проект из копии файла и обработать все его документы
+     */
+    bool processProject(const QString& _projectCopyPath);
+
+    /**
+     * @brief Экспортировать все текстовые документы проекта и построить по ним отчёты
+     */
+    bool processDocuments(BusinessLayer::StructureModel* _structureModel,
+                          ManagementLayer::ProjectModelsFacade* _modelsFacade);
+
+    /**
+     * @brief Экспортировать документ в заданный файл
+     */
+    bool exportDocument(Domain::DocumentObjectType _type, BusinessLayer::AbstractModel* _model,
+                        BusinessLayer::AbstractExporter* _exporter, const QString& _filePath);
+
+    /**
+     * @brief Получить уникальное в рамках проекта имя для файлов документа
+     */
+    QString documentFileName(BusinessLayer::StructureModel* _structureModel,
+                             Domain::DocumentObject* _document);
+
+
+    const Options options;
+
+    /**
+     * @brief Имя обрабатываемого проекта, которым начинается каждая строка вывода
+     */
+    QString projectName;
+
+    /**
+     * @brief Папка для результатов обработки текущего проекта
+     */
+    QDir projectOutputDir;
+
+    /**
+     * @brief Имена файлов документов, уже использованные в текущем проекте
+     */
+    QSet<QString> usedFileNames;
+};
+
+ProjectProcessor::Implementation::Implementation(const Options& _options)
+    : options(_options)
+{
+}
+
+bool ProjectProcessor::Implementation::runStage(const QString& _stage,
+                                                std::function<bool()> _stageFunction)
+{
+    QElapsedTimer timer;
+    timer.start();
+    const auto isSucceed = _stageFunction();
+    printResult(projectName, _stage,
+                isSucceed ? QString("%1 ms").arg(timer.elapsed()) : QString("failed"));
+    return isSucceed;
+}
+
+bool ProjectProcessor::Implementation::processProject(const QString& _projectCopyPath)
+{
+    using namespace BusinessLayer;
+
+    bool isProjectOpened = false;
+    const auto isOpenSucceed = runStage("open", [&_projectCopyPath, &isProjectOpened] {
+        if (!DatabaseLayer::Database::canOpenFile(_projectCopyPath)) {
+            return false;
+        }
+
+        DatabaseLayer::Database::setCurrentFile(_projectCopyPath);
+        isProjectOpened = true;
+        return !DatabaseLayer::Database::hasError();
+    });
+    if (!isOpenSucceed) {
+        if (isProjectOpened) {
+            DatabaseLayer::Database::closeCurrentFile();
+        }
+        return false;
+    }
+
+    bool isSucceed = false;
+    {
+        DataStorageLayer::DocumentImageStorage documentImageStorage;
+        StructureModel structureModel;
+        ManagementLayer::ProjectModelsFacade modelsFacade(&structureModel, &documentImageStorage);
+        const auto isStructureLoaded = runStage("structure", [&structureModel] {
+            structureModel.setDocument(DataStorageLayer::StorageFacade::documentStorage()->document(
+                Domain::DocumentObjectType::Structure));
+            return structureModel.document() != nullptr;
+        });
+        isSucceed = isStructureLoaded && processDocuments(&structureModel, &modelsFacade);
+
+        modelsFacade.clear();
+        structureModel.clear();
+    }
+
+    DatabaseLayer::Database::closeCurrentFile();
+    DataStorageLayer::StorageFacade::clearStorages();
+
+    return isSucceed;
+}
+
+bool ProjectProcessor::Implementation::processDocuments(
+    BusinessLayer::StructureModel* _structureModel,
+    ManagementLayer::ProjectModelsFacade* _modelsFacade)
+{
+    using namespace BusinessLayer;
+
+    bool isSucceed = true;
+    for (const auto type : kTextDocumentTypes) {
+        const auto documents = DataStorageLayer::StorageFacade::documentStorage()->documents(type);
+        for (const auto document : documents) {
+            //
+            // Документы из корзины не обрабатываем
+            //
+            if (isRemoved(_structureModel->itemForUuid(document->uuid()))) {
+                continue;
+            }
+
+            const auto fileName = documentFileName(_structureModel, document);
+            AbstractModel* model = nullptr;
+            const auto isLoaded = runStage(QString("load \"%1\"").arg(fileName), [&] {
+                model = _modelsFacade->modelFor(document);
+                return model != nullptr;
+            });
+            if (!isLoaded) {
+                isSucceed = false;
+                continue;
+            }
+
+            for (const auto& format : options.formats) {
+                QScopedPointer<AbstractExporter> exporter(createExporter(type, format));
+                if (exporter.isNull()) {
+                    continue;
+                }
+
+                const auto filePath
+                    = projectOutputDir.absoluteFilePath(QString("%1.%2").arg(fileName, format));
+                isSucceed &= runStage(
+                    QString("export %1 \"%2\"").arg(format, fileName), [&] {
+                        return exportDocument(type, model, exporter.data(), filePath);
+                    });
+            }
+
+            if (!options.buildReports) {
+                continue;
+            }
+
+            const auto reports = createReports(type);
+            for (const auto& report : reports) {
+                const auto filePath = projectOutputDir.absoluteFilePath(
+                    QString("%1 - %2.%3").arg(fileName, report.first, ExtensionHelper::xlsx()));
+                isSucceed &= runStage(
+                    QString("report %1 \"%2\"").arg(report.first, fileName), [&] {
+                        report.second->build(model);
+                        report.second->saveToFile(filePath);
+                        return QFileInfo(filePath).size() > 0;
+                    });
+            }
+        }
+    }
+
+    return isSucceed;
+}
+
+bool ProjectProcessor::Implementation::exportDocument(Domain::DocumentObjectType _type,
+                                                      BusinessLayer::AbstractModel* _model,
+                                                      BusinessLayer::AbstractExporter* _exporter,
+                                                      const QString& _filePath)
+{
+    using namespace BusinessLayer;
+
+    switch (_type) {
+    case Domain::DocumentObjectType::ScreenplayText: {
+        const auto textModel = qobject_cast<ScreenplayTextModel*>(_model);
+        auto exportOptions = exportOptionsFor<ScreenplayExportOptions>(textModel, _filePath);
+        const auto informationModel = textModel->informationModel();
+        exportOptions.showScenesNumbers = informationModel->showSceneNumbers();
+        exportOptions.showScenesNumbersOnLeft = informationModel->showSceneNumbersOnLeft();
+        exportOptions.showScenesNumbersOnRight = informationModel->showSceneNumbersOnRight();
+        exportOptions.showDialoguesNumbers = informationModel->showDialoguesNumbers();
+        _exporter->exportTo(textModel, exportOptions);
+        break;
+    }
+
+    case Domain::DocumentObjectType::ComicBookText: {
+        const auto textModel = qobject_cast<ComicBookTextModel*>(_model);
+        auto exportOptions = exportOptionsFor<ComicBookExportOptions>(textModel, _filePath);
+        _exporter->exportTo(textModel, exportOptions);
+        break;
+    }
+
+    case Domain::DocumentObjectType::AudioplayText: {
+        const auto textModel = qobject_cast<AudioplayTextModel*>(_model);
+        auto exportOptions = exportOptionsFor<AudioplayExportOptions>(textModel, _filePath);
+        exportOptions.showBlockNumbers = textModel->informationModel()->showBlockNumbers();
+        _exporter->exportTo(textModel, exportOptions);
+        break;
+    }
+
+    case Domain::DocumentObjectType::StageplayText: {
+        const auto textModel = qobject_cast<StageplayTextModel*>(_model);
+        auto exportOptions = exportOptionsFor<StageplayExportOptions>(textModel, _filePath);
+        _exporter->exportTo(textModel, exportOptions);
+        break;
+    }
+
+    case Domain::DocumentObjectType::NovelText: {
+        const auto textModel = qobject_cast<NovelTextModel*>(_model);
+        auto exportOptions = exportOptionsFor<NovelExportOptions>(textModel, _filePath);
+        _exporter->exportTo(textModel, exportOptions);
+        break;
+    }
+
+    default: {
+        return false;
+    }
+    }
+
+    //
+    // Экспортеры не сообщают об ошибках, поэтому ориентируемся на созданный файл
+    //
+    return QFileInfo(_filePath).size() > 0;
+}
+
+QString ProjectProcessor::Implementation::documentFileName(
+    BusinessLayer::StructureModel* _structureModel, Domain::DocumentObject* _document)
+{
+    //
+    // Текстовый документ лежит внутри документа сценария (романа и т.п.), имя которого и берём
+    //
+    const auto item = _structureModel->itemForUuid(_document->uuid());
+    const auto name = item != nullptr && item->parent() != nullptr ? item->parent()->name()
+                                                                   : QString();
+    const auto baseName = PlatformHelper::systemSavebleFileName(
+        name.isEmpty() ? _document->uuid().toString(QUuid::WithoutBraces) : name);
+
+    auto fileName = baseName;
+    for (int index = 2; usedFileNames.contains(fileName); ++index) {
+        fileName = QString("%1 (%2)").arg(baseName).arg(index);
+    }
+    usedFileNames.insert(fileName);
+    return fileName;
+}
+
+
+// ****
+
+
+ProjectProcessor::ProjectProcessor(const Options& _options)
+    : d(new Implementation(_options))
+{
+}
+
+ProjectProcessor::~ProjectProcessor() = default;
+
+bool ProjectProcessor::process(const QString& _projectPath)
+{
+    const QFileInfo projectFileInfo(_projectPath);
+    d->projectName = projectFileInfo.fileName();
+    d->projectOutputDir = QDir(d->options.outputFolder);
+    d->usedFileNames.clear();
+
+    QElapsedTimer timer;
+    timer.start();
+
+    //
+    // Работаем с копией проекта, т.к. при открытии база данных может быть обновлена до текущей
+    // версии, а сам проект в этот момент может быть открыт в приложении
+    //
+    QTemporaryDir temporaryDir;
+    const auto projectCopyPath = temporaryDir.filePath(projectFileInfo.fileName());
+    const auto isCopied = d->runStage("copy", [&] {
+        if (!temporaryDir.isValid() || !projectFileInfo.exists()) {
+            return false;
+        }
+
+        return snapshotProject(_projectPath, projectCopyPath);
+    });
+    if (!isCopied) {
+        return false;
+    }
+
+    //
+    // Результаты складываем в отдельную папку для каждого проекта
+    //
+    const auto projectOutputFolder = projectFileInfo.completeBaseName();
+    if (!d->projectOutputDir.mkpath(projectOutputFolder)
+        || !d->projectOutputDir.cd(projectOutputFolder)) {
+        printResult(d->projectName, "output", "failed");
+        return false;
+    }
+
+    const auto isSucceed = d->processProject(projectCopyPath);
+    printResult(d->projectName, "total", QString("%1 ms").arg(timer.elapsed()));
+    return isSucceed;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <QScopedPointer>
+#include <QStringList>
+
+
+/**
+ * @brief Обработчик проекта, выгружающий его текстовые документы и отчёты по ним
+ */
+class ProjectProcessor
+{
+public:
+    /**
+     * @brief Параметры обработки
+     */
+    struct Options {
+        /**
+         * @brief Папка, в которую сохраняются результаты
+         */
+        QString outputFolder;
+
+        /**
+         * @brief Форматы, в которые экспортируются документы
+         */
+        QStringList formats;
+
+        /**
+         * @brief Строить ли отчёты по документам
+         */
+        bool buildReports = true;
+    };
+
+public:
+    explicit ProjectProcessor(const Options& _options);
+    ~ProjectProcessor();
+
+    /**
+     * @brief Обработать проект, выводя длительность каждого из этапов обработки
+     * @note Работа ведётся с копией файла, поэтому сам проект никогда не изменяется
+     * @return Удалось ли успешно выполнить все этапы
+     */
+    bool process(const QString& _projectPath);
+
+private:
+    class Implementation;
+    QScopedPointer<Implementation> d;
+};
@@ -32,6 +32,7 @@
 
 #include <business_layer/model/abstract_model.h>
 #include <data_layer/database.h>
+#include <data_layer/database_writer.h>
 #include <data_layer/storage/settings_storage.h>
 #include <data_layer/storage/storage_facade.h>
 #include <domain/document_change_object.h>
@@ -231,6 +232,11 @@ public:
      */
     void saveChanges();
 
+    /**
+     * @brief Сообщить пользователю об ошибке сохранения изменений
+     */
+    void showSaveChangesError();
+
     /**
      * @brief Если проект был изменён, но не сохранён предложить пользователю сохранить его
      * @param _callback - метод, который будет вызван, если пользователь хочет (Да),
@@ -1298,39 +1304,11 @@ void ApplicationManager::Implementation::saveChanges()
     // Если произошла ошибка сохранения, то делаем дополнительные проверки и работаем с
     // пользователем
     //
+    // NOTE: Изменения записываются в базу данных в отдельном потоке, поэтому ошибки записи
+    //       приходят позднее, через сигнал потока записи
+    //
     if (DatabaseLayer::Database::hasError()) {
-        //
-        // Если файл, в который мы пробуем сохранять изменения существует
-        //
-        if (QFile::exists(DatabaseLayer::Database::currentFile())) {
-            //
-            // ... то у нас случилась какая-то внутренняя ошибка базы данных
-            //
-            StandardDialog::information(
-                applicationView, tr("Saving error"),
-                tr("Changes can't be written. There is an internal database error: \"%1\" "
-                   "Please check, if your file exists and if you have permission to write.")
-                    .arg(DatabaseLayer::Database::lastError()));
-
-            //
-            // TODO: пока хер знает, как реагировать на данную проблему...
-            //       нужны реальные кейсы и пробовать что-то предпринимать
-            //
-        }
-        //
-        // Файла с базой данных не найдено
-        //
-        else {
-            //
-            // ... возможно файл был на флешке, а она отошла, или файл был переименован во время
-            // работы программы
-            //
-            StandardDialog::information(
-                applicationView, tr("Saving error"),
-                tr("Changes can't be written because the story located at \"%1\" doesn't exist. "
-                   "Please move the file back and retry saving.")
-                    .arg(DatabaseLayer::Database::currentFile()));
-        }
+        showSaveChangesError();
         return;
     }
 
@@ -1371,14 +1349,60 @@ void ApplicationManager::Implementation::saveChanges()
                 = QString("%1 [%2]").arg(currentProject->name()).arg(currentProject->id());
         }
         QFuture<void> future = QtConcurrent::run(
-            BackupBuilder::save, projectsManager->currentProject()->path(),
-            settingsValue(DataStorageLayer::kApplicationBackupsFolderKey).toString(),
-            baseBackupName, settingsValue(DataStorageLayer::kApplicationBackupsQtyKey).toInt());
+            [projectPath = projectsManager->currentProject()->path(),
+             backupsFolder
+             = settingsValue(DataStorageLayer::kApplicationBackupsFolderKey).toString(),
+             baseBackupName,
+             backupsQty = settingsValue(DataStorageLayer::kApplicationBackupsQtyKey).toInt()] {
+                //
+                // Копию делаем только после того, как поток записи сохранит все изменения,
+                // а сам снимок читает данные вместе с журналом, поэтому переносить их в файл
+                // проекта не нужно
+                //
+                DatabaseLayer::Database::writer()->waitForPendingWrites();
+                BackupBuilder::save(projectPath, backupsFolder, baseBackupName, backupsQty);
+            });
     }
 
     Log::info("All changes saved");
 }
 
+void ApplicationManager::Implementation::showSaveChangesError()
+{
+    //
+    // Если файл, в который мы пробуем сохранять изменения существует
+    //
+    if (QFile::exists(DatabaseLayer::Database::currentFile())) {
+        //
+        // ... то у нас случилась какая-то внутренняя ошибка базы данных
+        //
+        StandardDialog::information(
+            applicationView, tr("Saving error"),
+            tr("Changes can't be written. There is an internal database error: \"%1\" "
+               "Please check, if your file exists and if you have permission to write.")
+                .arg(DatabaseLayer::Database::lastError()));
+
+        //
+        // TODO: пока хер знает, как реагировать на данную проблему...
+        //       нужны реальные кейсы и пробовать что-то предпринимать
+        //
+    }
+    //
+    // Файла с базой данных не найдено
+    //
+    else {
+        //
+        // ... возможно файл был на флешке, а она отошла, или файл был переименован во время
+        // работы программы
+        //
+        StandardDialog::information(
+            applicationView, tr("Saving error"),
+            tr("Changes can't be written because the story located at \"%1\" doesn't exist. "
+               "Please move the file back and retry saving.")
+                .arg(DatabaseLayer::Database::currentFile()));
+    }
+}
+
 void ApplicationManager::Implementation::saveIfNeeded(std::function<void()> _callback)
 {
     //
@@ -1530,6 +1554,7 @@ void ApplicationManager::Implementation::saveAs()
     //
     // ... скопируем текущую базу в указанный файл
     //
+    DatabaseLayer::Database::checkpoint();
     const auto isCopied = QFile::copy(currentProject->realPath(), saveAsProjectFilePath);
     if (!isCopied) {
         StandardDialog::information(
@@ -1721,6 +1746,24 @@ bool ApplicationManager::Implementation::openProject(const QString& _path)
         return false;
     }
 
+    //
+    // Резервные копии хранят содержимое документов отдельно от самого файла, поэтому вместо
+    // копии открываем восстановленный из неё файл проекта
+    //
+    if (_path.endsWith(ExtensionHelper::starc(), Qt::CaseInsensitive)
+        && BackupBuilder::isBackup(_path)) {
+        const auto restoredPath = BackupBuilder::restore(_path);
+        if (restoredPath.isEmpty()) {
+            StandardDialog::information(
+                applicationView, {},
+                tr("Backup can't be restored. Backups keep documents texts in a separate folder, "
+                   "check that it is available: %1")
+                    .arg(QDir::toNativeSeparators(BackupBuilder::contentsDir(_path))));
+            return false;
+        }
+        return openProject(restoredPath);
+    }
+
     if (projectsManager->project(_path) != nullptr && projectsManager->project(_path)->isLocal()
         && !QFileInfo::exists(_path)) {
         projectsManager->hideProject(_path);
@@ -2630,6 +2673,16 @@ bool ApplicationManager::event(QEvent* _event)
 
 void ApplicationManager::initConnections()
 {
+    //
+    // Ошибки записи изменений в базу данных
+    //
+    connect(DatabaseLayer::Database::writer(), &DatabaseLayer::DatabaseWriter::writeFailed, this,
+            [this](const QString& _error) {
+                DatabaseLayer::Database::setLastError(_error);
+                d->markChangesSaved(false);
+                d->showSaveChangesError();
+            });
+
     //
     // Горячие клавиши
     //
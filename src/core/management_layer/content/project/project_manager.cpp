@@ -3,6 +3,7 @@
 #include "include/custom_events.h"
 #include "project_models_facade.h"
 
+#include <business_layer/chronometry/chronometer.h>
 #include <business_layer/model/audioplay/audioplay_information_model.h>
 #include <business_layer/model/audioplay/text/audioplay_text_model.h>
 #include <business_layer/model/base/title_page_model.h>
@@ -25,6 +26,7 @@
 #include <business_layer/model/worlds/worlds_model.h>
 #include <business_layer/templates/text_template.h>
 #include <data_layer/database.h>
+#include <data_layer/document_changes_compactor.h>
 #include <data_layer/storage/document_change_storage.h>
 #include <data_layer/storage/document_image_storage.h>
 #include <data_layer/storage/document_storage.h>
@@ -73,6 +75,13 @@ const QLatin1String kCurrentViewMimeTypeKey("view-mime-type");
 const QLatin1String kCurrentVersionKey("current-version");
 constexpr int kCollaboratorsUpdateTimeoutMs = 60 * 1000;
 
+/**
+ * @brief Параметры объединения старых изменений документов
+ */
+constexpr int kChangesHistoryRetentionDays = 30;
+constexpr int kChangesCompactionStartDelayMs = 60 * 1000;
+constexpr int kChangesCompactionPassIntervalMs = 30 * 60 * 1000;
+
 /**
  * @brief Является ли заданный элемент текстовым
  */
@@ -281,6 +290,11 @@ public:
      */
     void updateViewsEditingMode();
 
+    /**
+     * @brief Запустить проход объединения старых изменений загруженных документов
+     */
+    void compactChangesHistory();
+
     //
     // Данные
     //
@@ -435,6 +449,16 @@ public:
      * @brief Возможность экспортирования для текущего документа
      */
     bool isCurrentDocumentExportAvailable = false;
+
+    /**
+     * @brief Таймер запуска проходов объединения старых изменений документов
+     */
+    QTimer changesCompactionTimer;
+
+    /**
+     * @brief Поток объединения старых изменений документов
+     */
+    DatabaseLayer::DocumentChangesCompactor changesCompactor;
 };
 
 ProjectManager::Implementation::Implementation(ProjectManager* _q, QWidget* _parent,
@@ -1792,6 +1816,35 @@ void ProjectManager::Implementation::updateViewsEditingMode()
     }
 }
 
+void ProjectManager::Implementation::compactChangesHistory()
+{
+    //
+    // Патчи изменений формируются по тэгам модели документа, поэтому объединяем историю только
+    // загруженных документов
+    //
+    QVector<DatabaseLayer::DocumentChangesCompactor::Document> documents;
+    auto models = modelsFacade.loadedModels();
+    models.prepend(projectStructureModel);
+    for (auto model : std::as_const(models)) {
+        if (model->document() == nullptr) {
+            continue;
+        }
+
+        documents.append({ model->document()->uuid(), model->xmlTags() });
+    }
+
+    //
+    // В облачных проектах объединяем только изменения, которые уже отправлены в облако, чтобы
+    // не менять то, что ещё предстоит синхронизировать. В локальных проектах изменения никогда
+    // не отмечаются синхронизированными, а синхронизировать их не с кем, поэтому там
+    // объединяются любые достаточно старые изменения
+    //
+    const auto isSyncedOnly = isProjectRemote;
+    changesCompactor.compact(DatabaseLayer::Database::currentFile(), documents,
+                             QDateTime::currentDateTimeUtc().addDays(-kChangesHistoryRetentionDays),
+                             isSyncedOnly);
+}
+
 
 // ****
 
@@ -1801,6 +1854,11 @@ ProjectManager::ProjectManager(QObject* _parent, QWidget* _parentWidget,
     : QObject(_parent)
     , d(new Implementation(this, _parentWidget, _pluginsBuilder))
 {
+    //
+    // Панели поиска в редакторах ищут текст по индексу документов проекта
+    //
+    d->pluginsBuilder.setSearchIndex(d->modelsFacade.searchIndex());
+
     connect(d->toolBar, &Ui::ProjectToolBar::menuPressed, this, &ProjectManager::menuRequested);
     connect(d->toolBar, &Ui::ProjectToolBar::viewPressed, this, [this](const QString& _mimeType) {
         showView(d->navigator->currentIndex(), _mimeType);
@@ -2419,6 +2477,8 @@ ProjectManager::ProjectManager(QObject* _parent, QWidget* _parentWidget,
             });
     connect(&d->modelsFacade, &ProjectModelsFacade::projectNameChanged, this,
             &ProjectManager::projectNameChanged);
+    connect(&d->modelsFacade, &ProjectModelsFacade::projectCoverChanged, this,
+            &ProjectManager::projectCoverChanged);
     connect(&d->modelsFacade, &ProjectModelsFacade::projectCollaboratorInviteRequested, this,
             &ProjectManager::projectCollaboratorInviteRequested);
     connect(&d->modelsFacade, &ProjectModelsFacade::projectCollaboratorUpdateRequested, this,
@@ -2928,6 +2988,27 @@ ProjectManager::ProjectManager(QObject* _parent, QWidget* _parentWidget,
     connect(&d->collaboratorsUpdateDebouncer, &Debouncer::gotWork, this, [this] {
         setCursors({ d->collaboratorsCursors.begin(), d->collaboratorsCursors.end() });
     });
+
+    //
+    // Старые изменения объединяются в отдельном потоке, а закончив проход ждём до следующего
+    //
+    d->changesCompactionTimer.setSingleShot(true);
+    connect(&d->changesCompactionTimer, &QTimer::timeout, this,
+            [this] { d->compactChangesHistory(); });
+    connect(&d->changesCompactor, &DatabaseLayer::DocumentChangesCompactor::changesMerged, this,
+            [](const QUuid& _documentUuid, const QVector<Domain::Identifier>& _removedChangesIds,
+               const Domain::Identifier& _mergedChangeId) {
+                DataStorageLayer::StorageFacade::documentChangeStorage()
+                    ->forgetMergedDocumentChanges(_documentUuid, _removedChangesIds,
+                                                  _mergedChangeId);
+            });
+    connect(&d->changesCompactor, &DatabaseLayer::DocumentChangesCompactor::compactionFinished,
+            this, [this](qint64 _reclaimedSize) {
+                if (_reclaimedSize > 0) {
+                    Log::info("Changes history compacted, %1 bytes reclaimed", _reclaimedSize);
+                }
+                d->changesCompactionTimer.start(kChangesCompactionPassIntervalMs);
+            });
 }
 
 ProjectManager::~ProjectManager() = default;
@@ -3022,6 +3103,7 @@ void ProjectManager::reconfigureScreenplayNavigator()
 
 void ProjectManager::reconfigureScreenplayDuration()
 {
+    BusinessLayer::ScreenplayChronometer::resetCache();
     for (auto model : d->modelsFacade.loadedModels()) {
         auto screenplayModel = qobject_cast<BusinessLayer::ScreenplayTextModel*>(model);
         if (screenplayModel == nullptr) {
@@ -3054,6 +3136,7 @@ void ProjectManager::reconfigureAudioplayNavigator()
 
 void ProjectManager::reconfigureAudioplayDuration()
 {
+    BusinessLayer::AudioplayChronometer::resetCache();
     for (auto model : d->modelsFacade.loadedModels()) {
         auto audioplayModel = qobject_cast<BusinessLayer::AudioplayTextModel*>(model);
         if (audioplayModel == nullptr) {
@@ -3134,7 +3217,13 @@ void ProjectManager::loadCurrentProject(BusinessLayer::ProjectsModelProjectItem*
     } else {
         emit projectNameChanged(projectInformationModel->name());
         emit projectLoglineChanged(projectInformationModel->logline());
-        emit projectCoverChanged(projectInformationModel->cover());
+        //
+        // Обложка может ещё декодироваться в фоне, в таком случае она будет передана, как только
+        // загрузится, а пока не затираем пустой заглушкой постер проекта в списке проектов
+        //
+        if (!projectInformationModel->cover().isNull()) {
+            emit projectCoverChanged(projectInformationModel->cover());
+        }
     }
     projectInformationModel->setStructureModel(d->projectStructureModel);
 
@@ -3143,10 +3232,20 @@ void ProjectManager::loadCurrentProject(BusinessLayer::ProjectsModelProjectItem*
     //
     restoreCurrentProjectState(_project->path());
 
+    //
+    // ... и загружаем в фоне модели остальных документов, чтобы переход к ним был мгновенным
+    //
+    d->modelsFacade.prefetchModels();
+
     //
     // Обновляем режим редактирования для всех вьюх
     //
     d->updateViewsEditingMode();
+
+    //
+    // Запускаем объединение старых изменений, когда проект уже полностью загружен
+    //
+    d->changesCompactionTimer.start(kChangesCompactionStartDelayMs);
 }
 
 void ProjectManager::updateCurrentProject(BusinessLayer::ProjectsModelProjectItem* _project)
@@ -3238,6 +3337,12 @@ void ProjectManager::closeCurrentProject(const QString& _path)
     d->documentToSyncTimer.clear();
     d->changesForSync.clear();
 
+    //
+    // Останавливаем объединение старых изменений
+    //
+    d->changesCompactionTimer.stop();
+    d->changesCompactor.cancel();
+
     //
     // Очищаем структуру
     //
@@ -1,5 +1,6 @@
 #include "project_models_facade.h"
 
+#include <business_layer/model/abstract_model_item.h>
 #include <business_layer/model/audioplay/audioplay_information_model.h>
 #include <business_layer/model/audioplay/audioplay_statistics_model.h>
 #include <business_layer/model/audioplay/audioplay_synopsis_model.h>
@@ -42,27 +43,128 @@
 #include <business_layer/model/stageplay/text/stageplay_text_model.h>
 #include <business_layer/model/structure/structure_model.h>
 #include <business_layer/model/structure/structure_model_item.h>
+#include <business_layer/model/text/text_model.h>
 #include <business_layer/model/worlds/world_model.h>
 #include <business_layer/model/worlds/worlds_model.h>
+#include <business_layer/search/search_index.h>
 #include <data_layer/storage/document_storage.h>
 #include <data_layer/storage/storage_facade.h>
 #include <domain/document_object.h>
+#include <ui/widgets/task_bar/task_bar.h>
 
+#include <QFutureWatcher>
 #include <QSet>
+#include <QtConcurrentRun>
+
+#include <optional>
 
 
 namespace ManagementLayer {
 
+namespace {
+
+/**
+ * @brief Является ли документ заданного типа текстовым, модель которого можно загрузить в фоне
+ * @note Алиасы, вроде тритмента, не учитываем, т.к. они ссылаются на модели других документов
+ */
+bool isTextDocument(Domain::DocumentObjectType _type)
+{
+    switch (_type) {
+    case Domain::DocumentObjectType::ScreenplayTitlePage:
+    case Domain::DocumentObjectType::ScreenplaySynopsis:
+    case Domain::DocumentObjectType::ScreenplayText:
+    case Domain::DocumentObjectType::ComicBookTitlePage:
+    case Domain::DocumentObjectType::ComicBookSynopsis:
+    case Domain::DocumentObjectType::ComicBookText:
+    case Domain::DocumentObjectType::AudioplayTitlePage:
+    case Domain::DocumentObjectType::AudioplaySynopsis:
+    case Domain::DocumentObjectType::AudioplayText:
+    case Domain::DocumentObjectType::StageplayTitlePage:
+    case Domain::DocumentObjectType::StageplaySynopsis:
+    case Domain::DocumentObjectType::StageplayText:
+    case Domain::DocumentObjectType::NovelTitlePage:
+    case Domain::DocumentObjectType::NovelSynopsis:
+    case Domain::DocumentObjectType::NovelText:
+    case Domain::DocumentObjectType::SimpleText: {
+        return true;
+    }
+
+    default: {
+        return false;
+    }
+    }
+}
+
+} // namespace
+
 class ProjectModelsFacade::Implementation
 {
 public:
     explicit Implementation(BusinessLayer::StructureModel* _projectStructureModel,
                             BusinessLayer::AbstractImageWrapper* _imageWrapper);
 
+    /**
+     * @brief Завершить загрузку модели, содержимое документа которой разбирается в фоне
+     */
+    void finishPreparation(Domain::DocumentObject* _document);
+
+    /**
+     * @brief Прервать загрузку модели, содержимое документа которой разбирается в фоне
+     * @return Модель, загрузка которой прервана
+     */
+    BusinessLayer::AbstractModel* cancelPreparation(Domain::DocumentObject* _document);
+
+    /**
+     * @brief Обновить прогресс предварительной загрузки моделей
+     */
+    void updatePrefetchProgress();
+
 
     BusinessLayer::StructureModel* projectStructureModel = nullptr;
     BusinessLayer::AbstractImageWrapper* imageWrapper = nullptr;
     QHash<Domain::DocumentObject*, BusinessLayer::AbstractModel*> documentsToModels;
+
+    /**
+     * @brief Индекс текста загруженных моделей
+     */
+    BusinessLayer::SearchIndex searchIndex;
+
+    /**
+     * @brief Документ, модель которого нужно загрузить в фоне, а не сразу
+     */
+    Domain::DocumentObject* documentToPrepare = nullptr;
+
+    /**
+     * @brief Прочитанное в фоне содержимое документа и подготовленные из него элементы модели
+     * @note Если содержимое прочитать не удалось, то модель загружается из самого документа
+     */
+    struct PreparedDocument {
+        std::optional<QByteArray> content;
+        QVector<BusinessLayer::AbstractModelItem*> items;
+    };
+
+    /**
+     * @brief Модели, содержимое документов которых сейчас разбирается в фоне
+     */
+    struct PreparingModel {
+        BusinessLayer::AbstractModel* model = nullptr;
+        QFutureWatcher<PreparedDocument>* watcher = nullptr;
+    };
+    QHash<Domain::DocumentObject*, PreparingModel> preparingModels;
+
+    /**
+     * @brief Документы, модели которых осталось предварительно загрузить
+     */
+    QVector<QUuid> prefetchQueue;
+
+    /**
+     * @brief Прогресс предварительной загрузки моделей
+     */
+    struct {
+        QString taskId;
+        int total = 0;
+        int done = 0;
+    } prefetch;
 };
 
 ProjectModelsFacade::Implementation::Implementation(
@@ -73,6 +175,68 @@ ProjectModelsFacade::Implementation::Implementation(
 {
 }
 
+void ProjectModelsFacade::Implementation::finishPreparation(Domain::DocumentObject* _document)
+{
+    if (!preparingModels.contains(_document)) {
+        return;
+    }
+
+    //
+    // Если разбор ещё не был запущен, то он выполнится прямо в текущем потоке
+    //
+    const auto preparingModel = preparingModels.take(_document);
+    preparingModel.watcher->disconnect();
+    const auto preparedDocument = preparingModel.watcher->result();
+    preparingModel.watcher->deleteLater();
+
+    //
+    // Прочитанное в фоне содержимое отдаём документу, чтобы не читать его повторно
+    //
+    if (preparedDocument.content.has_value() && !_document->isContentLoaded()) {
+        _document->setContentLoader([content = *preparedDocument.content] { return content; });
+    }
+    preparingModel.model->setDocument(_document, preparedDocument.items);
+    documentsToModels.insert(_document, preparingModel.model);
+    searchIndex.addModel(preparingModel.model);
+
+    ++prefetch.done;
+    updatePrefetchProgress();
+}
+
+BusinessLayer::AbstractModel* ProjectModelsFacade::Implementation::cancelPreparation(
+    Domain::DocumentObject* _document)
+{
+    if (!preparingModels.contains(_document)) {
+        return nullptr;
+    }
+
+    const auto preparingModel = preparingModels.take(_document);
+    preparingModel.watcher->disconnect();
+    preparingModel.watcher->waitForFinished();
+    qDeleteAll(preparingModel.watcher->result().items);
+    preparingModel.watcher->deleteLater();
+
+    ++prefetch.done;
+    updatePrefetchProgress();
+
+    return preparingModel.model;
+}
+
+void ProjectModelsFacade::Implementation::updatePrefetchProgress()
+{
+    if (prefetch.taskId.isEmpty()) {
+        return;
+    }
+
+    if (prefetchQueue.isEmpty() && preparingModels.isEmpty()) {
+        TaskBar::finishTask(prefetch.taskId);
+        prefetch = {};
+        return;
+    }
+
+    TaskBar::setTaskProgress(prefetch.taskId, prefetch.done * 100.0 / prefetch.total);
+}
+
 
 // ****
 
@@ -92,6 +256,19 @@ ProjectModelsFacade::~ProjectModelsFacade()
 
 void ProjectModelsFacade::clear()
 {
+    //
+    // Прерываем загрузку моделей, которые ещё не успели загрузиться
+    //
+    d->prefetchQueue.clear();
+    d->updatePrefetchProgress();
+    for (auto document : d->preparingModels.keys()) {
+        auto model = d->cancelPreparation(document);
+        model->disconnect();
+        delete model;
+    }
+
+    d->searchIndex.clear();
+
     //
     // Формируем список моделей для удаления, т.к. некоторые модели являются лишь ссылками на другие
     // модели, например модель тритмента - это ссылка на модель текста сценария
@@ -138,6 +315,16 @@ BusinessLayer::AbstractModel* ProjectModelsFacade::modelFor(Domain::DocumentObje
 
     while (!documentsToLoad.isEmpty()) {
         auto documentToLoad = documentsToLoad.takeFirst();
+        //
+        // Если модель документа уже загружается в фоне, то дожидаемся окончания загрузки
+        //
+        if (d->preparingModels.contains(documentToLoad)) {
+            d->finishPreparation(documentToLoad);
+            QMetaObject::invokeMethod(this, &ProjectModelsFacade::prefetchNextModel,
+                                      Qt::QueuedConnection);
+            continue;
+        }
+
         //
         // Является ли документы алиасом к другому, если да, то не исопльзуем его контент
         //
@@ -151,6 +338,9 @@ BusinessLayer::AbstractModel* ProjectModelsFacade::modelFor(Domain::DocumentObje
                 connect(projectInformationModel,
                         &BusinessLayer::ProjectInformationModel::nameChanged, this,
                         &ProjectModelsFacade::projectNameChanged, Qt::UniqueConnection);
+                connect(projectInformationModel,
+                        &BusinessLayer::ProjectInformationModel::coverChanged, this,
+                        &ProjectModelsFacade::projectCoverChanged, Qt::UniqueConnection);
                 connect(projectInformationModel,
                         &BusinessLayer::ProjectInformationModel::collaboratorInviteRequested, this,
                         &ProjectModelsFacade::projectCollaboratorInviteRequested,
@@ -1385,8 +1575,45 @@ BusinessLayer::AbstractModel* ProjectModelsFacade::modelFor(Domain::DocumentObje
             // Если документ не является алиасом, то загрузим из него модели и соединим модель со
             // всеми необходимыми обработчиками событий модели
             //
+            const bool isPreparing = documentToLoad == d->documentToPrepare
+                && qobject_cast<BusinessLayer::TextModel*>(model) != nullptr;
             if (!isDocumentAlias) {
-                model->setDocument(documentToLoad);
+                //
+                // Содержимое текстовых документов при предварительной загрузке разбираем в фоне,
+                // а сам документ зададим модели, когда разбор закончится
+                //
+                if (isPreparing) {
+                    using PreparedDocument = Implementation::PreparedDocument;
+                    auto watcher = new QFutureWatcher<PreparedDocument>(this);
+                    connect(watcher, &QFutureWatcher<PreparedDocument>::finished, this,
+                            [this, documentToLoad] {
+                                d->finishPreparation(documentToLoad);
+                                prefetchNextModel();
+                            });
+                    //
+                    // Ещё не загруженное содержимое читаем в фоне через отдельное соединение
+                    //
+                    auto contentLoader
+                        = DataStorageLayer::StorageFacade::documentStorage()
+                              ->concurrentContentLoader(documentToLoad);
+                    if (!contentLoader) {
+                        contentLoader = [content = documentToLoad->content()] {
+                            return std::optional<QByteArray>(content);
+                        };
+                    }
+                    watcher->setFuture(QtConcurrent::run([model, contentLoader] {
+                        PreparedDocument preparedDocument;
+                        preparedDocument.content = contentLoader();
+                        if (preparedDocument.content.has_value()) {
+                            preparedDocument.items
+                                = model->prepareItems(*preparedDocument.content);
+                        }
+                        return preparedDocument;
+                    }));
+                    d->preparingModels.insert(documentToLoad, { model, watcher });
+                } else {
+                    model->setDocument(documentToLoad);
+                }
 
                 connect(
                     model, &BusinessLayer::AbstractModel::documentNameChanged, this,
@@ -1405,7 +1632,10 @@ BusinessLayer::AbstractModel* ProjectModelsFacade::modelFor(Domain::DocumentObje
                         [this, model] { emit modelRemoveRequested(model); });
             }
 
-            d->documentsToModels.insert(documentToLoad, model);
+            if (!isPreparing || isDocumentAlias) {
+                d->documentsToModels.insert(documentToLoad, model);
+                d->searchIndex.addModel(model);
+            }
         }
     }
 
@@ -1428,13 +1658,102 @@ QVector<BusinessLayer::AbstractModel*> ProjectModelsFacade::modelsFor(
     return models;
 }
 
+void ProjectModelsFacade::prefetchModels()
+{
+    //
+    // Собираем текстовые документы в порядке их следования в структуре, не заглядывая в корзину
+    //
+    QVector<QUuid> documents;
+    std::function<void(BusinessLayer::StructureModelItem*)> collectDocuments;
+    collectDocuments = [&documents, &collectDocuments](BusinessLayer::StructureModelItem* _item) {
+        for (int childIndex = 0; childIndex < _item->childCount(); ++childIndex) {
+            const auto childItem = _item->childAt(childIndex);
+            if (childItem->type() == Domain::DocumentObjectType::RecycleBin) {
+                continue;
+            }
+
+            if (isTextDocument(childItem->type())) {
+                documents.append(childItem->uuid());
+            }
+            collectDocuments(childItem);
+        }
+    };
+    collectDocuments(d->projectStructureModel->itemForIndex({}));
+
+    if (documents.isEmpty()) {
+        return;
+    }
+
+    //
+    // Отображаем прогресс загрузки, пока не будут загружены все модели
+    //
+    if (d->prefetch.taskId.isEmpty()) {
+        d->prefetch.taskId = QUuid::createUuid().toString();
+        TaskBar::addTask(d->prefetch.taskId);
+        TaskBar::setTaskTitle(d->prefetch.taskId, tr("Loading documents"));
+    }
+    d->prefetchQueue.append(documents);
+    d->prefetch.total = d->prefetch.done + d->prefetchQueue.size() + d->preparingModels.size();
+    d->updatePrefetchProgress();
+
+    //
+    // Загружать модели начинаем, когда завершится открытие проекта
+    //
+    QMetaObject::invokeMethod(this, &ProjectModelsFacade::prefetchNextModel,
+                              Qt::QueuedConnection);
+}
+
+void ProjectModelsFacade::prefetchNextModel()
+{
+    //
+    // Модели загружаются по одной, поэтому пока не загружена предыдущая, следующую не начинаем
+    //
+    if (!d->preparingModels.isEmpty()) {
+        return;
+    }
+
+    while (!d->prefetchQueue.isEmpty()) {
+        const auto document = DataStorageLayer::StorageFacade::documentStorage()->document(
+            d->prefetchQueue.takeFirst());
+        if (document == nullptr || d->documentsToModels.contains(document)) {
+            ++d->prefetch.done;
+            continue;
+        }
+
+        d->documentToPrepare = document;
+        modelFor(document);
+        d->documentToPrepare = nullptr;
+
+        //
+        // Как только разбор содержимого запущен, ждём его окончания, а прогресс будет обновлён
+        // при завершении загрузки модели
+        //
+        if (!d->preparingModels.isEmpty()) {
+            return;
+        }
+
+        ++d->prefetch.done;
+    }
+
+    d->updatePrefetchProgress();
+}
+
 void ProjectModelsFacade::removeModelFor(Domain::DocumentObject* _document)
 {
+    if (auto model = d->cancelPreparation(_document); model != nullptr) {
+        model->disconnect();
+        model->deleteLater();
+        QMetaObject::invokeMethod(this, &ProjectModelsFacade::prefetchNextModel,
+                                  Qt::QueuedConnection);
+        return;
+    }
+
     if (!d->documentsToModels.contains(_document)) {
         return;
     }
 
     auto model = d->documentsToModels.take(_document);
+    d->searchIndex.removeModel(model);
     model->disconnect();
     model->clear();
     model->deleteLater();
@@ -1470,4 +1789,9 @@ QVector<Domain::DocumentObject*> ProjectModelsFacade::loadedDocuments() const
     return documents;
 }
 
+BusinessLayer::SearchIndex* ProjectModelsFacade::searchIndex() const
+{
+    return &d->searchIndex;
+}
+
 } // namespace ManagementLayer
@@ -6,6 +6,7 @@
 namespace BusinessLayer {
 class AbstractImageWrapper;
 class AbstractModel;
+class SearchIndex;
 class StructureModel;
 } // namespace BusinessLayer
 
@@ -47,6 +48,15 @@ public:
      */
     QVector<BusinessLayer::AbstractModel*> modelsFor(Domain::DocumentObjectType _type);
 
+    /**
+     * @brief Заранее загрузить модели текстовых документов проекта
+     * @note Модели загружаются по одной в порядке следования документов в структуре проекта,
+     *       их содержимое читается и разбирается в фоновом потоке, а модели, запрошенные до
+     *       окончания загрузки, догружаются сразу. Модели остальных документов загружаются при
+     *       первом обращении к ним
+     */
+    void prefetchModels();
+
     /**
      * @brief Удалить модель для заданного документа
      */
@@ -63,6 +73,12 @@ public:
      */
     QVector<Domain::DocumentObject*> loadedDocuments() const;
 
+    /**
+     * @brief Получить индекс для поиска по тексту загруженных документов
+     * @note Сами модели индексируются только при первом поиске
+     */
+    BusinessLayer::SearchIndex* searchIndex() const;
+
 signals:
     /**
      * @brief Изменилось название модели
@@ -229,6 +245,11 @@ signals:
     void emptyRecycleBinRequested();
 
 private:
+    /**
+     * @brief Запустить загрузку модели следующего документа из очереди предварительной загрузки
+     */
+    void prefetchNextModel();
+
     class Implementation;
     QScopedPointer<Implementation> d;
 };
@@ -1160,6 +1160,20 @@ void ProjectsManager::setCurrentProject(const QString& _path, const QString& _re
     const QString projectPath = QDir::toNativeSeparators(_path);
     const QString projectRealPath = QDir::toNativeSeparators(_realPath);
 
+    //
+    // Параметры хранения данных задаём до открытия файла, т.к. они применяются при открытии
+    //
+    auto storageProfile = DatabaseLayer::Database::storageProfile();
+    storageProfile.useWriteAheadLog
+        = settingsValue(DataStorageLayer::kApplicationUseWriteAheadLogKey).toBool();
+    storageProfile.cacheSizeKib
+        = settingsValue(DataStorageLayer::kApplicationStorageCacheSizeKey).toInt();
+    storageProfile.mmapSize
+        = settingsValue(DataStorageLayer::kApplicationStorageMmapSizeKey).toLongLong();
+    storageProfile.compressDocumentsContent
+        = settingsValue(DataStorageLayer::kApplicationCompressDocumentsContentKey).toBool();
+    DatabaseLayer::Database::setStorageProfile(storageProfile);
+
     //
     // Делаем проект текущим и загружаем из него БД
     // или создаём, если ранее его не существовало
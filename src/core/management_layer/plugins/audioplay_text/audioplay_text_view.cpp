@@ -975,6 +975,11 @@ void AudioplayTextView::setCurrentModelIndex(const QModelIndex& _index)
     d->textEdit->setCurrentModelIndex(_index);
 }
 
+void AudioplayTextView::setSearchIndex(BusinessLayer::SearchIndex* _index)
+{
+    d->searchManager->setSearchIndex(_index);
+}
+
 void AudioplayTextView::setAvailableCredits(int _credits)
 {
     d->aiAssistantView->setAvailableWords(_credits);
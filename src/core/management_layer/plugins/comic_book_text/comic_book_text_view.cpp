@@ -963,6 +963,11 @@ void ComicBookTextView::setCurrentModelIndex(const QModelIndex& _index)
     d->textEdit->setCurrentModelIndex(_index);
 }
 
+void ComicBookTextView::setSearchIndex(BusinessLayer::SearchIndex* _index)
+{
+    d->searchManager->setSearchIndex(_index);
+}
+
 void ComicBookTextView::setAvailableCredits(int _credits)
 {
     d->aiAssistantView->setAvailableWords(_credits);
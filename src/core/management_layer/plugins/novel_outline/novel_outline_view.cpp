@@ -1365,6 +1365,11 @@ void NovelOutlineView::setCurrentModelIndex(const QModelIndex& _index)
     d->textEdit->setCurrentModelIndex(_index);
 }
 
+void NovelOutlineView::setSearchIndex(BusinessLayer::SearchIndex* _index)
+{
+    d->searchManager->setSearchIndex(_index);
+}
+
 void NovelOutlineView::setAvailableCredits(int _credits)
 {
     d->aiAssistantView->setAvailableWords(_credits);
@@ -1386,6 +1386,11 @@ void NovelTextView::setCurrentModelIndex(const QModelIndex& _index)
     d->textEdit->setCurrentModelIndex(_index);
 }
 
+void NovelTextView::setSearchIndex(BusinessLayer::SearchIndex* _index)
+{
+    d->searchManager->setSearchIndex(_index);
+}
+
 void NovelTextView::setAvailableCredits(int _credits)
 {
     d->aiAssistantView->setAvailableWords(_credits);
@@ -1480,6 +1480,11 @@ void ScreenplayTextView::setCurrentModelIndex(const QModelIndex& _index)
     d->textEdit->setCurrentModelIndex(_index);
 }
 
+void ScreenplayTextView::setSearchIndex(BusinessLayer::SearchIndex* _index)
+{
+    d->searchManager->setSearchIndex(_index);
+}
+
 void ScreenplayTextView::setAvailableCredits(int _credits)
 {
     d->aiAssistantView->setAvailableWords(_credits);
@@ -33,6 +33,7 @@ public:
     void setCursors(const QVector<Domain::CursorInfo>& _cursors) override;
     void setCurrentCursor(const Domain::CursorInfo& _cursor) override;
     void setCurrentModelIndex(const QModelIndex& _index) override;
+    void setSearchIndex(BusinessLayer::SearchIndex* _index) override;
     void setAvailableCredits(int _credits) override;
     void setRephrasedText(const QString& _text) override;
     void setExpandedText(const QString& _text) override;
@@ -80,6 +80,36 @@ public:
      */
     void updateReviewMark(QKeyEvent* _event, int _from, int _to);
 
+    /**
+     * @brief Декорации блока, не зависящие от его положения на экране
+     */
+    struct BlockDecorations {
+        /**
+         * @brief Ревизия блока, для которой были определены декорации
+         */
+        int revision = -1;
+
+        QVector<QColor> sceneColors;
+        QColor beatColor;
+        QPointer<BusinessLayer::CharacterModel> character;
+        QString sceneNumber;
+        QString dialogueNumber;
+        QString groupTitle;
+        BusinessLayer::TextModelTextItem::Bookmark bookmark;
+    };
+
+    /**
+     * @brief Получить декорации блока
+     * @note Декорации кэшируются, т.к. определение каждой из них требует обращения к модели, а
+     *       делать это при каждой перерисовке для всех блоков на экране слишком дорого
+     */
+    const BlockDecorations& blockDecorations(const QTextBlock& _block) const;
+
+    /**
+     * @brief Сбросить кэш декораций блоков
+     */
+    void resetDecorationsCache();
+
 
     ScreenplayTextEdit* q = nullptr;
 
@@ -101,6 +131,18 @@ public:
     QVector<Domain::CursorInfo> collaboratorsCursorInfo;
     QVector<Domain::CursorInfo> pendingCollaboratorsCursorInfo;
     Debouncer collaboratorCursorInfoUpdateDebouncer;
+
+    /**
+     * @brief Кэш декораций блоков, ключом является пользовательские данные блока
+     * @note Сбрасывается при любых изменениях модели, а содержимое отдельных блоков
+     *       дополнительно проверяется по их ревизии
+     */
+    mutable QHash<const QTextBlockUserData*, BlockDecorations> decorationsCache;
+
+    /**
+     * @brief Декорации блока без пользовательских данных, который нельзя закэшировать
+     */
+    mutable BlockDecorations uncachedDecorations;
 };
 
 ScreenplayTextEdit::Implementation::Implementation(ScreenplayTextEdit* _q)
@@ -123,6 +165,60 @@ const BusinessLayer::ScreenplayTemplate& ScreenplayTextEdit::Implementation::scr
     return TemplatesFacade::screenplayTemplate(currentTemplateId);
 }
 
+const ScreenplayTextEdit::Implementation::BlockDecorations& ScreenplayTextEdit::Implementation::
+    blockDecorations(const QTextBlock& _block) const
+{
+    auto& decorations = _block.userData() != nullptr ? decorationsCache[_block.userData()]
+                                                     : uncachedDecorations;
+    if (_block.userData() != nullptr && decorations.revision == _block.revision()) {
+        return decorations;
+    }
+
+    decorations = {};
+    decorations.revision = _block.revision();
+    const auto blockType = TextBlockStyle::forBlock(_block);
+    switch (blockType) {
+    case TextParagraphType::SceneHeading:
+    case TextParagraphType::SequenceHeading:
+    case TextParagraphType::ActHeading:
+    case TextParagraphType::SequenceFooter:
+    case TextParagraphType::ActFooter: {
+        decorations.sceneColors = document.itemColors(_block);
+        break;
+    }
+
+    case TextParagraphType::BeatHeading: {
+        decorations.beatColor = document.itemColor(_block);
+        break;
+    }
+
+    case TextParagraphType::Character: {
+        if (model && model->charactersList() != nullptr) {
+            decorations.character
+                = model->character(BusinessLayer::ScreenplayCharacterParser::name(_block.text()));
+        }
+        decorations.dialogueNumber = document.dialogueNumber(_block);
+        break;
+    }
+
+    default: {
+        break;
+    }
+    }
+    if (blockType == TextParagraphType::SceneHeading) {
+        decorations.sceneNumber = document.sceneNumber(_block);
+        decorations.groupTitle = document.groupTitle(_block);
+    }
+    decorations.bookmark = document.bookmark(_block);
+
+    return decorations;
+}
+
+void ScreenplayTextEdit::Implementation::resetDecorationsCache()
+{
+    decorationsCache.clear();
+}
+
 void ScreenplayTextEdit::Implementation::revertAction(bool previous)
 {
     if (model == nullptr) {
@@ -293,8 +389,12 @@ void ScreenplayTextEdit::initWithModel(BusinessLayer::ScreenplayTextModel* _mode
         if (d->model->informationModel()) {
             d->model->informationModel()->disconnect(this);
         }
+        if (d->model->charactersList()) {
+            d->model->charactersList()->disconnect(this);
+        }
     }
     d->model = _model;
+    d->resetDecorationsCache();
 
     //
     // Сбрасываем модель, чтобы не вылезали изменения документа при изменении параметров страницы
@@ -335,6 +435,25 @@ void ScreenplayTextEdit::initWithModel(BusinessLayer::ScreenplayTextModel* _mode
                 &ScreenplayTextEdit::setFooter);
     }
     //
+    // Декорации блоков зависят от данных модели и списка персонажей, поэтому при их изменении
+    // сбрасываем закэшированные декорации
+    //
+    if (d->model) {
+        auto resetDecorationsCache = [this] { d->resetDecorationsCache(); };
+        for (auto model : std::initializer_list<QAbstractItemModel*>{
+                 d->model.data(), d->model->charactersList() }) {
+            if (model == nullptr) {
+                continue;
+            }
+
+            connect(model, &QAbstractItemModel::dataChanged, this, resetDecorationsCache);
+            connect(model, &QAbstractItemModel::rowsInserted, this, resetDecorationsCache);
+            connect(model, &QAbstractItemModel::rowsRemoved, this, resetDecorationsCache);
+            connect(model, &QAbstractItemModel::rowsMoved, this, resetDecorationsCache);
+            connect(model, &QAbstractItemModel::modelReset, this, resetDecorationsCache);
+        }
+    }
+    //
     // Добавляем словарные термины в список исключений для проверки орфографии
     //
     if (d->model && d->model->dictionariesModel()) {
@@ -978,6 +1097,10 @@ void ScreenplayTextEdit::paintEvent(QPaintEvent* _event)
             // Стиль текущего блока
             //
             const auto blockType = TextBlockStyle::forBlock(block);
+            //
+            // ... и его декорации
+            //
+            const auto& decorations = d->blockDecorations(block);
 
             //
             // Запоминаем информацию о бите
@@ -985,7 +1108,7 @@ void ScreenplayTextEdit::paintEvent(QPaintEvent* _event)
             if (blockType == TextParagraphType::BeatHeading) {
                 lastBeat.isPainted = false;
                 lastBeat.text = block.text();
-                lastBeat.color = d->document.itemColor(block);
+                lastBeat.color = decorations.beatColor;
                 if (!lastBeat.color.isValid()) {
                     lastBeat.color = palette().text().color();
                 }
@@ -1026,7 +1149,7 @@ void ScreenplayTextEdit::paintEvent(QPaintEvent* _event)
             case TextParagraphType::ActFooter: {
                 previousSceneBlockBottom = lastSceneBlockBottom;
                 lastSceneBlockBottom = cursorR.top();
-                lastSceneColors = d->document.itemColors(block);
+                lastSceneColors = decorations.sceneColors;
                 lastBeat = {};
                 break;
             }
@@ -1069,9 +1192,7 @@ void ScreenplayTextEdit::paintEvent(QPaintEvent* _event)
             if (blockType == TextParagraphType::Character && d->model
                 && d->model->charactersList() != nullptr) {
                 lastCharacterColor = QColor();
-                const QString characterName
-                    = BusinessLayer::ScreenplayCharacterParser::name(block.text());
-                if (auto character = d->model->character(characterName)) {
+                if (const auto character = decorations.character) {
                     if (character->color().isValid()) {
                         lastCharacterColor = character->color();
                     }
@@ -1134,7 +1255,7 @@ void ScreenplayTextEdit::paintEvent(QPaintEvent* _event)
                 //
                 // Прорисовка закладок
                 //
-                const auto bookmark = d->document.bookmark(block);
+                const auto& bookmark = decorations.bookmark;
                 if (bookmark.isValid()) {
                     setPainterPen(bookmark.color);
                     painter.setFont(DesignSystem::font().iconsForEditors());
@@ -1275,7 +1396,7 @@ void ScreenplayTextEdit::paintEvent(QPaintEvent* _event)
                     // Для заголовка сцены, если он не задан, рисуем название сцены
                     //
                     if (blockType == BusinessLayer::TextParagraphType::SceneHeading) {
-                        const auto title = d->document.groupTitle(block);
+                        const auto& title = decorations.groupTitle;
                         if (!title.isEmpty()) {
                             painter.setFont(block.charFormat().font());
                             const auto rect = textRect();
@@ -1342,7 +1463,7 @@ void ScreenplayTextEdit::paintEvent(QPaintEvent* _event)
                         //
                         // Определим номер сцены
                         //
-                        const auto sceneNumber = d->document.sceneNumber(block);
+                        const auto& sceneNumber = decorations.sceneNumber;
                         if (!sceneNumber.isEmpty()) {
                             setPainterPen(palette().text().color());
                             auto font = cursor.charFormat().font();
@@ -1382,7 +1503,7 @@ void ScreenplayTextEdit::paintEvent(QPaintEvent* _event)
                         //
                         // Определим номер реплики
                         //
-                        const auto dialogueNumber = d->document.dialogueNumber(block);
+                        const auto& dialogueNumber = decorations.dialogueNumber;
                         if (!dialogueNumber.isEmpty()) {
                             setPainterPen(palette().text().color());
                             painter.setFont(cursor.charFormat().font());
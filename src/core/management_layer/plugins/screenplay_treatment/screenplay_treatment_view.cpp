@@ -1391,6 +1391,11 @@ void ScreenplayTreatmentView::setCurrentModelIndex(const QModelIndex& _index)
     d->textEdit->setCurrentModelIndex(_index);
 }
 
+void ScreenplayTreatmentView::setSearchIndex(BusinessLayer::SearchIndex* _index)
+{
+    d->searchManager->setSearchIndex(_index);
+}
+
 void ScreenplayTreatmentView::setAvailableCredits(int _credits)
 {
     d->aiAssistantView->setAvailableWords(_credits);
@@ -934,6 +934,11 @@ void SimpleTextView::setCurrentModelIndex(const QModelIndex& _index)
     d->textEdit->setCurrentModelIndex(_index);
 }
 
+void SimpleTextView::setSearchIndex(BusinessLayer::SearchIndex* _index)
+{
+    d->searchManager->setSearchIndex(_index);
+}
+
 void SimpleTextView::setAvailableCredits(int _credits)
 {
     d->aiAssistantView->setAvailableWords(_credits);
@@ -360,6 +360,11 @@ public:
      * @brief Количество кредитов доступных для использования с ИИ инструментами
      */
     int availableCredits = 0;
+
+    /**
+     * @brief Индекс для поиска по тексту документов проекта
+     */
+    BusinessLayer::SearchIndex* searchIndex = nullptr;
 };
 
 Ui::IDocumentView* PluginsBuilder::Implementation::activatePlugin(
@@ -470,6 +475,10 @@ Ui::IDocumentView* PluginsBuilder::Implementation::activatePlugin(
     // ... а также доступные кредиты для работы с ИИ
     //
     view->setAvailableCredits(availableCredits);
+    //
+    // ... и индекс для поиска по тексту
+    //
+    view->setSearchIndex(searchIndex);
 
     return view;
 }
@@ -1075,6 +1084,11 @@ void PluginsBuilder::setAvailableCredits(int _credits) const
     }
 }
 
+void PluginsBuilder::setSearchIndex(BusinessLayer::SearchIndex* _index) const
+{
+    d->searchIndex = _index;
+}
+
 void PluginsBuilder::resetModels() const
 {
     for (auto plugin : std::as_const(d->plugins)) {
@@ -8,6 +8,7 @@ class QUuid;
 
 namespace BusinessLayer {
 class AbstractModel;
+class SearchIndex;
 }
 
 namespace Domain {
@@ -147,6 +148,11 @@ public:
      */
     void setAvailableCredits(int _credits) const;
 
+    /**
+     * @brief Задать индекс для поиска по тексту документов проекта
+     */
+    void setSearchIndex(BusinessLayer::SearchIndex* _index) const;
+
     /**
      * @brief Сбросить модели для всех плагинов
      */
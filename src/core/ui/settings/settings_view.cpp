@@ -4028,6 +4028,10 @@ void SettingsView::updateTranslations()
            "It saves the project every 3 seconds if you do not use your mouse or keyboard.\n"
            "If you work with no interruptions it saves the project every 3 minutes."));
     d->saveBackups->setText(tr("Save backups"));
+    d->saveBackups->setToolTip(
+        tr("Backups share documents texts and history stored in the \"<project>.contents\" "
+           "folder next to them.\nKeep this folder when you copy or move backups, without it "
+           "they can't be restored."));
     d->backupsFolderPath->setLabel(tr("Backups folder path"));
     d->backupsQty->setLabel(tr("Qty"));
     d->applicationTextEditingTitle->setText(tr("Text editing"));
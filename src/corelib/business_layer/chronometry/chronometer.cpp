@@ -8,9 +8,15 @@
 #include <utils/helpers/measurement_helper.h>
 #include <utils/helpers/text_helper.h>
 
-#include <QTextBlock>
+#include <QCache>
+#include <QFontMetricsF>
+#include <QMutex>
+#include <QSharedPointer>
 #include <QtMath>
 
+#include <functional>
+#include <optional>
+
 
 namespace BusinessLayer {
 
@@ -23,26 +29,109 @@ class AbstractChronometer
 {
 public:
     virtual ~AbstractChronometer() = default;
-    virtual std::chrono::milliseconds duration(TextParagraphType _type, const QString& _text,
-                                               const TextTemplate& _textTemplate) const = 0;
+
+    /**
+     * @brief Определить длительность блока
+     * @note Вычислитель не меняется после создания, поэтому может использоваться из любого потока
+     */
+    virtual std::chrono::milliseconds duration(TextParagraphType _type,
+                                               const QString& _text) const = 0;
 };
 
 /**
- * @brief Расчёт хронометража по количеству страниц
+ * @brief Ширины символов шрифта для быстрого разбиения текста на строки
  */
-class PageChronometer : public AbstractChronometer
+class FontAdvances
 {
 public:
-    explicit PageChronometer(int _secondsPerPage)
-        : m_secondsPerPage(_secondsPerPage)
+    explicit FontAdvances(const QFont& _font)
+        : m_font(_font)
     {
+        const QFontMetricsF metrics(m_font);
+        m_advances.resize(kAdvancesTableSize);
+        for (int character = 0; character < kAdvancesTableSize; ++character) {
+            m_advances[character] = metrics.horizontalAdvance(QChar(character));
+        }
     }
 
-    std::chrono::milliseconds duration(TextParagraphType _type, const QString& _text,
-                                       const TextTemplate& _textTemplate) const override
+    /**
+     * @brief Определить количество строк, которое займёт текст при заданной ширине
+     * @note Текст переносится по границам слов, как это делает QTextLayout
+     */
+    int linesCount(const QString& _text, qreal _width) const
     {
-        const auto milliseconds = m_secondsPerPage * 1000;
+        //
+        // Метрики создаём только, если в тексте встретились символы, которых нет в таблице
+        //
+        std::optional<QFontMetricsF> metrics;
+        const auto advance = [this, &metrics](const QChar& _character) {
+            if (_character.unicode() < kAdvancesTableSize) {
+                return m_advances.at(_character.unicode());
+            }
+
+            if (!metrics.has_value()) {
+                metrics.emplace(m_font);
+            }
+            return metrics->horizontalAdvance(_character);
+        };
+
+        int lines = 1;
+        qreal lineWidth = 0.0;
+        int index = 0;
+        while (index < _text.length()) {
+            if (_text.at(index) == '\n' || _text.at(index) == QChar::LineSeparator) {
+                ++lines;
+                lineWidth = 0.0;
+                ++index;
+                continue;
+            }
+
+            //
+            // Пробелы перед словом остаются в конце строки, если слово на неё не влезает
+            //
+            qreal spacesWidth = 0.0;
+            for (; index < _text.length() && _text.at(index) == ' '; ++index) {
+                spacesWidth += advance(_text.at(index));
+            }
+            qreal wordWidth = 0.0;
+            for (; index < _text.length() && _text.at(index) != ' ' && _text.at(index) != '\n'
+                 && _text.at(index) != QChar::LineSeparator;
+                 ++index) {
+                wordWidth += advance(_text.at(index));
+            }
+
+            if (lineWidth > 0.0 && lineWidth + spacesWidth + wordWidth > _width) {
+                ++lines;
+                lineWidth = wordWidth;
+            } else {
+                lineWidth += spacesWidth + wordWidth;
+            }
+        }
+        return lines;
+    }
+
+private:
+    /**
+     * @brief Размер таблицы ширин, покрывающей латиницу, греческий алфавит и кириллицу
+     */
+    static constexpr int kAdvancesTableSize = 0x0500;
+
+    const QFont m_font;
+    QVector<qreal> m_advances;
+};
 
+/**
+ * @brief Расчёт хронометража по количеству страниц
+ */
+class PageChronometer : public AbstractChronometer
+{
+public:
+    PageChronometer(int _secondsPerPage, const TextTemplate& _textTemplate)
+        : m_secondsPerPage(_secondsPerPage)
+    {
+        //
+        // Заранее рассчитываем геометрию страницы и блоков всех типов
+        //
         const auto mmPageSize
             = QPageSize(_textTemplate.pageSizeId()).rect(QPageSize::Millimeter).size();
         const bool x = true, y = false;
@@ -53,27 +142,55 @@ public:
                                              MeasurementHelper::mmToPx(mmPageMargins.top(), y),
                                              MeasurementHelper::mmToPx(mmPageMargins.right(), x),
                                              MeasurementHelper::mmToPx(mmPageMargins.bottom(), y));
-        const auto pageHeight = pxPageSize.height() - pxPageMargins.top() - pxPageMargins.bottom();
-
-        const auto& blockStyle = _textTemplate.paragraphStyle(_type);
-        const auto mmBlockMargins = blockStyle.margins();
-        const auto pxBlockMargins
-            = QMarginsF(MeasurementHelper::mmToPx(mmBlockMargins.left(), x),
-                        MeasurementHelper::mmToPx(mmBlockMargins.top(), y),
-                        MeasurementHelper::mmToPx(mmBlockMargins.right(), x),
-                        MeasurementHelper::mmToPx(mmBlockMargins.bottom(), y));
-        const auto textWidth = pxPageSize.width() - pxPageMargins.left() - pxPageMargins.right()
-            - pxBlockMargins.left() - pxBlockMargins.right();
-        const auto textLineHeight = TextHelper::fineLineSpacing(blockStyle.font());
-        const auto textHeight = TextHelper::heightForWidth(_text, blockStyle.font(), textWidth)
-            + pxBlockMargins.top() + pxBlockMargins.bottom()
-            + blockStyle.linesBefore() * textLineHeight + blockStyle.linesAfter() * textLineHeight;
+        m_pageHeight = pxPageSize.height() - pxPageMargins.top() - pxPageMargins.bottom();
+
+        QHash<QString, QSharedPointer<FontAdvances>> fontsAdvances;
+        for (int type = static_cast<int>(TextParagraphType::Undefined) + 1;
+             type <= static_cast<int>(TextParagraphType::Text); ++type) {
+            const auto& blockStyle
+                = _textTemplate.paragraphStyle(static_cast<TextParagraphType>(type));
+            const auto mmBlockMargins = blockStyle.margins();
+            const auto pxBlockMargins
+                = QMarginsF(MeasurementHelper::mmToPx(mmBlockMargins.left(), x),
+                            MeasurementHelper::mmToPx(mmBlockMargins.top(), y),
+                            MeasurementHelper::mmToPx(mmBlockMargins.right(), x),
+                            MeasurementHelper::mmToPx(mmBlockMargins.bottom(), y));
+
+            ParagraphMetrics metrics;
+            metrics.textWidth = pxPageSize.width() - pxPageMargins.left()
+                - pxPageMargins.right() - pxBlockMargins.left() - pxBlockMargins.right();
+            metrics.lineHeight = TextHelper::fineLineSpacing(blockStyle.font());
+            metrics.additionalHeight = pxBlockMargins.top() + pxBlockMargins.bottom()
+                + blockStyle.linesBefore() * metrics.lineHeight
+                + blockStyle.linesAfter() * metrics.lineHeight;
+            const auto fontKey = blockStyle.font().key();
+            if (!fontsAdvances.contains(fontKey)) {
+                fontsAdvances.insert(fontKey,
+                                     QSharedPointer<FontAdvances>::create(blockStyle.font()));
+            }
+            metrics.fontAdvances = fontsAdvances.value(fontKey);
+            m_paragraphsMetrics.insert(static_cast<TextParagraphType>(type), metrics);
+        }
+    }
+
+    std::chrono::milliseconds duration(TextParagraphType _type,
+                                       const QString& _text) const override
+    {
+        const auto metrics = m_paragraphsMetrics.value(_type);
+        if (metrics.fontAdvances.isNull()) {
+            return {};
+        }
+
+        const auto milliseconds = m_secondsPerPage * 1000;
+        const auto textHeight
+            = metrics.fontAdvances->linesCount(_text, metrics.textWidth) * metrics.lineHeight
+            + metrics.additionalHeight;
 
         //
         // Добавляем небольшую дельту, т.к. из-за приблизительности рассчётов не удаётся попадать
         // точно в минуты
         //
-        return std::chrono::milliseconds{ qCeil(textHeight / pageHeight * milliseconds * 1.01) };
+        return std::chrono::milliseconds{ qCeil(textHeight / m_pageHeight * milliseconds * 1.01) };
     }
 
 private:
@@ -81,6 +198,22 @@ private:
      * @brief Секунд на страницу
      */
     const int m_secondsPerPage = 60;
+
+    /**
+     * @brief Высота области текста на странице
+     */
+    qreal m_pageHeight = 1.0;
+
+    /**
+     * @brief Параметры блоков каждого из типов
+     */
+    struct ParagraphMetrics {
+        qreal textWidth = 0.0;
+        qreal lineHeight = 0.0;
+        qreal additionalHeight = 0.0;
+        QSharedPointer<FontAdvances> fontAdvances;
+    };
+    QHash<TextParagraphType, ParagraphMetrics> m_paragraphsMetrics;
 };
 
 /**
@@ -96,11 +229,10 @@ public:
     {
     }
 
-    std::chrono::milliseconds duration(TextParagraphType _type, const QString& _text,
-                                       const TextTemplate& _textTemplate) const override
+    std::chrono::milliseconds duration(TextParagraphType _type,
+                                       const QString& _text) const override
     {
         Q_UNUSED(_type)
-        Q_UNUSED(_textTemplate)
 
         auto text = _text;
         if (!m_considerSpaces) {
@@ -141,11 +273,10 @@ public:
     {
     }
 
-    std::chrono::milliseconds duration(TextParagraphType _type, const QString& _text,
-                                       const TextTemplate& _textTemplate) const override
+    std::chrono::milliseconds duration(TextParagraphType _type,
+                                       const QString& _text) const override
     {
         Q_UNUSED(_type)
-        Q_UNUSED(_textTemplate)
 
         const int milliseconds = m_seconds * 1000;
         const auto characterDuration = static_cast<qreal>(milliseconds) / m_words;
@@ -185,11 +316,9 @@ public:
     {
     }
 
-    std::chrono::milliseconds duration(TextParagraphType _type, const QString& _text,
-                                       const TextTemplate& _textTemplate) const override
+    std::chrono::milliseconds duration(TextParagraphType _type,
+                                       const QString& _text) const override
     {
-        Q_UNUSED(_textTemplate)
-
         const auto blockType = _type;
         if (blockType != TextParagraphType::SceneHeading && blockType != TextParagraphType::Action
             && blockType != TextParagraphType::Dialogue && blockType != TextParagraphType::Lyrics) {
@@ -229,23 +358,132 @@ private:
     qreal m_secondsPerEvery50ForSceneHeading = 0.0;
 };
 
-} // namespace
+/**
+ * @brief Ключ запомненной длительности блока
+ */
+struct DurationKey {
+    QString templateId;
+    TextParagraphType type = TextParagraphType::Undefined;
+    QString text;
 
+    bool operator==(const DurationKey& _other) const
+    {
+        return type == _other.type && templateId == _other.templateId && text == _other.text;
+    }
+};
 
-std::chrono::milliseconds ScreenplayChronometer::duration(TextParagraphType _type,
-                                                          const QString& _text,
-                                                          const QString& _templateId)
+uint qHash(const DurationKey& _key)
+{
+    return ::qHash(_key.text) ^ ::qHash(_key.templateId) ^ ::qHash(static_cast<int>(_key.type));
+}
+
+/**
+ * @brief Максимальное количество запоминаемых длительностей блоков
+ */
+const int kDurationsCacheMaxSize = 100000;
+
+/**
+ * @brief Кэш вычислителей хронометража и рассчитанных ими длительностей
+ * @note Вычислители создаются один раз для каждого шаблона до сброса кэша, поэтому настройки
+ *       и метрики шаблона не перечитываются при расчёте каждого блока
+ */
+class ChronometerCache
+{
+public:
+    using ChronometerBuilder
+        = std::function<QSharedPointer<AbstractChronometer>(const QString& _templateId)>;
+
+    explicit ChronometerCache(const ChronometerBuilder& _builder)
+        : m_builder(_builder)
+    {
+        m_durations.setMaxCost(kDurationsCacheMaxSize);
+    }
+
+    std::chrono::milliseconds duration(TextParagraphType _type, const QString& _text,
+                                       const QString& _templateId)
+    {
+        const DurationKey key{ _templateId, _type, _text };
+        QSharedPointer<AbstractChronometer> chronometer;
+        int generation = 0;
+        {
+            QMutexLocker locker(&m_mutex);
+            if (const auto duration = m_durations.object(key)) {
+                return *duration;
+            }
+
+            chronometer = m_chronometers.value(_templateId);
+            if (chronometer.isNull()) {
+                chronometer = m_builder(_templateId);
+                m_chronometers.insert(_templateId, chronometer);
+            }
+            generation = m_generation;
+        }
+
+        //
+        // Сам расчёт выполняем без блокировки, чтобы блоки из разных потоков считались параллельно
+        //
+        const auto duration = chronometer->duration(_type, _text);
+
+        //
+        // ... и запоминаем результат, только если за время расчёта кэш не был сброшен
+        //
+        QMutexLocker locker(&m_mutex);
+        if (generation == m_generation) {
+            m_durations.insert(key, new std::chrono::milliseconds(duration));
+        }
+        return duration;
+    }
+
+    void reset()
+    {
+        QMutexLocker locker(&m_mutex);
+        ++m_generation;
+        m_chronometers.clear();
+        m_durations.clear();
+    }
+
+    int generation()
+    {
+        QMutexLocker locker(&m_mutex);
+        return m_generation;
+    }
+
+private:
+    const ChronometerBuilder m_builder;
+
+    QMutex m_mutex;
+
+    /**
+     * @brief Поколение настроек, увеличивается при каждом сбросе кэша
+     */
+    int m_generation = 0;
+
+    /**
+     * @brief Вычислители хронометража для каждого из шаблонов
+     */
+    QHash<QString, QSharedPointer<AbstractChronometer>> m_chronometers;
+
+    /**
+     * @brief Рассчитанные длительности блоков
+     */
+    QCache<DurationKey, std::chrono::milliseconds> m_durations;
+};
+
+/**
+ * @brief Создать вычислитель хронометража сценария по текущим настройкам
+ */
+QSharedPointer<AbstractChronometer> createScreenplayChronometer(const QString& _templateId)
 {
     using namespace DataStorageLayer;
 
-    const auto chronometerType = settingsValue(kComponentsScreenplayDurationTypeKey).toInt();
     const auto& screenplayTemplate = TemplatesFacade::screenplayTemplate(_templateId);
-
+    const auto chronometerType = settingsValue(kComponentsScreenplayDurationTypeKey).toInt();
     switch (static_cast<ChronometerType>(chronometerType)) {
     case ChronometerType::Page: {
         const auto secondsPerPage
             = settingsValue(kComponentsScreenplayDurationByPageDurationKey).toInt();
-        return PageChronometer(secondsPerPage).duration(_type, _text, screenplayTemplate);
+        return QSharedPointer<AbstractChronometer>(
+            new PageChronometer(secondsPerPage, screenplayTemplate));
     }
 
     case ChronometerType::Characters: {
@@ -255,8 +493,8 @@ std::chrono::milliseconds ScreenplayChronometer::duration(TextParagraphType _typ
             = settingsValue(kComponentsScreenplayDurationByCharactersIncludeSpacesKey).toBool();
         const int seconds
             = settingsValue(kComponentsScreenplayDurationByCharactersDurationKey).toInt();
-        return CharactersChronometer(characters, considerSpaces, seconds)
-            .duration(_type, _text, screenplayTemplate);
+        return QSharedPointer<AbstractChronometer>(
+            new CharactersChronometer(characters, considerSpaces, seconds));
     }
 
     case ChronometerType::Configurable: {
@@ -283,30 +521,86 @@ std::chrono::milliseconds ScreenplayChronometer::duration(TextParagraphType _typ
             = settingsValue(
                   kComponentsScreenplayDurationConfigurableSecondsPerEvery50ForSceneHeadingKey)
                   .toDouble();
-        return ConfigurableChronometer(secondsPerParagraphForAction, secondsPerEvery50ForAction,
-                                       secondsPerParagraphForDialogue, secondsPerEvery50ForDialogue,
-                                       secondsPerParagraphForSceneHeading,
-                                       secondsPerEvery50ForSceneHeading)
-            .duration(_type, _text, screenplayTemplate);
+        return QSharedPointer<AbstractChronometer>(new ConfigurableChronometer(
+            secondsPerParagraphForAction, secondsPerEvery50ForAction,
+            secondsPerParagraphForDialogue, secondsPerEvery50ForDialogue,
+            secondsPerParagraphForSceneHeading, secondsPerEvery50ForSceneHeading));
     }
 
     default: {
         Q_ASSERT(false);
-        return {};
+        return QSharedPointer<AbstractChronometer>(new CharactersChronometer(1000, true, 60));
     }
     }
 }
 
-std::chrono::milliseconds AudioplayChronometer::duration(TextParagraphType _type,
-                                                         const QString& _text,
-                                                         const QString& _templateId)
+/**
+ * @brief Создать вычислитель хронометража аудиопостановки по текущим настройкам
+ */
+QSharedPointer<AbstractChronometer> createAudioplayChronometer(const QString& _templateId)
 {
     using namespace DataStorageLayer;
 
+    Q_UNUSED(_templateId)
+
     const int words = settingsValue(kComponentsAudioplayDurationByWordsWordsKey).toInt();
     const int seconds = settingsValue(kComponentsAudioplayDurationByWordsDurationKey).toInt();
-    const auto& audioplayTemplate = TemplatesFacade::audioplayTemplate(_templateId);
-    return WordsChronometer(words, seconds).duration(_type, _text, audioplayTemplate);
+    return QSharedPointer<AbstractChronometer>(new WordsChronometer(words, seconds));
+}
+
+/**
+ * @brief Кэш хронометража сценария
+ */
+ChronometerCache& screenplayCache()
+{
+    static ChronometerCache cache(createScreenplayChronometer);
+    return cache;
+}
+
+/**
+ * @brief Кэш хронометража аудиопостановки
+ */
+ChronometerCache& audioplayCache()
+{
+    static ChronometerCache cache(createAudioplayChronometer);
+    return cache;
+}
+
+} // namespace
+
+
+std::chrono::milliseconds ScreenplayChronometer::duration(TextParagraphType _type,
+                                                          const QString& _text,
+                                                          const QString& _templateId)
+{
+    return screenplayCache().duration(_type, _text, _templateId);
+}
+
+void ScreenplayChronometer::resetCache()
+{
+    screenplayCache().reset();
+}
+
+int ScreenplayChronometer::cacheGeneration()
+{
+    return screenplayCache().generation();
+}
+
+std::chrono::milliseconds AudioplayChronometer::duration(TextParagraphType _type,
+                                                         const QString& _text,
+                                                         const QString& _templateId)
+{
+    return audioplayCache().duration(_type, _text, _templateId);
+}
+
+void AudioplayChronometer::resetCache()
+{
+    audioplayCache().reset();
+}
+
+int AudioplayChronometer::cacheGeneration()
+{
+    return audioplayCache().generation();
 }
 
 } // namespace BusinessLayer
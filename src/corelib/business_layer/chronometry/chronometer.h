@@ -30,6 +30,18 @@ public:
      */
     static std::chrono::milliseconds duration(TextParagraphType _type, const QString& _text,
                                               const QString& _templateId);
+
+    /**
+     * @brief Сбросить запомненные параметры хронометража и длительности блоков
+     * @note Нужно вызывать после изменения настроек хронометража, или шаблонов
+     */
+    static void resetCache();
+
+    /**
+     * @brief Поколение настроек хронометража, увеличивается при каждом сбросе кэша
+     * @note Позволяет понять, что посчитанные ранее длительности устарели
+     */
+    static int cacheGeneration();
 };
 
 /**
@@ -43,6 +55,18 @@ public:
      */
     static std::chrono::milliseconds duration(TextParagraphType _type, const QString& _text,
                                               const QString& _templateId);
+
+    /**
+     * @brief Сбросить запомненные параметры хронометража и длительности блоков
+     * @note Нужно вызывать после изменения настроек хронометража, или шаблонов
+     */
+    static void resetCache();
+
+    /**
+     * @brief Поколение настроек хронометража, увеличивается при каждом сбросе кэша
+     * @note Позволяет понять, что посчитанные ранее длительности устарели
+     */
+    static int cacheGeneration();
 };
 
 } // namespace BusinessLayer
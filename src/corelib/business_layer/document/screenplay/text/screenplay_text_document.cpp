@@ -7,6 +7,8 @@
 #include <business_layer/model/screenplay/text/screenplay_text_model.h>
 #include <business_layer/model/screenplay/text/screenplay_text_model_scene_item.h>
 #include <business_layer/templates/screenplay_template.h>
+#include <data_layer/storage/settings_storage.h>
+#include <data_layer/storage/storage_facade.h>
 
 
 namespace BusinessLayer {
@@ -175,8 +177,8 @@ QSet<TextParagraphType> ScreenplayTextDocument::visibleBlocksTypes() const
     };
 }
 
-void ScreenplayTextDocument::setCorrectionOptions(bool _needToCorrectCharactersNames,
-                                                  bool _needToCorrectPageBreaks)
+QStringList ScreenplayTextDocument::correctionOptions(bool _needToCorrectCharactersNames,
+                                                      bool _needToCorrectPageBreaks)
 {
     QStringList correctionOptions;
     if (_needToCorrectCharactersNames) {
@@ -185,7 +187,22 @@ void ScreenplayTextDocument::setCorrectionOptions(bool _needToCorrectCharactersN
     if (_needToCorrectPageBreaks) {
         correctionOptions.append("correct-page-breaks");
     }
-    TextDocument::setCorrectionOptions(correctionOptions);
+    return correctionOptions;
+}
+
+QStringList ScreenplayTextDocument::editorCorrectionOptions()
+{
+    return correctionOptions(
+        settingsValue(DataStorageLayer::kComponentsScreenplayEditorContinueDialogueKey).toBool(),
+        settingsValue(DataStorageLayer::kComponentsScreenplayEditorCorrectTextOnPageBreaksKey)
+            .toBool());
+}
+
+void ScreenplayTextDocument::setCorrectionOptions(bool _needToCorrectCharactersNames,
+                                                  bool _needToCorrectPageBreaks)
+{
+    TextDocument::setCorrectionOptions(
+        correctionOptions(_needToCorrectCharactersNames, _needToCorrectPageBreaks));
 }
 
 QString ScreenplayTextDocument::sceneNumber(const QTextBlock& _forBlock) const
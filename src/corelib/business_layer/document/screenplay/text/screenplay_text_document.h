@@ -33,6 +33,17 @@ public:
      */
     QSet<TextParagraphType> visibleBlocksTypes() const;
 
+    /**
+     * @brief Сформировать опции корректировок
+     */
+    static QStringList correctionOptions(bool _needToCorrectCharactersNames,
+                                         bool _needToCorrectPageBreaks);
+
+    /**
+     * @brief Опции корректировок, заданные в настройках редактора сценария
+     */
+    static QStringList editorCorrectionOptions();
+
     /**
      * @brief Настроить необходимость корректировок
      */
@@ -17,6 +17,7 @@
 #include <utils/helpers/text_helper.h>
 #include <utils/shugar.h>
 #include <utils/tools/debouncer.h>
+#include <utils/tools/positions_map.h>
 
 #include <QDateTime>
 #include <QPointer>
@@ -52,7 +53,6 @@ public:
     /**
      * @brief Скорректировать позиции элементов на заданную дистанцию
      */
-    void correctPositionsToItems(std::map<int, TextModelItem*>::iterator _from, int _distance);
     void correctPositionsToItems(int _fromPosition, int _distance);
 
     /**
@@ -91,7 +91,7 @@ public:
     DocumentState state = DocumentState::Undefined;
     QPointer<BusinessLayer::TextModel> model;
     bool canChangeModel = true;
-    std::map<int, TextModelItem*> positionsToItems;
+    PositionsMap<TextModelItem*> positionsToItems;
     QScopedPointer<AbstractTextCorrector> corrector;
 
     /**
@@ -133,35 +133,9 @@ TextModelItem* TextDocument::Implementation::itemFor(const TextCursor& _cursor)
     return itemFor(_cursor.block());
 }
 
-void TextDocument::Implementation::correctPositionsToItems(
-    std::map<int, TextModelItem*>::iterator _from, int _distance)
-{
-    if (_from == positionsToItems.end()) {
-        return;
-    }
-
-    if (_distance > 0) {
-        auto reversed = [](std::map<int, TextModelItem*>::iterator iter) {
-            return std::prev(std::make_reverse_iterator(iter));
-        };
-        for (auto iter = positionsToItems.rbegin(); iter != std::make_reverse_iterator(_from);
-             ++iter) {
-            auto itemToUpdate = positionsToItems.extract(iter->first);
-            itemToUpdate.key() = itemToUpdate.key() + _distance;
-            iter = reversed(positionsToItems.insert(std::move(itemToUpdate)).position);
-        }
-    } else if (_distance < 0) {
-        for (auto iter = _from; iter != positionsToItems.end(); ++iter) {
-            auto itemToUpdate = positionsToItems.extract(iter->first);
-            itemToUpdate.key() = itemToUpdate.key() + _distance;
-            iter = positionsToItems.insert(std::move(itemToUpdate)).position;
-        }
-    }
-}
-
 void TextDocument::Implementation::correctPositionsToItems(int _fromPosition, int _distance)
 {
-    correctPositionsToItems(positionsToItems.lower_bound(_fromPosition), _distance);
+    positionsToItems.shift(_fromPosition, _distance);
 }
 
 void TextDocument::Implementation::readModelItemContent(int _itemRow, const QModelIndex& _parent,
@@ -204,7 +178,7 @@ void TextDocument::Implementation::readModelItemContent(int _itemRow, const QMod
             //
             // Запомним позицию разделителя
             //
-            positionsToItems.emplace(_cursor.position(), splitterItem);
+            positionsToItems.insert(_cursor.position(), splitterItem);
 
             //
             // Назначим блоку перед таблицей формат PageSplitter
@@ -258,7 +232,7 @@ void TextDocument::Implementation::readModelItemContent(int _itemRow, const QMod
             // поэтому тут лишь сохраняем его в карту позиций элементов
             //
             _cursor.movePosition(QTextCursor::NextBlock);
-            positionsToItems.emplace(_cursor.position(), splitterItem);
+            positionsToItems.insert(_cursor.position(), splitterItem);
             //
             // ... и сохраняем в блоке информацию об элементе
             //
@@ -339,7 +313,7 @@ void TextDocument::Implementation::readModelItemContent(int _itemRow, const QMod
         // Запомним позицию элемента
         //
         correctPositionsToItems(_cursor.position(), textItem->text().length() + additionalDistance);
-        positionsToItems.emplace(_cursor.position(), textItem);
+        positionsToItems.insert(_cursor.position(), textItem);
 
         //
         // Установим стиль блока
@@ -736,7 +710,7 @@ void TextDocument::setModel(BusinessLayer::TextModel* _model, bool _canChangeMod
                 //
                 // ... удаляем блок в карте
                 //
-                d->positionsToItems.erase(cursor.position());
+                d->positionsToItems.remove(cursor.position());
                 //
                 // ... и корректируем позиции элементов
                 //
@@ -958,7 +932,7 @@ void TextDocument::setModel(BusinessLayer::TextModel* _model, bool _canChangeMod
                         //
                         // ... удаляем блок в карте
                         //
-                        d->positionsToItems.erase(cursor.position());
+                        d->positionsToItems.remove(cursor.position());
                         //
                         // ... и корректируем позиции элементов
                         //
@@ -1020,7 +994,7 @@ void TextDocument::setModel(BusinessLayer::TextModel* _model, bool _canChangeMod
                     //
                     // Корректируем карту позиций блоков
                     //
-                    auto fromIter = d->positionsToItems.lower_bound(fromPosition);
+                    auto fromIter = d->positionsToItems.lowerBound(fromPosition);
                     auto endIter = std::next(fromIter, 2);
                     d->positionsToItems.erase(fromIter, endIter);
 
@@ -1060,8 +1034,8 @@ void TextDocument::setModel(BusinessLayer::TextModel* _model, bool _canChangeMod
             //
             // Корректируем карту позиций элементов
             //
-            auto fromIter = d->positionsToItems.lower_bound(cursor.selectionInterval().from);
-            auto endIter = d->positionsToItems.lower_bound(cursor.selectionInterval().to);
+            auto fromIter = d->positionsToItems.lowerBound(cursor.selectionInterval().from);
+            auto endIter = d->positionsToItems.lowerBound(cursor.selectionInterval().to);
             //
             // ... если удаление заканчивается на пустом абзаце, берём следующий за ним элемент
             //
@@ -1071,7 +1045,7 @@ void TextDocument::setModel(BusinessLayer::TextModel* _model, bool _canChangeMod
             //
             // ... определим дистанцию занимаемую удаляемыми элементами
             //
-            const auto distance = endIter->first - fromIter->first;
+            const auto distance = endIter.key() - fromIter.key();
             //
             // ... удаляем сами элементы из карты
             //
@@ -1280,16 +1254,7 @@ int TextDocument::itemPosition(const QModelIndex& _index, bool _fromStart)
     while (item->childCount() > 0) {
         item = item->childAt(_fromStart ? 0 : item->childCount() - 1);
     }
-    //
-    // FIXME: оптимизировать это место
-    //
-    for (const auto& [key, value] : d->positionsToItems) {
-        if (value == item) {
-            return key;
-        }
-    }
-
-    return -1;
+    return d->positionsToItems.position(item);
 }
 
 int TextDocument::itemStartPosition(const QModelIndex& _index)
@@ -1749,7 +1714,7 @@ void TextDocument::splitParagraph(const TextCursor& _cursor)
     {
         auto block = findBlock(cursor.selectionStart());
         while (block.isValid() && block.position() < cursor.selectionEnd()) {
-            auto item = d->positionsToItems[block.position()];
+            auto item = d->positionsToItems.value(block.position());
             if (item->type() == TextModelItemType::Text) {
                 auto textItem = static_cast<TextModelTextItem*>(item);
                 textItem->setInFirstColumn(true);
@@ -1858,7 +1823,7 @@ int TextDocument::mergeParagraph(const TextCursor& _cursor)
         auto updateCursor = cursor;
         updateCursor.movePosition(QTextCursor::NextBlock);
         while (!updateCursor.atEnd() && updateCursor.inTable()) {
-            auto item = d->positionsToItems[updateCursor.position()];
+            auto item = d->positionsToItems.value(updateCursor.position());
             if (item->type() == TextModelItemType::Text) {
                 auto textItem = static_cast<TextModelTextItem*>(item);
                 textItem->setInFirstColumn({});
@@ -1968,14 +1933,14 @@ void TextDocument::addReviewMark(const QColor& _textColor, const QColor& _backgr
         //
         // ... ищем текстовый элемент для текста куда добавляется новый текст
         //
-        const auto iter = d->positionsToItems.lower_bound(blockPosition);
-        if (iter == d->positionsToItems.end() || iter->second->type() != TextModelItemType::Text) {
+        const auto iter = d->positionsToItems.lowerBound(blockPosition);
+        if (iter == d->positionsToItems.end() || iter.value()->type() != TextModelItemType::Text) {
             break;
         }
         //
         // ... ищем редакторскую заметку с которой пересекается добавляемая
         //
-        auto textItem = static_cast<TextModelTextItem*>(iter->second);
+        auto textItem = static_cast<TextModelTextItem*>(iter.value());
         auto reviewMarks = textItem->reviewMarks();
         for (auto& mark : reviewMarks) {
             const auto markEnd = mark.end();
@@ -2106,38 +2071,17 @@ void TextDocument::updateModelOnContentChange(int _position, int _charsRemoved,
         //
         std::map<TextModelItem*, int> itemsToDelete;
         {
-            auto itemsToDeleteIter = d->positionsToItems.lower_bound(_position);
+            auto itemsToDeleteIter = d->positionsToItems.lowerBound(_position);
             while (itemsToDeleteIter != d->positionsToItems.end()
-                   && itemsToDeleteIter->first <= _position + _charsRemoved) {
-                itemsToDelete.emplace(itemsToDeleteIter->second, itemsToDeleteIter->first);
+                   && itemsToDeleteIter.key() <= _position + _charsRemoved) {
+                itemsToDelete.emplace(itemsToDeleteIter.value(), itemsToDeleteIter.key());
                 itemsToDeleteIter = d->positionsToItems.erase(itemsToDeleteIter);
             }
 
             //
             // Корректируем позиции элементов идущих за изменёнными блоками
             //
-
-            auto itemToUpdateIter = itemsToDeleteIter;
-
-            //
-            // Формируем мапу элементов со скорректированными позициями
-            //
-            std::map<int, TextModelItem*> correctedItems;
-            for (auto itemIter = itemToUpdateIter; itemIter != d->positionsToItems.end();
-                 ++itemIter) {
-                correctedItems.emplace(itemIter->first - _charsRemoved + _charsAdded,
-                                       itemIter->second);
-            }
-
-            //
-            // Удаляем элементы со старыми позициями
-            //
-            d->positionsToItems.erase(itemToUpdateIter, d->positionsToItems.end());
-
-            //
-            // И записываем на их место новые элементы
-            //
-            d->positionsToItems.merge(correctedItems);
+            d->correctPositionsToItems(_position + _charsRemoved + 1, _charsAdded - _charsRemoved);
         }
 
         //
@@ -2153,7 +2097,7 @@ void TextDocument::updateModelOnContentChange(int _position, int _charsRemoved,
                     //
                     // Восстанавливаем позицию блока с учётом смещения
                     //
-                    d->positionsToItems.emplace(block.position(), notRemovedItemIter->first);
+                    d->positionsToItems.insert(block.position(), notRemovedItemIter->first);
                     itemsToDelete.erase(notRemovedItemIter);
                 }
             }
@@ -2590,7 +2534,7 @@ void TextDocument::updateModelOnContentChange(int _position, int _charsRemoved,
                 //
                 // Запомним новый блок, или обновим старый
                 //
-                d->positionsToItems.insert_or_assign(block.position(), previousTextItem);
+                d->positionsToItems.insertOrAssign(block.position(), previousTextItem);
 
                 block = block.next();
                 continue;
@@ -3035,7 +2979,7 @@ void TextDocument::updateModelOnContentChange(int _position, int _charsRemoved,
         //
         // Запомним новый блок, или обновим старый
         //
-        d->positionsToItems.insert_or_assign(block.position(), previousTextItem);
+        d->positionsToItems.insertOrAssign(block.position(), previousTextItem);
 
         //
         // Переходим к обработке следующего блока
@@ -0,0 +1,251 @@
+#include "text_document_pagination.h"
+
+#include "text_block_data.h"
+#include "text_document.h"
+
+#include <business_layer/model/text/text_model.h>
+#include <business_layer/model/text/text_model_item.h>
+#include <business_layer/templates/text_template.h>
+#include <ui/widgets/text_edit/page/page_metrics.h>
+
+#include <QAbstractTextDocumentLayout>
+#include <QHash>
+#include <QMutex>
+#include <QTextBlock>
+#include <QTextFrame>
+#include <QTextLayout>
+
+#include <atomic>
+
+
+namespace BusinessLayer {
+
+namespace {
+
+/**
+ * @brief Закешированная разметка модели
+ */
+struct CachedPagination {
+    /**
+     * @brief Хэш контента модели, для которого сформирована разметка
+     */
+    QByteArray contentHash;
+
+    /**
+     * @brief Ключ параметров страницы шаблона и опций корректировки текста, для которых
+     *        сформирована разметка
+     */
+    QString layoutKey;
+
+    /**
+     * @brief Поколение шаблонов, для которого сформирована разметка
+     */
+    int templatesGeneration = 0;
+
+    QSharedPointer<const TextDocumentPagination> pagination;
+};
+
+/**
+ * @brief Кэш разметок моделей
+ */
+QHash<const TextModel*, CachedPagination>& paginationsCache()
+{
+    static QHash<const TextModel*, CachedPagination> cache;
+    return cache;
+}
+
+/**
+ * @brief Мьютекс кэша разметок, т.к. отчёты и графики могут строиться в фоновых потоках
+ */
+QMutex& paginationsCacheMutex()
+{
+    static QMutex mutex;
+    return mutex;
+}
+
+/**
+ * @brief Поколение шаблонов, увеличивается при каждом сбросе кэша
+ * @note Нужно, т.к. стили абзацев шаблона могут измениться без смены его идентификатора
+ */
+std::atomic<int> s_templatesGeneration{ 0 };
+
+/**
+ * @brief Сформировать ключ параметров вёрстки документа
+ */
+QString layoutKeyFor(const TextTemplate& _template, const QStringList& _correctionOptions)
+{
+    const auto margins = _template.pageMargins();
+    return QString("%1;%2;%3;%4;%5;%6;%7")
+        .arg(_template.id())
+        .arg(static_cast<int>(_template.pageSizeId()))
+        .arg(margins.left())
+        .arg(margins.top())
+        .arg(margins.right())
+        .arg(margins.bottom())
+        .arg(_correctionOptions.join(','));
+}
+
+} // namespace
+
+
+class TextDocumentPagination::Implementation
+{
+public:
+    /**
+     * @brief Сверстать документ модели и определить страницы её элементов
+     */
+    void build(TextModel* _model, const TextTemplate& _template,
+               const std::function<TextDocument*()>& _createDocument,
+               const QStringList& _correctionOptions);
+
+
+    /**
+     * @brief Номера страниц элементов модели по их серийным номерам
+     */
+    QHash<quint64, int> itemsPages;
+
+    /**
+     * @brief Количество страниц
+     */
+    int pageCount = 0;
+};
+
+void TextDocumentPagination::Implementation::build(
+    TextModel* _model, const TextTemplate& _template,
+    const std::function<TextDocument*()>& _createDocument, const QStringList& _correctionOptions)
+{
+    //
+    // Настраиваем документ так же, как это делает редактор текста в постраничном режиме
+    //
+    const PageMetrics pageMetrics(_template.pageSizeId(), _template.pageMargins());
+    QScopedPointer<TextDocument> document(_createDocument());
+    document->setPageSize(pageMetrics.pxPageSize());
+    document->setDocumentMargin(0.0);
+    auto rootFrameFormat = document->rootFrame()->frameFormat();
+    rootFrameFormat.setLeftMargin(pageMetrics.pxPageMargins().left());
+    rootFrameFormat.setTopMargin(pageMetrics.pxPageMargins().top());
+    rootFrameFormat.setRightMargin(pageMetrics.pxPageMargins().right());
+    rootFrameFormat.setBottomMargin(pageMetrics.pxPageMargins().bottom());
+    document->rootFrame()->setFrameFormat(rootFrameFormat);
+    document->setCorrectionOptions(_correctionOptions);
+
+    const bool kCanChangeModel = false;
+    document->setModel(_model, kCanChangeModel);
+
+    //
+    // Проходим по всем блокам документа и определяем страницы, на которых они начинаются
+    //
+    const auto pageHeight = pageMetrics.pxPageSize().height();
+    const auto documentLayout = document->documentLayout();
+    for (auto block = document->begin(); block.isValid(); block = block.next()) {
+        if (block.userData() == nullptr) {
+            continue;
+        }
+
+        const auto blockData = static_cast<TextBlockData*>(block.userData());
+        const TextModelItem* item = blockData->item();
+        if (item == nullptr || itemsPages.contains(item->serialNumber())) {
+            continue;
+        }
+
+        //
+        // Запрос геометрии блока гарантирует, что он будет свёрстан
+        //
+        qreal blockTop = documentLayout->blockBoundingRect(block).top();
+        const auto blockLayout = block.layout();
+        if (blockLayout != nullptr && blockLayout->lineCount() > 0) {
+            blockTop = blockLayout->position().y() + blockLayout->lineAt(0).y();
+        }
+        const int page = static_cast<int>(blockTop / pageHeight) + 1;
+
+        //
+        // Запоминаем страницу для самого элемента, а также для всех его родителей, которые
+        // начинаются с этого же блока
+        //
+        for (; item != nullptr && !itemsPages.contains(item->serialNumber());
+             item = item->parent()) {
+            itemsPages.insert(item->serialNumber(), page);
+        }
+    }
+
+    pageCount = document->pageCount();
+}
+
+
+// ****
+
+
+QSharedPointer<const TextDocumentPagination> TextDocumentPagination::forModel(
+    TextModel* _model, const TextTemplate& _template,
+    const std::function<TextDocument*()>& _createDocument, const QStringList& _correctionOptions)
+{
+    if (_model == nullptr) {
+        return QSharedPointer<const TextDocumentPagination>(new TextDocumentPagination);
+    }
+
+    //
+    // Если разметка для текущего состояния модели и шаблона уже есть, используем её
+    //
+    const auto contentHash = _model->contentHash();
+    const auto layoutKey = layoutKeyFor(_template, _correctionOptions);
+    const int templatesGeneration = s_templatesGeneration;
+    {
+        QMutexLocker locker(&paginationsCacheMutex());
+        const auto& cache = paginationsCache();
+        const auto cached = cache.constFind(_model);
+        if (cached != cache.constEnd() && cached->contentHash == contentHash
+            && cached->layoutKey == layoutKey
+            && cached->templatesGeneration == templatesGeneration) {
+            return cached->pagination;
+        }
+    }
+
+    //
+    // ... а если нет, то формируем новую, не блокируя кэш на время вёрстки
+    //
+    QSharedPointer<TextDocumentPagination> pagination(new TextDocumentPagination);
+    pagination->d->build(_model, _template, _createDocument, _correctionOptions);
+
+    //
+    // При удалении модели удаляем и её разметку из кэша
+    //
+    QMutexLocker locker(&paginationsCacheMutex());
+    auto& cache = paginationsCache();
+    if (!cache.contains(_model)) {
+        QObject::connect(_model, &QObject::destroyed, _model, [_model] {
+            QMutexLocker locker(&paginationsCacheMutex());
+            paginationsCache().remove(_model);
+        });
+    }
+    cache.insert(_model, { contentHash, layoutKey, templatesGeneration, pagination });
+
+    return pagination;
+}
+
+void TextDocumentPagination::resetCache()
+{
+    ++s_templatesGeneration;
+}
+
+TextDocumentPagination::TextDocumentPagination()
+    : d(new Implementation)
+{
+}
+
+TextDocumentPagination::~TextDocumentPagination() = default;
+
+int TextDocumentPagination::itemPage(const TextModelItem* _item) const
+{
+    if (_item == nullptr) {
+        return 0;
+    }
+
+    return d->itemsPages.value(_item->serialNumber(), 0);
+}
+
+int TextDocumentPagination::pageCount() const
+{
+    return d->pageCount;
+}
+
+} // namespace BusinessLayer
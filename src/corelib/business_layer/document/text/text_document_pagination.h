@@ -0,0 +1,76 @@
+#pragma once
+
+#include <QScopedPointer>
+#include <QSharedPointer>
+#include <QStringList>
+
+#include <corelib_global.h>
+
+#include <functional>
+
+
+namespace BusinessLayer {
+
+class TextDocument;
+class TextModel;
+class TextModelItem;
+class TextTemplate;
+
+/**
+ * @brief Разметка текстового документа по страницам, формируемая без использования виджетов
+ *
+ * Документ модели верстается по запросу с параметрами страницы из шаблона и с теми же опциями
+ * корректировки текста, что и в редакторе, после чего сам документ удаляется, а номера страниц
+ * элементов сохраняются в кэше. Результат используется всеми отчётами и графиками, пока не
+ * изменятся контент модели, параметры страницы шаблона, опции корректировки, или сами шаблоны,
+ * о чём сообщается через resetCache().
+ *
+ * @note Кэш можно использовать из нескольких потоков
+ */
+class CORE_LIBRARY_EXPORT TextDocumentPagination
+{
+public:
+    /**
+     * @brief Получить разметку для заданной модели
+     * @param _createDocument Фабрика документа, соответствующего типу модели
+     * @param _correctionOptions Опции корректировки текста документа
+     */
+    static QSharedPointer<const TextDocumentPagination> forModel(
+        TextModel* _model, const TextTemplate& _template,
+        const std::function<TextDocument*()>& _createDocument,
+        const QStringList& _correctionOptions);
+    template<typename Document>
+    static QSharedPointer<const TextDocumentPagination> forModel(
+        TextModel* _model, const TextTemplate& _template,
+        const QStringList& _correctionOptions = {})
+    {
+        return forModel(_model, _template, [] { return new Document; }, _correctionOptions);
+    }
+
+    /**
+     * @brief Сбросить кэш разметок, например после изменения стилей абзацев шаблона
+     */
+    static void resetCache();
+
+public:
+    ~TextDocumentPagination();
+
+    /**
+     * @brief Номер страницы (начиная с единицы) на которой начинается заданный элемент
+     * @return 0, если элемента нет в документе
+     */
+    int itemPage(const TextModelItem* _item) const;
+
+    /**
+     * @brief Количество страниц в документе
+     */
+    int pageCount() const;
+
+private:
+    TextDocumentPagination();
+
+    class Implementation;
+    QScopedPointer<Implementation> d;
+};
+
+} // namespace BusinessLayer
@@ -94,7 +94,7 @@ public:
     void writeStyles(QtZipWriter* _zip, const ExportOptions& _exportOptions) const;
     void writeHeader(QtZipWriter* _zip, const ExportOptions& _exportOptions) const;
     void writeFooter(QtZipWriter* _zip, const ExportOptions& _exportOptions) const;
-    void writeDocument(QtZipWriter* _zip, TextDocument* _documentText,
+    bool writeDocument(QtZipWriter* _zip, TextDocument* _documentText,
                        QMap<int, QStringList>& _comments,
                        const ExportOptions& _exportOptions) const;
     void writeComments(QtZipWriter* _zip, const QMap<int, QStringList>& _comments) const;
@@ -1070,20 +1070,28 @@ void AbstractDocxExporter::Implementation::writeFooter(QtZipWriter* _zip,
     _zip->addFile(QString::fromLatin1("word/footer1.xml"), footerXml.toUtf8());
 }
 
-void AbstractDocxExporter::Implementation::writeDocument(QtZipWriter* _zip,
+bool AbstractDocxExporter::Implementation::writeDocument(QtZipWriter* _zip,
                                                          TextDocument* _documentText,
                                                          QMap<int, QStringList>& _comments,
                                                          const ExportOptions& _exportOptions) const
 {
-    QString documentXml
-        = "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>"
-          "<w:document xmlns:o=\"urn:schemas-microsoft-com:office:office\" "
-          "xmlns:r=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships\" "
-          "xmlns:v=\"urn:schemas-microsoft-com:vml\" "
-          "xmlns:w=\"http://schemas.openxmlformats.org/wordprocessingml/2006/main\" "
-          "xmlns:w10=\"urn:schemas-microsoft-com:office:word\" "
-          "xmlns:wp=\"http://schemas.openxmlformats.org/drawingml/2006/wordprocessingDrawing\">"
-          "<w:body>";
+    //
+    // Документ может быть очень большим, поэтому не собираем его целиком в памяти, а пишем
+    // в архив по мере формирования, сжимая на лету
+    //
+    if (!_zip->startFile(QString::fromLatin1("word/document.xml"))) {
+        return false;
+    }
+
+    _zip->writeFileData(
+        "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>"
+        "<w:document xmlns:o=\"urn:schemas-microsoft-com:office:office\" "
+        "xmlns:r=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships\" "
+        "xmlns:v=\"urn:schemas-microsoft-com:vml\" "
+        "xmlns:w=\"http://schemas.openxmlformats.org/wordprocessingml/2006/main\" "
+        "xmlns:w10=\"urn:schemas-microsoft-com:office:word\" "
+        "xmlns:wp=\"http://schemas.openxmlformats.org/drawingml/2006/wordprocessingDrawing\">"
+        "<w:body>");
 
     //
     // Данные считываются из исходного документа, определяется тип блока
@@ -1095,13 +1103,13 @@ void AbstractDocxExporter::Implementation::writeDocument(QtZipWriter* _zip,
             continue;
         }
 
-        documentXml.append(docxText(_comments, documentCursor, _exportOptions));
+        _zip->writeFileData(docxText(_comments, documentCursor, _exportOptions).toUtf8());
     } while (documentCursor.movePosition(QTextCursor::NextBlock));
 
     //
     // В конце идёт блок настроек страницы
     //
-    documentXml.append("<w:sectPr>");
+    QString documentXml = "<w:sectPr>";
     //
     // ... колонтитулы
     //
@@ -1151,9 +1159,11 @@ void AbstractDocxExporter::Implementation::writeDocument(QtZipWriter* _zip,
     documentXml.append("</w:body></w:document>");
 
     //
-    // Запишем документ в архив
+    // Дописываем окончание документа и завершаем его в архиве
     //
-    _zip->addFile(QString::fromLatin1("word/document.xml"), documentXml.toUtf8());
+    _zip->writeFileData(documentXml.toUtf8());
+    _zip->finishFile();
+    return _zip->status() == QtZipWriter::NoError;
 }
 
 void AbstractDocxExporter::Implementation::writeComments(
@@ -1236,7 +1246,14 @@ void AbstractDocxExporter::exportTo(AbstractModel* _model, ExportOptions& _expor
         //
         QMap<int, QStringList> comments;
         QScopedPointer<TextDocument> document(prepareDocument(_model, _exportOptions));
-        d->writeDocument(&zip, document.data(), comments, _exportOptions);
+        if (!d->writeDocument(&zip, document.data(), comments, _exportOptions)) {
+            //
+            // Если документ записать не удалось, то архив уже испорчен, поэтому не оставляем его
+            //
+            zip.close();
+            docxFile.remove();
+            return;
+        }
         //
         // ... комментарии
         //
@@ -4,13 +4,16 @@
 #include <business_layer/document/text/text_block_data.h>
 #include <business_layer/document/text/text_cursor.h>
 #include <business_layer/export/export_options.h>
+#include <business_layer/model/abstract_image_wrapper.h>
 #include <business_layer/model/simple_text/simple_text_model.h>
 #include <business_layer/model/text/text_model.h>
 #include <business_layer/templates/text_template.h>
+#include <domain/document_object.h>
 #include <ui/widgets/text_edit/page/page_text_edit.h>
 #include <utils/helpers/measurement_helper.h>
 
 #include <QGuiApplication>
+#include <QPixmap>
 #include <QTextBlock>
 
 
@@ -419,4 +422,15 @@ bool AbstractExporter::prepareBlock(const ExportOptions& _exportOptions, TextCur
     return false;
 }
 
+QPixmap AbstractExporter::fullSizeImage(const AbstractModel* _model,
+                                        const Domain::DocumentImage& _image) const
+{
+    if (_model->imageWrapper() == nullptr || _image.uuid.isNull()) {
+        return _image.image;
+    }
+
+    const auto image = _model->imageWrapper()->loadFullSize(_image.uuid);
+    return image.isNull() ? _image.image : image;
+}
+
 } // namespace BusinessLayer
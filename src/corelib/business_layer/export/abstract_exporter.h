@@ -2,6 +2,12 @@
 
 #include <corelib_global.h>
 
+class QPixmap;
+
+namespace Domain {
+struct DocumentImage;
+}
+
 
 namespace BusinessLayer {
 
@@ -51,6 +57,12 @@ protected:
      * @brief Обработать блок необходимым образом в наследнике
      */
     virtual bool prepareBlock(const ExportOptions& _exportOptions, TextCursor& _cursor) const;
+
+    /**
+     * @brief Получить изображение модели в полном разрешении
+     * @note Пока изображение декодируется в фоне, модель хранит лишь его миниатюру
+     */
+    QPixmap fullSizeImage(const AbstractModel* _model, const Domain::DocumentImage& _image) const;
 };
 
 } // namespace BusinessLayer
@@ -95,8 +95,11 @@ TextDocument* CharacterExporter::prepareDocument(AbstractModel* _model,
     //
     // Фотка персонажа
     //
-    if (exportOptions.includeMainPhoto && !character->mainPhoto().image.isNull()) {
-        const auto mainPhotoScaled = character->mainPhoto().image.scaled(
+    const auto mainPhotoImage = exportOptions.includeMainPhoto
+        ? fullSizeImage(character, character->mainPhoto())
+        : QPixmap();
+    if (!mainPhotoImage.isNull()) {
+        const auto mainPhotoScaled = mainPhotoImage.scaled(
             MeasurementHelper::mmToPx(40), MeasurementHelper::mmToPx(40),
             Qt::KeepAspectRatioByExpanding, Qt::SmoothTransformation);
         const auto borderMargin = MeasurementHelper::mmToPx(3);
@@ -320,7 +323,8 @@ TextDocument* CharacterExporter::prepareDocument(AbstractModel* _model,
         cursor.insertBlock(blockFormat(MeasurementHelper::ptToPx(6)), baseFormat);
         const auto borderMargin = MeasurementHelper::mmToPx(3);
         for (int index = 1; index < character->photos().size(); ++index) {
-            const auto photoScaled = character->photos().value(index).image.scaled(
+            const auto photo = fullSizeImage(character, character->photos().value(index));
+            const auto photoScaled = photo.scaled(
                 MeasurementHelper::mmToPx(40), MeasurementHelper::mmToPx(40),
                 Qt::KeepAspectRatioByExpanding, Qt::SmoothTransformation);
             QImage mainPhoto(QSize(MeasurementHelper::mmToPx(40), MeasurementHelper::mmToPx(40))
@@ -110,8 +110,11 @@ TextDocument* CharactersExporter::prepareDocument(AbstractModel* _model,
         // Фотка персонажа
         //
         int photoHeight = 0;
-        if (exportOptions.includeMainPhoto && !character->mainPhoto().image.isNull()) {
-            const auto mainPhotoScaled = character->mainPhoto().image.scaled(
+        const auto mainPhotoImage = exportOptions.includeMainPhoto
+            ? fullSizeImage(character, character->mainPhoto())
+            : QPixmap();
+        if (!mainPhotoImage.isNull()) {
+            const auto mainPhotoScaled = mainPhotoImage.scaled(
                 MeasurementHelper::mmToPx(20), MeasurementHelper::mmToPx(20),
                 Qt::KeepAspectRatioByExpanding, Qt::SmoothTransformation);
             const auto borderMargin = MeasurementHelper::mmToPx(3);
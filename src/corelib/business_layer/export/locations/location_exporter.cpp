@@ -95,8 +95,11 @@ TextDocument* LocationExporter::prepareDocument(AbstractModel* _model,
     //
     // Фотка локации
     //
-    if (exportOptions.includeMainPhoto && !location->mainPhoto().image.isNull()) {
-        const auto mainPhotoScaled = location->mainPhoto().image.scaled(
+    const auto mainPhotoImage = exportOptions.includeMainPhoto
+        ? fullSizeImage(location, location->mainPhoto())
+        : QPixmap();
+    if (!mainPhotoImage.isNull()) {
+        const auto mainPhotoScaled = mainPhotoImage.scaled(
             MeasurementHelper::mmToPx(40), MeasurementHelper::mmToPx(40),
             Qt::KeepAspectRatioByExpanding, Qt::SmoothTransformation);
         const auto borderMargin = MeasurementHelper::mmToPx(3);
@@ -222,7 +225,8 @@ TextDocument* LocationExporter::prepareDocument(AbstractModel* _model,
         cursor.insertBlock(blockFormat(MeasurementHelper::ptToPx(6)), baseFormat);
         const auto borderMargin = MeasurementHelper::mmToPx(3);
         for (int index = 1; index < location->photos().size(); ++index) {
-            const auto photoScaled = location->photos().value(index).image.scaled(
+            const auto photo = fullSizeImage(location, location->photos().value(index));
+            const auto photoScaled = photo.scaled(
                 MeasurementHelper::mmToPx(40), MeasurementHelper::mmToPx(40),
                 Qt::KeepAspectRatioByExpanding, Qt::SmoothTransformation);
             QImage mainPhoto(QSize(MeasurementHelper::mmToPx(40), MeasurementHelper::mmToPx(40))
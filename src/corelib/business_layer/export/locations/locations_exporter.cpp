@@ -109,8 +109,11 @@ TextDocument* LocationsExporter::prepareDocument(AbstractModel* _model,
         // Фотка локации
         //
         int photoHeight = 0;
-        if (exportOptions.includeMainPhoto && !location->mainPhoto().image.isNull()) {
-            const auto mainPhotoScaled = location->mainPhoto().image.scaled(
+        const auto mainPhotoImage = exportOptions.includeMainPhoto
+            ? fullSizeImage(location, location->mainPhoto())
+            : QPixmap();
+        if (!mainPhotoImage.isNull()) {
+            const auto mainPhotoScaled = mainPhotoImage.scaled(
                 MeasurementHelper::mmToPx(20), MeasurementHelper::mmToPx(20),
                 Qt::KeepAspectRatioByExpanding, Qt::SmoothTransformation);
             const auto borderMargin = MeasurementHelper::mmToPx(3);
@@ -22,9 +22,17 @@ public:
 
     /**
      * @brief Получить изображение по заданному индентификатору
+     * @note Изображение может быть возвращено в уменьшенном виде, или вовсе пустым, если оно ещё
+     *       не загружено, тогда полноразмерное изображение придёт через сигнал imageLoaded
      */
     virtual QPixmap load(const QUuid& _uuid) const = 0;
 
+    /**
+     * @brief Получить изображение в полном разрешении, дождавшись его декодирования
+     * @note Для тех, кто не может дождаться сигнала imageLoaded, например для экспорта
+     */
+    virtual QPixmap loadFullSize(const QUuid& _uuid) const = 0;
+
     /**
      * @brief Установить изображение
      */
@@ -57,6 +65,13 @@ signals:
      */
     void imageUpdated(const QUuid& _uuid, const QPixmap& _image);
 
+    /**
+     * @brief Изображение было загружено
+     * @note Пока полноразмерное изображение декодируется, сигнал может прийти с его миниатюрой,
+     *       а затем ещё раз, уже с изображением в полном разрешении
+     */
+    void imageLoaded(const QUuid& _uuid, const QPixmap& _image);
+
     /**
      * @brief Изображение было удалено
      */
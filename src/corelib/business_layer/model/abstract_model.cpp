@@ -34,6 +34,11 @@ public:
      */
     AbstractImageWrapper* image = nullptr;
 
+    /**
+     * @brief Тэги документа
+     */
+    const QVector<QString> tags;
+
     /**
      * @brief Контроллер для формирования патчей изменений документа
      */
@@ -76,7 +81,8 @@ public:
 };
 
 AbstractModel::Implementation::Implementation(const QVector<QString>& _tags)
-    : dmpController(_tags)
+    : tags(_tags)
+    , dmpController(_tags)
     , updateDocumentContentDebouncer(300)
 {
 }
@@ -121,6 +127,25 @@ void AbstractModel::setDocument(Domain::DocumentObject* _document)
     }
 }
 
+void AbstractModel::setDocument(Domain::DocumentObject* _document,
+                                const QVector<AbstractModelItem*>& _preparedItems)
+{
+    if (d->document == _document || _document == nullptr || _preparedItems.isEmpty()) {
+        qDeleteAll(_preparedItems);
+        setDocument(_document);
+        return;
+    }
+
+    d->document = _document;
+    initDocumentFromItems(_preparedItems);
+}
+
+QVector<AbstractModelItem*> AbstractModel::prepareItems(const QByteArray& _content) const
+{
+    Q_UNUSED(_content)
+    return {};
+}
+
 QString AbstractModel::documentName() const
 {
     return {};
@@ -173,15 +198,8 @@ void AbstractModel::saveChanges()
         return;
     }
 
-    const auto content = toXml();
-    //
-    const QByteArray undoPatch = d->dmpController.makePatch(content, d->document->content());
-    if (undoPatch.isEmpty()) {
-        return;
-    }
-    //
-    const QByteArray redoPatch = d->dmpController.makePatch(d->document->content(), content);
-    if (redoPatch.isEmpty()) {
+    const auto change = makeContentChange();
+    if (change.undoPatch.isEmpty() || change.redoPatch.isEmpty()) {
         return;
     }
 
@@ -191,9 +209,9 @@ void AbstractModel::saveChanges()
     // то отменять и нечего, поэтому игнорируем такие изменения
     //
     const auto needToNotifyAboutContentChanged = !d->document->content().isEmpty();
-    d->document->setContent(content);
+    d->document->setContent(change.content);
     if (needToNotifyAboutContentChanged) {
-        emit contentsChanged(undoPatch, redoPatch);
+        emit contentsChanged(change.undoPatch, change.redoPatch);
     }
 }
 
@@ -248,6 +266,21 @@ bool AbstractModel::isRedoInProcess() const
     return d->isRedoInProgress;
 }
 
+QByteArray AbstractModel::restoreContent(const QByteArray& _keyframeContent,
+                                         const QVector<QByteArray>& _redoPatches) const
+{
+    auto content = _keyframeContent;
+    for (const auto& patch : _redoPatches) {
+        content = d->dmpController.applyPatch(content, patch);
+    }
+    return content;
+}
+
+QVector<QString> AbstractModel::xmlTags() const
+{
+    return d->tags;
+}
+
 bool AbstractModel::mergeDocumentChanges(const QByteArray _content,
                                          const QVector<QByteArray>& _patches)
 {
@@ -406,6 +439,12 @@ void AbstractModel::initImageWrapper()
 {
 }
 
+void AbstractModel::initDocumentFromItems(const QVector<AbstractModelItem*>& _items)
+{
+    qDeleteAll(_items);
+    initDocument();
+}
+
 ChangeCursor AbstractModel::applyPatch(const QByteArray& _patch)
 {
     const auto newContent = d->dmpController.applyPatch(toXml(), _patch);
@@ -417,6 +456,27 @@ ChangeCursor AbstractModel::applyPatch(const QByteArray& _patch)
     return {};
 }
 
+AbstractModel::ContentChange AbstractModel::makeContentChange()
+{
+    ContentChange change;
+    change.content = toXml();
+    //
+    // Если контент не изменился, то и формировать патчи не из чего
+    //
+    if (change.content.size() == d->document->content().size()
+        && change.content == d->document->content()) {
+        return change;
+    }
+    //
+    // Формируем патчи отмены и повтора за одно сравнение документов
+    //
+    const auto [undoPatch, redoPatch]
+        = d->dmpController.makeUndoRedoPatches(d->document->content(), change.content);
+    change.undoPatch = undoPatch;
+    change.redoPatch = redoPatch;
+    return change;
+}
+
 AbstractImageWrapper* AbstractModel::imageWrapper() const
 {
     Q_ASSERT(d->image);
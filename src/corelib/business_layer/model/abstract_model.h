@@ -42,6 +42,20 @@ public:
      */
     void setDocument(Domain::DocumentObject* _document);
 
+    /**
+     * @brief Задать документ, элементы которого были заранее подготовлены через prepareItems
+     * @note Модель становится владельцем элементов
+     */
+    void setDocument(Domain::DocumentObject* _document,
+                     const QVector<AbstractModelItem*>& _preparedItems);
+
+    /**
+     * @brief Разобрать содержимое документа в отдельные от модели элементы
+     * @note Может выполняться в фоновом потоке, поэтому не должна менять модель
+     * @return Пустой список, если модель не умеет готовить элементы заранее
+     */
+    virtual QVector<AbstractModelItem*> prepareItems(const QByteArray& _content) const;
+
     /**
      * @brief Получить название документа
      */
@@ -67,6 +81,11 @@ public:
      */
     void setImageWrapper(AbstractImageWrapper* _image);
 
+    /**
+     * @brief Получить обёртку для работы с изображениями
+     */
+    AbstractImageWrapper* imageWrapper() const;
+
     /**
      * @brief Очистить все загруженные данные
      */
@@ -109,6 +128,19 @@ public:
      */
     bool isRedoInProcess() const;
 
+    /**
+     * @brief Восстановить прошлое состояние документа, наложив патчи повтора изменений на снимок
+     * @note Модель при этом не меняется, а содержимое можно загрузить в неё, или в новую модель
+     */
+    QByteArray restoreContent(const QByteArray& _keyframeContent,
+                              const QVector<QByteArray>& _redoPatches) const;
+
+    /**
+     * @brief Тэги документа, по которым формируются патчи его изменений
+     * @note Нужны, чтобы работать с патчами изменений документа вне модели
+     */
+    QVector<QString> xmlTags() const;
+
     /**
      * @brief Смержить документ с заданным
      */
@@ -200,6 +232,12 @@ protected:
      */
     virtual void initDocument() = 0;
 
+    /**
+     * @brief Настроить документ из заранее подготовленных элементов
+     * @note По умолчанию элементы удаляются, а документ настраивается обычным образом
+     */
+    virtual void initDocumentFromItems(const QVector<AbstractModelItem*>& _items);
+
     /**
      * @brief Очистить документ
      */
@@ -217,9 +255,20 @@ protected:
     virtual ChangeCursor applyPatch(const QByteArray& _patch);
 
     /**
-     * @brief Получить обёртку для работы с изображениями
+     * @brief Изменение содержимого документа с момента последнего сохранения
+     * @note Если содержимое не изменилось, то патчи пустые
      */
-    AbstractImageWrapper* imageWrapper() const;
+    struct ContentChange {
+        QByteArray content;
+        QByteArray undoPatch;
+        QByteArray redoPatch;
+    };
+
+    /**
+     * @brief Сформировать новое содержимое документа и патчи его изменения
+     * @note По умолчанию документ формируется и сравнивается с сохранённым целиком
+     */
+    virtual ContentChange makeContentChange();
 
     /**
      * @brief Получить управляющего процессом применения изменений
@@ -15,6 +15,11 @@ public:
     AbstractModelItem* parent = nullptr;
     QVector<AbstractModelItem*> children;
     bool changed = false;
+
+    /**
+     * @brief Ревизия элемента
+     */
+    quint64 revision = 1;
 };
 
 AbstractModelItem::Implementation::~Implementation()
@@ -207,6 +212,7 @@ void AbstractModelItem::sortChildren(
     const std::function<bool(AbstractModelItem*, AbstractModelItem*)>& _sorter)
 {
     std::sort(d->children.begin(), d->children.end(), _sorter);
+    updateRevision();
 }
 
 AbstractModelItem* AbstractModelItem::childAt(int _index) const
@@ -224,6 +230,8 @@ void AbstractModelItem::setChanged(bool _changed)
     d->changed = _changed;
 
     if (_changed) {
+        ++d->revision;
+
         //
         // Сначала обрабатываем собственное изменение элемента
         //
@@ -238,6 +246,11 @@ void AbstractModelItem::setChanged(bool _changed)
     }
 }
 
+quint64 AbstractModelItem::revision() const
+{
+    return d->revision;
+}
+
 bool AbstractModelItem::isFilterAccepted(const QString& _text, bool _isCaseSensitive,
                                          int _filterType) const
 {
@@ -247,4 +260,11 @@ bool AbstractModelItem::isFilterAccepted(const QString& _text, bool _isCaseSensi
     return false;
 }
 
+void AbstractModelItem::updateRevision()
+{
+    for (auto item = this; item != nullptr; item = item->d->parent) {
+        ++item->d->revision;
+    }
+}
+
 } // namespace BusinessLayer
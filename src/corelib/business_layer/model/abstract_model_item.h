@@ -111,6 +111,12 @@ public:
     bool isChanged() const;
     void setChanged(bool _changed);
 
+    /**
+     * @brief Ревизия элемента, увеличивается при каждом изменении самого элемента или его детей
+     * @note Используется для инвалидации закешированных данных, например xml
+     */
+    quint64 revision() const;
+
     /**
      * @brief Подходит ли элемент под условия заданного фильтра
      */
@@ -118,6 +124,11 @@ public:
                                   int _filterType) const;
 
 protected:
+    /**
+     * @brief Обновить ревизию элемента и всех его родителей, не помечая их изменёнными
+     */
+    void updateRevision();
+
     /**
      * @brief Возможность обработки изменния для дочерних классов
      */
@@ -358,116 +358,6 @@ void AudioplayTextModel::updateCharacterName(const QString& _oldName, const QStr
     endChangeRows();
 }
 
-QVector<QModelIndex> AudioplayTextModel::characterDialogues(const QString& _name) const
-{
-    QVector<QModelIndex> modelIndexes;
-    for (int row = 0; row < rowCount(); ++row) {
-        modelIndexes.append(index(row, 0));
-    }
-    QString lastCharacter;
-    QVector<QModelIndex> dialoguesIndexes;
-    while (!modelIndexes.isEmpty()) {
-        const auto itemIndex = modelIndexes.takeFirst();
-        const auto item = itemForIndex(itemIndex);
-        if (item->type() == TextModelItemType::Text) {
-            const auto textItem = static_cast<TextModelTextItem*>(item);
-            switch (textItem->paragraphType()) {
-            case TextParagraphType::Character: {
-                lastCharacter = AudioplayCharacterParser::name(textItem->text());
-                break;
-            }
-
-            case TextParagraphType::Parenthetical: {
-                //
-                // Не очищаем имя персонажа, идём до реплики
-                //
-                break;
-            }
-
-            case TextParagraphType::Dialogue:
-            case TextParagraphType::Lyrics: {
-                if (lastCharacter == _name) {
-                    dialoguesIndexes.append(itemIndex);
-                }
-                break;
-            }
-
-            default: {
-                lastCharacter.clear();
-                break;
-            }
-            }
-        }
-
-        for (int childRow = 0; childRow < rowCount(itemIndex); ++childRow) {
-            modelIndexes.append(index(childRow, 0, itemIndex));
-        }
-    }
-
-    return dialoguesIndexes;
-}
-
-QVector<QString> AudioplayTextModel::findCharactersFromText() const
-{
-    QVector<QString> characters;
-    QHash<QString, int> charactersDialogues;
-    std::function<void(const TextModelItem*)> findCharacters;
-    findCharacters
-        = [&characters, &charactersDialogues, &findCharacters](const TextModelItem* _item) {
-              for (int childIndex = 0; childIndex < _item->childCount(); ++childIndex) {
-                  auto childItem = _item->childAt(childIndex);
-                  switch (childItem->type()) {
-                  case TextModelItemType::Folder:
-                  case TextModelItemType::Group: {
-                      findCharacters(childItem);
-                      break;
-                  }
-
-                  case TextModelItemType::Text: {
-                      auto textItem = static_cast<TextModelTextItem*>(childItem);
-                      if (textItem->paragraphType() == TextParagraphType::Character) {
-                          const auto character = AudioplayCharacterParser::name(textItem->text());
-                          if (charactersDialogues.contains(character)) {
-                              ++charactersDialogues[character];
-                          } else {
-                              characters.append(character);
-                              charactersDialogues.insert(character, 1);
-                          }
-                      }
-                      break;
-                  }
-
-                  default:
-                      break;
-                  }
-              }
-          };
-    findCharacters(d->rootItem());
-    std::sort(characters.begin(), characters.end(),
-              [&charactersDialogues](const QString& _lhs, const QString& _rhs) {
-                  return charactersDialogues.value(_lhs) > charactersDialogues.value(_rhs);
-              });
-
-    return characters;
-}
-
-void AudioplayTextModel::updateLocationName(const QString& _oldName, const QString& _newName)
-{
-    Q_UNUSED(_oldName)
-    Q_UNUSED(_newName)
-}
-
-QVector<QModelIndex> AudioplayTextModel::locationScenes(const QString& _name) const
-{
-    Q_UNUSED(_name);
-    return {};
-}
-
-QVector<QString> AudioplayTextModel::findLocationsFromText() const
-{
-    return {};
-}
-
 std::chrono::milliseconds AudioplayTextModel::duration() const
 {
     return static_cast<AudioplayTextModelFolderItem*>(d->rootItem())->duration();
@@ -568,42 +458,7 @@ void AudioplayTextModel::updateRuntimeDictionaries()
     //
     // В противном случае, собираем персонажей из текста
     //
-    QSet<QString> characters;
-    std::function<void(const TextModelItem*)> findInText;
-    findInText = [&findInText, &characters](const TextModelItem* _item) {
-        for (int childIndex = 0; childIndex < _item->childCount(); ++childIndex) {
-            auto childItem = _item->childAt(childIndex);
-            switch (childItem->type()) {
-            case TextModelItemType::Folder:
-            case TextModelItemType::Group: {
-                findInText(childItem);
-                break;
-            }
-
-            case TextModelItemType::Text: {
-                auto textItem = static_cast<AudioplayTextModelTextItem*>(childItem);
-
-                switch (textItem->paragraphType()) {
-                case TextParagraphType::Character: {
-                    characters.insert(AudioplayCharacterParser::name(textItem->text()));
-                    break;
-                }
-
-                default: {
-                    break;
-                }
-                }
-
-                break;
-            }
-
-            default:
-                break;
-            }
-        }
-    };
-    findInText(d->rootItem());
-    characters.remove({});
+    auto characters = charactersFromIndex();
     //
     // ... не забываем приаттачить всех персонажей, у кого определена роль в истории
     //
@@ -671,4 +526,13 @@ ChangeCursor AudioplayTextModel::applyPatch(const QByteArray& _patch)
     return changeCursor;
 }
 
+QVector<QString> AudioplayTextModel::charactersFromItem(const TextModelTextItem* _item) const
+{
+    if (_item->paragraphType() != TextParagraphType::Character) {
+        return {};
+    }
+
+    return { AudioplayCharacterParser::name(_item->text()) };
+}
+
 } // namespace BusinessLayer
@@ -4,9 +4,14 @@
 #include <business_layer/model/characters/characters_model.h>
 #include <business_layer/model/locations/location_model.h>
 #include <business_layer/model/locations/locations_model.h>
+#include <business_layer/model/text/text_model_text_item.h>
+#include <business_layer/templates/text_template.h>
+#include <utils/helpers/text_helper.h>
 
 #include <QStringListModel>
 
+#include <algorithm>
+
 
 namespace BusinessLayer {
 
@@ -20,6 +25,31 @@ public:
      */
     TextModelItem* rootItem() const;
 
+    /**
+     * @brief Построить индекс вхождений, если он ещё не построен
+     */
+    void buildOccurrencesIndexIfNeeded();
+
+    /**
+     * @brief Сбросить индекс вхождений, чтобы он был построен заново при следующем запросе
+     */
+    void invalidateOccurrencesIndex();
+
+    /**
+     * @brief Добавить в индекс вхождения из заданного элемента и, при необходимости, его детей
+     */
+    void indexItem(TextModelItem* _item, bool _withChildren);
+
+    /**
+     * @brief Убрать из индекса вхождения из заданного элемента и, при необходимости, его детей
+     */
+    void unindexItem(TextModelItem* _item, bool _withChildren);
+
+    /**
+     * @brief Упорядочить абзацы в порядке их следования в документе
+     */
+    QVector<TextModelTextItem*> sortedItems(const QSet<TextModelTextItem*>& _items) const;
+
 
     /**
      * @brief Родительский элемент
@@ -46,6 +76,18 @@ public:
      */
     QScopedPointer<QStringListModel> charactersModelFromText;
     QScopedPointer<QStringListModel> locationsModelFromText;
+
+    /**
+     * @brief Индекс вхождений персонажей и локаций в абзацы текста
+     */
+    struct ItemOccurrences {
+        QVector<QString> characters;
+        QString location;
+    };
+    bool isOccurrencesIndexBuilt = false;
+    QHash<TextModelTextItem*, ItemOccurrences> itemsOccurrences;
+    QHash<QString, QSet<TextModelTextItem*>> charactersItems;
+    QHash<QString, QSet<TextModelTextItem*>> locationsItems;
 };
 
 ScriptTextModel::Implementation::Implementation(ScriptTextModel* _q)
@@ -58,6 +100,129 @@ TextModelItem* ScriptTextModel::Implementation::rootItem() const
     return q->itemForIndex({});
 }
 
+void ScriptTextModel::Implementation::buildOccurrencesIndexIfNeeded()
+{
+    if (isOccurrencesIndexBuilt) {
+        return;
+    }
+
+    const bool withChildren = true;
+    indexItem(rootItem(), withChildren);
+    isOccurrencesIndexBuilt = true;
+}
+
+void ScriptTextModel::Implementation::invalidateOccurrencesIndex()
+{
+    isOccurrencesIndexBuilt = false;
+    itemsOccurrences.clear();
+    charactersItems.clear();
+    locationsItems.clear();
+}
+
+void ScriptTextModel::Implementation::indexItem(TextModelItem* _item, bool _withChildren)
+{
+    if (_item == nullptr) {
+        return;
+    }
+
+    if (_item->type() == TextModelItemType::Text) {
+        //
+        // Убираем прошлые вхождения абзаца и добавляем актуальные
+        //
+        const bool withChildren = false;
+        unindexItem(_item, withChildren);
+
+        const auto textItem = static_cast<TextModelTextItem*>(_item);
+        ItemOccurrences occurrences;
+        for (const auto& character : q->charactersFromItem(textItem)) {
+            if (!character.isEmpty() && !occurrences.characters.contains(character)) {
+                occurrences.characters.append(character);
+                charactersItems[character].insert(textItem);
+            }
+        }
+        occurrences.location = q->locationFromItem(textItem);
+        if (!occurrences.location.isEmpty()) {
+            locationsItems[occurrences.location].insert(textItem);
+        }
+        if (!occurrences.characters.isEmpty() || !occurrences.location.isEmpty()) {
+            itemsOccurrences.insert(textItem, occurrences);
+        }
+    }
+
+    if (!_withChildren) {
+        return;
+    }
+
+    for (int childIndex = 0; childIndex < _item->childCount(); ++childIndex) {
+        indexItem(_item->childAt(childIndex), _withChildren);
+    }
+}
+
+void ScriptTextModel::Implementation::unindexItem(TextModelItem* _item, bool _withChildren)
+{
+    if (_item == nullptr) {
+        return;
+    }
+
+    if (_item->type() == TextModelItemType::Text) {
+        const auto textItem = static_cast<TextModelTextItem*>(_item);
+        const auto occurrences = itemsOccurrences.take(textItem);
+        const auto removeOccurrence = [textItem](QHash<QString, QSet<TextModelTextItem*>>& _index,
+                                                 const QString& _name) {
+            auto iter = _index.find(_name);
+            if (iter == _index.end()) {
+                return;
+            }
+
+            iter->remove(textItem);
+            if (iter->isEmpty()) {
+                _index.erase(iter);
+            }
+        };
+        for (const auto& character : occurrences.characters) {
+            removeOccurrence(charactersItems, character);
+        }
+        if (!occurrences.location.isEmpty()) {
+            removeOccurrence(locationsItems, occurrences.location);
+        }
+    }
+
+    if (!_withChildren) {
+        return;
+    }
+
+    for (int childIndex = 0; childIndex < _item->childCount(); ++childIndex) {
+        unindexItem(_item->childAt(childIndex), _withChildren);
+    }
+}
+
+QVector<TextModelTextItem*> ScriptTextModel::Implementation::sortedItems(
+    const QSet<TextModelTextItem*>& _items) const
+{
+    //
+    // Позиция элемента в документе определяется номерами строк на пути от корня к нему
+    //
+    QVector<QPair<QVector<int>, TextModelTextItem*>> itemsPaths;
+    for (auto item : _items) {
+        QVector<int> path;
+        for (TextModelItem* child = item; child->parent() != nullptr; child = child->parent()) {
+            path.prepend(child->parent()->rowOfChild(child));
+        }
+        itemsPaths.append({ path, item });
+    }
+    std::sort(itemsPaths.begin(), itemsPaths.end(),
+              [](const QPair<QVector<int>, TextModelTextItem*>& _lhs,
+                 const QPair<QVector<int>, TextModelTextItem*>& _rhs) {
+                  return _lhs.first < _rhs.first;
+              });
+
+    QVector<TextModelTextItem*> items;
+    for (const auto& itemPath : std::as_const(itemsPaths)) {
+        items.append(itemPath.second);
+    }
+    return items;
+}
+
 
 // ****
 
@@ -66,6 +231,45 @@ ScriptTextModel::ScriptTextModel(QObject* _parent, TextModelFolderItem* _rootIte
     : TextModel(_parent, _rootItem)
     , d(new Implementation(this))
 {
+    //
+    // Индекс вхождений, если он уже построен, обновляем по мере изменения модели
+    //
+    connect(this, &ScriptTextModel::rowsInserted, this,
+            [this](const QModelIndex& _parent, int _first, int _last) {
+                if (!d->isOccurrencesIndexBuilt) {
+                    return;
+                }
+
+                for (int row = _first; row <= _last; ++row) {
+                    const bool withChildren = true;
+                    d->indexItem(itemForIndex(index(row, 0, _parent)), withChildren);
+                }
+            });
+    connect(this, &ScriptTextModel::rowsAboutToBeRemoved, this,
+            [this](const QModelIndex& _parent, int _first, int _last) {
+                if (!d->isOccurrencesIndexBuilt) {
+                    return;
+                }
+
+                for (int row = _first; row <= _last; ++row) {
+                    const bool withChildren = true;
+                    d->unindexItem(itemForIndex(index(row, 0, _parent)), withChildren);
+                }
+            });
+    connect(this, &ScriptTextModel::dataChanged, this,
+            [this](const QModelIndex& _topLeft, const QModelIndex& _bottomRight) {
+                if (!d->isOccurrencesIndexBuilt) {
+                    return;
+                }
+
+                for (int row = _topLeft.row(); row <= _bottomRight.row(); ++row) {
+                    const bool withChildren = false;
+                    d->indexItem(itemForIndex(index(row, 0, _topLeft.parent())), withChildren);
+                }
+            });
+    connect(this, &ScriptTextModel::modelAboutToBeReset, this,
+            [this] { d->invalidateOccurrencesIndex(); });
+    connect(this, &ScriptTextModel::modelReset, this, [this] { d->invalidateOccurrencesIndex(); });
 }
 
 ScriptTextModel::~ScriptTextModel() = default;
@@ -107,6 +311,76 @@ void ScriptTextModel::createCharacter(const QString& _name)
     d->charactersModel->createCharacter(_name);
 }
 
+QVector<QModelIndex> ScriptTextModel::characterDialogues(const QString& _name) const
+{
+    d->buildOccurrencesIndexIfNeeded();
+
+    QVector<QModelIndex> dialoguesIndexes;
+    const auto characterItems = d->sortedItems(d->charactersItems.value(_name));
+    for (const auto characterItem : characterItems) {
+        if (characterItem->paragraphType() != TextParagraphType::Character) {
+            continue;
+        }
+
+        //
+        // Реплики персонажа идут следом за блоком с его именем
+        //
+        const auto parentItem = characterItem->parent();
+        for (int row = parentItem->rowOfChild(characterItem) + 1; row < parentItem->childCount();
+             ++row) {
+            const auto item = parentItem->childAt(row);
+            if (item->type() != TextModelItemType::Text) {
+                continue;
+            }
+
+            const auto textItem = static_cast<TextModelTextItem*>(item);
+            if (textItem->paragraphType() == TextParagraphType::Parenthetical) {
+                //
+                // Не прерываемся, идём до реплики
+                //
+                continue;
+            }
+            if (textItem->paragraphType() != TextParagraphType::Dialogue
+                && textItem->paragraphType() != TextParagraphType::Lyrics) {
+                break;
+            }
+
+            dialoguesIndexes.append(indexForItem(textItem));
+        }
+    }
+
+    return dialoguesIndexes;
+}
+
+QVector<QString> ScriptTextModel::findCharactersFromText() const
+{
+    d->buildOccurrencesIndexIfNeeded();
+
+    //
+    // Сортируем персонажей по количеству реплик
+    //
+    QVector<QString> characters;
+    QHash<QString, int> charactersDialogues;
+    for (auto iter = d->charactersItems.cbegin(); iter != d->charactersItems.cend(); ++iter) {
+        int dialogues = 0;
+        for (const auto item : iter.value()) {
+            if (item->paragraphType() == TextParagraphType::Character) {
+                ++dialogues;
+            }
+        }
+        characters.append(iter.key());
+        charactersDialogues.insert(iter.key(), dialogues);
+    }
+    std::sort(characters.begin(), characters.end(),
+              [&charactersDialogues](const QString& _lhs, const QString& _rhs) {
+                  const auto lhsDialogues = charactersDialogues.value(_lhs);
+                  const auto rhsDialogues = charactersDialogues.value(_rhs);
+                  return lhsDialogues != rhsDialogues ? lhsDialogues > rhsDialogues : _lhs < _rhs;
+              });
+
+    return characters;
+}
+
 void ScriptTextModel::setLocationsModel(LocationsModel* _model)
 {
     if (d->locationsModel) {
@@ -144,6 +418,73 @@ void ScriptTextModel::createLocation(const QString& _name)
     d->locationsModel->createLocation(_name);
 }
 
+void ScriptTextModel::updateLocationName(const QString& _oldName, const QString& _newName)
+{
+    d->buildOccurrencesIndexIfNeeded();
+
+    //
+    // Копируем список абзацев, т.к. при обновлении текста индекс будет перестроен
+    //
+    const auto oldName = TextHelper::smartToUpper(_oldName);
+    const auto locationItems = d->locationsItems.value(oldName);
+    if (locationItems.isEmpty()) {
+        return;
+    }
+
+    beginChangeRows();
+    for (auto textItem : locationItems) {
+        auto text = textItem->text();
+        const auto nameIndex = TextHelper::smartToUpper(text).indexOf(oldName);
+        if (nameIndex == -1) {
+            continue;
+        }
+
+        text.remove(nameIndex, oldName.length());
+        text.insert(nameIndex, _newName);
+        textItem->setText(text);
+        updateItem(textItem);
+    }
+    endChangeRows();
+}
+
+QVector<QModelIndex> ScriptTextModel::locationScenes(const QString& _name) const
+{
+    d->buildOccurrencesIndexIfNeeded();
+
+    QVector<QModelIndex> scenesIndexes;
+    const auto locationItems = d->sortedItems(d->locationsItems.value(_name));
+    for (const auto locationItem : locationItems) {
+        const auto parentItem = locationItem->parent();
+        if (parentItem == nullptr || parentItem->type() != TextModelItemType::Group) {
+            continue;
+        }
+
+        const auto sceneIndex = indexForItem(parentItem);
+        if (!scenesIndexes.contains(sceneIndex)) {
+            scenesIndexes.append(sceneIndex);
+        }
+    }
+
+    return scenesIndexes;
+}
+
+QVector<QString> ScriptTextModel::findLocationsFromText() const
+{
+    d->buildOccurrencesIndexIfNeeded();
+
+    //
+    // Сортируем локации по количеству упоминаний
+    //
+    QVector<QString> locations = d->locationsItems.keys().toVector();
+    std::sort(locations.begin(), locations.end(), [this](const QString& _lhs, const QString& _rhs) {
+        const auto lhsCount = d->locationsItems.value(_lhs).size();
+        const auto rhsCount = d->locationsItems.value(_rhs).size();
+        return lhsCount != rhsCount ? lhsCount > rhsCount : _lhs < _rhs;
+    });
+
+    return locations;
+}
+
 void ScriptTextModel::updateRuntimeDictionariesIfNeeded()
 {
     if (!d->needUpdateRuntimeDictionaries) {
@@ -176,4 +517,38 @@ QStringListModel* ScriptTextModel::locationsModelFromText() const
     return d->locationsModelFromText.data();
 }
 
+QVector<QString> ScriptTextModel::charactersFromItem(const TextModelTextItem* _item) const
+{
+    Q_UNUSED(_item)
+    return {};
+}
+
+QString ScriptTextModel::locationFromItem(const TextModelTextItem* _item) const
+{
+    Q_UNUSED(_item)
+    return {};
+}
+
+QSet<QString> ScriptTextModel::charactersFromIndex() const
+{
+    d->buildOccurrencesIndexIfNeeded();
+
+    QSet<QString> characters;
+    for (auto iter = d->charactersItems.cbegin(); iter != d->charactersItems.cend(); ++iter) {
+        characters.insert(iter.key());
+    }
+    return characters;
+}
+
+QSet<QString> ScriptTextModel::locationsFromIndex() const
+{
+    d->buildOccurrencesIndexIfNeeded();
+
+    QSet<QString> locations;
+    for (auto iter = d->locationsItems.cbegin(); iter != d->locationsItems.cend(); ++iter) {
+        locations.insert(iter.key());
+    }
+    return locations;
+}
+
 } // namespace BusinessLayer
@@ -2,6 +2,8 @@
 
 #include <business_layer/model/text/text_model.h>
 
+#include <QSet>
+
 class QStringListModel;
 
 
@@ -52,12 +54,12 @@ public:
     /**
      * @brief Получить список реплик персонажа
      */
-    virtual QVector<QModelIndex> characterDialogues(const QString& _name) const = 0;
+    virtual QVector<QModelIndex> characterDialogues(const QString& _name) const;
 
     /**
      * @brief Найти всех персонажей сценария
      */
-    virtual QVector<QString> findCharactersFromText() const = 0;
+    virtual QVector<QString> findCharactersFromText() const;
 
     /**
      * @brief Модель локаций проекта
@@ -83,17 +85,17 @@ public:
     /**
      * @brief Обновить название локации
      */
-    virtual void updateLocationName(const QString& _oldName, const QString& _newName) = 0;
+    virtual void updateLocationName(const QString& _oldName, const QString& _newName);
 
     /**
      * @brief Получить список сцен локации
      */
-    virtual QVector<QModelIndex> locationScenes(const QString& _name) const = 0;
+    virtual QVector<QModelIndex> locationScenes(const QString& _name) const;
 
     /**
      * @brief Найти все локации сценария
      */
-    virtual QVector<QString> findLocationsFromText() const = 0;
+    virtual QVector<QString> findLocationsFromText() const;
 
     /**
      * @brief Настроить справочники сценария, которые собираются во время работы приложения
@@ -113,6 +115,24 @@ protected:
     QStringListModel* charactersModelFromText() const;
     QStringListModel* locationsModelFromText() const;
 
+    /**
+     * @brief Получить имена персонажей, упоминаемых в абзаце
+     * @note По ним строится индекс вхождений персонажей, который обновляется вместе с моделью,
+     *       поэтому поиск реплик и персонажей не требует разбора всего текста
+     */
+    virtual QVector<QString> charactersFromItem(const TextModelTextItem* _item) const;
+
+    /**
+     * @brief Получить название локации, упоминаемой в абзаце
+     */
+    virtual QString locationFromItem(const TextModelTextItem* _item) const;
+
+    /**
+     * @brief Получить всех персонажей и все локации, упоминаемые в тексте
+     */
+    QSet<QString> charactersFromIndex() const;
+    QSet<QString> locationsFromIndex() const;
+
 private:
     class Implementation;
     QScopedPointer<Implementation> d;
@@ -1471,21 +1471,22 @@ void CharacterModel::updateDialogues()
 }
 void CharacterModel::initImageWrapper()
 {
-    connect(imageWrapper(), &AbstractImageWrapper::imageUpdated, this,
-            [this](const QUuid& _uuid, const QPixmap& _image) {
-                for (auto& photo : d->photos) {
-                    if (photo.uuid == _uuid) {
-                        photo.image = _image;
-
-                        if (photo.uuid == d->photos.constFirst().uuid) {
-                            emit mainPhotoChanged(photo);
-                        }
-                        emit photosChanged(d->photos);
-
-                        break;
-                    }
+    auto updateImage = [this](const QUuid& _uuid, const QPixmap& _image) {
+        for (auto& photo : d->photos) {
+            if (photo.uuid == _uuid) {
+                photo.image = _image;
+
+                if (photo.uuid == d->photos.constFirst().uuid) {
+                    emit mainPhotoChanged(photo);
                 }
-            });
+                emit photosChanged(d->photos);
+
+                break;
+            }
+        }
+    };
+    connect(imageWrapper(), &AbstractImageWrapper::imageUpdated, this, updateImage);
+    connect(imageWrapper(), &AbstractImageWrapper::imageLoaded, this, updateImage);
 }
 
 void CharacterModel::initDocument()
@@ -111,16 +111,17 @@ void ImagesGalleryModel::removePhoto(const QUuid& _photoUuid)
 
 void ImagesGalleryModel::initImageWrapper()
 {
-    connect(imageWrapper(), &AbstractImageWrapper::imageUpdated, this,
-            [this](const QUuid& _uuid, const QPixmap& _image) {
-                for (auto& photo : d->photos) {
-                    if (photo.uuid == _uuid) {
-                        photo.image = _image;
-                        emit photosChanged(d->photos);
-                        break;
-                    }
-                }
-            });
+    auto updateImage = [this](const QUuid& _uuid, const QPixmap& _image) {
+        for (auto& photo : d->photos) {
+            if (photo.uuid == _uuid) {
+                photo.image = _image;
+                emit photosChanged(d->photos);
+                break;
+            }
+        }
+    };
+    connect(imageWrapper(), &AbstractImageWrapper::imageUpdated, this, updateImage);
+    connect(imageWrapper(), &AbstractImageWrapper::imageLoaded, this, updateImage);
 }
 
 void ImagesGalleryModel::initDocument()
@@ -183,14 +183,15 @@ void ProjectInformationModel::setTeammates(const QVector<Domain::TeamMemberInfo>
 
 void ProjectInformationModel::initImageWrapper()
 {
-    connect(imageWrapper(), &AbstractImageWrapper::imageUpdated, this,
-            [this](const QUuid& _uuid, const QPixmap& _image) {
-                if (_uuid != d->cover.uuid) {
-                    return;
-                }
-
-                setCover(_uuid, _image);
-            });
+    auto updateImage = [this](const QUuid& _uuid, const QPixmap& _image) {
+        if (_uuid != d->cover.uuid) {
+            return;
+        }
+
+        setCover(_uuid, _image);
+    };
+    connect(imageWrapper(), &AbstractImageWrapper::imageUpdated, this, updateImage);
+    connect(imageWrapper(), &AbstractImageWrapper::imageLoaded, this, updateImage);
 }
 
 void ProjectInformationModel::initDocument()
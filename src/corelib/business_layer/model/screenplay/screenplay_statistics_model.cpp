@@ -9,9 +9,14 @@
 #include <business_layer/reports/screenplay/screenplay_dialogues_report.h>
 #include <business_layer/reports/screenplay/screenplay_gender_report.h>
 #include <business_layer/reports/screenplay/screenplay_location_report.h>
+#include <business_layer/reports/screenplay/screenplay_report_snapshot.h>
 #include <business_layer/reports/screenplay/screenplay_scene_report.h>
 #include <business_layer/reports/screenplay/screenplay_summary_report.h>
 
+#include <QtConcurrentMap>
+
+#include <functional>
+
 
 namespace BusinessLayer {
 
@@ -62,14 +67,34 @@ void ScreenplayStatisticsModel::updateReports()
         return;
     }
 
-    d->summaryReport.build(d->textModel);
-    d->sceneReport.build(d->textModel);
-    d->castReport.build(d->textModel);
-    d->dialoguesReport.build(d->textModel);
-    d->locationReport.build(d->textModel);
-    d->genderReport.build(d->textModel);
-    d->structureAnalysisPlot.build(d->textModel);
-    d->charactersActivityPlot.build(d->textModel);
+    //
+    // Все отчёты и графики строятся по общему снимку сценария, поэтому сначала собираем его
+    // за один проход по модели, а отчёты и графики затем берут его из кэша
+    //
+    ScreenplayReportSnapshot::forModel(d->textModel);
+
+    //
+    // Снимок неизменяемый, поэтому независимые друг от друга отчёты и графики подготавливаем
+    // параллельно, а модель в это время не меняется, т.к. её поток ждёт окончания подготовки
+    //
+    const QVector<AbstractReport*> reports = {
+        &d->summaryReport,  &d->sceneReport,    &d->castReport,
+        &d->dialoguesReport, &d->locationReport, &d->genderReport,
+    };
+    QVector<std::function<void()>> tasks;
+    for (auto report : reports) {
+        tasks.append([this, report] { report->prepare(d->textModel); });
+    }
+    tasks.append([this] { d->structureAnalysisPlot.build(d->textModel); });
+    tasks.append([this] { d->charactersActivityPlot.build(d->textModel); });
+    QtConcurrent::blockingMap(tasks, [](const std::function<void()>& _task) { _task(); });
+
+    //
+    // ... а модели отчётов, на которые могут смотреть представления, наполняем уже в потоке модели
+    //
+    for (auto report : reports) {
+        report->applyPrepared(d->textModel);
+    }
 }
 
 const ScreenplaySummaryReport& ScreenplayStatisticsModel::summaryReport() const
@@ -322,225 +322,6 @@ void ScreenplayTextModel::updateCharacterName(const QString& _oldName, const QSt
     endChangeRows();
 }
 
-QVector<QModelIndex> ScreenplayTextModel::characterDialogues(const QString& _name) const
-{
-    QVector<QModelIndex> modelIndexes;
-    for (int row = 0; row < rowCount(); ++row) {
-        modelIndexes.append(index(row, 0));
-    }
-    QString lastCharacter;
-    QVector<QModelIndex> dialoguesIndexes;
-    while (!modelIndexes.isEmpty()) {
-        const auto itemIndex = modelIndexes.takeFirst();
-        const auto item = itemForIndex(itemIndex);
-        if (item->type() == TextModelItemType::Text) {
-            const auto textItem = static_cast<TextModelTextItem*>(item);
-            switch (textItem->paragraphType()) {
-            case TextParagraphType::Character: {
-                lastCharacter = ScreenplayCharacterParser::name(textItem->text());
-                break;
-            }
-
-            case TextParagraphType::Parenthetical: {
-                //
-                // Не очищаем имя персонажа, идём до реплики
-                //
-                break;
-            }
-
-            case TextParagraphType::Dialogue:
-            case TextParagraphType::Lyrics: {
-                if (lastCharacter == _name) {
-                    dialoguesIndexes.append(itemIndex);
-                }
-                break;
-            }
-
-            default: {
-                lastCharacter.clear();
-                break;
-            }
-            }
-        }
-
-        for (int childRow = 0; childRow < rowCount(itemIndex); ++childRow) {
-            modelIndexes.append(index(childRow, 0, itemIndex));
-        }
-    }
-
-    return dialoguesIndexes;
-}
-
-QVector<QString> ScreenplayTextModel::findCharactersFromText() const
-{
-    QVector<QString> characters;
-    QHash<QString, int> charactersDialogues;
-    std::function<void(const TextModelItem*)> findCharacters;
-    findCharacters
-        = [&characters, &charactersDialogues, &findCharacters](const TextModelItem* _item) {
-              for (int childIndex = 0; childIndex < _item->childCount(); ++childIndex) {
-                  auto childItem = _item->childAt(childIndex);
-                  switch (childItem->type()) {
-                  case TextModelItemType::Folder:
-                  case TextModelItemType::Group: {
-                      findCharacters(childItem);
-                      break;
-                  }
-
-                  case TextModelItemType::Text: {
-                      auto textItem = static_cast<ScreenplayTextModelTextItem*>(childItem);
-                      if (textItem->paragraphType() == TextParagraphType::SceneCharacters) {
-                          const auto textCharacters
-                              = ScreenplaySceneCharactersParser::characters(textItem->text());
-                          for (const auto& character : textCharacters) {
-                              if (!charactersDialogues.contains(character)) {
-                                  characters.append(character);
-                                  charactersDialogues.insert(character, 0);
-                              }
-                          }
-                      } else if (textItem->paragraphType() == TextParagraphType::Character) {
-                          const auto character = ScreenplayCharacterParser::name(textItem->text());
-                          if (charactersDialogues.contains(character)) {
-                              ++charactersDialogues[character];
-                          } else {
-                              characters.append(character);
-                              charactersDialogues.insert(character, 1);
-                          }
-                      }
-                      break;
-                  }
-
-                  default:
-                      break;
-                  }
-              }
-          };
-    findCharacters(d->rootItem());
-    std::sort(characters.begin(), characters.end(),
-              [&charactersDialogues](const QString& _lhs, const QString& _rhs) {
-                  return charactersDialogues.value(_lhs) > charactersDialogues.value(_rhs);
-              });
-
-    return characters;
-}
-
-QVector<QModelIndex> ScreenplayTextModel::locationScenes(const QString& _name) const
-{
-    QVector<QModelIndex> modelIndexes;
-    for (int row = 0; row < rowCount(); ++row) {
-        modelIndexes.append(index(row, 0));
-    }
-    QVector<QModelIndex> dialoguesIndexes;
-    while (!modelIndexes.isEmpty()) {
-        const auto itemIndex = modelIndexes.takeFirst();
-        const auto item = itemForIndex(itemIndex);
-        if (item->type() == TextModelItemType::Group) {
-            const auto groupItem = static_cast<TextModelGroupItem*>(item);
-            switch (groupItem->groupType()) {
-            case TextGroupType::Scene: {
-                if (_name == ScreenplaySceneHeadingParser::location(groupItem->heading())) {
-                    dialoguesIndexes.append(itemIndex);
-                }
-                break;
-            }
-
-            default: {
-                break;
-            }
-            }
-        }
-
-        for (int childRow = 0; childRow < rowCount(itemIndex); ++childRow) {
-            modelIndexes.append(index(childRow, 0, itemIndex));
-        }
-    }
-
-    return dialoguesIndexes;
-}
-
-QVector<QString> ScreenplayTextModel::findLocationsFromText() const
-{
-    QVector<QString> locations;
-    QHash<QString, int> locationsCount;
-    std::function<void(const TextModelItem*)> findLocations;
-    findLocations = [&locations, &locationsCount, &findLocations](const TextModelItem* _item) {
-        for (int childIndex = 0; childIndex < _item->childCount(); ++childIndex) {
-            auto childItem = _item->childAt(childIndex);
-            switch (childItem->type()) {
-            case TextModelItemType::Folder:
-            case TextModelItemType::Group: {
-                findLocations(childItem);
-                break;
-            }
-
-            case TextModelItemType::Text: {
-                auto textItem = static_cast<ScreenplayTextModelTextItem*>(childItem);
-                if (textItem->paragraphType() == TextParagraphType::SceneHeading) {
-                    const auto location = ScreenplaySceneHeadingParser::location(textItem->text());
-                    if (locationsCount.contains(location)) {
-                        ++locationsCount[location];
-                    } else {
-                        locations.append(location);
-                        locationsCount.insert(location, 1);
-                    }
-                }
-                break;
-            }
-
-            default:
-                break;
-            }
-        }
-    };
-    findLocations(d->rootItem());
-    std::sort(locations.begin(), locations.end(),
-              [&locationsCount](const QString& _lhs, const QString& _rhs) {
-                  return locationsCount.value(_lhs) > locationsCount.value(_rhs);
-              });
-
-    return locations;
-}
-
-void ScreenplayTextModel::updateLocationName(const QString& _oldName, const QString& _newName)
-{
-    const auto oldName = TextHelper::smartToUpper(_oldName);
-    std::function<void(const TextModelItem*)> updateLocationBlock;
-    updateLocationBlock
-        = [this, oldName, _newName, &updateLocationBlock](const TextModelItem* _item) {
-              for (int childIndex = 0; childIndex < _item->childCount(); ++childIndex) {
-                  auto childItem = _item->childAt(childIndex);
-                  switch (childItem->type()) {
-                  case TextModelItemType::Folder:
-                  case TextModelItemType::Group: {
-                      updateLocationBlock(childItem);
-                      break;
-                  }
-
-                  case TextModelItemType::Text: {
-                      auto textItem = static_cast<ScreenplayTextModelTextItem*>(childItem);
-                      if (textItem->paragraphType() == TextParagraphType::SceneHeading
-                          && ScreenplaySceneHeadingParser::location(textItem->text()) == oldName) {
-                          auto text = textItem->text();
-                          const auto nameIndex = TextHelper::smartToUpper(text).indexOf(oldName);
-                          text.remove(nameIndex, oldName.length());
-                          text.insert(nameIndex, _newName);
-                          textItem->setText(text);
-                          updateItem(textItem);
-                      }
-                      break;
-                  }
-
-                  default:
-                      break;
-                  }
-              }
-          };
-
-    beginChangeRows();
-    updateLocationBlock(d->rootItem());
-    endChangeRows();
-}
-
 int ScreenplayTextModel::treatmentPageCount() const
 {
     return d->treatmentPageCount;
@@ -834,61 +615,10 @@ void ScreenplayTextModel::updateRuntimeDictionaries()
               .toBool();
 
     //
-    // Формируем списки персонажей и локаций
-    //
-    QSet<QString> characters;
-    QSet<QString> locations;
-
-    //
-    // Если нужно собирать персонажей и локации из текста
+    // Формируем списки персонажей и локаций из текста
     //
-    std::function<void(const TextModelItem*)> findInText;
-    findInText = [&findInText, &characters, &locations](const TextModelItem* _item) {
-        for (int childIndex = 0; childIndex < _item->childCount(); ++childIndex) {
-            auto childItem = _item->childAt(childIndex);
-            switch (childItem->type()) {
-            case TextModelItemType::Folder:
-            case TextModelItemType::Group: {
-                findInText(childItem);
-                break;
-            }
-
-            case TextModelItemType::Text: {
-                auto textItem = static_cast<ScreenplayTextModelTextItem*>(childItem);
-
-                switch (textItem->paragraphType()) {
-                case TextParagraphType::SceneHeading: {
-                    locations.insert(ScreenplaySceneHeadingParser::location(textItem->text()));
-                    break;
-                }
-                case TextParagraphType::SceneCharacters: {
-                    const auto sceneCharacters
-                        = ScreenplaySceneCharactersParser::characters(textItem->text());
-                    for (const auto& character : sceneCharacters) {
-                        characters.insert(character);
-                    }
-                    break;
-                }
-                case TextParagraphType::Character: {
-                    characters.insert(ScreenplayCharacterParser::name(textItem->text()));
-                    break;
-                }
-                default: {
-                    break;
-                }
-                }
-
-                break;
-            }
-
-            default:
-                break;
-            }
-        }
-    };
-    findInText(d->rootItem());
-    characters.remove({});
-    locations.remove({});
+    auto characters = charactersFromIndex();
+    auto locations = locationsFromIndex();
 
     //
     // ... не забываем приаттачить персонажей из общей модели
@@ -998,4 +728,30 @@ ChangeCursor ScreenplayTextModel::applyPatch(const QByteArray& _patch)
     return changeCursor;
 }
 
+QVector<QString> ScreenplayTextModel::charactersFromItem(const TextModelTextItem* _item) const
+{
+    switch (_item->paragraphType()) {
+    case TextParagraphType::SceneCharacters: {
+        return ScreenplaySceneCharactersParser::characters(_item->text()).toVector();
+    }
+
+    case TextParagraphType::Character: {
+        return { ScreenplayCharacterParser::name(_item->text()) };
+    }
+
+    default: {
+        return {};
+    }
+    }
+}
+
+QString ScreenplayTextModel::locationFromItem(const TextModelTextItem* _item) const
+{
+    if (_item->paragraphType() != TextParagraphType::SceneHeading) {
+        return {};
+    }
+
+    return ScreenplaySceneHeadingParser::location(_item->text());
+}
+
 } // namespace BusinessLayer
@@ -48,31 +48,6 @@ public:
      */
     void updateCharacterName(const QString& _oldName, const QString& _newName) override;
 
-    /**
-     * @brief Получить список реплик персонажа
-     */
-    QVector<QModelIndex> characterDialogues(const QString& _name) const override;
-
-    /**
-     * @brief Найти всех персонажей сценария
-     */
-    QVector<QString> findCharactersFromText() const override;
-
-    /**
-     * @brief Получить список сцен локации
-     */
-    QVector<QModelIndex> locationScenes(const QString& _name) const override;
-
-    /**
-     * @brief Найти все локации сценария
-     */
-    QVector<QString> findLocationsFromText() const override;
-
-    /**
-     * @brief Обновить название локации
-     */
-    void updateLocationName(const QString& _oldName, const QString& _newName) override;
-
     /**
      * @brief Количество страниц текста поэпизодника
      */
@@ -141,6 +116,12 @@ public:
     QStringList mimeTypes() const override;
 
 protected:
+    /**
+     * @brief Получить имена персонажей и название локации, упоминаемых в абзаце
+     */
+    QVector<QString> charactersFromItem(const TextModelTextItem* _item) const override;
+    QString locationFromItem(const TextModelTextItem* _item) const override;
+
     /**
      * @brief Инициилизировать пустой документ
      */
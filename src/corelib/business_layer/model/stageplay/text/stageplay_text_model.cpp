@@ -352,116 +352,6 @@ void StageplayTextModel::updateCharacterName(const QString& _oldName, const QStr
     endChangeRows();
 }
 
-QVector<QModelIndex> StageplayTextModel::characterDialogues(const QString& _name) const
-{
-    QVector<QModelIndex> modelIndexes;
-    for (int row = 0; row < rowCount(); ++row) {
-        modelIndexes.append(index(row, 0));
-    }
-    QString lastCharacter;
-    QVector<QModelIndex> dialoguesIndexes;
-    while (!modelIndexes.isEmpty()) {
-        const auto itemIndex = modelIndexes.takeFirst();
-        const auto item = itemForIndex(itemIndex);
-        if (item->type() == TextModelItemType::Text) {
-            const auto textItem = static_cast<TextModelTextItem*>(item);
-            switch (textItem->paragraphType()) {
-            case TextParagraphType::Character: {
-                lastCharacter = StageplayCharacterParser::name(textItem->text());
-                break;
-            }
-
-            case TextParagraphType::Parenthetical: {
-                //
-                // Не очищаем имя персонажа, идём до реплики
-                //
-                break;
-            }
-
-            case TextParagraphType::Dialogue:
-            case TextParagraphType::Lyrics: {
-                if (lastCharacter == _name) {
-                    dialoguesIndexes.append(itemIndex);
-                }
-                break;
-            }
-
-            default: {
-                lastCharacter.clear();
-                break;
-            }
-            }
-        }
-
-        for (int childRow = 0; childRow < rowCount(itemIndex); ++childRow) {
-            modelIndexes.append(index(childRow, 0, itemIndex));
-        }
-    }
-
-    return dialoguesIndexes;
-}
-
-QVector<QString> StageplayTextModel::findCharactersFromText() const
-{
-    QVector<QString> characters;
-    QHash<QString, int> charactersDialogues;
-    std::function<void(const TextModelItem*)> findCharacters;
-    findCharacters
-        = [&characters, &charactersDialogues, &findCharacters](const TextModelItem* _item) {
-              for (int childIndex = 0; childIndex < _item->childCount(); ++childIndex) {
-                  auto childItem = _item->childAt(childIndex);
-                  switch (childItem->type()) {
-                  case TextModelItemType::Folder:
-                  case TextModelItemType::Group: {
-                      findCharacters(childItem);
-                      break;
-                  }
-
-                  case TextModelItemType::Text: {
-                      auto textItem = static_cast<TextModelTextItem*>(childItem);
-                      if (textItem->paragraphType() == TextParagraphType::Character) {
-                          const auto character = StageplayCharacterParser::name(textItem->text());
-                          if (charactersDialogues.contains(character)) {
-                              ++charactersDialogues[character];
-                          } else {
-                              characters.append(character);
-                              charactersDialogues.insert(character, 1);
-                          }
-                      }
-                      break;
-                  }
-
-                  default:
-                      break;
-                  }
-              }
-          };
-    findCharacters(d->rootItem());
-    std::sort(characters.begin(), characters.end(),
-              [&charactersDialogues](const QString& _lhs, const QString& _rhs) {
-                  return charactersDialogues.value(_lhs) > charactersDialogues.value(_rhs);
-              });
-
-    return characters;
-}
-
-void StageplayTextModel::updateLocationName(const QString& _oldName, const QString& _newName)
-{
-    Q_UNUSED(_oldName)
-    Q_UNUSED(_newName)
-}
-
-QVector<QModelIndex> StageplayTextModel::locationScenes(const QString& _name) const
-{
-    Q_UNUSED(_name)
-    return {};
-}
-
-QVector<QString> StageplayTextModel::findLocationsFromText() const
-{
-    return {};
-}
-
 void StageplayTextModel::updateRuntimeDictionaries()
 {
     const bool showHintsForAllItems
@@ -480,42 +370,7 @@ void StageplayTextModel::updateRuntimeDictionaries()
     //
     // В противном случае, собираем персонажей из текста
     //
-    QSet<QString> characters;
-    std::function<void(const TextModelItem*)> findInText;
-    findInText = [&findInText, &characters](const TextModelItem* _item) {
-        for (int childIndex = 0; childIndex < _item->childCount(); ++childIndex) {
-            auto childItem = _item->childAt(childIndex);
-            switch (childItem->type()) {
-            case TextModelItemType::Folder:
-            case TextModelItemType::Group: {
-                findInText(childItem);
-                break;
-            }
-
-            case TextModelItemType::Text: {
-                auto textItem = static_cast<TextModelTextItem*>(childItem);
-
-                switch (textItem->paragraphType()) {
-                case TextParagraphType::Character: {
-                    characters.insert(StageplayCharacterParser::name(textItem->text()));
-                    break;
-                }
-
-                default: {
-                    break;
-                }
-                }
-
-                break;
-            }
-
-            default:
-                break;
-            }
-        }
-    };
-    findInText(d->rootItem());
-    characters.remove({});
+    auto characters = charactersFromIndex();
     //
     // ... не забываем приаттачить всех персонажей, у кого определена роль в истории
     //
@@ -583,4 +438,13 @@ ChangeCursor StageplayTextModel::applyPatch(const QByteArray& _patch)
     return changeCursor;
 }
 
+QVector<QString> StageplayTextModel::charactersFromItem(const TextModelTextItem* _item) const
+{
+    if (_item->paragraphType() != TextParagraphType::Character) {
+        return {};
+    }
+
+    return { StageplayCharacterParser::name(_item->text()) };
+}
+
 } // namespace BusinessLayer
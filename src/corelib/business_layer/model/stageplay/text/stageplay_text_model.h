@@ -36,31 +36,6 @@ public:
      */
     void updateCharacterName(const QString& _oldName, const QString& _newName) override;
 
-    /**
-     * @brief Получить список реплик персонажа
-     */
-    QVector<QModelIndex> characterDialogues(const QString& _name) const override;
-
-    /**
-     * @brief Найти всех персонажей пьесы
-     */
-    QVector<QString> findCharactersFromText() const override;
-
-    /**
-     * @brief Обновить название локации
-     */
-    void updateLocationName(const QString& _oldName, const QString& _newName) override;
-
-    /**
-     * @brief Получить список сцен локации
-     */
-    QVector<QModelIndex> locationScenes(const QString& _name) const override;
-
-    /**
-     * @brief Найти все локации сценария
-     */
-    QVector<QString> findLocationsFromText() const override;
-
     /**
      * @brief Настроить справочники сценария, которые собираются во время работы приложения
      */
@@ -93,6 +68,11 @@ public:
     void setTextPageCount(int _count);
 
 protected:
+    /**
+     * @brief Получить имена персонажей, упоминаемых в абзаце
+     */
+    QVector<QString> charactersFromItem(const TextModelTextItem* _item) const override;
+
     /**
      * @brief Инициилизировать пустой документ
      */
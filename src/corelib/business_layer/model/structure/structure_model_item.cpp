@@ -3,6 +3,7 @@
 #include <domain/document_object.h>
 
 #include <QColor>
+#include <QHash>
 #include <QUuid>
 #include <QVariant>
 #include <QVector>
@@ -203,6 +204,11 @@ bool StructureModelItem::isEqual(const StructureModelItem* _other) const
         && d->readOnly == _other->d->readOnly && d->versions == _other->d->versions;
 }
 
+size_t StructureModelItem::equalityHash() const
+{
+    return qHash(d->uuid) ^ qHash(d->name);
+}
+
 void StructureModelItem::copyFrom(const StructureModelItem* _other) const
 {
     if (_other == nullptr) {
@@ -88,6 +88,7 @@ public:
     int subtype() const;
     QByteArray toXml() const;
     bool isEqual(const StructureModelItem* _other) const;
+    size_t equalityHash() const;
     void copyFrom(const StructureModelItem* _other) const;
     /** @} */
 
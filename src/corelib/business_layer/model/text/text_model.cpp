@@ -25,6 +25,7 @@
 #include <QDateTime>
 #include <QDomDocument>
 #include <QMimeData>
+#include <QScopedValueRollback>
 #include <QStringListModel>
 #include <QXmlStreamReader>
 
@@ -35,6 +36,30 @@
 
 namespace BusinessLayer {
 
+namespace {
+
+/**
+ * @brief Флаг подготовки элементов вне модели в текущем потоке
+ */
+thread_local bool g_isPreparingItems = false;
+
+/**
+ * @brief Обновить счётчики всех текстовых элементов заданного элемента
+ */
+void updateTextItemsCounters(TextModelItem* _item)
+{
+    for (int childIndex = 0; childIndex < _item->childCount(); ++childIndex) {
+        auto childItem = _item->childAt(childIndex);
+        if (childItem->type() == TextModelItemType::Text) {
+            static_cast<TextModelTextItem*>(childItem)->updateCounters(true);
+        } else if (childItem->hasChildren()) {
+            updateTextItemsCounters(childItem);
+        }
+    }
+}
+
+} // namespace
+
 class TextModel::Implementation
 {
 public:
@@ -45,6 +70,11 @@ public:
      */
     void buildModel(Domain::DocumentObject* _document);
 
+    /**
+     * @brief Считать элементы верхнего уровня из xml, не добавляя их в модель
+     */
+    QVector<AbstractModelItem*> readItems(const QByteArray& _content) const;
+
     /**
      * @brief Сформировать xml из данных модели
      */
@@ -55,6 +85,55 @@ public:
      */
     void updateContentHash(const QByteArray& _xml = {}) const;
 
+    /**
+     * @brief Сформировать заголовок xml документа
+     */
+    QByteArray documentHeader(Domain::DocumentObject* _document) const;
+
+    /**
+     * @brief Складывается ли xml элемента из его заголовка и независимых друг от друга xml детей
+     * @note Разорванные между страницами абзацы пишутся вместе со следующим абзацем, поэтому
+     *       элементы с ними так не собираются
+     */
+    bool isComposite(TextModelItem* _item) const;
+
+    /**
+     * @brief Получить заголовок составного элемента
+     */
+    QByteArray compositeHeader(TextModelItem* _item) const;
+
+    /**
+     * @brief Получить xml, который дитя добавляет в xml составного родителя
+     */
+    QByteArray childXml(TextModelItem* _parent, TextModelItem* _child) const;
+
+    /**
+     * @brief Определить длину xml в плоском тексте, в котором позиционируются патчи
+     */
+    int plainLength(const QByteArray& _xml) const;
+
+    /**
+     * @brief Запомнить состояние элемента и его детей с заданным xml
+     */
+    void rememberItem(TextModelItem* _item, const QByteArray& _xml);
+
+    /**
+     * @brief Забыть состояние элемента и его детей
+     */
+    void forgetItem(quint64 _serialNumber);
+
+    /**
+     * @brief Запомнить сохранённое содержимое документа и соответствующее ему состояние модели
+     */
+    void rememberContent(const QByteArray& _content);
+
+    /**
+     * @brief Сформировать изменение документа только по изменившимся с последнего сохранения
+     *        элементам
+     * @return false, если изменение нельзя определить по сохранённому состоянию модели
+     */
+    bool makeContentChange(ContentChange& _change);
+
 
     /**
      * @brief Родительский элемент
@@ -89,6 +168,33 @@ public:
      * @brief MD5-хэш текущего состояния контента
      */
     mutable QByteArray contentHash;
+
+    /**
+     * @brief Состояние элемента на момент последнего сохранения документа
+     */
+    struct SavedItem {
+        quint64 revision = 0;
+        int xmlLength = 0;
+        int plainLength = 0;
+
+        //
+        // Для составных элементов запоминаем заголовок и порядок детей
+        //
+        bool isComposite = false;
+        QByteArray header;
+        int headerPlainLength = 0;
+        QVector<quint64> children;
+    };
+
+    /**
+     * @brief Сохранённое состояние элементов модели по их серийным номерам
+     */
+    QHash<quint64, SavedItem> savedItems;
+
+    /**
+     * @brief Содержимое документа, которому соответствует сохранённое состояние элементов
+     */
+    QByteArray savedContent;
 };
 
 TextModel::Implementation::Implementation(TextModel* _q, TextModelFolderItem* _rootItem)
@@ -104,7 +210,13 @@ void TextModel::Implementation::buildModel(Domain::DocumentObject* _document)
         return;
     }
 
-    QXmlStreamReader contentReader(_document->content());
+    rootItem->appendItems(readItems(_document->content()));
+}
+
+QVector<AbstractModelItem*> TextModel::Implementation::readItems(const QByteArray& _content) const
+{
+    QVector<AbstractModelItem*> items;
+    QXmlStreamReader contentReader(_content);
     contentReader.readNextStartElement(); // document
     contentReader.readNextStartElement();
     while (!contentReader.atEnd()) {
@@ -114,15 +226,16 @@ void TextModel::Implementation::buildModel(Domain::DocumentObject* _document)
         }
 
         if (textFolderTypeFromString(currentTag) != TextFolderType::Undefined) {
-            rootItem->appendItem(q->createFolderItem(contentReader));
+            items.append(q->createFolderItem(contentReader));
         } else if (textGroupTypeFromString(currentTag) != TextGroupType::Undefined) {
-            rootItem->appendItem(q->createGroupItem(contentReader));
+            items.append(q->createGroupItem(contentReader));
         } else if (currentTag == xml::kSplitterTag) {
-            rootItem->appendItem(q->createSplitterItem(contentReader));
+            items.append(q->createSplitterItem(contentReader));
         } else {
-            rootItem->appendItem(q->createTextItem(contentReader));
+            items.append(q->createTextItem(contentReader));
         }
     }
+    return items;
 }
 
 QByteArray TextModel::Implementation::toXml(Domain::DocumentObject* _document) const
@@ -134,10 +247,8 @@ QByteArray TextModel::Implementation::toXml(Domain::DocumentObject* _document) c
     //
     // Формируем xml модели
     //
-    const bool addXmlHeader = true;
-    xml::TextModelXmlWriter xml(addXmlHeader);
-    xml += "<document mime-type=\"" + Domain::mimeTypeFor(_document->type())
-        + "\" version=\"1.0\">\n";
+    xml::TextModelXmlWriter xml;
+    xml += documentHeader(_document);
     for (int childIndex = 0; childIndex < rootItem->childCount(); ++childIndex) {
         xml += rootItem->childAt(childIndex)->toXml();
     }
@@ -169,6 +280,272 @@ void TextModel::Implementation::updateContentHash(const QByteArray& _xml) const
     contentHash = hash.result();
 }
 
+QByteArray TextModel::Implementation::documentHeader(Domain::DocumentObject* _document) const
+{
+    const bool addXmlHeader = true;
+    xml::TextModelXmlWriter xml(addXmlHeader);
+    xml += "<document mime-type=\"" + Domain::mimeTypeFor(_document->type())
+        + "\" version=\"1.0\">\n";
+    return xml.data();
+}
+
+bool TextModel::Implementation::isComposite(TextModelItem* _item) const
+{
+    //
+    // Элементы верхнего уровня пишутся в документ как есть
+    //
+    if (_item == rootItem) {
+        return true;
+    }
+
+    if (_item->type() != TextModelItemType::Folder && _item->type() != TextModelItemType::Group) {
+        return false;
+    }
+
+    for (int childIndex = 0; childIndex < _item->childCount(); ++childIndex) {
+        const auto child = _item->childAt(childIndex);
+        if (child->type() == TextModelItemType::Text
+            && static_cast<TextModelTextItem*>(child)->isBreakCorrectionStart()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+QByteArray TextModel::Implementation::compositeHeader(TextModelItem* _item) const
+{
+    if (_item == rootItem) {
+        return documentHeader(q->document());
+    }
+
+    if (_item->type() == TextModelItemType::Folder) {
+        return static_cast<TextModelFolderItem*>(_item)->xmlHeader();
+    }
+
+    Q_ASSERT(_item->type() == TextModelItemType::Group);
+    return static_cast<TextModelGroupItem*>(_item)->xmlHeader();
+}
+
+QByteArray TextModel::Implementation::childXml(TextModelItem* _parent, TextModelItem* _child) const
+{
+    //
+    // Внутри папок и групп корректирующие абзацы не пишутся, см. TextModelXmlWriter
+    //
+    if (_parent != rootItem && _child->type() == TextModelItemType::Text
+        && static_cast<TextModelTextItem*>(_child)->isCorrection()) {
+        return {};
+    }
+
+    return _child->toXml();
+}
+
+int TextModel::Implementation::plainLength(const QByteArray& _xml) const
+{
+    return q->dmpController().plainLength(QString::fromUtf8(_xml));
+}
+
+void TextModel::Implementation::rememberItem(TextModelItem* _item, const QByteArray& _xml)
+{
+    SavedItem savedItem;
+    savedItem.revision = _item->revision();
+    savedItem.xmlLength = _xml.size();
+    if (!isComposite(_item)) {
+        savedItem.plainLength = plainLength(_xml);
+    } else {
+        //
+        // Длины составного элемента собираем из длин его частей, чтобы не проходить по xml
+        // каждого из уровней вложенности повторно
+        //
+        savedItem.isComposite = true;
+        savedItem.header = compositeHeader(_item);
+        savedItem.headerPlainLength = plainLength(savedItem.header);
+        int partsLength = savedItem.header.size();
+        int partsPlainLength = savedItem.headerPlainLength;
+        for (int childIndex = 0; childIndex < _item->childCount(); ++childIndex) {
+            const auto child = _item->childAt(childIndex);
+            const auto xml = childXml(_item, child);
+            rememberItem(child, xml);
+            savedItem.children.append(child->serialNumber());
+            partsLength += xml.size();
+            partsPlainLength += savedItems.value(child->serialNumber()).plainLength;
+        }
+        savedItem.plainLength = partsPlainLength + plainLength(_xml.mid(partsLength));
+    }
+    savedItems.insert(_item->serialNumber(), savedItem);
+}
+
+void TextModel::Implementation::forgetItem(quint64 _serialNumber)
+{
+    const auto savedItem = savedItems.take(_serialNumber);
+    for (const auto childSerialNumber : savedItem.children) {
+        forgetItem(childSerialNumber);
+    }
+}
+
+void TextModel::Implementation::rememberContent(const QByteArray& _content)
+{
+    savedItems.clear();
+    savedContent = _content;
+    rememberItem(rootItem, _content);
+}
+
+bool TextModel::Implementation::makeContentChange(ContentChange& _change)
+{
+    const auto rootSavedItem = savedItems.constFind(rootItem->serialNumber());
+    if (rootSavedItem == savedItems.constEnd()) {
+        return false;
+    }
+
+    //
+    // Спускаемся от корня, пока изменения сосредоточены в одном составном элементе, который
+    // остался на своём месте и заголовок которого не изменился, попутно считая смещения
+    // изменившейся части в сохранённом xml и в плоском тексте
+    //
+    TextModelItem* container = rootItem;
+    const SavedItem* containerSavedItem = &rootSavedItem.value();
+    QVector<TextModelItem*> containers;
+    int xmlOffset = containerSavedItem->header.size();
+    int plainOffset = containerSavedItem->headerPlainLength;
+    int head = 0;
+    int tail = 0;
+    forever {
+        containers.append(container);
+        const auto& savedChildren = containerSavedItem->children;
+        const int childCount = container->childCount();
+        auto isUnchanged = [this, container, &savedChildren](int _savedIndex, int _index) {
+            const auto child = container->childAt(_index);
+            if (savedChildren.at(_savedIndex) != child->serialNumber()) {
+                return false;
+            }
+            const auto childSavedItem = savedItems.constFind(child->serialNumber());
+            return childSavedItem != savedItems.constEnd()
+                && childSavedItem->revision == child->revision();
+        };
+
+        head = 0;
+        while (head < childCount && head < savedChildren.size() && isUnchanged(head, head)) {
+            const auto childSavedItem = savedItems.constFind(savedChildren.at(head));
+            xmlOffset += childSavedItem->xmlLength;
+            plainOffset += childSavedItem->plainLength;
+            ++head;
+        }
+        tail = 0;
+        while (head + tail < childCount && head + tail < savedChildren.size()
+               && isUnchanged(savedChildren.size() - tail - 1, childCount - tail - 1)) {
+            ++tail;
+        }
+
+        if (childCount - head - tail != 1 || savedChildren.size() - head - tail != 1
+            || savedChildren.at(head) != container->childAt(head)->serialNumber()) {
+            break;
+        }
+        const auto child = container->childAt(head);
+        const auto childSavedItem = savedItems.constFind(child->serialNumber());
+        if (childSavedItem == savedItems.constEnd() || !childSavedItem->isComposite
+            || !isComposite(child) || compositeHeader(child) != childSavedItem->header) {
+            break;
+        }
+
+        container = child;
+        containerSavedItem = &childSavedItem.value();
+        xmlOffset += containerSavedItem->header.size();
+        plainOffset += containerSavedItem->headerPlainLength;
+    }
+
+    //
+    // Определяем изменившуюся часть сохранённого xml и формируем её новую версию
+    //
+    const auto savedChildren = containerSavedItem->children;
+    int beforeLength = 0;
+    int beforePlainLength = 0;
+    for (int index = head; index < savedChildren.size() - tail; ++index) {
+        const auto childSavedItem = savedItems.constFind(savedChildren.at(index));
+        if (childSavedItem == savedItems.constEnd()) {
+            return false;
+        }
+        beforeLength += childSavedItem->xmlLength;
+        beforePlainLength += childSavedItem->plainLength;
+    }
+    if (xmlOffset + beforeLength > savedContent.size()) {
+        return false;
+    }
+    QVector<TextModelItem*> afterItems;
+    QVector<QByteArray> afterItemsXml;
+    QByteArray after;
+    for (int index = head; index < container->childCount() - tail; ++index) {
+        afterItems.append(container->childAt(index));
+        afterItemsXml.append(childXml(container, afterItems.constLast()));
+        after += afterItemsXml.constLast();
+    }
+    const auto before = QByteArray::fromRawData(savedContent.constData() + xmlOffset, beforeLength);
+
+    //
+    // Сравниваем изменившуюся часть с небольшим контекстом вокруг, не разрезая тэгов
+    //
+    const int contextLength = 64;
+    int contextStart = std::max(0, xmlOffset - contextLength);
+    while (contextStart > 0 && savedContent.at(contextStart) != '<') {
+        --contextStart;
+    }
+    int contextEnd = std::min(static_cast<int>(savedContent.size()),
+                              xmlOffset + beforeLength + contextLength);
+    while (contextEnd < savedContent.size() && savedContent.at(contextEnd) != '<') {
+        ++contextEnd;
+    }
+    const auto headContext = savedContent.mid(contextStart, xmlOffset - contextStart);
+    const auto tailContext
+        = savedContent.mid(xmlOffset + beforeLength, contextEnd - xmlOffset - beforeLength);
+    if (before == after) {
+        _change.content = savedContent;
+    } else {
+        const auto [undoPatch, redoPatch] = q->dmpController().makeUndoRedoPatches(
+            QString::fromUtf8(headContext + before + tailContext),
+            QString::fromUtf8(headContext + after + tailContext),
+            plainOffset - plainLength(headContext));
+        _change.content = savedContent.left(xmlOffset) + after
+            + savedContent.mid(xmlOffset + beforeLength);
+        _change.undoPatch = undoPatch;
+        _change.redoPatch = redoPatch;
+    }
+
+#ifdef XML_CHECKS
+    if (_change.content != toXml(q->document())) {
+        qDebug(QString("Content built from changed items is\n\n%1\n\n")
+                   .arg(_change.content.constData())
+                   .toUtf8());
+        qDebug(QString("Model xml is\n\n%1\n\n").arg(toXml(q->document()).constData()).toUtf8());
+    }
+    Q_ASSERT(_change.content == toXml(q->document()));
+#endif
+
+    //
+    // Обновляем сохранённое состояние: заменяем изменившихся детей и корректируем длины
+    // и ревизии элементов, внутри которых они находятся
+    //
+    int afterPlainLength = 0;
+    QVector<quint64> afterSerialNumbers;
+    for (int index = head; index < savedChildren.size() - tail; ++index) {
+        forgetItem(savedChildren.at(index));
+    }
+    for (int index = 0; index < afterItems.size(); ++index) {
+        const auto item = afterItems.at(index);
+        rememberItem(item, afterItemsXml.at(index));
+        afterSerialNumbers.append(item->serialNumber());
+        afterPlainLength += savedItems.value(item->serialNumber()).plainLength;
+    }
+    for (auto item : std::as_const(containers)) {
+        auto& savedItem = savedItems[item->serialNumber()];
+        savedItem.revision = item->revision();
+        savedItem.xmlLength += after.size() - beforeLength;
+        savedItem.plainLength += afterPlainLength - beforePlainLength;
+    }
+    savedItems[container->serialNumber()].children = savedChildren.mid(0, head)
+        + afterSerialNumbers + savedChildren.mid(savedChildren.size() - tail);
+    savedContent = _change.content;
+
+    return true;
+}
+
 
 // ****
 
@@ -1799,6 +2176,24 @@ QByteArray TextModel::contentHash() const
     return d->contentHash;
 }
 
+QVector<AbstractModelItem*> TextModel::prepareItems(const QByteArray& _content) const
+{
+    //
+    // Пустой документ настраивается моделью самостоятельно
+    //
+    if (_content.isEmpty()) {
+        return {};
+    }
+
+    QScopedValueRollback isPreparingItemsRollback(g_isPreparingItems, true);
+    return d->readItems(_content);
+}
+
+bool TextModel::isPreparingItems()
+{
+    return g_isPreparingItems;
+}
+
 void TextModel::initDocument()
 {
     //
@@ -1822,6 +2217,20 @@ void TextModel::initDocument()
     finalizeInitialization();
 }
 
+void TextModel::initDocumentFromItems(const QVector<AbstractModelItem*>& _items)
+{
+    beginResetModelTransaction();
+    d->rootItem->appendItems(_items);
+    endResetModelTransaction();
+
+    //
+    // Счётчики элементов, подготовленных вне модели, не считались, поэтому считаем их сейчас
+    //
+    updateTextItemsCounters(d->rootItem);
+
+    finalizeInitialization();
+}
+
 void TextModel::clearDocument()
 {
     if (!d->rootItem->hasChildren()) {
@@ -1842,6 +2251,9 @@ void TextModel::clearDocument()
     while (d->rootItem->hasChildren()) {
         d->rootItem->removeItem(d->rootItem->childAt(0));
     }
+
+    d->savedItems.clear();
+    d->savedContent.clear();
 }
 
 QByteArray TextModel::toXml() const
@@ -1849,6 +2261,35 @@ QByteArray TextModel::toXml() const
     return d->toXml(document());
 }
 
+AbstractModel::ContentChange TextModel::makeContentChange()
+{
+    //
+    // Если документ не менялся в обход сохранения, то формируем изменение только по тем
+    // элементам, которые изменились с момента последнего сохранения
+    //
+    const auto& content = document()->content();
+    ContentChange change;
+    if (!d->savedContent.isNull() && d->savedContent.constData() == content.constData()
+        && d->savedContent.size() == content.size() && d->makeContentChange(change)) {
+        return change;
+    }
+
+    //
+    // В противном случае (первое сохранение после загрузки, отмена изменения, применение
+    // изменений с сервера) сравниваем документ целиком и запоминаем состояние модели заново
+    //
+    change = AbstractModel::makeContentChange();
+    if (!change.undoPatch.isEmpty() && !change.redoPatch.isEmpty()) {
+        d->rememberContent(change.content);
+    } else if (change.content.size() == content.size() && change.content == content) {
+        d->rememberContent(content);
+    } else {
+        d->savedItems.clear();
+        d->savedContent.clear();
+    }
+    return change;
+}
+
 ChangeCursor TextModel::applyPatch(const QByteArray& _patch)
 {
     Q_ASSERT(document());
@@ -1971,11 +2412,11 @@ ChangeCursor TextModel::applyPatch(const QByteArray& _patch)
     }
 
     //
-    // Если элеметов очень много, то обсчитывать все изменения будет очень дорого,
+    // Если элеметов очень много, то таблица расстояний между ними займёт слишком много памяти,
     // поэтому применяем грубую силу - просто накатываем патч и обновляем модель целиком
     //
-    const auto operationsLimit = 300;
-    if (oldItemsPlain.size() * newItemsPlain.size() / 2 > operationsLimit) {
+    const qint64 operationsLimit = 4'000'000;
+    if (static_cast<qint64>(oldItemsPlain.size()) * newItemsPlain.size() > operationsLimit) {
         Log::trace("Apply patch operations to much, avoid step by step procesing.");
 
         //
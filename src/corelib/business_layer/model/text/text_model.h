@@ -143,15 +143,29 @@ public:
      */
     QByteArray contentHash() const;
 
+    /**
+     * @brief Разобрать содержимое документа в отдельные от модели элементы
+     */
+    QVector<AbstractModelItem*> prepareItems(const QByteArray& _content) const override;
+
+    /**
+     * @brief Готовятся ли в текущем потоке элементы, которые ещё не добавлены в модель
+     * @note В этот момент элементы не должны обращаться к настройкам и шаблонам, т.к. те не
+     *       рассчитаны на работу из нескольких потоков
+     */
+    static bool isPreparingItems();
+
 protected:
     /**
      * @brief Реализация модели для работы с документами
      */
     /** @{ */
     void initDocument() override;
+    void initDocumentFromItems(const QVector<AbstractModelItem*>& _items) override;
     void clearDocument() override;
     QByteArray toXml() const override;
     ChangeCursor applyPatch(const QByteArray& _patch) override;
+    ContentChange makeContentChange() override;
     /** @} */
 
     /**
@@ -10,6 +10,7 @@
 #include <business_layer/templates/text_template.h>
 #include <utils/helpers/text_helper.h>
 
+#include <QHash>
 #include <QUuid>
 #include <QVariant>
 #include <QXmlStreamReader>
@@ -53,6 +54,12 @@ public:
      * @brief Название папки
      */
     QString heading;
+
+    /**
+     * @brief Закешированный xml элемента и ревизия элемента, для которой он был сформирован
+     */
+    QByteArray xml;
+    quint64 xmlRevision = 0;
 };
 
 
@@ -242,7 +249,16 @@ void TextModelFolderItem::readContent(QXmlStreamReader& _contentReader)
 
 QByteArray TextModelFolderItem::toXml() const
 {
-    return toXml(nullptr, 0, nullptr, 0, false);
+    //
+    // Пересобираем xml только если сам элемент, или кто-то из его детей изменились с момента
+    // последнего формирования, в противном случае используем закешированное значение
+    //
+    if (d->xmlRevision != revision()) {
+        d->xml = toXml(nullptr, 0, nullptr, 0, false);
+        d->xmlRevision = revision();
+    }
+
+    return d->xml;
 }
 
 QByteArray TextModelFolderItem::toXml(TextModelItem* _from, int _fromPosition, TextModelItem* _to,
@@ -389,6 +405,7 @@ void TextModelFolderItem::copyFrom(TextModelItem* _item)
     d->color = folderItem->d->color;
     d->description = folderItem->d->description;
     d->stamp = folderItem->d->stamp;
+    updateRevision();
 }
 
 bool TextModelFolderItem::isEqual(TextModelItem* _item) const
@@ -402,6 +419,11 @@ bool TextModelFolderItem::isEqual(TextModelItem* _item) const
         && d->description == folderItem->d->description && d->stamp == folderItem->d->stamp;
 }
 
+size_t TextModelFolderItem::equalityHash() const
+{
+    return qHash(d->uuid) ^ qHash(static_cast<int>(d->folderType));
+}
+
 void TextModelFolderItem::setHeading(const QString& _heading)
 {
     d->heading = _heading;
@@ -10,6 +10,7 @@
 #include <utils/helpers/text_helper.h>
 
 #include <QDateTime>
+#include <QHash>
 #include <QLocale>
 #include <QUuid>
 #include <QVariant>
@@ -104,6 +105,12 @@ public:
      * @brief Количество редакторских заметок
      */
     int reviewMarksSize = 0;
+
+    /**
+     * @brief Закешированный xml элемента и ревизия элемента, для которой он был сформирован
+     */
+    QByteArray xml;
+    quint64 xmlRevision = 0;
 };
 
 
@@ -163,6 +170,7 @@ void TextModelGroupItem::resetNumber()
 {
     if (d->number.has_value()) {
         d->number.reset();
+        updateRevision();
     }
 }
 
@@ -571,7 +579,16 @@ void TextModelGroupItem::readContent(QXmlStreamReader& _contentReader)
 
 QByteArray TextModelGroupItem::toXml() const
 {
-    return toXml(nullptr, 0, nullptr, 0, false);
+    //
+    // Пересобираем xml только если сам элемент, или кто-то из его детей изменились с момента
+    // последнего формирования, в противном случае используем закешированное значение
+    //
+    if (d->xmlRevision != revision()) {
+        d->xml = toXml(nullptr, 0, nullptr, 0, false);
+        d->xmlRevision = revision();
+    }
+
+    return d->xml;
 }
 
 QByteArray TextModelGroupItem::toXml(TextModelItem* _from, int _fromPosition, TextModelItem* _to,
@@ -702,6 +719,7 @@ void TextModelGroupItem::copyFrom(TextModelItem* _item)
     d->startDateTime = groupItem->d->startDateTime;
     d->stamp = groupItem->d->stamp;
     d->tags = groupItem->d->tags;
+    updateRevision();
 }
 
 bool TextModelGroupItem::isEqual(TextModelItem* _item) const
@@ -722,6 +740,11 @@ bool TextModelGroupItem::isEqual(TextModelItem* _item) const
         && d->stamp == groupItem->d->stamp && d->tags == groupItem->d->tags;
 }
 
+size_t TextModelGroupItem::equalityHash() const
+{
+    return qHash(d->uuid) ^ qHash(static_cast<int>(d->groupType));
+}
+
 void TextModelGroupItem::setHeading(const QString& _heading)
 {
     d->heading = _heading;
@@ -1,11 +1,24 @@
 #include "text_model_item.h"
 
+#include <QHash>
 #include <QVariant>
 #include <QXmlStreamReader>
 
+#include <atomic>
+
 
 namespace BusinessLayer {
 
+namespace {
+
+/**
+ * @brief Последний выданный серийный номер элемента
+ * @note Элементы могут создаваться и в фоновых потоках, при разборе документов
+ */
+std::atomic<quint64> s_lastSerialNumber{ 0 };
+
+} // namespace
+
 class TextModelItem::Implementation
 {
 public:
@@ -14,6 +27,7 @@ public:
     const TextModelItemType type;
     QString icon;
     const TextModel* model = nullptr;
+    const quint64 serialNumber = ++s_lastSerialNumber;
 
     //
     // Ридонли свойства, которые формируются по ходу работы
@@ -58,6 +72,11 @@ int TextModelItem::subtype() const
     return 0;
 }
 
+size_t TextModelItem::equalityHash() const
+{
+    return qHash(static_cast<int>(type())) ^ qHash(subtype());
+}
+
 QString TextModelItem::customIcon() const
 {
     return d->icon;
@@ -73,6 +92,11 @@ const TextModel* TextModelItem::model() const
     return d->model;
 }
 
+quint64 TextModelItem::serialNumber() const
+{
+    return d->serialNumber;
+}
+
 TextModelItem* TextModelItem::parent() const
 {
     return static_cast<TextModelItem*>(AbstractModelItem::parent());
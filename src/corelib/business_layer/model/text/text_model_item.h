@@ -65,6 +65,13 @@ public:
      */
     const TextModel* model() const;
 
+    /**
+     * @brief Серийный номер элемента, уникальный за всё время работы приложения
+     * @note В отличие от адреса элемента, не может достаться новому элементу после удаления
+     *       старого, поэтому подходит для ключей кэшей, переживающих сами элементы
+     */
+    quint64 serialNumber() const;
+
     /**
      * @brief Переопределяем интерфейс для возврата элемента собственного класса
      */
@@ -108,6 +115,12 @@ public:
      */
     virtual bool isEqual(TextModelItem* _item) const = 0;
 
+    /**
+     * @brief Хэш данных, по которым элемент сравнивается с другими в isEqual
+     * @note Равные элементы обязаны иметь равные хэши, но не наоборот
+     */
+    virtual size_t equalityHash() const;
+
 protected:
     /**
      * @brief Считать кастомный контент и вернуть название тэга на котором стоит ридер
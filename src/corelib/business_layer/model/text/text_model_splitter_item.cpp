@@ -2,6 +2,7 @@
 
 #include "text_model_xml.h"
 
+#include <QHash>
 #include <QVariant>
 #include <QXmlStreamReader>
 
@@ -101,4 +102,9 @@ bool TextModelSplitterItem::isEqual(TextModelItem* _item) const
     return d->splitterType == splitterItem->d->splitterType;
 }
 
+size_t TextModelSplitterItem::equalityHash() const
+{
+    return qHash(static_cast<int>(d->splitterType));
+}
+
 } // namespace BusinessLayer
@@ -12,6 +12,7 @@
 #include <utils/tools/run_once.h>
 
 #include <QColor>
+#include <QHash>
 #include <QLocale>
 #include <QVariant>
 #include <QXmlStreamReader>
@@ -745,6 +746,10 @@ void TextModelTextItem::setBreakCorrectionStart(bool _broken)
     }
 
     d->isBreakCorrectionStart = _broken;
+    //
+    // Разрыв блока влияет на формирование xml родительских элементов
+    //
+    updateRevision();
 }
 
 bool TextModelTextItem::isBreakCorrectionEnd() const
@@ -759,6 +764,10 @@ void TextModelTextItem::setBreakCorrectionEnd(bool _broken)
     }
 
     d->isBreakCorrectionEnd = _broken;
+    //
+    // Разрыв блока влияет на формирование xml родительских элементов
+    //
+    updateRevision();
 }
 
 std::optional<bool> TextModelTextItem::isInFirstColumn() const
@@ -1190,6 +1199,11 @@ bool TextModelTextItem::isEqual(TextModelItem* _item) const
         && d->resourceMarks == textItem->d->resourceMarks && d->formats == textItem->d->formats;
 }
 
+size_t TextModelTextItem::equalityHash() const
+{
+    return qHash(textToSave()) ^ qHash(static_cast<int>(d->paragraphType));
+}
+
 void TextModelTextItem::updateCounters(bool _force)
 {
     Q_UNUSED(_force)
@@ -1248,6 +1262,13 @@ QString TextModelTextItem::textToSave() const
 
 void TextModelTextItem::handleChange()
 {
+    //
+    // Счётчики элементов, подготавливаемых вне модели, будут посчитаны при добавлении в неё
+    //
+    if (TextModel::isPreparingItems()) {
+        return;
+    }
+
     updateCounters();
 }
 
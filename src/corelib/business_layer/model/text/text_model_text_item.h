@@ -224,6 +224,7 @@ public:
      * @brief Проверить равен ли текущий элемент заданному
      */
     bool isEqual(TextModelItem* _item) const override;
+    size_t equalityHash() const override;
 
     /**
      * @brief Обновить счётчики
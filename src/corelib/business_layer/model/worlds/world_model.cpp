@@ -1394,21 +1394,56 @@ void WorldModel::setMagicTypes(const QVector<WorldItem>& _items)
 
 void WorldModel::initImageWrapper()
 {
-    connect(imageWrapper(), &AbstractImageWrapper::imageUpdated, this,
-            [this](const QUuid& _uuid, const QPixmap& _image) {
-                for (auto& photo : d->photos) {
-                    if (photo.uuid == _uuid) {
-                        photo.image = _image;
-
-                        if (photo.uuid == d->photos.constFirst().uuid) {
-                            emit mainPhotoChanged(photo);
-                        }
-                        emit photosChanged(d->photos);
-
-                        break;
-                    }
+    auto updateImage = [this](const QUuid& _uuid, const QPixmap& _image) {
+        for (auto& photo : d->photos) {
+            if (photo.uuid == _uuid) {
+                photo.image = _image;
+
+                if (photo.uuid == d->photos.constFirst().uuid) {
+                    emit mainPhotoChanged(photo);
+                }
+                emit photosChanged(d->photos);
+
+                return;
+            }
+        }
+
+        //
+        // Изображения могут быть и у элементов мира
+        //
+        auto updateItemImage = [&_uuid, &_image](QVector<WorldItem>& _items) {
+            for (auto& item : _items) {
+                if (item.photo.uuid == _uuid) {
+                    item.photo.image = _image;
+                    return true;
                 }
-            });
+            }
+            return false;
+        };
+        if (updateItemImage(d->races)) {
+            emit racesChanged(d->races);
+        } else if (updateItemImage(d->floras)) {
+            emit florasChanged(d->floras);
+        } else if (updateItemImage(d->animals)) {
+            emit animalsChanged(d->animals);
+        } else if (updateItemImage(d->naturalResources)) {
+            emit naturalResourcesChanged(d->naturalResources);
+        } else if (updateItemImage(d->climates)) {
+            emit climatesChanged(d->climates);
+        } else if (updateItemImage(d->religions)) {
+            emit religionsChanged(d->religions);
+        } else if (updateItemImage(d->ethics)) {
+            emit ethicsChanged(d->ethics);
+        } else if (updateItemImage(d->languages)) {
+            emit languagesChanged(d->languages);
+        } else if (updateItemImage(d->castes)) {
+            emit castesChanged(d->castes);
+        } else if (updateItemImage(d->magicTypes)) {
+            emit magicTypesChanged(d->magicTypes);
+        }
+    };
+    connect(imageWrapper(), &AbstractImageWrapper::imageUpdated, this, updateImage);
+    connect(imageWrapper(), &AbstractImageWrapper::imageLoaded, this, updateImage);
 }
 
 void WorldModel::initDocument()
@@ -1,21 +1,13 @@
 #include "screenplay_characters_activity_plot.h"
 
 #include <3rd_party/qtxlsxwriter/xlsxdocument.h>
-#include <business_layer/document/screenplay/text/screenplay_text_document.h>
-#include <business_layer/model/screenplay/screenplay_information_model.h>
-#include <business_layer/model/screenplay/text/screenplay_text_block_parser.h>
 #include <business_layer/model/screenplay/text/screenplay_text_model.h>
-#include <business_layer/model/screenplay/text/screenplay_text_model_scene_item.h>
-#include <business_layer/model/screenplay/text/screenplay_text_model_text_item.h>
-#include <business_layer/templates/screenplay_template.h>
-#include <business_layer/templates/templates_facade.h>
-#include <ui/widgets/text_edit/page/page_text_edit.h>
+#include <business_layer/reports/screenplay/screenplay_report_snapshot.h>
 #include <utils/helpers/color_helper.h>
-#include <utils/helpers/text_helper.h>
 #include <utils/helpers/time_helper.h>
 
 #include <QCoreApplication>
-#include <QRegularExpression>
+#include <QSet>
 
 #include <cmath>
 
@@ -69,145 +61,58 @@ void ScreenplayCharactersActivityPlot::build(QAbstractItemModel* _model) const
     QVector<QString> characters;
 
     //
-    // Сформируем регулярное выражение для выуживания молчаливых персонажей
+    // Собираем статистику
     //
-    QString rxPattern;
-    auto charactersModel = screenplayModel->charactersList();
-    for (int index = 0; index < charactersModel->rowCount(); ++index) {
-        auto characterName = charactersModel->index(index, 0).data().toString();
-        if (!rxPattern.isEmpty()) {
-            rxPattern.append("|");
+    const auto snapshot = ScreenplayReportSnapshot::forModel(screenplayModel);
+    for (const auto& paragraph : snapshot->paragraphs()) {
+        if (paragraph.isCorrection) {
+            continue;
         }
-        rxPattern.append(TextHelper::toRxEscaped(characterName));
-    }
-    if (!rxPattern.isEmpty()) {
-        rxPattern.prepend("(^|\\W)(");
-        rxPattern.append(")($|\\W)");
-    }
-    const QRegularExpression rxCharacterFinder(
-        rxPattern,
-        QRegularExpression::CaseInsensitiveOption | QRegularExpression::UseUnicodePropertiesOption);
-
-    //
-    // Подготовим текстовый документ, для определения страниц сцен
-    //
-    const auto& screenplayTemplate
-        = TemplatesFacade::screenplayTemplate(screenplayModel->informationModel()->templateId());
-    PageTextEdit screenplayTextEdit;
-    screenplayTextEdit.setUsePageMode(true);
-    screenplayTextEdit.setPageSpacing(0);
-    screenplayTextEdit.setPageFormat(screenplayTemplate.pageSizeId());
-    screenplayTextEdit.setPageMarginsMm(screenplayTemplate.pageMargins());
-    ScreenplayTextDocument screenplayDocument;
-    screenplayTextEdit.setDocument(&screenplayDocument);
-    const bool kCanChangeModel = false;
-    screenplayDocument.setModel(screenplayModel, kCanChangeModel);
-    QTextCursor screenplayCursor(&screenplayDocument);
-    auto textItemPage = [&screenplayTextEdit, &screenplayDocument,
-                         &screenplayCursor](TextModelTextItem* _item) {
-        screenplayCursor.setPosition(
-            screenplayDocument.itemPosition(screenplayDocument.model()->indexForItem(_item), true));
-        return screenplayTextEdit.cursorPage(screenplayCursor);
-    };
 
-    //
-    // Собираем статистику
-    //
-    std::function<void(const TextModelItem*)> includeInReport;
-    includeInReport = [&includeInReport, &scenes, &lastScene, &characters, &rxCharacterFinder,
-                       textItemPage, invalidPage](const TextModelItem* _item) {
-        for (int childIndex = 0; childIndex < _item->childCount(); ++childIndex) {
-            auto childItem = _item->childAt(childIndex);
-            switch (childItem->type()) {
-            case TextModelItemType::Folder:
-            case TextModelItemType::Group: {
-                includeInReport(childItem);
-                break;
+        //
+        // ... стата по объектам
+        //
+        switch (paragraph.type) {
+        case TextParagraphType::SceneHeading: {
+            //
+            // Началась новая сцена
+            //
+            if (lastScene.page != invalidPage) {
+                scenes.append(lastScene);
+                lastScene = SceneData();
             }
 
-            case TextModelItemType::Text: {
-                auto textItem = static_cast<ScreenplayTextModelTextItem*>(childItem);
-                if (textItem->isCorrection()) {
-                    break;
-                }
-
-                //
-                // ... стата по объектам
-                //
-                switch (textItem->paragraphType()) {
-                case TextParagraphType::SceneHeading: {
-                    //
-                    // Началась новая сцена
-                    //
-                    if (lastScene.page != invalidPage) {
-                        scenes.append(lastScene);
-                        lastScene = SceneData();
-                    }
-
-                    const auto sceneItem
-                        = static_cast<ScreenplayTextModelSceneItem*>(textItem->parent());
-                    lastScene.name = sceneItem->heading();
-                    lastScene.number = sceneItem->number()->text;
-                    lastScene.duration = sceneItem->duration();
-                    lastScene.page = textItemPage(textItem);
-                    break;
-                }
-
-                case TextParagraphType::SceneCharacters: {
-                    const auto sceneCharacters
-                        = ScreenplaySceneCharactersParser::characters(textItem->text());
-                    for (const auto& character : sceneCharacters) {
-                        lastScene.characters.insert(character);
-                        if (!characters.contains(character)) {
-                            characters.append(character);
-                        }
-                    }
-                    break;
-                }
-
-                case TextParagraphType::Character: {
-                    const auto character = ScreenplayCharacterParser::name(textItem->text());
-                    lastScene.characters.insert(character);
-                    if (!characters.contains(character)) {
-                        characters.append(character);
-                    }
-                    break;
-                }
-
-                case TextParagraphType::Action: {
-                    if (rxCharacterFinder.pattern().isEmpty()) {
-                        break;
-                    }
-
-                    auto match = rxCharacterFinder.match(textItem->text());
-                    while (match.hasMatch()) {
-                        const auto character = TextHelper::smartToUpper(match.captured(2));
-                        lastScene.characters.insert(character);
-                        if (!characters.contains(character)) {
-                            characters.append(character);
-                        }
-
-                        //
-                        // Ищем дальше
-                        //
-                        match = rxCharacterFinder.match(textItem->text(), match.capturedEnd());
-                    }
-                    break;
-                }
+            lastScene.name = paragraph.sceneHeading;
+            lastScene.number = paragraph.sceneNumber;
+            lastScene.duration = paragraph.sceneDuration;
+            lastScene.page = paragraph.page;
+            break;
+        }
 
-                default:
-                    break;
+        case TextParagraphType::SceneCharacters:
+        case TextParagraphType::Action: {
+            for (const auto& character : paragraph.characters) {
+                lastScene.characters.insert(character);
+                if (!characters.contains(character)) {
+                    characters.append(character);
                 }
-
-                break;
             }
+            break;
+        }
 
-            default:
-                break;
+        case TextParagraphType::Character: {
+            const auto& character = paragraph.character;
+            lastScene.characters.insert(character);
+            if (!characters.contains(character)) {
+                characters.append(character);
             }
+            break;
         }
-    };
-    includeInReport(screenplayModel->itemForIndex({}));
+
+        default:
+            break;
+        }
+    }
     if (lastScene.page != invalidPage) {
         scenes.append(lastScene);
     }
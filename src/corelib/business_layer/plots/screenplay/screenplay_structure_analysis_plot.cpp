@@ -1,21 +1,13 @@
 #include "screenplay_structure_analysis_plot.h"
 
 #include <3rd_party/qtxlsxwriter/xlsxdocument.h>
-#include <business_layer/document/screenplay/text/screenplay_text_document.h>
-#include <business_layer/model/screenplay/screenplay_information_model.h>
-#include <business_layer/model/screenplay/text/screenplay_text_block_parser.h>
 #include <business_layer/model/screenplay/text/screenplay_text_model.h>
-#include <business_layer/model/screenplay/text/screenplay_text_model_scene_item.h>
-#include <business_layer/model/screenplay/text/screenplay_text_model_text_item.h>
-#include <business_layer/templates/screenplay_template.h>
-#include <business_layer/templates/templates_facade.h>
-#include <ui/widgets/text_edit/page/page_text_edit.h>
+#include <business_layer/reports/screenplay/screenplay_report_snapshot.h>
 #include <utils/helpers/color_helper.h>
-#include <utils/helpers/text_helper.h>
 #include <utils/helpers/time_helper.h>
 
 #include <QCoreApplication>
-#include <QRegularExpression>
+#include <QSet>
 
 
 namespace BusinessLayer {
@@ -72,142 +64,64 @@ void ScreenplayStructureAnalysisPlot::build(QAbstractItemModel* _model) const
     QVector<SceneData> scenes;
     SceneData lastScene;
 
-    //
-    // Сформируем регулярное выражение для выуживания молчаливых персонажей
-    //
-    QString rxPattern;
-    auto charactersModel = screenplayModel->charactersList();
-    for (int index = 0; index < charactersModel->rowCount(); ++index) {
-        auto characterName = charactersModel->index(index, 0).data().toString();
-        if (!rxPattern.isEmpty()) {
-            rxPattern.append("|");
-        }
-        rxPattern.append(TextHelper::toRxEscaped(characterName));
-    }
-    if (!rxPattern.isEmpty()) {
-        rxPattern.prepend("(^|\\W)(");
-        rxPattern.append(")($|\\W)");
-    }
-    const QRegularExpression rxCharacterFinder(
-        rxPattern,
-        QRegularExpression::CaseInsensitiveOption | QRegularExpression::UseUnicodePropertiesOption);
-
-    //
-    // Подготовим текстовый документ, для определения страниц сцен
-    //
-    const auto& screenplayTemplate
-        = TemplatesFacade::screenplayTemplate(screenplayModel->informationModel()->templateId());
-    PageTextEdit screenplayTextEdit;
-    screenplayTextEdit.setUsePageMode(true);
-    screenplayTextEdit.setPageSpacing(0);
-    screenplayTextEdit.setPageFormat(screenplayTemplate.pageSizeId());
-    screenplayTextEdit.setPageMarginsMm(screenplayTemplate.pageMargins());
-    ScreenplayTextDocument screenplayDocument;
-    screenplayTextEdit.setDocument(&screenplayDocument);
-    const bool kCanChangeModel = false;
-    screenplayDocument.setModel(screenplayModel, kCanChangeModel);
-    QTextCursor screenplayCursor(&screenplayDocument);
-    auto textItemPage = [&screenplayTextEdit, &screenplayDocument,
-                         &screenplayCursor](TextModelTextItem* _item) {
-        screenplayCursor.setPosition(
-            screenplayDocument.itemPosition(screenplayDocument.model()->indexForItem(_item), true));
-        return screenplayTextEdit.cursorPage(screenplayCursor);
-    };
-
     //
     // Собираем статистику
     //
-    std::function<void(const TextModelItem*)> includeInReport;
-    includeInReport = [&includeInReport, &scenes, &lastScene, &rxCharacterFinder, textItemPage,
-                       invalidPage](const TextModelItem* _item) {
-        for (int childIndex = 0; childIndex < _item->childCount(); ++childIndex) {
-            auto childItem = _item->childAt(childIndex);
-            switch (childItem->type()) {
-            case TextModelItemType::Folder:
-            case TextModelItemType::Group: {
-                includeInReport(childItem);
-                break;
+    const auto snapshot = ScreenplayReportSnapshot::forModel(screenplayModel);
+    for (const auto& paragraph : snapshot->paragraphs()) {
+        //
+        // ... стата по объектам
+        //
+        switch (paragraph.type) {
+        case TextParagraphType::SceneHeading: {
+            //
+            // Началась новая сцена
+            //
+            if (lastScene.page != invalidPage) {
+                scenes.append(lastScene);
+                lastScene = SceneData();
             }
 
-            case TextModelItemType::Text: {
-                auto textItem = static_cast<ScreenplayTextModelTextItem*>(childItem);
-                //
-                // ... стата по объектам
-                //
-                switch (textItem->paragraphType()) {
-                case TextParagraphType::SceneHeading: {
-                    //
-                    // Началась новая сцена
-                    //
-                    if (lastScene.page != invalidPage) {
-                        scenes.append(lastScene);
-                        lastScene = SceneData();
-                    }
-
-                    const auto sceneItem
-                        = static_cast<ScreenplayTextModelSceneItem*>(textItem->parent());
-                    lastScene.name = sceneItem->heading();
-                    lastScene.number = sceneItem->number()->text;
-                    lastScene.duration = sceneItem->duration();
-                    lastScene.page = textItemPage(textItem);
-                    break;
-                }
-
-                case TextParagraphType::SceneCharacters: {
-                    const auto sceneCharacters
-                        = ScreenplaySceneCharactersParser::characters(textItem->text());
-                    for (const auto& character : sceneCharacters) {
-                        lastScene.characters.insert(character);
-                    }
-                    break;
-                }
-
-                case TextParagraphType::Character: {
-                    lastScene.dialoguesDuration += textItem->duration();
-                    lastScene.characters.insert(ScreenplayCharacterParser::name(textItem->text()));
-                    ++lastScene.dialoguesCount;
-                    break;
-                }
-
-                case TextParagraphType::Parenthetical:
-                case TextParagraphType::Dialogue:
-                case TextParagraphType::Lyrics: {
-                    lastScene.dialoguesDuration += textItem->duration();
-                    break;
-                }
-
-                case TextParagraphType::Action: {
-                    lastScene.actionDuration += textItem->duration();
-
-                    if (rxCharacterFinder.pattern().isEmpty()) {
-                        break;
-                    }
-
-                    auto match = rxCharacterFinder.match(textItem->text());
-                    while (match.hasMatch()) {
-                        lastScene.characters.insert(TextHelper::smartToUpper(match.captured(2)));
-
-                        //
-                        // Ищем дальше
-                        //
-                        match = rxCharacterFinder.match(textItem->text(), match.capturedEnd());
-                    }
-                    break;
-                }
-
-                default:
-                    break;
-                }
-
-                break;
+            lastScene.name = paragraph.sceneHeading;
+            lastScene.number = paragraph.sceneNumber;
+            lastScene.duration = paragraph.sceneDuration;
+            lastScene.page = paragraph.page;
+            break;
+        }
+
+        case TextParagraphType::SceneCharacters: {
+            for (const auto& character : paragraph.characters) {
+                lastScene.characters.insert(character);
             }
+            break;
+        }
+
+        case TextParagraphType::Character: {
+            lastScene.dialoguesDuration += paragraph.duration;
+            lastScene.characters.insert(paragraph.character);
+            ++lastScene.dialoguesCount;
+            break;
+        }
 
-            default:
-                break;
+        case TextParagraphType::Parenthetical:
+        case TextParagraphType::Dialogue:
+        case TextParagraphType::Lyrics: {
+            lastScene.dialoguesDuration += paragraph.duration;
+            break;
+        }
+
+        case TextParagraphType::Action: {
+            lastScene.actionDuration += paragraph.duration;
+            for (const auto& character : paragraph.characters) {
+                lastScene.characters.insert(character);
             }
+            break;
         }
-    };
-    includeInReport(screenplayModel->itemForIndex({}));
+
+        default:
+            break;
+        }
+    }
     if (lastScene.page != invalidPage) {
         scenes.append(lastScene);
     }
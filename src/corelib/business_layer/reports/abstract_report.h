@@ -19,6 +19,23 @@ public:
      */
     virtual void build(QAbstractItemModel* _model) = 0;
 
+    /**
+     * @brief Подготовить данные отчёта из заданной модели, не трогая моделей самого отчёта
+     * @note Может выполняться в фоновом потоке параллельно с подготовкой других отчётов, пока
+     *       поток модели ждёт её завершения, а по умолчанию отчёт целиком строится при применении
+     */
+    virtual void prepare(QAbstractItemModel* _model)
+    {
+    }
+
+    /**
+     * @brief Наполнить модели отчёта подготовленными данными в потоке модели
+     */
+    virtual void applyPrepared(QAbstractItemModel* _model)
+    {
+        build(_model);
+    }
+
     /**
      * @brief Сохранить отчёт в файл
      */
@@ -3,6 +3,7 @@
 #include <3rd_party/qtxlsxwriter/xlsxdocument.h>
 #include <3rd_party/qtxlsxwriter/xlsxrichstring.h>
 #include <business_layer/document/audioplay/text/audioplay_text_document.h>
+#include <business_layer/document/text/text_document_pagination.h>
 #include <business_layer/model/audioplay/audioplay_information_model.h>
 #include <business_layer/model/audioplay/text/audioplay_text_block_parser.h>
 #include <business_layer/model/audioplay/text/audioplay_text_model.h>
@@ -98,21 +99,10 @@ void AudioplayDialoguesReport::build(QAbstractItemModel* _model)
     //
     const auto& audioplayTemplate
         = TemplatesFacade::audioplayTemplate(d->audioplayModel->informationModel()->templateId());
-    PageTextEdit audioplayTextEdit;
-    audioplayTextEdit.setUsePageMode(true);
-    audioplayTextEdit.setPageSpacing(0);
-    audioplayTextEdit.setPageFormat(audioplayTemplate.pageSizeId());
-    audioplayTextEdit.setPageMarginsMm(audioplayTemplate.pageMargins());
-    AudioplayTextDocument audioplayDocument;
-    audioplayTextEdit.setDocument(&audioplayDocument);
-    const bool kCanChangeModel = false;
-    audioplayDocument.setModel(d->audioplayModel, kCanChangeModel);
-    QTextCursor audioplayCursor(&audioplayDocument);
-    auto textItemPage = [&audioplayTextEdit, &audioplayDocument,
-                         &audioplayCursor](TextModelTextItem* _item) {
-        audioplayCursor.setPosition(
-            audioplayDocument.itemPosition(audioplayDocument.model()->indexForItem(_item), true));
-        return audioplayTextEdit.cursorPage(audioplayCursor);
+    const auto pagination = TextDocumentPagination::forModel<AudioplayTextDocument>(
+        d->audioplayModel, audioplayTemplate);
+    auto textItemPage = [pagination](TextModelTextItem* _item) {
+        return pagination->itemPage(_item);
     };
 
     //
@@ -1,20 +1,19 @@
 #include "screenplay_cast_report.h"
 
 #include <3rd_party/qtxlsxwriter/xlsxdocument.h>
-#include <business_layer/document/screenplay/text/screenplay_text_document.h>
 #include <business_layer/model/screenplay/screenplay_information_model.h>
-#include <business_layer/model/screenplay/text/screenplay_text_block_parser.h>
 #include <business_layer/model/screenplay/text/screenplay_text_model.h>
-#include <business_layer/model/screenplay/text/screenplay_text_model_text_item.h>
+#include <business_layer/reports/screenplay/screenplay_report_snapshot.h>
 #include <business_layer/templates/screenplay_template.h>
 #include <business_layer/templates/templates_facade.h>
 #include <ui/widgets/text_edit/page/page_text_edit.h>
+#include <utils/helpers/model_helper.h>
 #include <utils/helpers/text_helper.h>
 
 #include <QCoreApplication>
 #include <QPdfWriter>
 #include <QPointer>
-#include <QRegularExpression>
+#include <QSet>
 #include <QStandardItemModel>
 
 
@@ -32,6 +31,7 @@ public:
      * @brief Модель персонажей
      */
     QScopedPointer<QStandardItemModel> castModel;
+    QStandardItemModel preparedCastModel;
 
     /**
      * @brief Нужно ли показывать расширенную стату по сценам
@@ -60,7 +60,7 @@ ScreenplayCastReport::ScreenplayCastReport()
 
 ScreenplayCastReport::~ScreenplayCastReport() = default;
 
-void ScreenplayCastReport::build(QAbstractItemModel* _model)
+void ScreenplayCastReport::prepare(QAbstractItemModel* _model)
 {
     if (_model == nullptr) {
         return;
@@ -91,172 +91,116 @@ void ScreenplayCastReport::build(QAbstractItemModel* _model)
     QVector<QString> charactersOrder;
     QString lastSpeakingCharacter;
 
-    //
-    // Сформируем регулярное выражение для выуживания молчаливых персонажей
-    //
-    QString rxPattern;
-    auto charactersModel = d->screenplayModel->charactersList();
-    for (int index = 0; index < charactersModel->rowCount(); ++index) {
-        auto characterName = charactersModel->index(index, 0).data().toString();
-        if (!rxPattern.isEmpty()) {
-            rxPattern.append("|");
-        }
-        rxPattern.append(TextHelper::toRxEscaped(characterName));
-    }
-    if (!rxPattern.isEmpty()) {
-        rxPattern.prepend("(^|\\W)(");
-        rxPattern.append(")($|\\W)");
-    }
-    const QRegularExpression rxCharacterFinder(
-        rxPattern,
-        QRegularExpression::CaseInsensitiveOption | QRegularExpression::UseUnicodePropertiesOption);
-
     //
     // Собираем статистику
     //
-    std::function<void(const TextModelItem*)> includeInReport;
-    includeInReport = [&includeInReport, &charactersData, &lastSceneNonspeakingCharacters,
-                       &lastSceneSpeakingCharacters, &charactersOrder, &lastSpeakingCharacter,
-                       &rxCharacterFinder](const TextModelItem* _item) {
-        for (int childIndex = 0; childIndex < _item->childCount(); ++childIndex) {
-            auto childItem = _item->childAt(childIndex);
-            switch (childItem->type()) {
-            case TextModelItemType::Folder:
-            case TextModelItemType::Group: {
-                includeInReport(childItem);
-                break;
-            }
+    const auto snapshot = ScreenplayReportSnapshot::forModel(d->screenplayModel);
+    for (const auto& paragraph : snapshot->paragraphs()) {
+        //
+        // ... стата по объектам
+        //
+        switch (paragraph.type) {
+        case TextParagraphType::SceneHeading: {
+            //
+            // Началась новая сцена
+            //
+            lastSceneNonspeakingCharacters.clear();
+            lastSceneSpeakingCharacters.clear();
+            break;
+        }
 
-            case TextModelItemType::Text: {
-                auto textItem = static_cast<ScreenplayTextModelTextItem*>(childItem);
+        case TextParagraphType::SceneCharacters: {
+            for (const auto& character : paragraph.characters) {
+                lastSceneNonspeakingCharacters.insert(character);
                 //
-                // ... стата по объектам
+                // Первое упоминание персонажа - первая молчаливая сцена
                 //
-                switch (textItem->paragraphType()) {
-                case TextParagraphType::SceneHeading: {
-                    //
-                    // Началась новая сцена
-                    //
-                    lastSceneNonspeakingCharacters.clear();
-                    lastSceneSpeakingCharacters.clear();
-                    break;
+                if (!charactersData.contains(character)) {
+                    charactersData.insert(character, { 0, 0, 0, 1 });
+                    charactersOrder.append(character);
                 }
-
-                case TextParagraphType::SceneCharacters: {
-                    const auto sceneCharacters
-                        = ScreenplaySceneCharactersParser::characters(textItem->text());
-                    for (const auto& character : sceneCharacters) {
-                        lastSceneNonspeakingCharacters.insert(character);
-                        //
-                        // Первое упоминание персонажа - первая молчаливая сцена
-                        //
-                        if (!charactersData.contains(character)) {
-                            charactersData.insert(character, { 0, 0, 0, 1 });
-                            charactersOrder.append(character);
-                        }
-                        //
-                        // Не первое упоминание - плюс одна молчаливая сцена
-                        //
-                        else {
-                            ++charactersData[character].nonspeakingScenesCount;
-                        }
-                    }
-                    break;
+                //
+                // Не первое упоминание - плюс одна молчаливая сцена
+                //
+                else {
+                    ++charactersData[character].nonspeakingScenesCount;
                 }
+            }
+            break;
+        }
 
-                case TextParagraphType::Character: {
-                    const auto character = ScreenplayCharacterParser::name(textItem->text());
-                    if (character.isEmpty()) {
-                        break;
-                    }
+        case TextParagraphType::Character: {
+            const auto& character = paragraph.character;
+            if (character.isEmpty()) {
+                break;
+            }
 
-                    if (!charactersData.contains(character)) {
-                        charactersData.insert(character, { 1, 1, 1, 0 });
-                        charactersOrder.append(character);
-                        lastSceneSpeakingCharacters.insert(character);
-                    } else {
-                        auto& characterData = charactersData[character];
-                        if (lastSceneNonspeakingCharacters.contains(character)) {
-                            lastSceneNonspeakingCharacters.remove(character);
-                            lastSceneSpeakingCharacters.insert(character);
-                            --characterData.nonspeakingScenesCount;
-                            ++characterData.speakingScenesCount;
-                        } else if (!lastSceneSpeakingCharacters.contains(character)) {
-                            lastSceneSpeakingCharacters.insert(character);
-                            ++characterData.speakingScenesCount;
-                        }
-                        ++characterData.totalDialogues;
-                    }
-                    lastSpeakingCharacter = character;
-                    break;
+            if (!charactersData.contains(character)) {
+                charactersData.insert(character, { 1, 1, 1, 0 });
+                charactersOrder.append(character);
+                lastSceneSpeakingCharacters.insert(character);
+            } else {
+                auto& characterData = charactersData[character];
+                if (lastSceneNonspeakingCharacters.contains(character)) {
+                    lastSceneNonspeakingCharacters.remove(character);
+                    lastSceneSpeakingCharacters.insert(character);
+                    --characterData.nonspeakingScenesCount;
+                    ++characterData.speakingScenesCount;
+                } else if (!lastSceneSpeakingCharacters.contains(character)) {
+                    lastSceneSpeakingCharacters.insert(character);
+                    ++characterData.speakingScenesCount;
                 }
+                ++characterData.totalDialogues;
+            }
+            lastSpeakingCharacter = character;
+            break;
+        }
 
-                case TextParagraphType::Dialogue:
-                case TextParagraphType::Lyrics: {
-                    if (lastSpeakingCharacter.isEmpty()) {
-                        break;
-                    }
-
-                    auto& characterData = charactersData[lastSpeakingCharacter];
-                    characterData.totalWords += TextHelper::wordsCount(textItem->text());
-                    break;
-                }
+        case TextParagraphType::Dialogue:
+        case TextParagraphType::Lyrics: {
+            if (lastSpeakingCharacter.isEmpty()) {
+                break;
+            }
 
-                case TextParagraphType::Action: {
-                    if (rxCharacterFinder.pattern().isEmpty()) {
-                        break;
-                    }
+            auto& characterData = charactersData[lastSpeakingCharacter];
+            characterData.totalWords += TextHelper::wordsCount(paragraph.text);
+            break;
+        }
 
-                    auto match = rxCharacterFinder.match(textItem->text());
-                    while (match.hasMatch()) {
-                        const QString character = TextHelper::smartToUpper(match.captured(2));
-                        if (!charactersData.contains(character)) {
-                            charactersData.insert(character, { 0, 0, 0, 1 });
-                            charactersOrder.append(character);
-                            lastSceneNonspeakingCharacters.insert(character);
-                        } else {
-                            //
-                            // Если он ещё не добавлен в текущую сцену
-                            //
-                            if (!lastSceneNonspeakingCharacters.contains(character)
-                                && !lastSceneSpeakingCharacters.contains(character)) {
-                                lastSceneNonspeakingCharacters.insert(character);
-                                ++charactersData[character].nonspeakingScenesCount;
-                            }
-                        }
-
-                        //
-                        // Ищем дальше
-                        //
-                        match = rxCharacterFinder.match(textItem->text(), match.capturedEnd());
+        case TextParagraphType::Action: {
+            for (const auto& character : paragraph.characters) {
+                if (!charactersData.contains(character)) {
+                    charactersData.insert(character, { 0, 0, 0, 1 });
+                    charactersOrder.append(character);
+                    lastSceneNonspeakingCharacters.insert(character);
+                } else {
+                    //
+                    // Если он ещё не добавлен в текущую сцену
+                    //
+                    if (!lastSceneNonspeakingCharacters.contains(character)
+                        && !lastSceneSpeakingCharacters.contains(character)) {
+                        lastSceneNonspeakingCharacters.insert(character);
+                        ++charactersData[character].nonspeakingScenesCount;
                     }
-                    break;
                 }
-
-                default:
-                    break;
-                }
-
-                //
-                // Очищаем последнего говорящего персонажа, если ушли из реплики
-                //
-                if (!lastSpeakingCharacter.isEmpty()
-                    && textItem->paragraphType() != TextParagraphType::Character
-                    && textItem->paragraphType() != TextParagraphType::Parenthetical
-                    && textItem->paragraphType() != TextParagraphType::Dialogue
-                    && textItem->paragraphType() != TextParagraphType::Lyrics) {
-                    lastSpeakingCharacter.clear();
-                }
-
-                break;
             }
+            break;
+        }
 
-            default:
-                break;
-            }
+        default:
+            break;
         }
-    };
-    includeInReport(d->screenplayModel->itemForIndex({}));
+
+        //
+        // Очищаем последнего говорящего персонажа, если ушли из реплики
+        //
+        if (!lastSpeakingCharacter.isEmpty() && paragraph.type != TextParagraphType::Character
+            && paragraph.type != TextParagraphType::Parenthetical
+            && paragraph.type != TextParagraphType::Dialogue
+            && paragraph.type != TextParagraphType::Lyrics) {
+            lastSpeakingCharacter.clear();
+        }
+    }
 
     //
     // Формируем отчёт
@@ -328,16 +272,12 @@ void ScreenplayCastReport::build(QAbstractItemModel* _model)
     //
     // Формируем таблицу
     //
-    if (d->castModel.isNull()) {
-        d->castModel.reset(new QStandardItemModel);
-    } else {
-        d->castModel->clear();
-    }
+    d->preparedCastModel.clear();
     //
     auto addCharacterItemToReport
         = [this, &createModelItem](const QString& _name, const CharacterData& _count) {
               auto characterItem = createModelItem(_name);
-              d->castModel->appendRow({
+              d->preparedCastModel.appendRow({
                   characterItem,
                   createModelItem(QString::number(_count.totalWords)),
                   createModelItem(QString::number(_count.totalDialogues)),
@@ -350,38 +290,56 @@ void ScreenplayCastReport::build(QAbstractItemModel* _model)
         addCharacterItemToReport(character.first, character.second);
     }
     //
-    d->castModel->setHeaderData(
+    d->preparedCastModel.setHeaderData(
         0, Qt::Horizontal,
         QCoreApplication::translate("BusinessLayer::ScreenplayCastReport", "Character name"),
         Qt::DisplayRole);
-    d->castModel->setHeaderData(
+    d->preparedCastModel.setHeaderData(
         1, Qt::Horizontal,
         QCoreApplication::translate("BusinessLayer::ScreenplayCastReport", "Total words"),
         Qt::DisplayRole);
-    d->castModel->setHeaderData(
+    d->preparedCastModel.setHeaderData(
         2, Qt::Horizontal,
         QCoreApplication::translate("BusinessLayer::ScreenplayCastReport", "Total dialogues"),
         Qt::DisplayRole);
-    d->castModel->setHeaderData(
+    d->preparedCastModel.setHeaderData(
         3, Qt::Horizontal,
         QCoreApplication::translate("BusinessLayer::ScreenplayCastReport", "Speaking scenes"),
         Qt::DisplayRole);
-    d->castModel->setHeaderData(
+    d->preparedCastModel.setHeaderData(
         4, Qt::Horizontal,
         QCoreApplication::translate("BusinessLayer::ScreenplayCastReport", "Nonspeaking scenes"),
         Qt::DisplayRole);
-    d->castModel->setHeaderData(
+    d->preparedCastModel.setHeaderData(
         5, Qt::Horizontal,
         QCoreApplication::translate("BusinessLayer::ScreenplayCastReport", "Total scenes"),
         Qt::DisplayRole);
 
     if (!d->showSceneDetails) {
-        d->castModel->removeColumn(4);
-        d->castModel->removeColumn(3);
+        d->preparedCastModel.removeColumn(4);
+        d->preparedCastModel.removeColumn(3);
     }
     if (!d->showWords) {
-        d->castModel->removeColumn(1);
+        d->preparedCastModel.removeColumn(1);
+    }
+}
+
+void ScreenplayCastReport::applyPrepared(QAbstractItemModel* _model)
+{
+    if (qobject_cast<ScreenplayTextModel*>(_model) == nullptr) {
+        return;
     }
+
+    if (d->castModel.isNull()) {
+        d->castModel.reset(new QStandardItemModel);
+    }
+    ModelHelper::moveContent(&d->preparedCastModel, d->castModel.data());
+}
+
+void ScreenplayCastReport::build(QAbstractItemModel* _model)
+{
+    prepare(_model);
+    applyPrepared(_model);
 }
 
 void ScreenplayCastReport::setParameters(bool _showSceneDetails, bool _showWords, int _sortBy)
@@ -2,25 +2,22 @@
 
 #include <3rd_party/qtxlsxwriter/xlsxdocument.h>
 #include <3rd_party/qtxlsxwriter/xlsxrichstring.h>
-#include <business_layer/document/screenplay/text/screenplay_text_document.h>
 #include <business_layer/model/screenplay/screenplay_information_model.h>
 #include <business_layer/model/screenplay/text/screenplay_text_block_parser.h>
 #include <business_layer/model/screenplay/text/screenplay_text_model.h>
-#include <business_layer/model/screenplay/text/screenplay_text_model_scene_item.h>
-#include <business_layer/model/screenplay/text/screenplay_text_model_text_item.h>
+#include <business_layer/reports/screenplay/screenplay_report_snapshot.h>
 #include <business_layer/templates/screenplay_template.h>
 #include <business_layer/templates/templates_facade.h>
 #include <ui/design_system/design_system.h>
 #include <ui/widgets/text_edit/page/page_text_edit.h>
 #include <utils/helpers/color_helper.h>
 #include <utils/helpers/model_helper.h>
-#include <utils/helpers/text_helper.h>
 #include <utils/helpers/time_helper.h>
 
 #include <QCoreApplication>
 #include <QPdfWriter>
 #include <QPointer>
-#include <QRegularExpression>
+#include <QSet>
 #include <QStandardItemModel>
 
 #include <set>
@@ -40,6 +37,7 @@ public:
      * @brief Модель реплик
      */
     QScopedPointer<QStandardItemModel> dialoguesModel;
+    QStandardItemModel preparedDialoguesModel;
 
     /**
      * @brief Список персонажей + видимые
@@ -59,7 +57,7 @@ ScreenplayDialoguesReport::ScreenplayDialoguesReport()
 
 ScreenplayDialoguesReport::~ScreenplayDialoguesReport() = default;
 
-void ScreenplayDialoguesReport::build(QAbstractItemModel* _model)
+void ScreenplayDialoguesReport::prepare(QAbstractItemModel* _model)
 {
     if (_model == nullptr) {
         return;
@@ -93,139 +91,94 @@ void ScreenplayDialoguesReport::build(QAbstractItemModel* _model)
     SceneData lastScene;
     QSet<QString> characters;
 
-    //
-    // Подготовим текстовый документ, для определения страниц сцен
-    //
-    const auto& screenplayTemplate
-        = TemplatesFacade::screenplayTemplate(d->screenplayModel->informationModel()->templateId());
-    PageTextEdit screenplayTextEdit;
-    screenplayTextEdit.setUsePageMode(true);
-    screenplayTextEdit.setPageSpacing(0);
-    screenplayTextEdit.setPageFormat(screenplayTemplate.pageSizeId());
-    screenplayTextEdit.setPageMarginsMm(screenplayTemplate.pageMargins());
-    ScreenplayTextDocument screenplayDocument;
-    screenplayTextEdit.setDocument(&screenplayDocument);
-    const bool kCanChangeModel = false;
-    screenplayDocument.setModel(d->screenplayModel, kCanChangeModel);
-    QTextCursor screenplayCursor(&screenplayDocument);
-    auto textItemPage = [&screenplayTextEdit, &screenplayDocument,
-                         &screenplayCursor](TextModelTextItem* _item) {
-        screenplayCursor.setPosition(
-            screenplayDocument.itemPosition(screenplayDocument.model()->indexForItem(_item), true));
-        return screenplayTextEdit.cursorPage(screenplayCursor);
-    };
-
     //
     // Собираем статистику
     //
-    std::function<void(const TextModelItem*)> includeInReport;
-    includeInReport = [&includeInReport, &scenes, &lastScene, textItemPage, &dialogueNumber,
-                       &characters, invalidPage](const TextModelItem* _item) {
-        for (int childIndex = 0; childIndex < _item->childCount(); ++childIndex) {
-            auto childItem = _item->childAt(childIndex);
-            switch (childItem->type()) {
-            case TextModelItemType::Folder:
-            case TextModelItemType::Group: {
-                includeInReport(childItem);
+    const auto snapshot = ScreenplayReportSnapshot::forModel(d->screenplayModel);
+    for (const auto& paragraph : snapshot->paragraphs()) {
+        //
+        // ... стата по объектам
+        //
+        switch (paragraph.type) {
+        case TextParagraphType::SceneHeading: {
+            //
+            // Началась новая сцена
+            //
+            if (lastScene.page != invalidPage) {
+                scenes.append(lastScene);
+                lastScene = SceneData();
+            }
+
+            lastScene.name = paragraph.sceneHeading;
+            lastScene.number = paragraph.sceneNumber;
+            lastScene.duration = paragraph.sceneDuration;
+            lastScene.page = paragraph.page;
+            break;
+        }
+
+        case TextParagraphType::Character: {
+            if (paragraph.isCorrection || paragraph.text.isEmpty()) {
                 break;
             }
 
-            case TextModelItemType::Text: {
-                auto textItem = static_cast<ScreenplayTextModelTextItem*>(childItem);
-                //
-                // ... стата по объектам
-                //
-                switch (textItem->paragraphType()) {
-                case TextParagraphType::SceneHeading: {
-                    //
-                    // Началась новая сцена
-                    //
-                    if (lastScene.page != invalidPage) {
-                        scenes.append(lastScene);
-                        lastScene = SceneData();
-                    }
-
-                    const auto sceneItem
-                        = static_cast<ScreenplayTextModelSceneItem*>(textItem->parent());
-                    lastScene.name = sceneItem->heading();
-                    lastScene.number = sceneItem->number()->text;
-                    lastScene.duration = sceneItem->duration();
-                    lastScene.page = textItemPage(textItem);
-                    break;
-                }
-
-                case TextParagraphType::Character: {
-                    if (textItem->isCorrection() || textItem->text().isEmpty()) {
-                        break;
-                    }
-
-                    DialogueData dialogue;
-                    dialogue.number = dialogueNumber++;
-                    dialogue.character = ScreenplayCharacterParser::name(textItem->text());
-                    dialogue.extension = ScreenplayCharacterParser::extension(textItem->text());
-                    lastScene.dialogues.append(dialogue);
-
-                    characters.insert(dialogue.character);
-                    break;
-                }
-
-                case TextParagraphType::Parenthetical: {
-                    if (textItem->isCorrection() || lastScene.dialogues.isEmpty()) {
-                        break;
-                    }
-
-                    //
-                    // Если реплика ещё не была задана, то это ремарка перед репликой
-                    //
-                    if (lastScene.dialogues.constLast().dialogue.isEmpty()) {
-                        lastScene.dialogues.last().parenthetical = textItem->text();
-                    }
-                    //
-                    // А если реплика уже была, то это новая реплика с ремаркой
-                    //
-                    else {
-                        auto dialogue = lastScene.dialogues.constLast();
-                        dialogue.parenthetical = textItem->text();
-                        dialogue.dialogue.clear();
-                        lastScene.dialogues.append(dialogue);
-                    }
-                    break;
-                }
-
-                case TextParagraphType::Dialogue:
-                case TextParagraphType::Lyrics: {
-                    if (textItem->isCorrection() || lastScene.dialogues.isEmpty()) {
-                        break;
-                    }
-
-                    //
-                    // Если реплика ещё не была задана, то это ремарка перед репликой
-                    //
-                    if (lastScene.dialogues.constLast().dialogue.isEmpty()) {
-                        lastScene.dialogues.last().dialogue = textItem->text();
-                    }
-                    //
-                    // А если реплика уже была, то допишем в конец с пробельчиком
-                    //
-                    else {
-                        lastScene.dialogues.last().dialogue += " " + textItem->text();
-                    }
-                    break;
-                }
-
-                default:
-                    break;
-                }
+            DialogueData dialogue;
+            dialogue.number = dialogueNumber++;
+            dialogue.character = paragraph.character;
+            dialogue.extension = ScreenplayCharacterParser::extension(paragraph.text);
+            lastScene.dialogues.append(dialogue);
+
+            characters.insert(dialogue.character);
+            break;
+        }
 
+        case TextParagraphType::Parenthetical: {
+            if (paragraph.isCorrection || lastScene.dialogues.isEmpty()) {
                 break;
             }
 
-            default:
+            //
+            // Если реплика ещё не была задана, то это ремарка перед репликой
+            //
+            if (lastScene.dialogues.constLast().dialogue.isEmpty()) {
+                lastScene.dialogues.last().parenthetical = paragraph.text;
+            }
+            //
+            // А если реплика уже была, то это новая реплика с ремаркой
+            //
+            else {
+                auto dialogue = lastScene.dialogues.constLast();
+                dialogue.parenthetical = paragraph.text;
+                dialogue.dialogue.clear();
+                lastScene.dialogues.append(dialogue);
+            }
+            break;
+        }
+
+        case TextParagraphType::Dialogue:
+        case TextParagraphType::Lyrics: {
+            if (paragraph.isCorrection || lastScene.dialogues.isEmpty()) {
                 break;
             }
+
+            //
+            // Если реплика ещё не была задана, то это ремарка перед репликой
+            //
+            if (lastScene.dialogues.constLast().dialogue.isEmpty()) {
+                lastScene.dialogues.last().dialogue = paragraph.text;
+            }
+            //
+            // А если реплика уже была, то допишем в конец с пробельчиком
+            //
+            else {
+                lastScene.dialogues.last().dialogue += " " + paragraph.text;
+            }
+            break;
         }
-    };
-    includeInReport(d->screenplayModel->itemForIndex({}));
+
+        default:
+            break;
+        }
+    }
     if (lastScene.page != invalidPage) {
         scenes.append(lastScene);
     }
@@ -244,11 +197,7 @@ void ScreenplayDialoguesReport::build(QAbstractItemModel* _model)
     //
     // ... наполняем таблицу
     //
-    if (d->dialoguesModel.isNull()) {
-        d->dialoguesModel.reset(new QStandardItemModel);
-    } else {
-        d->dialoguesModel->clear();
-    }
+    d->preparedDialoguesModel.clear();
     const auto titleBackgroundColor = QVariant::fromValue(ColorHelper::transparent(
         Ui::DesignSystem::color().onBackground(), Ui::DesignSystem::elevationEndOpacity()));
     for (const auto& scene : scenes) {
@@ -279,7 +228,7 @@ void ScreenplayDialoguesReport::build(QAbstractItemModel* _model)
             continue;
         }
 
-        d->dialoguesModel->appendRow({
+        d->preparedDialoguesModel.appendRow({
             sceneItem,
             createModelItem({ scene.name }, titleBackgroundColor),
             createModelItem({ scene.number }, titleBackgroundColor),
@@ -287,19 +236,19 @@ void ScreenplayDialoguesReport::build(QAbstractItemModel* _model)
         });
     }
     //
-    d->dialoguesModel->setHeaderData(
+    d->preparedDialoguesModel.setHeaderData(
         0, Qt::Horizontal,
         QCoreApplication::translate("BusinessLayer::ScreenplayDialoguesReport", "Scene/character"),
         Qt::DisplayRole);
-    d->dialoguesModel->setHeaderData(
+    d->preparedDialoguesModel.setHeaderData(
         1, Qt::Horizontal,
         QCoreApplication::translate("BusinessLayer::ScreenplayDialoguesReport", "Dialogue/lyrics"),
         Qt::DisplayRole);
-    d->dialoguesModel->setHeaderData(
+    d->preparedDialoguesModel.setHeaderData(
         2, Qt::Horizontal,
         QCoreApplication::translate("BusinessLayer::ScreenplayDialoguesReport", "Parenthetical"),
         Qt::DisplayRole);
-    d->dialoguesModel->setHeaderData(
+    d->preparedDialoguesModel.setHeaderData(
         3, Qt::Horizontal,
         QCoreApplication::translate("BusinessLayer::ScreenplayDialoguesReport", "Extension"),
         Qt::DisplayRole);
@@ -309,6 +258,24 @@ void ScreenplayDialoguesReport::build(QAbstractItemModel* _model)
     std::sort(d->characters.begin(), d->characters.end());
 }
 
+void ScreenplayDialoguesReport::applyPrepared(QAbstractItemModel* _model)
+{
+    if (qobject_cast<ScreenplayTextModel*>(_model) == nullptr) {
+        return;
+    }
+
+    if (d->dialoguesModel.isNull()) {
+        d->dialoguesModel.reset(new QStandardItemModel);
+    }
+    ModelHelper::moveContent(&d->preparedDialoguesModel, d->dialoguesModel.data());
+}
+
+void ScreenplayDialoguesReport::build(QAbstractItemModel* _model)
+{
+    prepare(_model);
+    applyPrepared(_model);
+}
+
 void ScreenplayDialoguesReport::setParameters(const QVector<QString>& _characters)
 {
     d->visibleCharacters = _characters;
@@ -21,6 +21,12 @@ public:
      */
     void build(QAbstractItemModel* _model) override;
 
+    /**
+     * @brief Подготовить данные отчёта и наполнить ими модели отчёта
+     */
+    void prepare(QAbstractItemModel* _model) override;
+    void applyPrepared(QAbstractItemModel* _model) override;
+
     /**
      * @brief Задать параметры отчёта
      */
@@ -1,22 +1,20 @@
 #include "screenplay_gender_report.h"
 
 #include <3rd_party/qtxlsxwriter/xlsxdocument.h>
-#include <business_layer/document/screenplay/text/screenplay_text_document.h>
 #include <business_layer/model/characters/character_model.h>
 #include <business_layer/model/screenplay/screenplay_information_model.h>
-#include <business_layer/model/screenplay/text/screenplay_text_block_parser.h>
 #include <business_layer/model/screenplay/text/screenplay_text_model.h>
-#include <business_layer/model/screenplay/text/screenplay_text_model_text_item.h>
+#include <business_layer/reports/screenplay/screenplay_report_snapshot.h>
 #include <business_layer/templates/screenplay_template.h>
 #include <business_layer/templates/templates_facade.h>
 #include <ui/widgets/text_edit/page/page_text_edit.h>
 #include <utils/helpers/color_helper.h>
-#include <utils/helpers/text_helper.h>
+#include <utils/helpers/model_helper.h>
 
 #include <QCoreApplication>
 #include <QPdfWriter>
 #include <QPointer>
-#include <QRegularExpression>
+#include <QSet>
 #include <QStandardItemModel>
 
 #include <set>
@@ -35,8 +33,11 @@ public:
     int reverseBeckdelTest = 0;
 
     QScopedPointer<QStandardItemModel> scenesInfoModel;
+    QStandardItemModel preparedScenesInfoModel;
     QScopedPointer<QStandardItemModel> dialoguesInfoModel;
+    QStandardItemModel preparedDialoguesInfoModel;
     QScopedPointer<QStandardItemModel> charactersInfoModel;
+    QStandardItemModel preparedCharactersInfoModel;
 };
 
 
@@ -50,7 +51,7 @@ ScreenplayGenderReport::ScreenplayGenderReport()
 
 ScreenplayGenderReport::~ScreenplayGenderReport() = default;
 
-void ScreenplayGenderReport::build(QAbstractItemModel* _model)
+void ScreenplayGenderReport::prepare(QAbstractItemModel* _model)
 {
     if (_model == nullptr) {
         return;
@@ -80,26 +81,6 @@ void ScreenplayGenderReport::build(QAbstractItemModel* _model)
     GenderCounter dialogues;
     QSet<QString> lastSceneCharacters;
 
-    //
-    // Сформируем регулярное выражение для выуживания молчаливых персонажей
-    //
-    QString rxPattern;
-    auto charactersModel = d->screenplayModel->charactersList();
-    for (int index = 0; index < charactersModel->rowCount(); ++index) {
-        auto characterName = charactersModel->index(index, 0).data().toString();
-        if (!rxPattern.isEmpty()) {
-            rxPattern.append("|");
-        }
-        rxPattern.append(TextHelper::toRxEscaped(characterName));
-    }
-    if (!rxPattern.isEmpty()) {
-        rxPattern.prepend("(^|\\W)(");
-        rxPattern.append(")($|\\W)");
-    }
-    const QRegularExpression rxCharacterFinder(
-        rxPattern,
-        QRegularExpression::CaseInsensitiveOption | QRegularExpression::UseUnicodePropertiesOption);
-
     //
     // Соберём список персонажей
     //
@@ -133,137 +114,101 @@ void ScreenplayGenderReport::build(QAbstractItemModel* _model)
     //
     // Собираем статистику
     //
-    std::function<void(const TextModelItem*)> includeInReport;
-    includeInReport = [&includeInReport, &bechdelTest, &reverseBechdelTest, &male, &female, &other,
-                       &undefined, &scenes, &lastScene, &totalScenes, &dialogues,
-                       &lastSceneCharacters, &rxCharacterFinder](const TextModelItem* _item) {
-        for (int childIndex = 0; childIndex < _item->childCount(); ++childIndex) {
-            auto childItem = _item->childAt(childIndex);
-            switch (childItem->type()) {
-            case TextModelItemType::Folder:
-            case TextModelItemType::Group: {
-                includeInReport(childItem);
-                break;
+    const auto snapshot = ScreenplayReportSnapshot::forModel(d->screenplayModel);
+    for (const auto& paragraph : snapshot->paragraphs()) {
+        //
+        // ... стата по объектам
+        //
+        switch (paragraph.type) {
+        case TextParagraphType::SceneHeading: {
+            ++totalScenes;
+            //
+            scenes.male += std::min(1, lastScene.male);
+            scenes.female += std::min(1, lastScene.female);
+            scenes.other += std::min(1, lastScene.other);
+            scenes.undefined += std::min(1, lastScene.undefined);
+            //
+            if (lastScene.male > 1 && lastScene.female == 0 && lastScene.other == 0
+                && lastScene.undefined == 0 && lastScene.hasDialogues) {
+                ++reverseBechdelTest;
+            } else if (lastScene.male == 0 && lastScene.female > 1 && lastScene.other == 0
+                       && lastScene.undefined == 0 && lastScene.hasDialogues) {
+                ++bechdelTest;
             }
 
-            case TextModelItemType::Text: {
-                auto textItem = static_cast<ScreenplayTextModelTextItem*>(childItem);
-
-                //
-                // ... стата по объектам
-                //
-                switch (textItem->paragraphType()) {
-                case TextParagraphType::SceneHeading: {
-                    ++totalScenes;
-                    //
-                    scenes.male += std::min(1, lastScene.male);
-                    scenes.female += std::min(1, lastScene.female);
-                    scenes.other += std::min(1, lastScene.other);
-                    scenes.undefined += std::min(1, lastScene.undefined);
-                    //
-                    if (lastScene.male > 1 && lastScene.female == 0 && lastScene.other == 0
-                        && lastScene.undefined == 0 && lastScene.hasDialogues) {
-                        ++reverseBechdelTest;
-                    } else if (lastScene.male == 0 && lastScene.female > 1 && lastScene.other == 0
-                               && lastScene.undefined == 0 && lastScene.hasDialogues) {
-                        ++bechdelTest;
-                    }
+            lastScene = GenderCounter();
+            lastSceneCharacters.clear();
+            break;
+        }
 
-                    lastScene = GenderCounter();
-                    lastSceneCharacters.clear();
-                    break;
+        case TextParagraphType::SceneCharacters: {
+            for (const auto& character : paragraph.characters) {
+                if (male.contains(character)) {
+                    ++lastScene.male;
+                } else if (female.contains(character)) {
+                    ++lastScene.female;
+                } else if (other.contains(character)) {
+                    ++lastScene.other;
+                } else {
+                    undefined.insert(character);
+                    ++lastScene.undefined;
                 }
+            }
+            break;
+        }
 
-                case TextParagraphType::SceneCharacters: {
-                    const auto sceneCharacters
-                        = ScreenplaySceneCharactersParser::characters(textItem->text());
-                    for (const auto& character : sceneCharacters) {
-                        if (male.contains(character)) {
-                            ++lastScene.male;
-                        } else if (female.contains(character)) {
-                            ++lastScene.female;
-                        } else if (other.contains(character)) {
-                            ++lastScene.other;
-                        } else {
-                            undefined.insert(character);
-                            ++lastScene.undefined;
-                        }
-                    }
-                    break;
+        case TextParagraphType::Character: {
+            if (!paragraph.isCorrection) {
+                const auto& character = paragraph.character;
+                if (male.contains(character)) {
+                    ++dialogues.male;
+                } else if (female.contains(character)) {
+                    ++dialogues.female;
+                } else if (other.contains(character)) {
+                    ++dialogues.other;
+                } else {
+                    undefined.insert(character);
+                    ++dialogues.undefined;
                 }
-
-                case TextParagraphType::Character: {
-                    if (!textItem->isCorrection()) {
-                        const auto character = ScreenplayCharacterParser::name(textItem->text());
-                        if (male.contains(character)) {
-                            ++dialogues.male;
-                        } else if (female.contains(character)) {
-                            ++dialogues.female;
-                        } else if (other.contains(character)) {
-                            ++dialogues.other;
-                        } else {
-                            undefined.insert(character);
-                            ++dialogues.undefined;
-                        }
-                        if (!lastSceneCharacters.contains(character)) {
-                            if (male.contains(character)) {
-                                ++lastScene.male;
-                            } else if (female.contains(character)) {
-                                ++lastScene.female;
-                            } else if (other.contains(character)) {
-                                ++lastScene.other;
-                            } else {
-                                ++lastScene.undefined;
-                            }
-                            lastSceneCharacters.insert(character);
-                        }
-                        lastScene.hasDialogues = true;
+                if (!lastSceneCharacters.contains(character)) {
+                    if (male.contains(character)) {
+                        ++lastScene.male;
+                    } else if (female.contains(character)) {
+                        ++lastScene.female;
+                    } else if (other.contains(character)) {
+                        ++lastScene.other;
+                    } else {
+                        ++lastScene.undefined;
                     }
-                    break;
+                    lastSceneCharacters.insert(character);
                 }
+                lastScene.hasDialogues = true;
+            }
+            break;
+        }
 
-                case TextParagraphType::Action: {
-                    if (rxCharacterFinder.pattern().isEmpty()) {
-                        break;
-                    }
-
-                    auto match = rxCharacterFinder.match(textItem->text());
-                    while (match.hasMatch()) {
-                        const QString character = TextHelper::smartToUpper(match.captured(2));
-                        if (!lastSceneCharacters.contains(character)) {
-                            if (male.contains(character)) {
-                                ++lastScene.male;
-                            } else if (female.contains(character)) {
-                                ++lastScene.female;
-                            } else if (other.contains(character)) {
-                                ++lastScene.other;
-                            } else {
-                                ++lastScene.undefined;
-                            }
-                            lastSceneCharacters.insert(character);
-                        }
-
-                        //
-                        // Ищем дальше
-                        //
-                        match = rxCharacterFinder.match(textItem->text(), match.capturedEnd());
+        case TextParagraphType::Action: {
+            for (const auto& character : paragraph.characters) {
+                if (!lastSceneCharacters.contains(character)) {
+                    if (male.contains(character)) {
+                        ++lastScene.male;
+                    } else if (female.contains(character)) {
+                        ++lastScene.female;
+                    } else if (other.contains(character)) {
+                        ++lastScene.other;
+                    } else {
+                        ++lastScene.undefined;
                     }
-                    break;
-                }
-
-                default:
-                    break;
+                    lastSceneCharacters.insert(character);
                 }
-
-                break;
             }
+            break;
+        }
 
-            default:
-                break;
-            }
+        default:
+            break;
         }
-    };
-    includeInReport(d->screenplayModel->itemForIndex({}));
+    }
     //
     // ... и последняя сцена
     //
@@ -337,16 +282,12 @@ void ScreenplayGenderReport::build(QAbstractItemModel* _model)
         //
         // Формируем таблицу
         //
-        if (d->scenesInfoModel.isNull()) {
-            d->scenesInfoModel.reset(new QStandardItemModel);
-        } else {
-            d->scenesInfoModel->clear();
-        }
-        makeRow(0, scenes.male, totalScenes, d->scenesInfoModel.data());
-        makeRow(1, scenes.female, totalScenes, d->scenesInfoModel.data());
-        makeRow(2, scenes.other, totalScenes, d->scenesInfoModel.data());
-        makeRow(3, scenes.undefined, totalScenes, d->scenesInfoModel.data());
-        makeHeader(d->scenesInfoModel.data());
+        d->preparedScenesInfoModel.clear();
+        makeRow(0, scenes.male, totalScenes, &d->preparedScenesInfoModel);
+        makeRow(1, scenes.female, totalScenes, &d->preparedScenesInfoModel);
+        makeRow(2, scenes.other, totalScenes, &d->preparedScenesInfoModel);
+        makeRow(3, scenes.undefined, totalScenes, &d->preparedScenesInfoModel);
+        makeHeader(&d->preparedScenesInfoModel);
     }
 
     //
@@ -356,19 +297,15 @@ void ScreenplayGenderReport::build(QAbstractItemModel* _model)
         //
         // Формируем таблицу
         //
-        if (d->dialoguesInfoModel.isNull()) {
-            d->dialoguesInfoModel.reset(new QStandardItemModel);
-        } else {
-            d->dialoguesInfoModel->clear();
-        }
+        d->preparedDialoguesInfoModel.clear();
         //
         const auto totalDialogues
             = dialogues.male + dialogues.female + dialogues.other + dialogues.undefined;
-        makeRow(0, dialogues.male, totalDialogues, d->dialoguesInfoModel.data());
-        makeRow(1, dialogues.female, totalDialogues, d->dialoguesInfoModel.data());
-        makeRow(2, dialogues.other, totalDialogues, d->dialoguesInfoModel.data());
-        makeRow(3, dialogues.undefined, totalDialogues, d->dialoguesInfoModel.data());
-        makeHeader(d->dialoguesInfoModel.data());
+        makeRow(0, dialogues.male, totalDialogues, &d->preparedDialoguesInfoModel);
+        makeRow(1, dialogues.female, totalDialogues, &d->preparedDialoguesInfoModel);
+        makeRow(2, dialogues.other, totalDialogues, &d->preparedDialoguesInfoModel);
+        makeRow(3, dialogues.undefined, totalDialogues, &d->preparedDialoguesInfoModel);
+        makeHeader(&d->preparedDialoguesInfoModel);
     }
     //
     // ... персонажи
@@ -377,21 +314,45 @@ void ScreenplayGenderReport::build(QAbstractItemModel* _model)
         //
         // Формируем таблицу
         //
-        if (d->charactersInfoModel.isNull()) {
-            d->charactersInfoModel.reset(new QStandardItemModel);
-        } else {
-            d->charactersInfoModel->clear();
-        }
+        d->preparedCharactersInfoModel.clear();
         //
         const auto totalCharacters = male.size() + female.size() + other.size() + undefined.size();
-        makeRow(0, male.size(), totalCharacters, d->charactersInfoModel.data());
-        makeRow(1, female.size(), totalCharacters, d->charactersInfoModel.data());
-        makeRow(2, other.size(), totalCharacters, d->charactersInfoModel.data());
-        makeRow(3, undefined.size(), totalCharacters, d->charactersInfoModel.data());
-        makeHeader(d->charactersInfoModel.data());
+        makeRow(0, male.size(), totalCharacters, &d->preparedCharactersInfoModel);
+        makeRow(1, female.size(), totalCharacters, &d->preparedCharactersInfoModel);
+        makeRow(2, other.size(), totalCharacters, &d->preparedCharactersInfoModel);
+        makeRow(3, undefined.size(), totalCharacters, &d->preparedCharactersInfoModel);
+        makeHeader(&d->preparedCharactersInfoModel);
     }
 }
 
+void ScreenplayGenderReport::applyPrepared(QAbstractItemModel* _model)
+{
+    if (qobject_cast<ScreenplayTextModel*>(_model) == nullptr) {
+        return;
+    }
+
+    if (d->scenesInfoModel.isNull()) {
+        d->scenesInfoModel.reset(new QStandardItemModel);
+    }
+    ModelHelper::moveContent(&d->preparedScenesInfoModel, d->scenesInfoModel.data());
+
+    if (d->dialoguesInfoModel.isNull()) {
+        d->dialoguesInfoModel.reset(new QStandardItemModel);
+    }
+    ModelHelper::moveContent(&d->preparedDialoguesInfoModel, d->dialoguesInfoModel.data());
+
+    if (d->charactersInfoModel.isNull()) {
+        d->charactersInfoModel.reset(new QStandardItemModel);
+    }
+    ModelHelper::moveContent(&d->preparedCharactersInfoModel, d->charactersInfoModel.data());
+}
+
+void ScreenplayGenderReport::build(QAbstractItemModel* _model)
+{
+    prepare(_model);
+    applyPrepared(_model);
+}
+
 int ScreenplayGenderReport::bechdelTest() const
 {
     return d->bechdelTest;
@@ -1,25 +1,21 @@
 #include "screenplay_location_report.h"
 
 #include <3rd_party/qtxlsxwriter/xlsxdocument.h>
-#include <business_layer/document/screenplay/text/screenplay_text_document.h>
 #include <business_layer/model/screenplay/screenplay_information_model.h>
 #include <business_layer/model/screenplay/text/screenplay_text_block_parser.h>
 #include <business_layer/model/screenplay/text/screenplay_text_model.h>
-#include <business_layer/model/screenplay/text/screenplay_text_model_scene_item.h>
-#include <business_layer/model/screenplay/text/screenplay_text_model_text_item.h>
+#include <business_layer/reports/screenplay/screenplay_report_snapshot.h>
 #include <business_layer/templates/screenplay_template.h>
 #include <business_layer/templates/templates_facade.h>
 #include <ui/design_system/design_system.h>
 #include <ui/widgets/text_edit/page/page_text_edit.h>
 #include <utils/helpers/color_helper.h>
 #include <utils/helpers/model_helper.h>
-#include <utils/helpers/text_helper.h>
 #include <utils/helpers/time_helper.h>
 
 #include <QCoreApplication>
 #include <QPdfWriter>
 #include <QPointer>
-#include <QRegularExpression>
 #include <QStandardItemModel>
 
 #include <set>
@@ -38,6 +34,7 @@ public:
      * @brief Модель локаций
      */
     QScopedPointer<QStandardItemModel> locationModel;
+    QStandardItemModel preparedLocationModel;
 
     /**
      * @brief Нужно ли отображать детали по сценам
@@ -61,7 +58,7 @@ ScreenplayLocationReport::ScreenplayLocationReport()
 
 ScreenplayLocationReport::~ScreenplayLocationReport() = default;
 
-void ScreenplayLocationReport::build(QAbstractItemModel* _model)
+void ScreenplayLocationReport::prepare(QAbstractItemModel* _model)
 {
     if (_model == nullptr) {
         return;
@@ -119,98 +116,43 @@ void ScreenplayLocationReport::build(QAbstractItemModel* _model)
     LocationData lastLocation;
     QVector<QString> locationsOrder;
 
-    //
-    // Подготовим текстовый документ, для определения страниц сцен
-    //
-    const auto& screenplayTemplate
-        = TemplatesFacade::screenplayTemplate(d->screenplayModel->informationModel()->templateId());
-    PageTextEdit screenplayTextEdit;
-    screenplayTextEdit.setUsePageMode(true);
-    screenplayTextEdit.setPageSpacing(0);
-    screenplayTextEdit.setPageFormat(screenplayTemplate.pageSizeId());
-    screenplayTextEdit.setPageMarginsMm(screenplayTemplate.pageMargins());
-    ScreenplayTextDocument screenplayDocument;
-    screenplayTextEdit.setDocument(&screenplayDocument);
-    const bool kCanChangeModel = false;
-    screenplayDocument.setModel(d->screenplayModel, kCanChangeModel);
-    QTextCursor screenplayCursor(&screenplayDocument);
-    auto textItemPage = [&screenplayTextEdit, &screenplayDocument,
-                         &screenplayCursor](TextModelTextItem* _item) {
-        screenplayCursor.setPosition(
-            screenplayDocument.itemPosition(screenplayDocument.model()->indexForItem(_item), true));
-        return screenplayTextEdit.cursorPage(screenplayCursor);
-    };
-
     //
     // Собираем статистику
     //
-    std::function<void(const TextModelItem*)> includeInReport;
-    includeInReport = [&includeInReport, &locations, &lastLocation, &locationsOrder,
-                       textItemPage](const TextModelItem* _item) {
-        for (int childIndex = 0; childIndex < _item->childCount(); ++childIndex) {
-            auto childItem = _item->childAt(childIndex);
-            switch (childItem->type()) {
-            case TextModelItemType::Folder:
-            case TextModelItemType::Group: {
-                includeInReport(childItem);
-                break;
-            }
-
-            case TextModelItemType::Text: {
-                auto textItem = static_cast<ScreenplayTextModelTextItem*>(childItem);
-                //
-                // ... стата по объектам
-                //
-                switch (textItem->paragraphType()) {
-                case TextParagraphType::SceneHeading: {
-                    //
-                    // Началась новая сцена
-                    //
-                    if (!lastLocation.name.isEmpty()) {
-                        locations[lastLocation.name] = lastLocation;
-                    }
-                    //
-                    const auto locationName
-                        = ScreenplaySceneHeadingParser::location(textItem->text());
-                    if (!locations.contains(locationName)) {
-                        locationsOrder.append(locationName);
-                    }
-                    lastLocation = locations[locationName];
-                    lastLocation.name = locationName;
-                    //
-                    const auto timeName = ScreenplaySceneHeadingParser::sceneTime(textItem->text());
-                    if (lastLocation.sceneTimes.isEmpty()
-                        || !lastLocation.sceneTimes.contains(timeName)) {
-                        SceneTimeData sceneTime;
-                        sceneTime.name = timeName;
-                        lastLocation.sceneTimes.insert(timeName, sceneTime);
-                    }
-                    //
-                    SceneData scene;
-                    const auto sceneItem
-                        = static_cast<ScreenplayTextModelSceneItem*>(textItem->parent());
-                    scene.name = sceneItem->heading();
-                    scene.number = sceneItem->number()->text;
-                    scene.duration = sceneItem->duration();
-                    scene.page = textItemPage(textItem);
-                    lastLocation.sceneTimes[timeName].scenes.append(scene);
-
-                    break;
-                }
-
-                default:
-                    break;
-                }
-
-                break;
-            }
+    const auto snapshot = ScreenplayReportSnapshot::forModel(d->screenplayModel);
+    for (const auto& paragraph : snapshot->paragraphs()) {
+        if (paragraph.type != TextParagraphType::SceneHeading) {
+            continue;
+        }
 
-            default:
-                break;
-            }
+        //
+        // Началась новая сцена
+        //
+        if (!lastLocation.name.isEmpty()) {
+            locations[lastLocation.name] = lastLocation;
         }
-    };
-    includeInReport(d->screenplayModel->itemForIndex({}));
+        //
+        const auto locationName = ScreenplaySceneHeadingParser::location(paragraph.text);
+        if (!locations.contains(locationName)) {
+            locationsOrder.append(locationName);
+        }
+        lastLocation = locations[locationName];
+        lastLocation.name = locationName;
+        //
+        const auto timeName = ScreenplaySceneHeadingParser::sceneTime(paragraph.text);
+        if (lastLocation.sceneTimes.isEmpty() || !lastLocation.sceneTimes.contains(timeName)) {
+            SceneTimeData sceneTime;
+            sceneTime.name = timeName;
+            lastLocation.sceneTimes.insert(timeName, sceneTime);
+        }
+        //
+        SceneData scene;
+        scene.name = paragraph.sceneHeading;
+        scene.number = paragraph.sceneNumber;
+        scene.duration = paragraph.sceneDuration;
+        scene.page = paragraph.page;
+        lastLocation.sceneTimes[timeName].scenes.append(scene);
+    }
     if (!lastLocation.name.isEmpty()) {
         locations[lastLocation.name] = lastLocation;
     }
@@ -287,11 +229,7 @@ void ScreenplayLocationReport::build(QAbstractItemModel* _model)
     //
     // ... наполняем таблицу
     //
-    if (d->locationModel.isNull()) {
-        d->locationModel.reset(new QStandardItemModel);
-    } else {
-        d->locationModel->clear();
-    }
+    d->preparedLocationModel.clear();
     const auto titleBackgroundColor = d->extendedView
         ? QVariant::fromValue(ColorHelper::transparent(Ui::DesignSystem::color().onBackground(),
                                                        Ui::DesignSystem::elevationEndOpacity()))
@@ -336,7 +274,7 @@ void ScreenplayLocationReport::build(QAbstractItemModel* _model)
             }
         }
 
-        d->locationModel->appendRow({
+        d->preparedLocationModel.appendRow({
             locationItem,
             createModelItem({}, titleBackgroundColor),
             createModelItem({}, titleBackgroundColor),
@@ -345,28 +283,46 @@ void ScreenplayLocationReport::build(QAbstractItemModel* _model)
         });
     }
     //
-    d->locationModel->setHeaderData(
+    d->preparedLocationModel.setHeaderData(
         0, Qt::Horizontal,
         QCoreApplication::translate("BusinessLayer::ScreenplayLocationReport", "Location/scene"),
         Qt::DisplayRole);
-    d->locationModel->setHeaderData(
+    d->preparedLocationModel.setHeaderData(
         1, Qt::Horizontal,
         QCoreApplication::translate("BusinessLayer::ScreenplayLocationReport", "Number"),
         Qt::DisplayRole);
-    d->locationModel->setHeaderData(
+    d->preparedLocationModel.setHeaderData(
         2, Qt::Horizontal,
         QCoreApplication::translate("BusinessLayer::ScreenplayLocationReport", "Page"),
         Qt::DisplayRole);
-    d->locationModel->setHeaderData(
+    d->preparedLocationModel.setHeaderData(
         3, Qt::Horizontal,
         QCoreApplication::translate("BusinessLayer::ScreenplayLocationReport", "Scenes"),
         Qt::DisplayRole);
-    d->locationModel->setHeaderData(
+    d->preparedLocationModel.setHeaderData(
         4, Qt::Horizontal,
         QCoreApplication::translate("BusinessLayer::ScreenplayLocationReport", "Duration"),
         Qt::DisplayRole);
 }
 
+void ScreenplayLocationReport::applyPrepared(QAbstractItemModel* _model)
+{
+    if (qobject_cast<ScreenplayTextModel*>(_model) == nullptr) {
+        return;
+    }
+
+    if (d->locationModel.isNull()) {
+        d->locationModel.reset(new QStandardItemModel);
+    }
+    ModelHelper::moveContent(&d->preparedLocationModel, d->locationModel.data());
+}
+
+void ScreenplayLocationReport::build(QAbstractItemModel* _model)
+{
+    prepare(_model);
+    applyPrepared(_model);
+}
+
 void ScreenplayLocationReport::setParameters(bool _extendedView, int _sortBy)
 {
     d->extendedView = _extendedView;
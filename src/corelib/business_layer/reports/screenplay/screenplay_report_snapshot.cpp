@@ -0,0 +1,283 @@
+#include "screenplay_report_snapshot.h"
+
+#include <business_layer/chronometry/chronometer.h>
+#include <business_layer/document/screenplay/text/screenplay_text_document.h>
+#include <business_layer/document/text/text_document_pagination.h>
+#include <business_layer/model/screenplay/screenplay_information_model.h>
+#include <business_layer/model/screenplay/text/screenplay_text_block_parser.h>
+#include <business_layer/model/screenplay/text/screenplay_text_model.h>
+#include <business_layer/model/screenplay/text/screenplay_text_model_scene_item.h>
+#include <business_layer/model/screenplay/text/screenplay_text_model_text_item.h>
+#include <business_layer/templates/screenplay_template.h>
+#include <business_layer/templates/templates_facade.h>
+#include <utils/helpers/text_helper.h>
+
+#include <QHash>
+#include <QMutex>
+#include <QRegularExpression>
+#include <QtConcurrentMap>
+
+
+namespace BusinessLayer {
+
+namespace {
+
+/**
+ * @brief Закешированный снимок модели
+ */
+struct CachedSnapshot {
+    /**
+     * @brief Хэш контента модели, для которого сформирован снимок
+     */
+    QByteArray contentHash;
+
+    /**
+     * @brief Шаблон, по которому определялись страницы абзацев
+     */
+    QString templateId;
+
+    /**
+     * @brief Разметка, из которой взяты страницы абзацев
+     */
+    QSharedPointer<const TextDocumentPagination> pagination;
+
+    /**
+     * @brief Поколение настроек хронометража, с которыми посчитаны длительности абзацев
+     */
+    int chronometryGeneration = 0;
+
+    /**
+     * @brief Шаблон поиска молчаливых персонажей, с которым разбирались абзацы
+     */
+    QString charactersPattern;
+
+    QSharedPointer<const ScreenplayReportSnapshot> snapshot;
+};
+
+/**
+ * @brief Кэш снимков моделей
+ */
+QHash<const ScreenplayTextModel*, CachedSnapshot>& snapshotsCache()
+{
+    static QHash<const ScreenplayTextModel*, CachedSnapshot> cache;
+    return cache;
+}
+
+/**
+ * @brief Мьютекс кэша снимков, т.к. отчёты могут подготавливаться параллельно в фоновых потоках
+ */
+QMutex& snapshotsCacheMutex()
+{
+    static QMutex mutex;
+    return mutex;
+}
+
+/**
+ * @brief Сформировать регулярное выражение для выуживания молчаливых персонажей
+ */
+QString charactersPatternFor(ScreenplayTextModel* _model)
+{
+    QString rxPattern;
+    auto charactersModel = _model->charactersList();
+    for (int index = 0; index < charactersModel->rowCount(); ++index) {
+        const auto characterName = charactersModel->index(index, 0).data().toString();
+        if (!rxPattern.isEmpty()) {
+            rxPattern.append("|");
+        }
+        rxPattern.append(TextHelper::toRxEscaped(characterName));
+    }
+    if (!rxPattern.isEmpty()) {
+        rxPattern.prepend("(^|\\W)(");
+        rxPattern.append(")($|\\W)");
+    }
+    return rxPattern;
+}
+
+} // namespace
+
+
+class ScreenplayReportSnapshot::Implementation
+{
+public:
+    /**
+     * @brief Собрать абзацы модели
+     */
+    void collectParagraphs(const TextModelItem* _item, const TextDocumentPagination& _pagination);
+
+    /**
+     * @brief Разобрать текст абзацев
+     */
+    void parseParagraphs(const QString& _charactersPattern);
+
+
+    QVector<ScreenplayReportParagraph> paragraphs;
+};
+
+void ScreenplayReportSnapshot::Implementation::collectParagraphs(
+    const TextModelItem* _item, const TextDocumentPagination& _pagination)
+{
+    for (int childIndex = 0; childIndex < _item->childCount(); ++childIndex) {
+        auto childItem = _item->childAt(childIndex);
+        switch (childItem->type()) {
+        case TextModelItemType::Folder:
+        case TextModelItemType::Group: {
+            collectParagraphs(childItem, _pagination);
+            break;
+        }
+
+        case TextModelItemType::Text: {
+            auto textItem = static_cast<ScreenplayTextModelTextItem*>(childItem);
+            ScreenplayReportParagraph paragraph;
+            paragraph.type = textItem->paragraphType();
+            paragraph.text = textItem->text();
+            paragraph.isCorrection = textItem->isCorrection();
+            paragraph.duration = textItem->duration();
+            if (paragraph.type == TextParagraphType::SceneHeading) {
+                const auto sceneItem
+                    = static_cast<ScreenplayTextModelSceneItem*>(textItem->parent());
+                paragraph.page = _pagination.itemPage(textItem);
+                paragraph.sceneHeading = sceneItem->heading();
+                if (sceneItem->number().has_value()) {
+                    paragraph.sceneNumber = sceneItem->number()->text;
+                }
+                paragraph.sceneDuration = sceneItem->duration();
+            }
+            paragraphs.append(paragraph);
+            break;
+        }
+
+        default:
+            break;
+        }
+    }
+}
+
+void ScreenplayReportSnapshot::Implementation::parseParagraphs(const QString& _charactersPattern)
+{
+    QRegularExpression rxCharacterFinder(_charactersPattern,
+                                         QRegularExpression::CaseInsensitiveOption
+                                             | QRegularExpression::UseUnicodePropertiesOption);
+    //
+    // Компилируем выражение заранее, чтобы потоки не делали этого одновременно
+    //
+    rxCharacterFinder.optimize();
+
+    //
+    // Абзацы разбираются независимо друг от друга, а каждый поток пишет только в свой абзац,
+    // поэтому их можно разбирать параллельно
+    //
+    QtConcurrent::blockingMap(paragraphs, [&rxCharacterFinder](
+                                              ScreenplayReportParagraph& _paragraph) {
+        switch (_paragraph.type) {
+        case TextParagraphType::SceneCharacters: {
+            const auto sceneCharacters
+                = ScreenplaySceneCharactersParser::characters(_paragraph.text);
+            for (const auto& character : sceneCharacters) {
+                _paragraph.characters.append(character);
+            }
+            break;
+        }
+
+        case TextParagraphType::Character: {
+            _paragraph.character = ScreenplayCharacterParser::name(_paragraph.text);
+            break;
+        }
+
+        case TextParagraphType::Action: {
+            if (rxCharacterFinder.pattern().isEmpty()) {
+                break;
+            }
+
+            auto match = rxCharacterFinder.match(_paragraph.text);
+            while (match.hasMatch()) {
+                _paragraph.characters.append(TextHelper::smartToUpper(match.captured(2)));
+
+                //
+                // Ищем дальше
+                //
+                match = rxCharacterFinder.match(_paragraph.text, match.capturedEnd());
+            }
+            break;
+        }
+
+        default:
+            break;
+        }
+    });
+}
+
+
+// ****
+
+
+QSharedPointer<const ScreenplayReportSnapshot> ScreenplayReportSnapshot::forModel(
+    ScreenplayTextModel* _model)
+{
+    if (_model == nullptr) {
+        return QSharedPointer<const ScreenplayReportSnapshot>(new ScreenplayReportSnapshot);
+    }
+
+    //
+    // Если снимок для текущего состояния модели уже есть, используем его
+    //
+    // NOTE: Разметка сама кэшируется, поэтому её получение не требует повторной вёрстки, а если
+    //       она всё же пересобрана (например, изменились стили шаблона), то устарел и снимок
+    //
+    // NOTE: Проверка и сборка снимка выполняются целиком под мьютексом, т.к. при параллельной
+    //       подготовке отчётов снимок запрашивается из нескольких потоков одновременно, а
+    //       получение ключей кэша (например, хэша контента) лениво обновляет данные модели
+    //
+    QMutexLocker locker(&snapshotsCacheMutex());
+    auto& cache = snapshotsCache();
+    const auto contentHash = _model->contentHash();
+    const auto templateId = _model->informationModel()->templateId();
+    const auto charactersPattern = charactersPatternFor(_model);
+    const auto& screenplayTemplate = TemplatesFacade::screenplayTemplate(templateId);
+    const auto pagination = TextDocumentPagination::forModel<ScreenplayTextDocument>(
+        _model, screenplayTemplate, ScreenplayTextDocument::editorCorrectionOptions());
+    const auto chronometryGeneration = ScreenplayChronometer::cacheGeneration();
+    const auto cached = cache.constFind(_model);
+    if (cached != cache.constEnd() && cached->contentHash == contentHash
+        && cached->templateId == templateId && cached->pagination == pagination
+        && cached->chronometryGeneration == chronometryGeneration
+        && cached->charactersPattern == charactersPattern) {
+        return cached->snapshot;
+    }
+
+    //
+    // ... а если нет, то собираем абзацы за один проход по модели и разбираем их
+    //
+    QSharedPointer<ScreenplayReportSnapshot> snapshot(new ScreenplayReportSnapshot);
+    snapshot->d->collectParagraphs(_model->itemForIndex({}), *pagination);
+    snapshot->d->parseParagraphs(charactersPattern);
+
+    //
+    // При удалении модели удаляем и её снимок из кэша
+    //
+    if (cached == cache.constEnd()) {
+        QObject::connect(_model, &QObject::destroyed, _model,
+                         [_model] {
+                             QMutexLocker locker(&snapshotsCacheMutex());
+                             snapshotsCache().remove(_model);
+                         });
+    }
+    cache.insert(_model,
+                 { contentHash, templateId, pagination, chronometryGeneration, charactersPattern,
+                   snapshot });
+
+    return snapshot;
+}
+
+ScreenplayReportSnapshot::ScreenplayReportSnapshot()
+    : d(new Implementation)
+{
+}
+
+ScreenplayReportSnapshot::~ScreenplayReportSnapshot() = default;
+
+const QVector<ScreenplayReportParagraph>& ScreenplayReportSnapshot::paragraphs() const
+{
+    return d->paragraphs;
+}
+
+} // namespace BusinessLayer
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <business_layer/templates/text_template.h>
+
+#include <QScopedPointer>
+#include <QSharedPointer>
+#include <QString>
+#include <QVector>
+
+#include <corelib_global.h>
+
+#include <chrono>
+
+
+namespace BusinessLayer {
+
+class ScreenplayTextModel;
+
+/**
+ * @brief Данные абзаца сценария, необходимые для построения отчётов
+ */
+struct CORE_LIBRARY_EXPORT ScreenplayReportParagraph {
+    /**
+     * @brief Тип абзаца
+     */
+    TextParagraphType type = TextParagraphType::Undefined;
+
+    /**
+     * @brief Текст абзаца
+     */
+    QString text;
+
+    /**
+     * @brief Является ли абзац корректировкой
+     */
+    bool isCorrection = false;
+
+    /**
+     * @brief Хронометраж абзаца
+     */
+    std::chrono::milliseconds duration = std::chrono::milliseconds{ 0 };
+
+    /**
+     * @brief Номер страницы, на которой начинается абзац
+     */
+    int page = 0;
+
+    /**
+     * @brief Данные сцены, заполняются только для заголовков сцен
+     */
+    /** @{ */
+    QString sceneHeading;
+    QString sceneNumber;
+    std::chrono::milliseconds sceneDuration = std::chrono::milliseconds{ 0 };
+    /** @} */
+
+    /**
+     * @brief Персонаж реплики, заполняется только для блоков персонажа
+     */
+    QString character;
+
+    /**
+     * @brief Персонажи, упомянутые в абзаце
+     * @note Для блока персонажей сцены - все перечисленные в нём, для описания действия -
+     *       найденные в тексте молчаливые персонажи, в порядке их появления в тексте
+     */
+    QVector<QString> characters;
+};
+
+/**
+ * @brief Неизменяемый снимок сценария для построения отчётов и графиков
+ *
+ * Формируется за один проход по модели, разбор текста абзацев (имена персонажей, поиск
+ * молчаливых персонажей в описаниях действия) выполняется параллельно в пуле потоков.
+ * Снимок кэшируется для модели и пересобирается только при изменении её контента, шаблона
+ * или списка персонажей, так что все отчёты вкладки статистики используют один и тот же снимок.
+ */
+class CORE_LIBRARY_EXPORT ScreenplayReportSnapshot
+{
+public:
+    /**
+     * @brief Получить снимок для заданной модели
+     */
+    static QSharedPointer<const ScreenplayReportSnapshot> forModel(ScreenplayTextModel* _model);
+
+public:
+    ~ScreenplayReportSnapshot();
+
+    /**
+     * @brief Абзацы сценария в порядке следования
+     */
+    const QVector<ScreenplayReportParagraph>& paragraphs() const;
+
+private:
+    ScreenplayReportSnapshot();
+
+    class Implementation;
+    QScopedPointer<Implementation> d;
+};
+
+} // namespace BusinessLayer
@@ -2,24 +2,21 @@
 
 #include <3rd_party/qtxlsxwriter/xlsxdocument.h>
 #include <3rd_party/qtxlsxwriter/xlsxrichstring.h>
-#include <business_layer/document/screenplay/text/screenplay_text_document.h>
 #include <business_layer/model/screenplay/screenplay_information_model.h>
-#include <business_layer/model/screenplay/text/screenplay_text_block_parser.h>
 #include <business_layer/model/screenplay/text/screenplay_text_model.h>
-#include <business_layer/model/screenplay/text/screenplay_text_model_scene_item.h>
-#include <business_layer/model/screenplay/text/screenplay_text_model_text_item.h>
+#include <business_layer/reports/screenplay/screenplay_report_snapshot.h>
 #include <business_layer/templates/screenplay_template.h>
 #include <business_layer/templates/templates_facade.h>
 #include <ui/design_system/design_system.h>
 #include <ui/widgets/text_edit/page/page_text_edit.h>
 #include <utils/helpers/color_helper.h>
-#include <utils/helpers/text_helper.h>
+#include <utils/helpers/model_helper.h>
 #include <utils/helpers/time_helper.h>
 
 #include <QCoreApplication>
 #include <QPdfWriter>
 #include <QPointer>
-#include <QRegularExpression>
+#include <QSet>
 #include <QStandardItemModel>
 
 #include <set>
@@ -39,6 +36,7 @@ public:
      * @brief Модель сцен
      */
     QScopedPointer<QStandardItemModel> sceneModel;
+    QStandardItemModel preparedSceneModel;
 
     /**
      * @brief Необходимо ли отображать персонажей
@@ -62,7 +60,7 @@ ScreenplaySceneReport::ScreenplaySceneReport()
 
 ScreenplaySceneReport::~ScreenplaySceneReport() = default;
 
-void ScreenplaySceneReport::build(QAbstractItemModel* _model)
+void ScreenplaySceneReport::prepare(QAbstractItemModel* _model)
 {
     if (_model == nullptr) {
         return;
@@ -105,148 +103,70 @@ void ScreenplaySceneReport::build(QAbstractItemModel* _model)
     SceneData lastScene;
     QSet<QString> characters;
 
-    //
-    // Сформируем регулярное выражение для выуживания молчаливых персонажей
-    //
-    QString rxPattern;
-    auto charactersModel = d->screenplayModel->charactersList();
-    for (int index = 0; index < charactersModel->rowCount(); ++index) {
-        auto characterName = charactersModel->index(index, 0).data().toString();
-        if (!rxPattern.isEmpty()) {
-            rxPattern.append("|");
-        }
-        rxPattern.append(TextHelper::toRxEscaped(characterName));
-    }
-    if (!rxPattern.isEmpty()) {
-        rxPattern.prepend("(^|\\W)(");
-        rxPattern.append(")($|\\W)");
-    }
-    const QRegularExpression rxCharacterFinder(
-        rxPattern,
-        QRegularExpression::CaseInsensitiveOption | QRegularExpression::UseUnicodePropertiesOption);
-
-    //
-    // Подготовим текстовый документ, для определения страниц сцен
-    //
-    const auto& screenplayTemplate
-        = TemplatesFacade::screenplayTemplate(d->screenplayModel->informationModel()->templateId());
-    PageTextEdit screenplayTextEdit;
-    screenplayTextEdit.setUsePageMode(true);
-    screenplayTextEdit.setPageSpacing(0);
-    screenplayTextEdit.setPageFormat(screenplayTemplate.pageSizeId());
-    screenplayTextEdit.setPageMarginsMm(screenplayTemplate.pageMargins());
-    ScreenplayTextDocument screenplayDocument;
-    screenplayTextEdit.setDocument(&screenplayDocument);
-    const bool kCanChangeModel = false;
-    screenplayDocument.setModel(d->screenplayModel, kCanChangeModel);
-    QTextCursor screenplayCursor(&screenplayDocument);
-    auto textItemPage = [&screenplayTextEdit, &screenplayDocument,
-                         &screenplayCursor](TextModelTextItem* _item) {
-        screenplayCursor.setPosition(
-            screenplayDocument.itemPosition(screenplayDocument.model()->indexForItem(_item), true));
-        return screenplayTextEdit.cursorPage(screenplayCursor);
-    };
-
     //
     // Собираем статистику
     //
-    std::function<void(const TextModelItem*)> includeInReport;
-    includeInReport = [&includeInReport, &scenes, &lastScene, &characters, &rxCharacterFinder,
-                       textItemPage, invalidPage](const TextModelItem* _item) {
-        for (int childIndex = 0; childIndex < _item->childCount(); ++childIndex) {
-            auto childItem = _item->childAt(childIndex);
-            switch (childItem->type()) {
-            case TextModelItemType::Folder:
-            case TextModelItemType::Group: {
-                includeInReport(childItem);
-                break;
+    const auto snapshot = ScreenplayReportSnapshot::forModel(d->screenplayModel);
+    for (const auto& paragraph : snapshot->paragraphs()) {
+        //
+        // ... стата по объектам
+        //
+        switch (paragraph.type) {
+        case TextParagraphType::SceneHeading: {
+            //
+            // Началась новая сцена
+            //
+            if (lastScene.page != invalidPage) {
+                scenes.append(lastScene);
+                lastScene = SceneData();
             }
 
-            case TextModelItemType::Text: {
-                auto textItem = static_cast<ScreenplayTextModelTextItem*>(childItem);
-                //
-                // ... стата по объектам
-                //
-                switch (textItem->paragraphType()) {
-                case TextParagraphType::SceneHeading: {
-                    //
-                    // Началась новая сцена
-                    //
-                    if (lastScene.page != invalidPage) {
-                        scenes.append(lastScene);
-                        lastScene = SceneData();
-                    }
-
-                    const auto sceneItem
-                        = static_cast<ScreenplayTextModelSceneItem*>(textItem->parent());
-                    lastScene.name = sceneItem->heading();
-                    lastScene.number = sceneItem->number()->text;
-                    lastScene.duration = sceneItem->duration();
-                    lastScene.page = textItemPage(textItem);
-                    break;
-                }
-
-                case TextParagraphType::SceneCharacters: {
-                    const auto sceneCharacters
-                        = ScreenplaySceneCharactersParser::characters(textItem->text());
-                    for (const auto& character : sceneCharacters) {
-                        auto& characterData = lastScene.character(character);
-                        if (!characters.contains(character)) {
-                            characters.insert(character);
-                            characterData.isFirstAppearance = true;
-                        }
-                    }
-                    break;
-                }
+            lastScene.name = paragraph.sceneHeading;
+            lastScene.number = paragraph.sceneNumber;
+            lastScene.duration = paragraph.sceneDuration;
+            lastScene.page = paragraph.page;
+            break;
+        }
 
-                case TextParagraphType::Character: {
-                    if (!textItem->isCorrection()) {
-                        const auto character = ScreenplayCharacterParser::name(textItem->text());
-                        auto& characterData = lastScene.character(character);
-                        ++characterData.totalDialogues;
-                        if (!characters.contains(character)) {
-                            characters.insert(character);
-                            characterData.isFirstAppearance = true;
-                        }
-                    }
-                    break;
+        case TextParagraphType::SceneCharacters: {
+            for (const auto& character : paragraph.characters) {
+                auto& characterData = lastScene.character(character);
+                if (!characters.contains(character)) {
+                    characters.insert(character);
+                    characterData.isFirstAppearance = true;
                 }
+            }
+            break;
+        }
 
-                case TextParagraphType::Action: {
-                    if (rxCharacterFinder.pattern().isEmpty()) {
-                        break;
-                    }
-
-                    auto match = rxCharacterFinder.match(textItem->text());
-                    while (match.hasMatch()) {
-                        const QString character = TextHelper::smartToUpper(match.captured(2));
-                        auto& characterData = lastScene.character(character);
-                        if (!characters.contains(character)) {
-                            characters.insert(character);
-                            characterData.isFirstAppearance = true;
-                        }
-
-                        //
-                        // Ищем дальше
-                        //
-                        match = rxCharacterFinder.match(textItem->text(), match.capturedEnd());
-                    }
-                    break;
+        case TextParagraphType::Character: {
+            if (!paragraph.isCorrection) {
+                const auto& character = paragraph.character;
+                auto& characterData = lastScene.character(character);
+                ++characterData.totalDialogues;
+                if (!characters.contains(character)) {
+                    characters.insert(character);
+                    characterData.isFirstAppearance = true;
                 }
+            }
+            break;
+        }
 
-                default:
-                    break;
+        case TextParagraphType::Action: {
+            for (const auto& character : paragraph.characters) {
+                auto& characterData = lastScene.character(character);
+                if (!characters.contains(character)) {
+                    characters.insert(character);
+                    characterData.isFirstAppearance = true;
                 }
-
-                break;
             }
+            break;
+        }
 
-            default:
-                break;
-            }
+        default:
+            break;
         }
-    };
-    includeInReport(d->screenplayModel->itemForIndex({}));
+    }
     if (lastScene.page != invalidPage) {
         scenes.append(lastScene);
     }
@@ -310,11 +230,7 @@ void ScreenplaySceneReport::build(QAbstractItemModel* _model)
     //
     // ... наполняем таблицу
     //
-    if (d->sceneModel.isNull()) {
-        d->sceneModel.reset(new QStandardItemModel);
-    } else {
-        d->sceneModel->clear();
-    }
+    d->preparedSceneModel.clear();
     const auto titleBackgroundColor = d->showCharacters
         ? QVariant::fromValue(ColorHelper::transparent(Ui::DesignSystem::color().onBackground(),
                                                        Ui::DesignSystem::elevationEndOpacity()))
@@ -335,7 +251,7 @@ void ScreenplaySceneReport::build(QAbstractItemModel* _model)
             }
         }
 
-        d->sceneModel->appendRow({
+        d->preparedSceneModel.appendRow({
             sceneItem,
             createModelItem(scene.number, titleBackgroundColor),
             createModelItem(QString::number(scene.page), titleBackgroundColor),
@@ -344,28 +260,46 @@ void ScreenplaySceneReport::build(QAbstractItemModel* _model)
         });
     }
     //
-    d->sceneModel->setHeaderData(
+    d->preparedSceneModel.setHeaderData(
         0, Qt::Horizontal,
         QCoreApplication::translate("BusinessLayer::ScreenplaySceneReport", "Scene/characters"),
         Qt::DisplayRole);
-    d->sceneModel->setHeaderData(
+    d->preparedSceneModel.setHeaderData(
         1, Qt::Horizontal,
         QCoreApplication::translate("BusinessLayer::ScreenplaySceneReport", "Number"),
         Qt::DisplayRole);
-    d->sceneModel->setHeaderData(
+    d->preparedSceneModel.setHeaderData(
         2, Qt::Horizontal,
         QCoreApplication::translate("BusinessLayer::ScreenplaySceneReport", "Page"),
         Qt::DisplayRole);
-    d->sceneModel->setHeaderData(
+    d->preparedSceneModel.setHeaderData(
         3, Qt::Horizontal,
         QCoreApplication::translate("BusinessLayer::ScreenplaySceneReport", "Characters"),
         Qt::DisplayRole);
-    d->sceneModel->setHeaderData(
+    d->preparedSceneModel.setHeaderData(
         4, Qt::Horizontal,
         QCoreApplication::translate("BusinessLayer::ScreenplaySceneReport", "Duration"),
         Qt::DisplayRole);
 }
 
+void ScreenplaySceneReport::applyPrepared(QAbstractItemModel* _model)
+{
+    if (qobject_cast<ScreenplayTextModel*>(_model) == nullptr) {
+        return;
+    }
+
+    if (d->sceneModel.isNull()) {
+        d->sceneModel.reset(new QStandardItemModel);
+    }
+    ModelHelper::moveContent(&d->preparedSceneModel, d->sceneModel.data());
+}
+
+void ScreenplaySceneReport::build(QAbstractItemModel* _model)
+{
+    prepare(_model);
+    applyPrepared(_model);
+}
+
 void ScreenplaySceneReport::setParameters(bool _showCharacters, int _sortBy)
 {
     d->showCharacters = _showCharacters;
@@ -5,18 +5,18 @@
 #include <business_layer/model/screenplay/screenplay_information_model.h>
 #include <business_layer/model/screenplay/text/screenplay_text_block_parser.h>
 #include <business_layer/model/screenplay/text/screenplay_text_model.h>
-#include <business_layer/model/screenplay/text/screenplay_text_model_text_item.h>
+#include <business_layer/reports/screenplay/screenplay_report_snapshot.h>
 #include <business_layer/templates/screenplay_template.h>
 #include <business_layer/templates/templates_facade.h>
 #include <ui/widgets/text_edit/page/page_text_edit.h>
 #include <utils/helpers/color_helper.h>
+#include <utils/helpers/model_helper.h>
 #include <utils/helpers/text_helper.h>
 #include <utils/helpers/time_helper.h>
 
 #include <QCoreApplication>
 #include <QPdfWriter>
 #include <QPointer>
-#include <QRegularExpression>
 #include <QStandardItemModel>
 
 #include <set>
@@ -37,9 +37,13 @@ public:
     CharactersCount charactersCount;
 
     QScopedPointer<QStandardItemModel> textInfoModel;
+    QStandardItemModel preparedTextInfoModel;
     QScopedPointer<QStandardItemModel> scenesInfoModel;
+    QStandardItemModel preparedScenesInfoModel;
     QScopedPointer<QStandardItemModel> locationsInfoModel;
+    QStandardItemModel preparedLocationsInfoModel;
     QScopedPointer<QStandardItemModel> charactersInfoModel;
+    QStandardItemModel preparedCharactersInfoModel;
 };
 
 
@@ -53,7 +57,7 @@ ScreenplaySummaryReport::ScreenplaySummaryReport()
 
 ScreenplaySummaryReport::~ScreenplaySummaryReport() = default;
 
-void ScreenplaySummaryReport::build(QAbstractItemModel* _model)
+void ScreenplaySummaryReport::prepare(QAbstractItemModel* _model)
 {
     if (_model == nullptr) {
         return;
@@ -88,121 +92,57 @@ void ScreenplaySummaryReport::build(QAbstractItemModel* _model)
     // - персонаж - кол-во реплик
     QHash<QString, int> charactersToDialogues;
 
-    //
-    // Сформируем регулярное выражение для выуживания молчаливых персонажей
-    //
-    QString rxPattern;
-    auto charactersModel = d->screenplayModel->charactersList();
-    for (int index = 0; index < charactersModel->rowCount(); ++index) {
-        const auto characterName = charactersModel->index(index, 0).data().toString();
-        if (!rxPattern.isEmpty()) {
-            rxPattern.append("|");
-        }
-        rxPattern.append(TextHelper::toRxEscaped(characterName));
-    }
-    if (!rxPattern.isEmpty()) {
-        rxPattern.prepend("(^|\\W)(");
-        rxPattern.append(")($|\\W)");
-    }
-    const QRegularExpression rxCharacterFinder(
-        rxPattern,
-        QRegularExpression::CaseInsensitiveOption | QRegularExpression::UseUnicodePropertiesOption);
-
     //
     // Собираем статистику
     //
-    std::function<void(const TextModelItem*)> includeInReport;
-    includeInReport = [&includeInReport, &paragraphsToCounters, &totalWords, &totalCharacters,
-                       &scenes, &charactersToDialogues,
-                       &rxCharacterFinder](const TextModelItem* _item) {
-        for (int childIndex = 0; childIndex < _item->childCount(); ++childIndex) {
-            auto childItem = _item->childAt(childIndex);
-            switch (childItem->type()) {
-            case TextModelItemType::Folder:
-            case TextModelItemType::Group: {
-                includeInReport(childItem);
-                break;
-            }
-
-            case TextModelItemType::Text: {
-                auto textItem = static_cast<ScreenplayTextModelTextItem*>(childItem);
-                //
-                // ... счётчики
-                //
-                if (paragraphsToCounters.contains(textItem->paragraphType())) {
-                    auto& paragraphCounters = paragraphsToCounters[textItem->paragraphType()];
-                    ++paragraphCounters.occurrences;
-                    const auto paragraphWords = TextHelper::wordsCount(textItem->text());
-                    paragraphCounters.words += paragraphWords;
-                    totalWords += paragraphWords;
-                    totalCharacters.withSpaces += textItem->text().length();
-                    totalCharacters.withoutSpaces
-                        += textItem->text().length() - textItem->text().count(' ');
-                }
-
-                //
-                // ... стата по объектам
-                //
-                switch (textItem->paragraphType()) {
-                case TextParagraphType::SceneHeading: {
-                    scenes.append(TextHelper::smartToUpper(textItem->text()));
-                    break;
-                }
-
-                case TextParagraphType::SceneCharacters: {
-                    const auto sceneCharacters
-                        = ScreenplaySceneCharactersParser::characters(textItem->text());
-                    for (const auto& character : sceneCharacters) {
-                        if (!charactersToDialogues.contains(character)) {
-                            charactersToDialogues.insert(character, 0);
-                        }
-                    }
-                    break;
-                }
-
-                case TextParagraphType::Character: {
-                    const auto character = ScreenplayCharacterParser::name(textItem->text());
-                    if (!charactersToDialogues.contains(character)) {
-                        charactersToDialogues.insert(character, 1);
-                    } else {
-                        ++charactersToDialogues[character];
-                    }
-                    break;
-                }
+    const auto snapshot = ScreenplayReportSnapshot::forModel(d->screenplayModel);
+    for (const auto& paragraph : snapshot->paragraphs()) {
+        //
+        // ... счётчики
+        //
+        if (paragraphsToCounters.contains(paragraph.type)) {
+            auto& paragraphCounters = paragraphsToCounters[paragraph.type];
+            ++paragraphCounters.occurrences;
+            const auto paragraphWords = TextHelper::wordsCount(paragraph.text);
+            paragraphCounters.words += paragraphWords;
+            totalWords += paragraphWords;
+            totalCharacters.withSpaces += paragraph.text.length();
+            totalCharacters.withoutSpaces += paragraph.text.length() - paragraph.text.count(' ');
+        }
 
-                case TextParagraphType::Action: {
-                    if (rxCharacterFinder.pattern().isEmpty()) {
-                        break;
-                    }
-
-                    auto match = rxCharacterFinder.match(textItem->text());
-                    while (match.hasMatch()) {
-                        const QString character = TextHelper::smartToUpper(match.captured(2));
-                        if (!charactersToDialogues.contains(character)) {
-                            charactersToDialogues.insert(character, 0);
-                        }
-
-                        //
-                        // Ищем дальше
-                        //
-                        match = rxCharacterFinder.match(textItem->text(), match.capturedEnd());
-                    }
-                    break;
-                }
+        //
+        // ... стата по объектам
+        //
+        switch (paragraph.type) {
+        case TextParagraphType::SceneHeading: {
+            scenes.append(TextHelper::smartToUpper(paragraph.text));
+            break;
+        }
 
-                default:
-                    break;
+        case TextParagraphType::SceneCharacters:
+        case TextParagraphType::Action: {
+            for (const auto& character : paragraph.characters) {
+                if (!charactersToDialogues.contains(character)) {
+                    charactersToDialogues.insert(character, 0);
                 }
-
-                break;
             }
+            break;
+        }
 
-            default:
-                break;
+        case TextParagraphType::Character: {
+            const auto& character = paragraph.character;
+            if (!charactersToDialogues.contains(character)) {
+                charactersToDialogues.insert(character, 1);
+            } else {
+                ++charactersToDialogues[character];
             }
+            break;
         }
-    };
-    includeInReport(d->screenplayModel->itemForIndex({}));
+
+        default:
+            break;
+        }
+    }
 
     //
     // Формируем отчёт
@@ -221,34 +161,12 @@ void ScreenplaySummaryReport::build(QAbstractItemModel* _model)
     // ... сводка
     //
     {
-        d->duration = d->screenplayModel->duration();
-        d->pagesCount = [this] {
-            const auto& screenplayTemplate = TemplatesFacade::screenplayTemplate(
-                d->screenplayModel->informationModel()->templateId());
-
-            PageTextEdit textEdit;
-            textEdit.setUsePageMode(true);
-            textEdit.setPageSpacing(0);
-            textEdit.setPageFormat(screenplayTemplate.pageSizeId());
-            textEdit.setPageMarginsMm(screenplayTemplate.pageMargins());
-            ScreenplayTextDocument screenplayDocument;
-            textEdit.setDocument(&screenplayDocument);
-
-            const bool kCanChangeModel = false;
-            screenplayDocument.setModel(d->screenplayModel, kCanChangeModel);
-
-            return screenplayDocument.pageCount();
-        }();
         d->wordsCount = totalWords;
         d->charactersCount = totalCharacters;
         //
         // ... иформация по тексту
         //
-        if (d->textInfoModel.isNull()) {
-            d->textInfoModel.reset(new QStandardItemModel);
-        } else {
-            d->textInfoModel->clear();
-        }
+        d->preparedTextInfoModel.clear();
         //
         for (int index = 0; index < paragraphTypes.size(); ++index) {
             const auto& paragraphType = paragraphTypes.at(index);
@@ -261,25 +179,25 @@ void ScreenplaySummaryReport::build(QAbstractItemModel* _model)
             paragraphItem->setData(u8"\U000F0766", Qt::DecorationRole);
             paragraphItem->setData(ColorHelper::forNumber(index), Qt::DecorationPropertyRole);
 
-            d->textInfoModel->appendRow(
+            d->preparedTextInfoModel.appendRow(
                 { paragraphItem, createModelItem(QString::number(paragraphCounters.words)),
                   createModelItem(QString::number(paragraphCounters.occurrences)),
                   createPercentModelItem(paragraphCounters.words * 100.0 / totalWords) });
         }
         //
-        d->textInfoModel->setHeaderData(
+        d->preparedTextInfoModel.setHeaderData(
             0, Qt::Horizontal,
             QCoreApplication::translate("BusinessLayer::ScreenplaySummaryReport", "Paragraph"),
             Qt::DisplayRole);
-        d->textInfoModel->setHeaderData(
+        d->preparedTextInfoModel.setHeaderData(
             1, Qt::Horizontal,
             QCoreApplication::translate("BusinessLayer::ScreenplaySummaryReport", "Words"),
             Qt::DisplayRole);
-        d->textInfoModel->setHeaderData(
+        d->preparedTextInfoModel.setHeaderData(
             2, Qt::Horizontal,
             QCoreApplication::translate("BusinessLayer::ScreenplaySummaryReport", "Occurrences"),
             Qt::DisplayRole);
-        d->textInfoModel->setHeaderData(
+        d->preparedTextInfoModel.setHeaderData(
             3, Qt::Horizontal,
             QCoreApplication::translate("BusinessLayer::ScreenplaySummaryReport", "Percents"),
             Qt::DisplayRole);
@@ -306,11 +224,7 @@ void ScreenplaySummaryReport::build(QAbstractItemModel* _model)
         //
         // Формируем таблицу
         //
-        if (d->scenesInfoModel.isNull()) {
-            d->scenesInfoModel.reset(new QStandardItemModel);
-        } else {
-            d->scenesInfoModel->clear();
-        }
+        d->preparedScenesInfoModel.clear();
         //
         const auto totalCount
             = std::accumulate(sceneTimesToCount.begin(), sceneTimesToCount.end(), 0);
@@ -326,21 +240,21 @@ void ScreenplaySummaryReport::build(QAbstractItemModel* _model)
                 timeName->setData(u8"\U000F0766", Qt::DecorationRole);
                 timeName->setData(ColorHelper::forNumber(index++), Qt::DecorationPropertyRole);
 
-                d->scenesInfoModel->appendRow(
+                d->preparedScenesInfoModel.appendRow(
                     { timeName, createModelItem(QString::number(count)),
                       createPercentModelItem(count * 100.0 / totalCount) });
             }
         }
         //
-        d->scenesInfoModel->setHeaderData(
+        d->preparedScenesInfoModel.setHeaderData(
             0, Qt::Horizontal,
             QCoreApplication::translate("BusinessLayer::ScreenplaySummaryReport", "Scene time"),
             Qt::DisplayRole);
-        d->scenesInfoModel->setHeaderData(
+        d->preparedScenesInfoModel.setHeaderData(
             1, Qt::Horizontal,
             QCoreApplication::translate("BusinessLayer::ScreenplaySummaryReport", "Occurrences"),
             Qt::DisplayRole);
-        d->scenesInfoModel->setHeaderData(
+        d->preparedScenesInfoModel.setHeaderData(
             2, Qt::Horizontal,
             QCoreApplication::translate("BusinessLayer::ScreenplaySummaryReport", "Percents"),
             Qt::DisplayRole);
@@ -367,11 +281,7 @@ void ScreenplaySummaryReport::build(QAbstractItemModel* _model)
         //
         // Формируем таблицу
         //
-        if (d->locationsInfoModel.isNull()) {
-            d->locationsInfoModel.reset(new QStandardItemModel);
-        } else {
-            d->locationsInfoModel->clear();
-        }
+        d->preparedLocationsInfoModel.clear();
         //
         const auto totalCount
             = std::accumulate(locationPlacesToCount.begin(), locationPlacesToCount.end(), 0);
@@ -387,21 +297,21 @@ void ScreenplaySummaryReport::build(QAbstractItemModel* _model)
                 placeName->setData(u8"\U000F0766", Qt::DecorationRole);
                 placeName->setData(ColorHelper::forNumber(index++), Qt::DecorationPropertyRole);
 
-                d->locationsInfoModel->appendRow(
+                d->preparedLocationsInfoModel.appendRow(
                     { placeName, createModelItem(QString::number(count)),
                       createPercentModelItem(count * 100.0 / totalCount) });
             }
         }
         //
-        d->locationsInfoModel->setHeaderData(
+        d->preparedLocationsInfoModel.setHeaderData(
             0, Qt::Horizontal,
             QCoreApplication::translate("BusinessLayer::ScreenplaySummaryReport", "Scene intro"),
             Qt::DisplayRole);
-        d->locationsInfoModel->setHeaderData(
+        d->preparedLocationsInfoModel.setHeaderData(
             1, Qt::Horizontal,
             QCoreApplication::translate("BusinessLayer::ScreenplaySummaryReport", "Occurrences"),
             Qt::DisplayRole);
-        d->locationsInfoModel->setHeaderData(
+        d->preparedLocationsInfoModel.setHeaderData(
             2, Qt::Horizontal,
             QCoreApplication::translate("BusinessLayer::ScreenplaySummaryReport", "Percents"),
             Qt::DisplayRole);
@@ -427,11 +337,7 @@ void ScreenplaySummaryReport::build(QAbstractItemModel* _model)
         //
         // Формируем таблицу
         //
-        if (d->charactersInfoModel.isNull()) {
-            d->charactersInfoModel.reset(new QStandardItemModel);
-        } else {
-            d->charactersInfoModel->clear();
-        }
+        d->preparedCharactersInfoModel.clear();
         //
         const auto totalCount = nonspeaking + speakAbout10 + speakMore10;
         int index = 0;
@@ -441,7 +347,7 @@ void ScreenplaySummaryReport::build(QAbstractItemModel* _model)
             characterItem->setData(u8"\U000F0766", Qt::DecorationRole);
             characterItem->setData(ColorHelper::forNumber(index++), Qt::DecorationPropertyRole);
 
-            d->charactersInfoModel->appendRow(
+            d->preparedCharactersInfoModel.appendRow(
                 { characterItem, createModelItem(QString::number(_count)),
                   createPercentModelItem(_count * 100.0 / totalCount) });
         };
@@ -457,21 +363,77 @@ void ScreenplaySummaryReport::build(QAbstractItemModel* _model)
             QCoreApplication::translate("BusinessLogic::ScreenplaySummaryReport", "Nonspeaking"),
             nonspeaking);
         //
-        d->charactersInfoModel->setHeaderData(
+        d->preparedCharactersInfoModel.setHeaderData(
             0, Qt::Horizontal,
             QCoreApplication::translate("BusinessLayer::ScreenplaySummaryReport", "Character type"),
             Qt::DisplayRole);
-        d->charactersInfoModel->setHeaderData(
+        d->preparedCharactersInfoModel.setHeaderData(
             1, Qt::Horizontal,
             QCoreApplication::translate("BusinessLayer::ScreenplaySummaryReport", "Occurrences"),
             Qt::DisplayRole);
-        d->charactersInfoModel->setHeaderData(
+        d->preparedCharactersInfoModel.setHeaderData(
             2, Qt::Horizontal,
             QCoreApplication::translate("BusinessLayer::ScreenplaySummaryReport", "Percents"),
             Qt::DisplayRole);
     }
 }
 
+void ScreenplaySummaryReport::applyPrepared(QAbstractItemModel* _model)
+{
+    if (qobject_cast<ScreenplayTextModel*>(_model) == nullptr) {
+        return;
+    }
+
+    //
+    // Длительность и количество страниц определяются по документу, который вёрстается в
+    // потоке модели, поэтому их получаем при применении, а не при фоновой подготовке отчёта
+    //
+    d->duration = d->screenplayModel->duration();
+    d->pagesCount = [this] {
+        const auto& screenplayTemplate = TemplatesFacade::screenplayTemplate(
+            d->screenplayModel->informationModel()->templateId());
+
+        PageTextEdit textEdit;
+        textEdit.setUsePageMode(true);
+        textEdit.setPageSpacing(0);
+        textEdit.setPageFormat(screenplayTemplate.pageSizeId());
+        textEdit.setPageMarginsMm(screenplayTemplate.pageMargins());
+        ScreenplayTextDocument screenplayDocument;
+        textEdit.setDocument(&screenplayDocument);
+
+        const bool kCanChangeModel = false;
+        screenplayDocument.setModel(d->screenplayModel, kCanChangeModel);
+
+        return screenplayDocument.pageCount();
+    }();
+
+    if (d->textInfoModel.isNull()) {
+        d->textInfoModel.reset(new QStandardItemModel);
+    }
+    ModelHelper::moveContent(&d->preparedTextInfoModel, d->textInfoModel.data());
+
+    if (d->scenesInfoModel.isNull()) {
+        d->scenesInfoModel.reset(new QStandardItemModel);
+    }
+    ModelHelper::moveContent(&d->preparedScenesInfoModel, d->scenesInfoModel.data());
+
+    if (d->locationsInfoModel.isNull()) {
+        d->locationsInfoModel.reset(new QStandardItemModel);
+    }
+    ModelHelper::moveContent(&d->preparedLocationsInfoModel, d->locationsInfoModel.data());
+
+    if (d->charactersInfoModel.isNull()) {
+        d->charactersInfoModel.reset(new QStandardItemModel);
+    }
+    ModelHelper::moveContent(&d->preparedCharactersInfoModel, d->charactersInfoModel.data());
+}
+
+void ScreenplaySummaryReport::build(QAbstractItemModel* _model)
+{
+    prepare(_model);
+    applyPrepared(_model);
+}
+
 std::chrono::milliseconds ScreenplaySummaryReport::duration() const
 {
     return d->duration;
@@ -0,0 +1,522 @@
+#include "search_index.h"
+
+#include <business_layer/model/characters/character_model.h>
+#include <business_layer/model/locations/location_model.h>
+#include <business_layer/model/text/text_model.h>
+#include <business_layer/model/text/text_model_text_item.h>
+#include <business_layer/model/worlds/world_model.h>
+#include <business_layer/templates/text_template.h>
+#include <utils/helpers/text_helper.h>
+
+#include <QMap>
+
+#include <algorithm>
+#include <functional>
+
+
+namespace BusinessLayer {
+
+namespace {
+
+/**
+ * @brief Слово текста вместе с его позицией
+ */
+struct Token {
+    int position = 0;
+    QString text;
+};
+
+/**
+ * @brief Разбить текст на слова, приведённые к нижнему регистру
+ */
+QVector<Token> tokenize(const QString& _text)
+{
+    QVector<Token> tokens;
+    int wordStart = -1;
+    for (int index = 0; index <= _text.length(); ++index) {
+        const bool isWordCharacter = index < _text.length() && _text.at(index).isLetterOrNumber();
+        if (isWordCharacter && wordStart == -1) {
+            wordStart = index;
+        } else if (!isWordCharacter && wordStart != -1) {
+            tokens.append(
+                { wordStart, TextHelper::smartToLower(_text.mid(wordStart, index - wordStart)) });
+            wordStart = -1;
+        }
+    }
+    return tokens;
+}
+
+} // namespace
+
+
+class SearchIndex::Implementation
+{
+public:
+    /**
+     * @brief Проиндексированный абзац текста, или поле карточки
+     */
+    struct Entry {
+        AbstractModel* model = nullptr;
+        TextModelItem* item = nullptr;
+        SearchField field = SearchField::Text;
+        TextParagraphType paragraphType = TextParagraphType::Undefined;
+        QVector<Token> tokens;
+    };
+
+    /**
+     * @brief Записи индекса, относящиеся к модели
+     */
+    struct ModelEntries {
+        QHash<TextModelItem*, int> items;
+        QHash<int, int> fields;
+    };
+
+
+    /**
+     * @brief Добавить запись в индекс
+     * @return Идентификатор записи
+     */
+    int addEntry(const Entry& _entry);
+
+    /**
+     * @brief Удалить запись из индекса
+     */
+    void removeEntry(int _entryId);
+
+    /**
+     * @brief Проиндексировать элемент текстовой модели вместе с вложенными элементами
+     */
+    void indexItem(AbstractModel* _model, TextModelItem* _item, bool _withChildren);
+
+    /**
+     * @brief Убрать из индекса элемент текстовой модели вместе с вложенными элементами
+     */
+    void unindexItem(AbstractModel* _model, TextModelItem* _item);
+
+    /**
+     * @brief Проиндексировать поле карточки
+     */
+    void indexField(AbstractModel* _model, SearchField _field, const QString& _text);
+
+    /**
+     * @brief Проиндексировать модель целиком
+     */
+    void indexModel(AbstractModel* _model);
+
+    /**
+     * @brief Убрать из индекса все записи модели
+     */
+    void unindexModel(AbstractModel* _model);
+
+
+    /**
+     * @brief Проиндексированы ли модели, индекс строится при первом поиске
+     */
+    bool isBuilt = false;
+
+    /**
+     * @brief Модели в порядке их добавления в индекс
+     */
+    QVector<AbstractModel*> models;
+
+    /**
+     * @brief Записи индекса каждой из моделей
+     */
+    QHash<AbstractModel*, ModelEntries> modelsEntries;
+
+    /**
+     * @brief Все записи индекса
+     */
+    QHash<int, Entry> entries;
+    int lastEntryId = 0;
+
+    /**
+     * @brief Слово - записи, в которых оно встречается
+     * @note Слова упорядочены, чтобы можно было быстро найти все слова с заданным началом
+     */
+    QMap<QString, QSet<int>> postings;
+};
+
+int SearchIndex::Implementation::addEntry(const Entry& _entry)
+{
+    const int entryId = ++lastEntryId;
+    entries.insert(entryId, _entry);
+    for (const auto& token : _entry.tokens) {
+        postings[token.text].insert(entryId);
+    }
+    return entryId;
+}
+
+void SearchIndex::Implementation::removeEntry(int _entryId)
+{
+    const auto entry = entries.take(_entryId);
+    for (const auto& token : entry.tokens) {
+        auto iter = postings.find(token.text);
+        if (iter == postings.end()) {
+            continue;
+        }
+
+        iter->remove(_entryId);
+        if (iter->isEmpty()) {
+            postings.erase(iter);
+        }
+    }
+}
+
+void SearchIndex::Implementation::indexItem(AbstractModel* _model, TextModelItem* _item,
+                                            bool _withChildren)
+{
+    if (_item == nullptr) {
+        return;
+    }
+
+    if (_item->type() == TextModelItemType::Text) {
+        const auto textItem = static_cast<TextModelTextItem*>(_item);
+        auto& items = modelsEntries[_model].items;
+        const auto tokens = tokenize(textItem->text());
+        const auto entryIter = items.constFind(_item);
+        if (entryIter != items.constEnd()) {
+            //
+            // Если текст и тип абзаца не изменились, то и перестраивать нечего
+            //
+            const auto& entry = entries[entryIter.value()];
+            const auto isTokensEqual = [](const Token& _lhs, const Token& _rhs) {
+                return _lhs.position == _rhs.position && _lhs.text == _rhs.text;
+            };
+            if (entry.paragraphType == textItem->paragraphType()
+                && entry.tokens.size() == tokens.size()
+                && std::equal(entry.tokens.begin(), entry.tokens.end(), tokens.begin(),
+                              isTokensEqual)) {
+                return;
+            }
+
+            removeEntry(entryIter.value());
+        }
+
+        Entry entry;
+        entry.model = _model;
+        entry.item = _item;
+        entry.paragraphType = textItem->paragraphType();
+        entry.tokens = tokens;
+        items.insert(_item, addEntry(entry));
+    }
+
+    if (!_withChildren) {
+        return;
+    }
+
+    for (int childIndex = 0; childIndex < _item->childCount(); ++childIndex) {
+        indexItem(_model, _item->childAt(childIndex), _withChildren);
+    }
+}
+
+void SearchIndex::Implementation::unindexItem(AbstractModel* _model, TextModelItem* _item)
+{
+    if (_item == nullptr) {
+        return;
+    }
+
+    auto& items = modelsEntries[_model].items;
+    if (const auto entryIter = items.find(_item); entryIter != items.end()) {
+        removeEntry(entryIter.value());
+        items.erase(entryIter);
+    }
+
+    for (int childIndex = 0; childIndex < _item->childCount(); ++childIndex) {
+        unindexItem(_model, _item->childAt(childIndex));
+    }
+}
+
+void SearchIndex::Implementation::indexField(AbstractModel* _model, SearchField _field,
+                                             const QString& _text)
+{
+    auto& fields = modelsEntries[_model].fields;
+    if (fields.contains(static_cast<int>(_field))) {
+        removeEntry(fields.take(static_cast<int>(_field)));
+    }
+
+    Entry entry;
+    entry.model = _model;
+    entry.field = _field;
+    entry.tokens = tokenize(_text);
+    if (entry.tokens.isEmpty()) {
+        return;
+    }
+
+    fields.insert(static_cast<int>(_field), addEntry(entry));
+}
+
+void SearchIndex::Implementation::indexModel(AbstractModel* _model)
+{
+    if (auto textModel = qobject_cast<TextModel*>(_model)) {
+        const bool withChildren = true;
+        indexItem(_model, textModel->itemForIndex({}), withChildren);
+    } else if (auto character = qobject_cast<CharacterModel*>(_model)) {
+        indexField(_model, SearchField::Name, character->name());
+        indexField(_model, SearchField::OneSentenceDescription,
+                   character->oneSentenceDescription());
+        indexField(_model, SearchField::LongDescription, character->longDescription());
+    } else if (auto location = qobject_cast<LocationModel*>(_model)) {
+        indexField(_model, SearchField::Name, location->name());
+        indexField(_model, SearchField::OneSentenceDescription,
+                   location->oneSentenceDescription());
+        indexField(_model, SearchField::LongDescription, location->longDescription());
+    } else if (auto world = qobject_cast<WorldModel*>(_model)) {
+        indexField(_model, SearchField::Name, world->name());
+        indexField(_model, SearchField::OneSentenceDescription, world->oneSentenceDescription());
+        indexField(_model, SearchField::LongDescription, world->longDescription());
+    }
+}
+
+void SearchIndex::Implementation::unindexModel(AbstractModel* _model)
+{
+    const auto modelEntries = modelsEntries.take(_model);
+    for (const auto entryId : modelEntries.items) {
+        removeEntry(entryId);
+    }
+    for (const auto entryId : modelEntries.fields) {
+        removeEntry(entryId);
+    }
+}
+
+
+// ****
+
+
+SearchIndex::SearchIndex(QObject* _parent)
+    : QObject(_parent)
+    , d(new Implementation)
+{
+}
+
+SearchIndex::~SearchIndex() = default;
+
+void SearchIndex::addModel(AbstractModel* _model)
+{
+    if (_model == nullptr || d->models.contains(_model)) {
+        return;
+    }
+
+    d->models.append(_model);
+    connect(_model, &AbstractModel::destroyed, this, [this, _model] { removeModel(_model); });
+
+    //
+    // Пока поиском не пользовались, лишь запоминаем модель, а проиндексируем её при первом поиске
+    //
+    if (d->isBuilt) {
+        watchModel(_model);
+    }
+}
+
+void SearchIndex::watchModel(AbstractModel* _model)
+{
+    d->indexModel(_model);
+
+    //
+    // Карточки индексируем целиком при каждом изменении, т.к. текста в них немного
+    //
+    if (qobject_cast<TextModel*>(_model) == nullptr) {
+        connect(_model, &AbstractModel::contentsChanged, this,
+                [this, _model] { d->indexModel(_model); });
+        connect(_model, &AbstractModel::modelReset, this, [this, _model] {
+            d->unindexModel(_model);
+            d->indexModel(_model);
+        });
+        return;
+    }
+
+    //
+    // А в текстовых документах обновляем только изменившиеся абзацы
+    //
+    auto textModel = static_cast<TextModel*>(_model);
+    connect(textModel, &TextModel::dataChanged, this,
+            [this, textModel](const QModelIndex& _topLeft, const QModelIndex& _bottomRight) {
+                for (int row = _topLeft.row(); row <= _bottomRight.row(); ++row) {
+                    const auto index = textModel->index(row, 0, _topLeft.parent());
+                    const bool withChildren = false;
+                    d->indexItem(textModel, textModel->itemForIndex(index), withChildren);
+                }
+            });
+    connect(textModel, &TextModel::rowsInserted, this,
+            [this, textModel](const QModelIndex& _parent, int _first, int _last) {
+                for (int row = _first; row <= _last; ++row) {
+                    const auto index = textModel->index(row, 0, _parent);
+                    const bool withChildren = true;
+                    d->indexItem(textModel, textModel->itemForIndex(index), withChildren);
+                }
+            });
+    connect(textModel, &TextModel::rowsAboutToBeRemoved, this,
+            [this, textModel](const QModelIndex& _parent, int _first, int _last) {
+                for (int row = _first; row <= _last; ++row) {
+                    d->unindexItem(textModel,
+                                   textModel->itemForIndex(textModel->index(row, 0, _parent)));
+                }
+            });
+    connect(textModel, &TextModel::modelReset, this, [this, textModel] {
+        d->unindexModel(textModel);
+        d->indexModel(textModel);
+    });
+}
+
+void SearchIndex::removeModel(AbstractModel* _model)
+{
+    if (!d->models.removeOne(_model)) {
+        return;
+    }
+
+    _model->disconnect(this);
+    d->unindexModel(_model);
+}
+
+void SearchIndex::clear()
+{
+    for (auto model : std::as_const(d->models)) {
+        model->disconnect(this);
+    }
+    d->isBuilt = false;
+    d->models.clear();
+    d->modelsEntries.clear();
+    d->entries.clear();
+    d->postings.clear();
+}
+
+QVector<SearchResult> SearchIndex::find(const QString& _text,
+                                        const QSet<TextParagraphType>& _types)
+{
+    const auto queryTokens = tokenize(_text);
+    if (queryTokens.isEmpty()) {
+        return {};
+    }
+
+    if (!d->isBuilt) {
+        d->isBuilt = true;
+        for (auto model : std::as_const(d->models)) {
+            watchModel(model);
+        }
+    }
+
+    //
+    // Все слова фразы, кроме последнего, должны встречаться в записи целиком
+    //
+    bool hasCandidates = false;
+    QSet<int> candidates;
+    for (int index = 0; index < queryTokens.size() - 1; ++index) {
+        const auto postingsIter = d->postings.constFind(queryTokens.at(index).text);
+        if (postingsIter == d->postings.constEnd()) {
+            return {};
+        }
+
+        if (hasCandidates) {
+            candidates.intersect(postingsIter.value());
+        } else {
+            candidates = postingsIter.value();
+            hasCandidates = true;
+        }
+        if (candidates.isEmpty()) {
+            return {};
+        }
+    }
+
+    //
+    // ... а последнее может быть лишь началом слова
+    //
+    const auto& lastToken = queryTokens.constLast().text;
+    QSet<int> entriesToCheck;
+    for (auto postingsIter = d->postings.lowerBound(lastToken);
+         postingsIter != d->postings.constEnd() && postingsIter.key().startsWith(lastToken);
+         ++postingsIter) {
+        if (!hasCandidates) {
+            entriesToCheck.unite(postingsIter.value());
+            continue;
+        }
+
+        for (const auto entryId : postingsIter.value()) {
+            if (candidates.contains(entryId)) {
+                entriesToCheck.insert(entryId);
+            }
+        }
+    }
+
+    //
+    // Ищем вхождения фразы в отобранных записях
+    //
+    QHash<int, QVector<SearchResult>> entriesResults;
+    QSet<AbstractModel*> modelsWithResults;
+    for (const auto entryId : std::as_const(entriesToCheck)) {
+        const auto& entry = d->entries.find(entryId).value();
+        if (!_types.isEmpty()
+            && (entry.item == nullptr || !_types.contains(entry.paragraphType))) {
+            continue;
+        }
+
+        const auto& tokens = entry.tokens;
+        for (int index = 0; index + queryTokens.size() <= tokens.size(); ++index) {
+            bool isMatched = true;
+            for (int queryIndex = 0; queryIndex < queryTokens.size() - 1; ++queryIndex) {
+                if (tokens.at(index + queryIndex).text != queryTokens.at(queryIndex).text) {
+                    isMatched = false;
+                    break;
+                }
+            }
+            const auto& lastMatchedToken = tokens.at(index + queryTokens.size() - 1);
+            if (!isMatched || !lastMatchedToken.text.startsWith(lastToken)) {
+                continue;
+            }
+
+            SearchResult result;
+            result.model = entry.model;
+            result.item = entry.item;
+            result.field = entry.field;
+            result.position = tokens.at(index).position;
+            result.length = lastMatchedToken.position + lastToken.length() - result.position;
+            entriesResults[entryId].append(result);
+            modelsWithResults.insert(entry.model);
+        }
+    }
+    if (entriesResults.isEmpty()) {
+        return {};
+    }
+
+    //
+    // Упорядочиваем результаты по моделям и следованию абзацев внутри текстовых документов
+    //
+    QVector<SearchResult> results;
+    const auto appendEntryResults = [&entriesResults, &results](int _entryId) {
+        const auto entryIter = entriesResults.constFind(_entryId);
+        if (entryIter != entriesResults.constEnd()) {
+            results.append(entryIter.value());
+        }
+    };
+    for (auto model : std::as_const(d->models)) {
+        if (!modelsWithResults.contains(model)) {
+            continue;
+        }
+
+        const auto modelEntries = d->modelsEntries.value(model);
+        if (auto textModel = qobject_cast<TextModel*>(model)) {
+            std::function<void(TextModelItem*)> appendItemResults;
+            appendItemResults = [&modelEntries, &appendEntryResults,
+                                 &appendItemResults](TextModelItem* _item) {
+                if (const auto entryIter = modelEntries.items.constFind(_item);
+                    entryIter != modelEntries.items.constEnd()) {
+                    appendEntryResults(entryIter.value());
+                }
+                for (int childIndex = 0; childIndex < _item->childCount(); ++childIndex) {
+                    appendItemResults(_item->childAt(childIndex));
+                }
+            };
+            appendItemResults(textModel->itemForIndex({}));
+        } else {
+            for (const auto field : { SearchField::Name, SearchField::OneSentenceDescription,
+                                      SearchField::LongDescription }) {
+                if (const auto entryIter = modelEntries.fields.constFind(static_cast<int>(field));
+                    entryIter != modelEntries.fields.constEnd()) {
+                    appendEntryResults(entryIter.value());
+                }
+            }
+        }
+    }
+    return results;
+}
+
+} // namespace BusinessLayer
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <QObject>
+#include <QSet>
+#include <QVector>
+
+#include <corelib_global.h>
+
+
+namespace BusinessLayer {
+
+class AbstractModel;
+class TextModelItem;
+enum class TextParagraphType;
+
+/**
+ * @brief Поле документа, в котором найден текст
+ */
+enum class CORE_LIBRARY_EXPORT SearchField {
+    Text,
+    Name,
+    OneSentenceDescription,
+    LongDescription,
+};
+
+/**
+ * @brief Найденное вхождение искомого текста
+ */
+struct CORE_LIBRARY_EXPORT SearchResult {
+    /**
+     * @brief Модель документа, в котором найден текст
+     */
+    AbstractModel* model = nullptr;
+
+    /**
+     * @brief Абзац текстового документа, либо nullptr, если текст найден в поле карточки
+     */
+    TextModelItem* item = nullptr;
+
+    /**
+     * @brief Поле, в котором найден текст
+     */
+    SearchField field = SearchField::Text;
+
+    /**
+     * @brief Позиция и длина вхождения в тексте абзаца, или поля
+     */
+    int position = 0;
+    int length = 0;
+};
+
+/**
+ * @brief Обратный индекс слов документов проекта для полнотекстового поиска
+ * @note Индекс строится при первом поиске, а затем обновляется по сигналам об изменении моделей,
+ *       поэтому пока поиском не пользуются, модели не индексируются. Поиск ведётся без учёта
+ *       регистра и знаков препинания между словами, при этом последнее слово запроса ищется как
+ *       начало слова
+ */
+class CORE_LIBRARY_EXPORT SearchIndex : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit SearchIndex(QObject* _parent = nullptr);
+    ~SearchIndex() override;
+
+    /**
+     * @brief Добавить модель в индекс
+     * @note Индексируются текстовые модели, а также карточки персонажей, локаций и миров
+     */
+    void addModel(AbstractModel* _model);
+
+    /**
+     * @brief Убрать модель из индекса
+     */
+    void removeModel(AbstractModel* _model);
+
+    /**
+     * @brief Очистить индекс
+     */
+    void clear();
+
+    /**
+     * @brief Найти все вхождения фразы в документах проекта
+     * @param _types Типы абзацев, в которых нужно искать, если не заданы, то ищем везде
+     * @return Вхождения в порядке добавления моделей и следования абзацев в документе
+     */
+    QVector<SearchResult> find(const QString& _text, const QSet<TextParagraphType>& _types = {});
+
+private:
+    /**
+     * @brief Проиндексировать модель и отслеживать её изменения
+     */
+    void watchModel(AbstractModel* _model);
+
+
+    class Implementation;
+    QScopedPointer<Implementation> d;
+};
+
+} // namespace BusinessLayer
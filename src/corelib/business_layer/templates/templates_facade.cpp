@@ -7,6 +7,8 @@
 #include "simple_text_template.h"
 #include "stageplay_template.h"
 
+#include <business_layer/chronometry/chronometer.h>
+#include <business_layer/document/text/text_document_pagination.h>
 #include <business_layer/model/audioplay/audioplay_information_model.h>
 #include <business_layer/model/audioplay/audioplay_synopsis_model.h>
 #include <business_layer/model/audioplay/audioplay_title_page_model.h>
@@ -286,6 +288,11 @@ void TemplatesFacade::Implementation::saveTemplate(const QString& _templatesDir,
     const QString templatesFolderPath = QString("%1/%2").arg(appDataFolderPath, _templatesDir);
     _template.saveToFile(QString("%1/%2").arg(templatesFolderPath, _template.id()));
 
+    //
+    // Стили шаблона могли измениться, поэтому сохранённые разметки документов уже не актуальны
+    //
+    TextDocumentPagination::resetCache();
+
     auto& templateInfo = this->templateInfo<TemplateType>();
 
     //
@@ -350,6 +357,7 @@ void TemplatesFacade::Implementation::removeTemplate(const QString& _templatesDi
         = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
     const QString templatesFolderPath = QString("%1/%2").arg(appDataFolderPath, _templatesDir);
     QFile::remove(QString("%1/%2").arg(templatesFolderPath, _templateId));
+    TextDocumentPagination::resetCache();
 
     //
     // Удаляем шаблон из списке
@@ -489,6 +497,7 @@ void TemplatesFacade::setDefaultSimpleTextTemplate(const QString& _templateId)
 void TemplatesFacade::setDefaultScreenplayTemplate(const QString& _templateId)
 {
     instance().d->setDefaultTemplate<ScreenplayTemplate>(_templateId);
+    ScreenplayChronometer::resetCache();
 }
 
 void TemplatesFacade::setDefaultComicBookTemplate(const QString& _templateId)
@@ -499,6 +508,7 @@ void TemplatesFacade::setDefaultComicBookTemplate(const QString& _templateId)
 void TemplatesFacade::setDefaultAudioplayTemplate(const QString& _templateId)
 {
     instance().d->setDefaultTemplate<AudioplayTemplate>(_templateId);
+    AudioplayChronometer::resetCache();
 }
 
 void TemplatesFacade::setDefaultStageplayTemplate(const QString& _templateId)
@@ -519,6 +529,7 @@ void TemplatesFacade::saveSimpleTextTemplate(const SimpleTextTemplate& _template
 void TemplatesFacade::saveScreenplayTemplate(const ScreenplayTemplate& _template)
 {
     instance().d->saveTemplate<ScreenplayTemplate>(kScreenplayTemplatesDirectory, _template);
+    ScreenplayChronometer::resetCache();
 }
 
 void TemplatesFacade::saveComicBookTemplate(const ComicBookTemplate& _template)
@@ -529,6 +540,7 @@ void TemplatesFacade::saveComicBookTemplate(const ComicBookTemplate& _template)
 void TemplatesFacade::saveAudioplayTemplate(const AudioplayTemplate& _template)
 {
     instance().d->saveTemplate<AudioplayTemplate>(kAudioplayTemplatesDirectory, _template);
+    AudioplayChronometer::resetCache();
 }
 
 void TemplatesFacade::saveStageplayTemplate(const StageplayTemplate& _template)
@@ -549,6 +561,7 @@ void TemplatesFacade::removeSimpleTextTemplate(const QString& _templateId)
 void TemplatesFacade::removeScreenplayTemplate(const QString& _templateId)
 {
     instance().d->removeTemplate<ScreenplayTemplate>(kScreenplayTemplatesDirectory, _templateId);
+    ScreenplayChronometer::resetCache();
 }
 
 void TemplatesFacade::removeComicBookTemplate(const QString& _templateId)
@@ -559,6 +572,7 @@ void TemplatesFacade::removeComicBookTemplate(const QString& _templateId)
 void TemplatesFacade::removeAudioplayTemplate(const QString& _templateId)
 {
     instance().d->removeTemplate<AudioplayTemplate>(kAudioplayTemplatesDirectory, _templateId);
+    AudioplayChronometer::resetCache();
 }
 
 void TemplatesFacade::removeStageplayTemplate(const QString& _templateId)
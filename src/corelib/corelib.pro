@@ -4,7 +4,7 @@ TEMPLATE = lib
 CONFIG += c++1z
 CONFIG += force_debug_info
 CONFIG += separate_debug_info
-QT += widgets widgets-private sql xml network
+QT += concurrent widgets widgets-private sql xml network
 greaterThan(QT_MAJOR_VERSION, 5) {
     QT += core5compat
 }
@@ -174,6 +174,7 @@ SOURCES += \
     business_layer/document/text/text_block_data.cpp \
     business_layer/document/text/text_cursor.cpp \
     business_layer/document/text/text_document.cpp \
+    business_layer/document/text/text_document_pagination.cpp \
     business_layer/export/abstract_docx_exporter.cpp \
     business_layer/export/abstract_exporter.cpp \
     business_layer/export/abstract_markdown_exporter.cpp \
@@ -332,6 +333,7 @@ SOURCES += \
     business_layer/reports/screenplay/screenplay_dialogues_report.cpp \
     business_layer/reports/screenplay/screenplay_gender_report.cpp \
     business_layer/reports/screenplay/screenplay_location_report.cpp \
+    business_layer/reports/screenplay/screenplay_report_snapshot.cpp \
     business_layer/reports/screenplay/screenplay_scene_report.cpp \
     business_layer/reports/screenplay/screenplay_summary_report.cpp \
     business_layer/reports/screenplay/series/screenplay_series_cast_report.cpp \
@@ -340,6 +342,7 @@ SOURCES += \
     business_layer/reports/screenplay/series/screenplay_series_scene_report.cpp \
     business_layer/reports/screenplay/series/screenplay_series_summary_report.cpp \
     business_layer/reports/stageplay/stageplay_summary_report.cpp \
+    business_layer/search/search_index.cpp \
     business_layer/templates/audioplay_template.cpp \
     business_layer/templates/comic_book_template.cpp \
     business_layer/templates/novel_template.cpp \
@@ -349,8 +352,11 @@ SOURCES += \
     business_layer/templates/templates_facade.cpp \
     business_layer/templates/text_template.cpp \
     data_layer/database.cpp \
+    data_layer/database_writer.cpp \
+    data_layer/document_changes_compactor.cpp \
     data_layer/mapper/abstract_mapper.cpp \
     data_layer/mapper/document_change_mapper.cpp \
+    data_layer/mapper/document_content_codec.cpp \
     data_layer/mapper/document_mapper.cpp \
     data_layer/mapper/mapper_facade.cpp \
     data_layer/mapper/settings_mapper.cpp \
@@ -522,6 +528,7 @@ HEADERS += \
     business_layer/document/text/text_block_data.h \
     business_layer/document/text/text_cursor.h \
     business_layer/document/text/text_document.h \
+    business_layer/document/text/text_document_pagination.h \
     business_layer/export/abstract_docx_exporter.h \
     business_layer/export/abstract_exporter.h \
     business_layer/export/abstract_markdown_exporter.h \
@@ -700,6 +707,7 @@ HEADERS += \
     business_layer/reports/screenplay/screenplay_dialogues_report.h \
     business_layer/reports/screenplay/screenplay_gender_report.h \
     business_layer/reports/screenplay/screenplay_location_report.h \
+    business_layer/reports/screenplay/screenplay_report_snapshot.h \
     business_layer/reports/screenplay/screenplay_scene_report.h \
     business_layer/reports/screenplay/screenplay_summary_report.h \
     business_layer/reports/screenplay/series/screenplay_series_cast_report.h \
@@ -708,6 +716,7 @@ HEADERS += \
     business_layer/reports/screenplay/series/screenplay_series_scene_report.h \
     business_layer/reports/screenplay/series/screenplay_series_summary_report.h \
     business_layer/reports/stageplay/stageplay_summary_report.h \
+    business_layer/search/search_index.h \
     business_layer/templates/audioplay_template.h \
     business_layer/templates/comic_book_template.h \
     business_layer/templates/novel_template.h \
@@ -718,8 +727,11 @@ HEADERS += \
     business_layer/templates/text_template.h \
     corelib_global.h \
     data_layer/database.h \
+    data_layer/database_writer.h \
+    data_layer/document_changes_compactor.h \
     data_layer/mapper/abstract_mapper.h \
     data_layer/mapper/document_change_mapper.h \
+    data_layer/mapper/document_content_codec.h \
     data_layer/mapper/document_mapper.h \
     data_layer/mapper/mapper_facade.h \
     data_layer/mapper/settings_mapper.h \
@@ -878,6 +890,7 @@ HEADERS += \
     utils/tools/debouncer.h \
     utils/tools/model_index_path.h \
     utils/tools/once.h \
+    utils/tools/positions_map.h \
     utils/tools/run_once.h \
     utils/validators/email_validator.h
 
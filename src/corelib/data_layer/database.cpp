@@ -1,13 +1,26 @@
 #include "database.h"
 
+#include "database_writer.h"
+
+#include <data_layer/mapper/document_content_codec.h>
+#include <domain/document_object.h>
+
 #include <QApplication>
 #include <QDateTime>
+#include <QFileInfo>
+#include <QPointer>
+#include <QRegularExpression>
 #include <QSqlDatabase>
+#include <QSqlError>
 #include <QSqlQuery>
 #include <QSqlRecord>
+#include <QStorageInfo>
 #include <QStringList>
 #include <QVariant>
 
+#include <map>
+#include <utility>
+
 namespace DatabaseLayer {
 
 namespace {
@@ -41,6 +54,143 @@ static QString s_lastError;
  */
 static int s_openedTransactions = 0;
 
+/**
+ * @brief Запросы на изменение данных текущей транзакции, ещё не переданные потоку записи
+ */
+static QVector<DatabaseWriteOperation> s_pendingWrites;
+
+/**
+ * @brief Выполняется ли открытая транзакция напрямую в основном соединении
+ * @note Так бывает, когда внутри транзакции читаются таблицы, которые она уже изменила: чтобы
+ *       чтение увидело эти изменения, а транзакция осталась целой, её запросы выполняются в
+ *       основном соединении, а не передаются потоку записи
+ */
+static bool s_isTransactionDirect = false;
+
+/**
+ * @brief Не выполнился ли какой-либо из запросов транзакции, выполняемой напрямую
+ */
+static bool s_isDirectTransactionFailed = false;
+
+/**
+ * @brief Обработчики ошибок запросов транзакции, выполняемой напрямую
+ * @note Если хотя бы один из запросов не выполнен, то транзакция откатывается целиком
+ */
+static QVector<std::function<void()>> s_directTransactionFailureHandlers;
+
+/**
+ * @brief Подготовленные запросы текущего соединения
+ * @note Используется карта, т.к. ссылки на её элементы не меняются при добавлении новых
+ */
+static std::map<QString, QSqlQuery> s_preparedQueries;
+
+/**
+ * @brief Параметры хранения данных
+ */
+static Database::StorageProfile s_storageProfile;
+
+/**
+ * @brief Значение auto_vacuum, соответствующее инкрементальному режиму
+ */
+constexpr int kIncrementalAutoVacuum = 2;
+
+/**
+ * @brief Включён ли для текущей базы данных журнал упреждающей записи
+ */
+static bool s_isWriteAheadLogEnabled = false;
+
+/**
+ * @brief Используется ли для текущей базы данных поток отложенной записи
+ * @note Базу данных в памяти нельзя открыть из другого соединения, поэтому в неё пишем сразу.
+ *       Так же пишем и в файлы без журнала упреждающей записи, т.к. в них чтение и запись из
+ *       разных соединений блокируют друг друга
+ */
+static bool isWriteBehindEnabled()
+{
+    return s_databaseName != ":memory:" && s_isWriteAheadLogEnabled;
+}
+
+/**
+ * @brief Находится ли заданный файл на сетевом диске
+ * @note Журнал упреждающей записи использует разделяемую память, которая не работает для
+ *       файлов на сетевых дисках
+ */
+static bool isNetworkFile(const QString& _fileName)
+{
+    if (_fileName.startsWith("\\\\") || _fileName.startsWith("//")) {
+        return true;
+    }
+
+    static const QSet<QString> kNetworkFileSystems = {
+        "nfs", "nfs4", "cifs", "smbfs", "smb2", "smb3", "afpfs", "webdav", "davfs", "fuse.sshfs",
+    };
+    const QStorageInfo storage(QFileInfo(_fileName).absolutePath());
+    return storage.isValid()
+        && kNetworkFileSystems.contains(QString::fromUtf8(storage.fileSystemType()).toLower());
+}
+
+/**
+ * @brief Обозначение запроса, который может затрагивать любые таблицы
+ */
+const QString kAnyTable = QStringLiteral("*");
+
+/**
+ * @brief Определить таблицы, к которым обращается запрос
+ * @note Если таблицы определить не удалось, то считаем, что запрос затрагивает любые из них
+ */
+static QSet<QString> statementTables(const QString& _statement)
+{
+    static QHash<QString, QSet<QString>> s_statementsTables;
+    auto statementTablesIter = s_statementsTables.find(_statement);
+    if (statementTablesIter != s_statementsTables.end()) {
+        return statementTablesIter.value();
+    }
+
+    static const QRegularExpression kTableRegex(
+        "\\b(?:FROM|JOIN|INTO|UPDATE)\\s+(\\w+)", QRegularExpression::CaseInsensitiveOption);
+    QSet<QString> tables;
+    auto matches = kTableRegex.globalMatch(_statement);
+    while (matches.hasNext()) {
+        tables.insert(matches.next().captured(1).toLower());
+    }
+    if (tables.isEmpty()) {
+        tables.insert(kAnyTable);
+    }
+    return s_statementsTables.insert(_statement, tables).value();
+}
+
+/**
+ * @brief Передать накопившиеся запросы на изменение данных потоку записи
+ */
+static void flushPendingWrites()
+{
+    if (s_pendingWrites.isEmpty()) {
+        return;
+    }
+
+    QSet<QString> tables;
+    for (const auto& operation : std::as_const(s_pendingWrites)) {
+        tables.unite(statementTables(operation.statement));
+    }
+    Database::writer()->enqueue(s_databaseName, s_pendingWrites, tables);
+    s_pendingWrites.clear();
+}
+
+/**
+ * @brief Изменяют ли накопленные запросы открытой транзакции какую-либо из заданных таблиц
+ */
+static bool isPendingWritesChangeTables(const QSet<QString>& _tables)
+{
+    for (const auto& operation : std::as_const(s_pendingWrites)) {
+        const auto operationTables = statementTables(operation.statement);
+        if (operationTables.contains(kAnyTable) || _tables.contains(kAnyTable)
+            || operationTables.intersects(_tables)) {
+            return true;
+        }
+    }
+    return false;
+}
+
 /**
  * @brief Получить ключ хранения номера версии приложения
  */
@@ -48,8 +198,171 @@ static QString applicationVersionKey()
 {
     return "application-version";
 }
+
+/**
+ * @brief Получить ключ хранения версии формата содержимого документов
+ */
+static QString documentsContentFormatKey()
+{
+    return "documents-content-format";
+}
+
+/**
+ * @brief Версии формата содержимого документов
+ */
+enum DocumentsContentFormat {
+    //! Содержимое хранится в исходном виде
+    PlainDocumentsContent = 0,
+    //! Содержимое может храниться в сжатом виде
+    CompressedDocumentsContent = 1,
+    //! Последняя поддерживаемая версия
+    LatestDocumentsContent = CompressedDocumentsContent
+};
+
+/**
+ * @brief Версия формата содержимого документов текущего файла
+ */
+static int s_documentsContentFormat = PlainDocumentsContent;
+
+/**
+ * @brief Прочитать версию формата содержимого документов из заданной базы данных
+ */
+static int readDocumentsContentFormat(const QSqlDatabase& _database)
+{
+    QSqlQuery query(_database);
+    query.prepare("SELECT value FROM system_variables WHERE variable = ? ");
+    query.addBindValue(documentsContentFormatKey());
+    if (!query.exec() || !query.next()) {
+        return PlainDocumentsContent;
+    }
+
+    return query.value(0).toInt();
+}
+
+/**
+ * @brief Вернуть содержимое документов заданной базы данных к исходному виду и снять с неё
+ *        пометку о формате со сжатым содержимым
+ * @note Документы обрабатываются по одному, чтобы не держать в памяти содержимое их всех
+ * @return Удалось ли раскодировать и перезаписать содержимое всех документов
+ */
+static bool downgradeDocumentsContent(QSqlDatabase& _database)
+{
+    QVector<QPair<QVariant, Domain::DocumentObjectType>> documents;
+    {
+        QSqlQuery query(_database);
+        query.setForwardOnly(true);
+        if (!query.exec("SELECT id, type FROM documents")) {
+            return false;
+        }
+        while (query.next()) {
+            const auto type = static_cast<Domain::DocumentObjectType>(query.value(1).toInt());
+            documents.append({ query.value(0), type });
+        }
+    }
+
+    _database.transaction();
+    QSqlQuery selectQuery(_database);
+    selectQuery.prepare("SELECT content FROM documents WHERE id = ? ");
+    QSqlQuery updateQuery(_database);
+    updateQuery.prepare("UPDATE documents SET content = ? WHERE id = ? ");
+    for (const auto& document : std::as_const(documents)) {
+        selectQuery.bindValue(0, document.first);
+        if (!selectQuery.exec() || !selectQuery.next()) {
+            _database.rollback();
+            return false;
+        }
+        const auto content = selectQuery.value(0).toByteArray();
+        selectQuery.finish();
+
+        const auto decodedContent
+            = DataMappingLayer::DocumentContentCodec::tryDecode(content, document.second);
+        if (!decodedContent.has_value()) {
+            _database.rollback();
+            return false;
+        }
+
+        //
+        // Содержимое, которое и так хранится в исходном виде, не перезаписываем
+        //
+        if (decodedContent->size() == content.size()) {
+            continue;
+        }
+
+        updateQuery.bindValue(0, *decodedContent);
+        updateQuery.bindValue(1, document.first);
+        if (!updateQuery.exec()) {
+            _database.rollback();
+            return false;
+        }
+    }
+
+    QSqlQuery query(_database);
+    query.prepare("DELETE FROM system_variables WHERE variable = ? ");
+    query.addBindValue(documentsContentFormatKey());
+    if (!query.exec()) {
+        _database.rollback();
+        return false;
+    }
+
+    return _database.commit();
+}
 } // namespace
 
+void Database::setStorageProfile(const StorageProfile& _profile)
+{
+    s_storageProfile = _profile;
+}
+
+const Database::StorageProfile& Database::storageProfile()
+{
+    return s_storageProfile;
+}
+
+bool Database::applyStorageProfile(QSqlDatabase& _database)
+{
+    QSqlQuery query(_database);
+
+    //
+    // Журнал упреждающей записи включаем только для локальных файлов, а если его не удалось
+    // включить, или он выключен в параметрах, то возвращаем файл к журналу отката, чтобы рядом
+    // с ним не оставалось служебных файлов журнала
+    //
+    const bool isNetwork = isNetworkFile(_database.databaseName());
+    bool isWriteAheadLogEnabled = false;
+    if (s_storageProfile.useWriteAheadLog && !isNetwork) {
+        isWriteAheadLogEnabled = query.exec("PRAGMA journal_mode = WAL") && query.next()
+            && query.value(0).toString().compare("wal", Qt::CaseInsensitive) == 0;
+    }
+    if (!isWriteAheadLogEnabled) {
+        query.exec("PRAGMA journal_mode = DELETE");
+    }
+    if (isWriteAheadLogEnabled && s_storageProfile.useNormalSynchronous) {
+        query.exec("PRAGMA synchronous = NORMAL");
+    }
+    //
+    // NOTE: Отрицательное значение задаёт размер кэша в килобайтах, а не в страницах
+    //
+    query.exec(QString("PRAGMA cache_size = -%1").arg(s_storageProfile.cacheSizeKib));
+    //
+    // NOTE: Отображение в память файлов на сетевых дисках не защищено от их изменения извне
+    //
+    if (!isNetwork) {
+        query.exec(QString("PRAGMA mmap_size = %1").arg(s_storageProfile.mmapSize));
+    }
+    if (s_storageProfile.useMemoryTempStore) {
+        query.exec("PRAGMA temp_store = MEMORY");
+    }
+    //
+    // Для уже существующих файлов режим очистки включится только после полного сжатия базы,
+    // а для новых - сразу, т.к. таблицы в них ещё не созданы
+    //
+    if (s_storageProfile.useIncrementalVacuum) {
+        query.exec("PRAGMA auto_vacuum = INCREMENTAL");
+    }
+
+    return isWriteAheadLogEnabled;
+}
+
 bool Database::canOpenFile(const QString& _databaseFileName)
 {
     bool canOpen = true;
@@ -74,6 +387,16 @@ bool Database::canOpenFile(const QString& _databaseFileName)
                                                       "Project was modified in a newer version. "
                                                       "Update to the latest version to open it.");
         }
+        //
+        // 2. Если содержимое документов хранится в неизвестном формате, его нельзя прочитать
+        //
+        else if (readDocumentsContentFormat(database) > LatestDocumentsContent) {
+            canOpen = false;
+            s_openFileError = QApplication::translate(
+                "DatabaseLayer::Database",
+                "Project documents are stored in a newer format. "
+                "Update to the latest version to open it.");
+        }
     }
 
     QSqlDatabase::removeDatabase("tmp_database");
@@ -86,6 +409,11 @@ QString Database::openFileError()
     return s_openFileError;
 }
 
+bool Database::isDocumentsContentCompressionEnabled()
+{
+    return s_documentsContentFormat >= CompressedDocumentsContent;
+}
+
 bool Database::hasError()
 {
     return !s_lastError.isEmpty();
@@ -126,9 +454,24 @@ void Database::setCurrentFile(const QString& _databaseFileName)
 
 void Database::closeCurrentFile()
 {
+    //
+    // Дожидаемся записи всех изменений в старую базу данных и останавливаем поток записи
+    //
+    flushPendingWrites();
+    writer()->stop();
+
+    s_preparedQueries.clear();
     if (QSqlDatabase::contains(s_connectionName)) {
+        //
+        // ... и переносим их из журнала в сам файл, чтобы он был самодостаточным
+        //
+        {
+            QSqlQuery query(QSqlDatabase::database(s_connectionName));
+            query.exec("PRAGMA wal_checkpoint(TRUNCATE)");
+        }
         QSqlDatabase::removeDatabase(s_connectionName);
     }
+    s_isWriteAheadLogEnabled = false;
 }
 
 QString Database::currentFile()
@@ -138,15 +481,104 @@ QString Database::currentFile()
 
 QSqlQuery Database::query()
 {
+    //
+    // Текст запроса ещё не известен, поэтому, чтобы прочитать данные в актуальном состоянии,
+    // нужно дождаться записи всех изменений
+    //
+    waitForPendingWritesBeforeRead({ kAnyTable });
+
     return QSqlQuery(instanse());
 }
 
+QSqlQuery& Database::preparedQuery(const QString& _statement)
+{
+    //
+    // Чтение идёт через основное соединение, а запись через соединение потока записи, поэтому
+    // дожидаться нужно лишь записи изменений тех таблиц, которые читает запрос
+    //
+    waitForPendingWritesBeforeRead(statementTables(_statement));
+
+    auto queryIter = s_preparedQueries.find(_statement);
+    if (queryIter == s_preparedQueries.end()) {
+        queryIter = s_preparedQueries.try_emplace(_statement, instanse()).first;
+        queryIter->second.prepare(_statement);
+    }
+    return queryIter->second;
+}
+
+bool Database::write(const QString& _statement, const QVariantList& _values,
+                     const std::function<void()>& _failureHandler)
+{
+    return write(DatabaseWriteOperation{ _statement, _values, {}, _failureHandler });
+}
+
+bool Database::writeBatch(const QString& _statement, const QVector<QVariantList>& _rows,
+                          const std::function<void()>& _failureHandler)
+{
+    if (_rows.isEmpty()) {
+        return true;
+    }
+
+    return write(DatabaseWriteOperation{ _statement, {}, _rows, _failureHandler });
+}
+
+bool Database::write(const DatabaseWriteOperation& _operation)
+{
+    if (s_isTransactionDirect) {
+        return writeDirectly(_operation);
+    }
+
+    if (isWriteBehindEnabled()) {
+        s_pendingWrites.append(_operation);
+
+        //
+        // Вне транзакции запрос сразу отправляется на запись, а в транзакции - при её фиксации
+        //
+        if (s_openedTransactions == 0) {
+            flushPendingWrites();
+        }
+        return true;
+    }
+
+    auto& query = preparedQuery(_operation.statement);
+    if (DatabaseWriter::execute(query, _operation)) {
+        return true;
+    }
+
+    setLastError(query.lastError().text());
+    return false;
+}
+
+void Database::waitForPendingWrites()
+{
+    if (s_openedTransactions == 0) {
+        flushPendingWrites();
+    }
+    writer()->waitForPendingWrites();
+}
+
+DatabaseWriter* Database::writer()
+{
+    //
+    // Поток записи принадлежит приложению, чтобы он был остановлен и удалён вместе с ним,
+    // а не при уничтожении статических объектов, когда приложения уже нет
+    //
+    static QPointer<DatabaseWriter> writer;
+    if (writer.isNull()) {
+        writer = new DatabaseWriter(QCoreApplication::instance());
+    }
+    return writer;
+}
+
 void Database::transaction()
 {
     //
     // Для первого запроса открываем транзакцию
     //
-    if (s_openedTransactions == 0) {
+    // NOTE: При отложенной записи транзакция лишь объединяет запросы в один пакет, а сама
+    //       транзакция в базе данных открывается потоком записи
+    //
+    if (s_openedTransactions == 0 && !isWriteBehindEnabled()) {
         instanse().transaction();
     }
 
@@ -167,18 +599,137 @@ void Database::commit()
     // При закрытии корневой транзакции фиксируем изменения в базе данных
     //
     if (s_openedTransactions == 0) {
-        instanse().commit();
+        if (s_isTransactionDirect) {
+            commitDirectTransaction();
+        } else if (isWriteBehindEnabled()) {
+            flushPendingWrites();
+        } else {
+            instanse().commit();
+        }
     }
 }
 
+void Database::checkpoint()
+{
+    auto query = Database::query();
+    query.exec("PRAGMA wal_checkpoint(TRUNCATE)");
+}
+
 void Database::vacuum()
 {
     auto query = Database::query();
+
+    //
+    // Если в базе включена инкрементальная очистка, то просто возвращаем свободные страницы,
+    // не пересобирая весь файл
+    //
+    if (s_storageProfile.useIncrementalVacuum && query.exec("PRAGMA auto_vacuum") && query.next()
+        && query.value(0).toInt() == kIncrementalAutoVacuum) {
+        //
+        // NOTE: За каждый шаг выполнения запроса освобождается одна страница, поэтому проходим
+        //       запрос до конца
+        //
+        query.exec("PRAGMA incremental_vacuum");
+        while (query.next()) {
+        }
+        return;
+    }
+
+    //
+    // ... а в противном случае сжимаем базу полностью, после чего для неё включится
+    //     инкрементальный режим, если он задан в параметрах хранения
+    //
     query.exec("VACUUM");
 }
 
 // ****
 
+void Database::waitForPendingWritesBeforeRead(const QSet<QString>& _tables)
+{
+    if (!isWriteBehindEnabled() || s_isTransactionDirect) {
+        return;
+    }
+
+    //
+    // Вне транзакции передаём накопленные запросы потоку записи и дожидаемся записи тех из них,
+    // что изменяют читаемые таблицы
+    //
+    if (s_openedTransactions == 0) {
+        flushPendingWrites();
+        writer()->waitForPendingWrites(_tables);
+        return;
+    }
+
+    //
+    // Внутри транзакции, если она ещё не меняла читаемые таблицы, достаточно дождаться записи
+    // предыдущих пакетов
+    //
+    if (!isPendingWritesChangeTables(_tables)) {
+        writer()->waitForPendingWrites(_tables);
+        return;
+    }
+
+    //
+    // ... а иначе дожидаемся записи всех предыдущих пакетов и продолжаем транзакцию в основном
+    //     соединении, выполнив в нём уже накопленные запросы, чтобы чтение увидело их, а сама
+    //     транзакция не разбилась на части
+    //
+    writer()->waitForPendingWrites();
+    s_isTransactionDirect = true;
+    instanse().transaction();
+    const auto pendingWrites = std::exchange(s_pendingWrites, {});
+    for (const auto& operation : pendingWrites) {
+        writeDirectly(operation);
+    }
+}
+
+bool Database::writeDirectly(const DatabaseWriteOperation& _operation)
+{
+    if (_operation.failureHandler) {
+        s_directTransactionFailureHandlers.append(_operation.failureHandler);
+    }
+
+    //
+    // После первой ошибки транзакция всё равно будет откачена, поэтому запросы не выполняем
+    //
+    if (s_isDirectTransactionFailed) {
+        return false;
+    }
+
+    auto& query = preparedQuery(_operation.statement);
+    if (DatabaseWriter::execute(query, _operation)) {
+        return true;
+    }
+
+    setLastError(query.lastError().text());
+    s_isDirectTransactionFailed = true;
+    return false;
+}
+
+void Database::commitDirectTransaction()
+{
+    s_isTransactionDirect = false;
+
+    auto database = instanse();
+    if (s_isDirectTransactionFailed || !database.commit()) {
+        if (!s_isDirectTransactionFailed) {
+            setLastError(database.lastError().text());
+        }
+        database.rollback();
+
+        //
+        // Транзакция откачена целиком, поэтому сообщаем об ошибке каждого из её запросов
+        //
+        for (const auto& failureHandler : std::as_const(s_directTransactionFailureHandlers)) {
+            QMetaObject::invokeMethod(QCoreApplication::instance(), failureHandler,
+                                      Qt::QueuedConnection);
+        }
+    }
+
+    s_isDirectTransactionFailed = false;
+    s_directTransactionFailureHandlers.clear();
+}
+
 QSqlDatabase Database::instanse()
 {
     QSqlDatabase database;
@@ -200,17 +751,64 @@ void Database::open(QSqlDatabase& _database, const QString& _connectionName,
     _database = QSqlDatabase::addDatabase(s_sqlDriver, _connectionName);
     _database.setDatabaseName(_databaseName);
     _database.open();
+    s_isWriteAheadLogEnabled = applyStorageProfile(_database);
 
     Database::States states = checkState(_database);
 
     if (!states.testFlag(SchemeFlag))
         createTables(_database);
-    if (!states.testFlag(IndexesFlag))
-        createIndexes(_database);
     if (!states.testFlag(EnumsFlag))
         createEnums(_database);
     if (states.testFlag(OldVersionFlag))
         updateDatabase(_database);
+    //
+    // NOTE: Таблицы, добавленные без смены версии файла, создаются по факту их отсутствия
+    //
+    const bool isTablesCreated = states.testFlag(SchemeFlag) && createMissingTables(_database);
+    //
+    // NOTE: Индексы создаются после обновления схемы и пересоздаются при обновлении версии,
+    //       т.к. в новой версии их набор мог измениться, а создаются они, только если их ещё нет
+    //
+    if (!states.testFlag(IndexesFlag) || states.testFlag(OldVersionFlag))
+        createIndexes(_database);
+
+    //
+    // Сжатое содержимое документов пишем только в файлы, помеченные как обновлённые до
+    // соответствующего формата, чтобы версии без его поддержки отказывались открывать их,
+    // а не теряли содержимое
+    //
+    s_documentsContentFormat = readDocumentsContentFormat(_database);
+    const bool needUpgradeDocumentsContentFormat = s_storageProfile.compressDocumentsContent
+        && s_documentsContentFormat < CompressedDocumentsContent;
+    if (needUpgradeDocumentsContentFormat) {
+        QSqlQuery query(_database);
+        query.prepare("INSERT INTO system_variables VALUES (?, ?)");
+        query.addBindValue(documentsContentFormatKey());
+        query.addBindValue(QString::number(CompressedDocumentsContent));
+        if (query.exec()) {
+            s_documentsContentFormat = CompressedDocumentsContent;
+        }
+    }
+    //
+    // ... а если сжатие выключено, то возвращаем файл к исходному формату, чтобы его снова могли
+    //     открыть версии без поддержки сжатия
+    //
+    const bool needDowngradeDocumentsContentFormat = !s_storageProfile.compressDocumentsContent
+        && s_documentsContentFormat == CompressedDocumentsContent;
+    if (needDowngradeDocumentsContentFormat && downgradeDocumentsContent(_database)) {
+        s_documentsContentFormat = PlainDocumentsContent;
+    }
+
+    //
+    // Изменения схемы сразу переносим из журнала в файл, т.к. дальнейшие изменения будут
+    // записываться уже другим соединением
+    //
+    if (!states.testFlag(SchemeFlag) || !states.testFlag(IndexesFlag)
+        || states.testFlag(OldVersionFlag) || isTablesCreated || needUpgradeDocumentsContentFormat
+        || needDowngradeDocumentsContentFormat) {
+        QSqlQuery query(_database);
+        query.exec("PRAGMA wal_checkpoint(TRUNCATE)");
+    }
 }
 
 // Проверка состояния базы данных
@@ -305,6 +903,18 @@ void Database::createTables(QSqlDatabase& _database)
                "is_synced INTEGER NOT NULL DEFAULT(0) "
                ")");
 
+    //
+    // Таблица со снимками документов
+    //
+    query.exec("CREATE TABLE documents_keyframes "
+               "("
+               "id INTEGER PRIMARY KEY AUTOINCREMENT, "
+               "fk_document_uuid TEXT NOT NULL, "
+               "fk_document_change_id INTEGER NOT NULL, " // последнее учтённое изменение
+               "content BLOB NOT NULL, "
+               "date_time TEXT NOT NULL "
+               ")");
+
     _database.commit();
 }
 
@@ -316,11 +926,23 @@ void Database::createIndexes(QSqlDatabase& _database)
     //
     // Таблица с изменениями документов
     //
-    query.exec("CREATE INDEX documents_changes_fk_document_uuid_idx "
-               "ON documents_changes (fk_document_uuid)");
-    query.exec("CREATE INDEX documents_changes_date_time_idx "
+    // NOTE: Индекс по документу и идентификатору заменяет собой индекс только по документу,
+    //       а частичный индекс содержит лишь ещё не синхронизированные изменения
+    //
+    query.exec("DROP INDEX IF EXISTS documents_changes_fk_document_uuid_idx");
+    query.exec("CREATE INDEX IF NOT EXISTS documents_changes_fk_document_uuid_id_idx "
+               "ON documents_changes (fk_document_uuid, id)");
+    query.exec("CREATE INDEX IF NOT EXISTS documents_changes_unsynced_idx "
+               "ON documents_changes (fk_document_uuid) WHERE is_synced = 0");
+    query.exec("CREATE INDEX IF NOT EXISTS documents_changes_date_time_idx "
                "ON documents_changes (date_time)");
 
+    //
+    // Таблица со снимками документов
+    //
+    query.exec("CREATE INDEX IF NOT EXISTS documents_keyframes_fk_document_uuid_change_idx "
+               "ON documents_keyframes (fk_document_uuid, fk_document_change_id)");
+
     _database.commit();
 }
 
@@ -592,4 +1214,34 @@ void Database::updateDatabaseTo_0_6_2(QSqlDatabase& _database)
     _database.commit();
 }
 
+bool Database::createMissingTables(QSqlDatabase& _database)
+{
+    QSqlQuery q_updater(_database);
+
+    //
+    // Таблица со снимками документов
+    //
+    if (q_updater.exec("SELECT COUNT(*) FROM sqlite_master WHERE type = 'table' "
+                       "AND name = 'documents_keyframes' ")
+        && q_updater.next() && q_updater.value(0).toInt() > 0) {
+        return false;
+    }
+
+    _database.transaction();
+
+    q_updater.exec("CREATE TABLE documents_keyframes "
+                   "("
+                   "id INTEGER PRIMARY KEY AUTOINCREMENT, "
+                   "fk_document_uuid TEXT NOT NULL, "
+                   "fk_document_change_id INTEGER NOT NULL, "
+                   "content BLOB NOT NULL, "
+                   "date_time TEXT NOT NULL "
+                   ")");
+    q_updater.exec("CREATE INDEX IF NOT EXISTS documents_keyframes_fk_document_uuid_change_idx "
+                   "ON documents_keyframes (fk_document_uuid, fk_document_change_id)");
+
+    _database.commit();
+    return true;
+}
+
 } // namespace DatabaseLayer
@@ -1,9 +1,13 @@
 #pragma once
 
-#include <QtGlobal>
+#include <QSet>
+#include <QVariant>
+#include <QVector>
 
 #include <corelib_global.h>
 
+#include <functional>
+
 class QString;
 class QSqlQuery;
 class QSqlDatabase;
@@ -11,9 +15,74 @@ class QSqlDatabase;
 
 namespace DatabaseLayer {
 
+class DatabaseWriter;
+struct DatabaseWriteOperation;
+
 class CORE_LIBRARY_EXPORT Database
 {
 public:
+    /**
+     * @brief Параметры хранения данных, применяемые к каждому соединению с базой данных
+     */
+    struct StorageProfile {
+        /**
+         * @brief Вести журнал упреждающей записи (WAL) вместо журнала отката
+         * @note Читающие соединения не блокируют пишущее, а запись не требует перезаписи
+         *       страниц самого файла при каждой фиксации транзакции
+         */
+        bool useWriteAheadLog = true;
+
+        /**
+         * @brief Синхронизировать файл с диском только при контрольных точках журнала
+         */
+        bool useNormalSynchronous = true;
+
+        /**
+         * @brief Размер кэша страниц на одно соединение в килобайтах
+         */
+        int cacheSizeKib = 32 * 1024;
+
+        /**
+         * @brief Размер отображаемой в память части файла в байтах, 0 - не отображать
+         */
+        qint64 mmapSize = 256 * 1024 * 1024;
+
+        /**
+         * @brief Размещать временные таблицы и индексы в памяти
+         */
+        bool useMemoryTempStore = true;
+
+        /**
+         * @brief Освобождать страницы удалённых данных инкрементально вместо полного сжатия
+         */
+        bool useIncrementalVacuum = true;
+
+        /**
+         * @brief Обновлять открываемые файлы до формата со сжатым содержимым документов
+         * @note Версии приложения без поддержки формата не смогут прочитать содержимое, поэтому
+         *       по умолчанию сжатие выключено. Содержимое, сохранённое в любом из форматов,
+         *       читается независимо от этого флага, а файлы, обновлённые ранее, при выключенном
+         *       флаге возвращаются к исходному формату
+         */
+        bool compressDocumentsContent = false;
+    };
+
+    /**
+     * @brief Задать параметры хранения данных
+     * @note Применяются к соединениям, которые будут открыты после этого, поэтому задавать их
+     *       нужно до открытия файла
+     */
+    static void setStorageProfile(const StorageProfile& _profile);
+    static const StorageProfile& storageProfile();
+
+    /**
+     * @brief Применить текущие параметры хранения данных к заданному соединению
+     * @note Для файлов на сетевых дисках, или если его не удалось включить, журнал упреждающей
+     *       записи не используется
+     * @return Включён ли для файла журнал упреждающей записи
+     */
+    static bool applyStorageProfile(QSqlDatabase& _database);
+
     /**
      * @brief Можно ли открыть заданный файл
      */
@@ -24,6 +93,12 @@ public:
      */
     static QString openFileError();
 
+    /**
+     * @brief Обновлён ли текущий файл до формата со сжатым содержимым документов
+     * @note Пока файл не обновлён, содержимое документов сохраняется в исходном виде
+     */
+    static bool isDocumentsContentCompressionEnabled();
+
     /**
      * @brief Текст последней ошибки базы данных
      * @note Если он пуст, то и ошибки нет
@@ -51,9 +126,49 @@ public:
 
     /**
      * @brief Получить объект для выполнения запросов в БД
+     * @note Перед этим дожидается записи всех отложенных запросов на изменение данных, а если
+     *       открытая транзакция уже что-то изменила, то продолжает её в основном соединении,
+     *       чтобы чтение увидело её изменения
      */
     static QSqlQuery query();
 
+    /**
+     * @brief Получить подготовленный запрос с заданным текстом
+     * @note Запросы кэшируются для текущего соединения, поэтому каждый из них подготавливается
+     *       лишь однажды. После выборки данных у запроса нужно вызвать finish(). Перед этим
+     *       дожидается записи отложенных запросов только тех таблиц, которые читает запрос, в
+     *       том числе и запросов открытой транзакции
+     */
+    static QSqlQuery& preparedQuery(const QString& _statement);
+
+    /**
+     * @brief Выполнить запрос на изменение данных
+     * @note Для файла на диске запрос выполняется потоком отложенной записи, вместе со всеми
+     *       остальными запросами текущей транзакции
+     * @param _failureHandler Вызывается в главном потоке, если отложенную запись выполнить
+     *        не удалось
+     * @return Удалось ли выполнить, или поставить запрос в очередь на выполнение
+     */
+    static bool write(const QString& _statement, const QVariantList& _values,
+                      const std::function<void()>& _failureHandler = {});
+
+    /**
+     * @brief Выполнить запрос на изменение данных для каждой из строк значений параметров
+     */
+    static bool writeBatch(const QString& _statement, const QVector<QVariantList>& _rows,
+                           const std::function<void()>& _failureHandler = {});
+
+    /**
+     * @brief Дождаться записи всех отложенных запросов на изменение данных
+     * @note Запросы открытой транзакции потоку записи не передаются до её фиксации
+     */
+    static void waitForPendingWrites();
+
+    /**
+     * @brief Поток отложенной записи, через который можно узнать о результатах записи
+     */
+    static DatabaseWriter* writer();
+
     /**
      * @brief Запустить транзакцию, если ещё не запущена
      */
@@ -64,6 +179,12 @@ public:
      */
     static void commit();
 
+    /**
+     * @brief Перенести содержимое журнала упреждающей записи в файл базы данных
+     * @note Нужно делать перед копированием файла, т.к. без журнала его данные не полны
+     */
+    static void checkpoint();
+
     /**
      * @brief Сжать базу данных
      */
@@ -92,6 +213,27 @@ private:
      */
     static QSqlDatabase instanse();
 
+    /**
+     * @brief Выполнить, или поставить в очередь на выполнение запрос на изменение данных
+     */
+    static bool write(const DatabaseWriteOperation& _operation);
+
+    /**
+     * @brief Дождаться записи изменений заданных таблиц перед их чтением
+     */
+    static void waitForPendingWritesBeforeRead(const QSet<QString>& _tables);
+
+    /**
+     * @brief Выполнить запрос в транзакции, которая выполняется напрямую в основном соединении
+     */
+    static bool writeDirectly(const DatabaseWriteOperation& _operation);
+
+    /**
+     * @brief Зафиксировать транзакцию, выполняемую напрямую, или откатить её целиком, если
+     *        какой-либо из её запросов не выполнен
+     */
+    static void commitDirectTransaction();
+
     /**
      * @brief Открыть соединение с базой данных
      */
@@ -102,6 +244,12 @@ private:
     static void createIndexes(QSqlDatabase& _database);
     static void createEnums(QSqlDatabase& _database);
 
+    /**
+     * @brief Создать таблицы, которых нет в уже существующем файле
+     * @return Были ли созданы таблицы
+     */
+    static bool createMissingTables(QSqlDatabase& _database);
+
     static void updateDatabase(QSqlDatabase& _database);
     static void updateDatabaseTo_0_0_10(QSqlDatabase& _database);
     static void updateDatabaseTo_0_1_3(QSqlDatabase& _database);
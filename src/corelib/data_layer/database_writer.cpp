@@ -0,0 +1,432 @@
+#include "database_writer.h"
+
+#include "database.h"
+
+#include <QCoreApplication>
+#include <QMutex>
+#include <QQueue>
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QWaitCondition>
+
+#include <map>
+
+
+namespace DatabaseLayer {
+
+namespace {
+
+/**
+ * @brief Плагин используемый для работы с базой
+ */
+const QString kSqlDriver = "QSQLITE";
+
+/**
+ * @brief Максимальное количество пакетов запросов в очереди
+ */
+constexpr int kMaximumQueueSize = 16;
+
+/**
+ * @brief Обозначение пакета, который может изменять любые таблицы
+ */
+const QString kAnyTable = QStringLiteral("*");
+
+} // namespace
+
+class DatabaseWriter::Implementation
+{
+public:
+    /**
+     * @brief Пакет запросов
+     */
+    struct Batch {
+        QString databaseName;
+        QVector<DatabaseWriteOperation> operations;
+        QSet<QString> tables;
+    };
+
+    /**
+     * @brief Добавить обработчики ошибок всех запросов пакета в заданный список
+     */
+    static void appendFailureHandlers(const Batch& _batch,
+                                      QVector<std::function<void()>>& _failureHandlers);
+
+    /**
+     * @brief Выполнить пакеты запросов в рамках одной транзакции
+     * @note Если какой-либо из запросов пакета не выполнен, то пакет откатывается целиком
+     * @param _failureHandlers Обработчики ошибок запросов пакетов, которые не удалось записать
+     * @return Текст первой возникшей ошибки, или пустая строка, если ошибок не было
+     */
+    QString write(const QVector<Batch>& _batches,
+                  QVector<std::function<void()>>& _failureHandlers);
+
+    /**
+     * @brief Есть ли в очереди незаписанные изменения заданных таблиц
+     * @note Вызывать только под мьютексом
+     */
+    bool hasPendingWrites(const QSet<QString>& _tables) const;
+
+    /**
+     * @brief Перенести содержимое журнала в файл базы данных
+     */
+    void checkpoint();
+
+    /**
+     * @brief Закрыть соединение с базой данных
+     */
+    void closeDatabase();
+
+
+    /**
+     * @brief Имя соединения и имя файла базы данных, с которой оно установлено
+     * @note Используются только потоком записи
+     */
+    QString connectionName;
+    QString databaseName;
+
+    /**
+     * @brief Подготовленные запросы соединения
+     * @note Используется карта, т.к. ссылки на её элементы не меняются при добавлении новых
+     */
+    std::map<QString, QSqlQuery> preparedQueries;
+
+    /**
+     * @brief Состояние очереди, защищаемое мьютексом
+     */
+    /** @{ */
+    mutable QMutex mutex;
+    QWaitCondition stateChanged;
+    QQueue<Batch> queue;
+    QHash<QString, int> pendingTables;
+    bool isWriting = false;
+    bool isCheckpointRequested = false;
+    bool isStopRequested = false;
+    /** @} */
+};
+
+void DatabaseWriter::Implementation::appendFailureHandlers(
+    const Batch& _batch, QVector<std::function<void()>>& _failureHandlers)
+{
+    for (const auto& operation : _batch.operations) {
+        if (operation.failureHandler) {
+            _failureHandlers.append(operation.failureHandler);
+        }
+    }
+}
+
+QString DatabaseWriter::Implementation::write(const QVector<Batch>& _batches,
+                                              QVector<std::function<void()>>& _failureHandlers)
+{
+    //
+    // Если нужна другая база данных, переоткрываем соединение
+    //
+    const auto& batchesDatabaseName = _batches.constFirst().databaseName;
+    if (connectionName.isEmpty() || databaseName != batchesDatabaseName) {
+        closeDatabase();
+
+        databaseName = batchesDatabaseName;
+        connectionName = QString("database_writer [%1]").arg(databaseName);
+        auto database = QSqlDatabase::addDatabase(kSqlDriver, connectionName);
+        database.setDatabaseName(databaseName);
+        if (!database.open()) {
+            for (const auto& batch : _batches) {
+                appendFailureHandlers(batch, _failureHandlers);
+            }
+            return database.lastError().text();
+        }
+        Database::applyStorageProfile(database);
+    }
+
+    auto database = QSqlDatabase::database(connectionName);
+    QString error;
+    QVector<std::function<void()>> failureHandlers;
+    database.transaction();
+    QSqlQuery savepointQuery(database);
+    for (const auto& batch : _batches) {
+        //
+        // Каждый пакет выполняем в собственной точке сохранения, чтобы при первой же ошибке
+        // откатить его целиком, не затрагивая остальные пакеты транзакции
+        //
+        savepointQuery.exec("SAVEPOINT batch");
+        bool isBatchWritten = true;
+        for (const auto& operation : batch.operations) {
+            //
+            // Каждый запрос подготавливаем лишь однажды, а затем только подставляем в него
+            // новые значения параметров
+            //
+            auto queryIter = preparedQueries.find(operation.statement);
+            if (queryIter == preparedQueries.end()) {
+                queryIter = preparedQueries.try_emplace(operation.statement, database).first;
+                queryIter->second.prepare(operation.statement);
+            }
+
+            auto& query = queryIter->second;
+            if (!DatabaseWriter::execute(query, operation)) {
+                if (error.isEmpty()) {
+                    error = query.lastError().text();
+                }
+                isBatchWritten = false;
+                break;
+            }
+        }
+
+        if (!isBatchWritten) {
+            savepointQuery.exec("ROLLBACK TO batch");
+            appendFailureHandlers(batch, failureHandlers);
+        }
+        savepointQuery.exec("RELEASE batch");
+    }
+
+    //
+    // Если не удалось зафиксировать транзакцию, то не записан ни один из пакетов
+    //
+    if (!database.commit()) {
+        if (error.isEmpty()) {
+            error = database.lastError().text();
+        }
+        database.rollback();
+        failureHandlers.clear();
+        for (const auto& batch : _batches) {
+            appendFailureHandlers(batch, failureHandlers);
+        }
+    }
+    _failureHandlers.append(failureHandlers);
+
+    return error;
+}
+
+bool DatabaseWriter::Implementation::hasPendingWrites(const QSet<QString>& _tables) const
+{
+    if (queue.isEmpty() && !isWriting) {
+        return false;
+    }
+
+    if (_tables.contains(kAnyTable) || pendingTables.contains(kAnyTable)) {
+        return true;
+    }
+
+    for (const auto& table : _tables) {
+        if (pendingTables.contains(table)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void DatabaseWriter::Implementation::checkpoint()
+{
+    if (connectionName.isEmpty()) {
+        return;
+    }
+
+    QSqlQuery query(QSqlDatabase::database(connectionName));
+    query.exec("PRAGMA wal_checkpoint(TRUNCATE)");
+}
+
+void DatabaseWriter::Implementation::closeDatabase()
+{
+    if (connectionName.isEmpty()) {
+        return;
+    }
+
+    preparedQueries.clear();
+    if (QSqlDatabase::contains(connectionName)) {
+        QSqlDatabase::removeDatabase(connectionName);
+    }
+    connectionName.clear();
+    databaseName.clear();
+}
+
+
+// ****
+
+
+bool DatabaseWriter::execute(QSqlQuery& _query, const DatabaseWriteOperation& _operation)
+{
+    if (_operation.rows.isEmpty()) {
+        for (int index = 0; index < _operation.values.size(); ++index) {
+            _query.bindValue(index, _operation.values.at(index));
+        }
+        return _query.exec();
+    }
+
+    //
+    // Для пакетного выполнения значения параметров передаются по столбцам
+    //
+    const auto columnsCount = _operation.rows.constFirst().size();
+    for (int column = 0; column < columnsCount; ++column) {
+        QVariantList columnValues;
+        columnValues.reserve(_operation.rows.size());
+        for (const auto& row : _operation.rows) {
+            columnValues.append(row.value(column));
+        }
+        _query.bindValue(column, columnValues);
+    }
+    return _query.execBatch();
+}
+
+DatabaseWriter::DatabaseWriter(QObject* _parent)
+    : QThread(_parent)
+    , d(new Implementation)
+{
+}
+
+DatabaseWriter::~DatabaseWriter()
+{
+    stop();
+}
+
+void DatabaseWriter::enqueue(const QString& _databaseName,
+                             const QVector<DatabaseWriteOperation>& _operations,
+                             const QSet<QString>& _tables)
+{
+    if (_operations.isEmpty()) {
+        return;
+    }
+
+    if (!isRunning()) {
+        start();
+    }
+
+    QMutexLocker locker(&d->mutex);
+    while (d->queue.size() >= kMaximumQueueSize) {
+        d->stateChanged.wait(&d->mutex);
+    }
+    d->queue.enqueue({ _databaseName, _operations, _tables });
+    for (const auto& table : _tables) {
+        ++d->pendingTables[table];
+    }
+    d->stateChanged.wakeAll();
+}
+
+bool DatabaseWriter::hasPendingWrites() const
+{
+    QMutexLocker locker(&d->mutex);
+    return !d->queue.isEmpty() || d->isWriting;
+}
+
+void DatabaseWriter::waitForPendingWrites()
+{
+    QMutexLocker locker(&d->mutex);
+    while (!d->queue.isEmpty() || d->isWriting) {
+        d->stateChanged.wait(&d->mutex);
+    }
+}
+
+void DatabaseWriter::waitForPendingWrites(const QSet<QString>& _tables)
+{
+    QMutexLocker locker(&d->mutex);
+    while (d->hasPendingWrites(_tables)) {
+        d->stateChanged.wait(&d->mutex);
+    }
+}
+
+void DatabaseWriter::checkpoint()
+{
+    if (!isRunning()) {
+        return;
+    }
+
+    QMutexLocker locker(&d->mutex);
+    while (!d->queue.isEmpty() || d->isWriting) {
+        d->stateChanged.wait(&d->mutex);
+    }
+    d->isCheckpointRequested = true;
+    d->stateChanged.wakeAll();
+    while (d->isCheckpointRequested) {
+        d->stateChanged.wait(&d->mutex);
+    }
+}
+
+void DatabaseWriter::stop()
+{
+    if (!isRunning()) {
+        return;
+    }
+
+    {
+        QMutexLocker locker(&d->mutex);
+        d->isStopRequested = true;
+        d->stateChanged.wakeAll();
+    }
+    wait();
+
+    QMutexLocker locker(&d->mutex);
+    d->isStopRequested = false;
+}
+
+void DatabaseWriter::run()
+{
+    forever {
+        QVector<Implementation::Batch> batches;
+        {
+            QMutexLocker locker(&d->mutex);
+            while (d->queue.isEmpty() && !d->isCheckpointRequested && !d->isStopRequested) {
+                d->stateChanged.wait(&d->mutex);
+            }
+
+            //
+            // Контрольную точку журнала делаем вне транзакции записи, когда очередь уже пуста
+            //
+            if (d->queue.isEmpty() && d->isCheckpointRequested) {
+                locker.unlock();
+                d->checkpoint();
+                locker.relock();
+
+                d->isCheckpointRequested = false;
+                d->stateChanged.wakeAll();
+                continue;
+            }
+
+            //
+            // Соединение закрываем и останавливаем поток только когда очередь уже пуста
+            //
+            if (d->queue.isEmpty()) {
+                locker.unlock();
+                d->closeDatabase();
+                return;
+            }
+
+            //
+            // Забираем из очереди все пакеты для одной базы данных
+            //
+            const auto databaseName = d->queue.head().databaseName;
+            while (!d->queue.isEmpty() && d->queue.head().databaseName == databaseName) {
+                batches.append(d->queue.dequeue());
+            }
+            d->isWriting = true;
+            d->stateChanged.wakeAll();
+        }
+
+        QVector<std::function<void()>> failureHandlers;
+        const auto error = d->write(batches, failureHandlers);
+        if (error.isEmpty()) {
+            emit writeFinished();
+        } else {
+            emit writeFailed(error);
+        }
+
+        //
+        // Сообщаем о запросах, которые не удалось записать, в главном потоке
+        //
+        for (const auto& failureHandler : std::as_const(failureHandlers)) {
+            QMetaObject::invokeMethod(QCoreApplication::instance(), failureHandler,
+                                      Qt::QueuedConnection);
+        }
+
+        QMutexLocker locker(&d->mutex);
+        for (const auto& batch : std::as_const(batches)) {
+            for (const auto& table : batch.tables) {
+                auto pendingTable = d->pendingTables.find(table);
+                if (pendingTable != d->pendingTables.end() && --pendingTable.value() == 0) {
+                    d->pendingTables.erase(pendingTable);
+                }
+            }
+        }
+        d->isWriting = false;
+        d->stateChanged.wakeAll();
+    }
+}
+
+} // namespace DatabaseLayer
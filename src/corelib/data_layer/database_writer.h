@@ -0,0 +1,124 @@
+#pragma once
+
+#include <QScopedPointer>
+#include <QSet>
+#include <QThread>
+#include <QVariant>
+
+#include <corelib_global.h>
+
+#include <functional>
+
+class QSqlQuery;
+
+
+namespace DatabaseLayer {
+
+/**
+ * @brief Запрос на изменение данных
+ */
+struct CORE_LIBRARY_EXPORT DatabaseWriteOperation {
+    /**
+     * @brief Текст запроса
+     */
+    QString statement;
+
+    /**
+     * @brief Значения параметров запроса
+     */
+    QVariantList values;
+
+    /**
+     * @brief Значения параметров для пакетного выполнения запроса, по строке на каждую запись
+     * @note Если заданы, то запрос выполняется для каждой из строк, а values не используются
+     */
+    QVector<QVariantList> rows;
+
+    /**
+     * @brief Обработчик ошибки выполнения запроса
+     * @note Вызывается в главном потоке приложения, уже после того, как пакет был записан
+     */
+    std::function<void()> failureHandler;
+};
+
+
+/**
+ * @brief Поток отложенной записи в базу данных
+ *
+ * Принимает пакеты запросов на изменение данных из потока интерфейса и выполняет их через
+ * собственное соединение с базой данных. Все накопившиеся к моменту записи пакеты выполняются
+ * в рамках одной транзакции. Очередь ограничена, если она заполнена, то добавление нового
+ * пакета дожидается освобождения места в ней. Для каждого пакета известны таблицы, которые он
+ * изменяет, поэтому чтение дожидается записи только тех пакетов, что затрагивают читаемые
+ * таблицы.
+ */
+class CORE_LIBRARY_EXPORT DatabaseWriter : public QThread
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief Выполнить запрос с параметрами заданной операции в подготовленном запросе
+     */
+    static bool execute(QSqlQuery& _query, const DatabaseWriteOperation& _operation);
+
+public:
+    explicit DatabaseWriter(QObject* _parent = nullptr);
+    ~DatabaseWriter() override;
+
+    /**
+     * @brief Добавить пакет запросов в очередь на запись в заданную базу данных
+     * @param _tables Таблицы, которые изменяются запросами пакета, "*" - любые таблицы
+     */
+    void enqueue(const QString& _databaseName, const QVector<DatabaseWriteOperation>& _operations,
+                 const QSet<QString>& _tables);
+
+    /**
+     * @brief Есть ли запросы, которые ещё не были записаны
+     */
+    bool hasPendingWrites() const;
+
+    /**
+     * @brief Дождаться записи всех запросов из очереди
+     */
+    void waitForPendingWrites();
+
+    /**
+     * @brief Дождаться записи запросов, изменяющих заданные таблицы, "*" - любые таблицы
+     */
+    void waitForPendingWrites(const QSet<QString>& _tables);
+
+    /**
+     * @brief Дождаться записи всех запросов и перенести их из журнала в файл базы данных
+     */
+    void checkpoint();
+
+    /**
+     * @brief Дождаться записи всех запросов, закрыть соединение с базой данных и остановить поток
+     * @note Поток будет снова запущен при добавлении следующего пакета в очередь
+     */
+    void stop();
+
+signals:
+    /**
+     * @brief Пакеты запросов записаны в базу данных
+     */
+    void writeFinished();
+
+    /**
+     * @brief При записи пакетов запросов возникла ошибка
+     */
+    void writeFailed(const QString& _error);
+
+protected:
+    /**
+     * @brief Переопределяем для обработки очереди запросов
+     */
+    void run() override;
+
+private:
+    class Implementation;
+    QScopedPointer<Implementation> d;
+};
+
+} // namespace DatabaseLayer
@@ -0,0 +1,515 @@
+#include "document_changes_compactor.h"
+
+#include "database.h"
+
+#include <utils/diff_match_patch/diff_match_patch_controller.h>
+#include <utils/logging.h>
+
+#include <QDateTime>
+#include <QHash>
+#include <QMutex>
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QWaitCondition>
+
+#include <algorithm>
+#include <functional>
+
+
+namespace DatabaseLayer {
+
+namespace {
+
+/**
+ * @brief Плагин используемый для работы с базой
+ */
+const QString kSqlDriver = "QSQLITE";
+
+/**
+ * @brief Формат хранения даты и времени изменений
+ */
+const QString kDateTimeFormat = "yyyy-MM-dd hh:mm:ss:zzz";
+
+/**
+ * @brief Значение auto_vacuum, соответствующее инкрементальному режиму
+ */
+constexpr int kIncrementalAutoVacuum = 2;
+
+/**
+ * @brief Сколько изменений просматривать за один шаг
+ * @note Ограничивает и количество патчей, накладываемых за шаг для восстановления содержимого
+ */
+constexpr int kMaximumScannedChanges = 200;
+
+/**
+ * @brief Максимальное количество изменений в одной объединяемой серии
+ */
+constexpr int kMaximumRunSize = 100;
+
+/**
+ * @brief Максимальный промежуток времени между первым и последним изменениями серии
+ */
+constexpr qint64 kMaximumRunDurationSecs = 60 * 60;
+
+/**
+ * @brief Пауза между шагами, чтобы не мешать записи изменений пользователя
+ */
+constexpr unsigned long kStepIntervalMs = 2 * 1000;
+
+/**
+ * @brief Сведения об изменении документа
+ */
+struct ChangeInfo {
+    int id = 0;
+    QString userName;
+    QString userEmail;
+    QDateTime dateTime;
+    bool isSynced = false;
+    QByteArray redoPatch;
+};
+
+} // namespace
+
+class DocumentChangesCompactor::Implementation
+{
+public:
+    explicit Implementation(DocumentChangesCompactor* _q);
+
+    /**
+     * @brief Состояние просмотра истории изменений документа
+     */
+    struct DocumentState {
+        /**
+         * @brief До какого изменения история уже просмотрена
+         */
+        int scannedChangeId = 0;
+
+        /**
+         * @brief Содержимое документа после этого изменения
+         */
+        QByteArray content;
+    };
+
+    /**
+     * @brief Выполнить один шаг объединения истории документа
+     * @return Осталось ли в истории документа что-то, что можно просмотреть в этом проходе
+     */
+    bool compactStep(QSqlDatabase& _database, const Document& _document,
+                     const DiffMatchPatchController& _dmpController, DocumentState& _state);
+
+    /**
+     * @brief Заменить серию изменений одним изменением с заданными патчами
+     * @return Количество байт, на которое уменьшился размер истории изменений
+     */
+    qint64 merge(QSqlDatabase& _database, const QUuid& _documentUuid,
+                 const QVector<int>& _changesIds, const QByteArray& _undoPatch,
+                 const QByteArray& _redoPatch);
+
+    /**
+     * @brief Освободить страницы удалённых данных
+     */
+    void vacuum(QSqlDatabase& _database);
+
+    /**
+     * @brief Подождать перед следующим шагом
+     * @return Можно ли продолжать проход
+     */
+    bool waitNextStep();
+
+    /**
+     * @brief Выполнить действие в главном потоке, если проход не был прерван к тому моменту
+     */
+    void notify(const std::function<void()>& _action);
+
+
+    DocumentChangesCompactor* q = nullptr;
+
+    /**
+     * @brief Параметры текущего прохода
+     * @note Задаются перед запуском потока и не меняются до его завершения
+     */
+    /** @{ */
+    QString databaseName;
+    QVector<Document> documents;
+    QDateTime olderThan;
+    bool isSyncedOnly = true;
+    int passNumber = 0;
+    /** @} */
+
+    /**
+     * @brief Сколько байт освобождено за текущий проход
+     */
+    qint64 reclaimedSize = 0;
+
+    /**
+     * @brief Состояния просмотра истории документов, сохраняемые между проходами
+     * @note Используются только потоком объединения
+     */
+    QString statesDatabaseName;
+    QHash<QUuid, DocumentState> states;
+
+    /**
+     * @brief Запрос на прерывание прохода, защищаемый мьютексом
+     */
+    /** @{ */
+    QMutex mutex;
+    QWaitCondition cancelRequested;
+    bool isCancelRequested = false;
+    /** @} */
+};
+
+DocumentChangesCompactor::Implementation::Implementation(DocumentChangesCompactor* _q)
+    : q(_q)
+{
+}
+
+bool DocumentChangesCompactor::Implementation::compactStep(
+    QSqlDatabase& _database, const Document& _document,
+    const DiffMatchPatchController& _dmpController, DocumentState& _state)
+{
+    QSqlQuery query(_database);
+
+    //
+    // Если изменение, до которого была просмотрена история, удалено, то начинаем заново
+    //
+    if (_state.scannedChangeId != 0) {
+        query.prepare("SELECT COUNT(*) FROM documents_changes WHERE id = ? ");
+        query.addBindValue(_state.scannedChangeId);
+        if (!query.exec() || !query.next() || query.value(0).toInt() == 0) {
+            _state = {};
+        }
+    }
+
+    //
+    // Самое первое изменение документа не трогаем, а просмотр начинаем сразу после него
+    //
+    if (_state.scannedChangeId == 0) {
+        query.prepare("SELECT id, redo_patch FROM documents_changes WHERE fk_document_uuid = ? "
+                      "ORDER BY id LIMIT 1 ");
+        query.addBindValue(_document.uuid.toString());
+        if (!query.exec() || !query.next()) {
+            return false;
+        }
+        _state.scannedChangeId = query.value(0).toInt();
+        _state.content
+            = _dmpController.applyPatch({}, qUncompress(query.value(1).toByteArray()));
+    }
+
+    query.prepare("SELECT id, user_name, user_email, date_time, is_synced, redo_patch "
+                  "FROM documents_changes WHERE fk_document_uuid = ? AND id > ? "
+                  "ORDER BY id LIMIT ? ");
+    query.addBindValue(_document.uuid.toString());
+    query.addBindValue(_state.scannedChangeId);
+    query.addBindValue(kMaximumScannedChanges);
+    if (!query.exec()) {
+        Log::warning("Can't read document changes: %1", query.lastError().text());
+        return false;
+    }
+    QVector<ChangeInfo> changes;
+    while (query.next()) {
+        ChangeInfo change;
+        change.id = query.value(0).toInt();
+        change.userName = query.value(1).toString();
+        change.userEmail = query.value(2).toString();
+        change.dateTime = QDateTime::fromString(query.value(3).toString(), kDateTimeFormat);
+        change.dateTime.setTimeSpec(Qt::UTC);
+        change.isSynced = query.value(4).toBool();
+        change.redoPatch = query.value(5).toByteArray();
+        changes.append(change);
+    }
+    if (changes.isEmpty()) {
+        return false;
+    }
+
+    query.prepare("SELECT fk_document_change_id FROM documents_keyframes "
+                  "WHERE fk_document_uuid = ? AND fk_document_change_id > ? "
+                  "ORDER BY fk_document_change_id ");
+    query.addBindValue(_document.uuid.toString());
+    query.addBindValue(_state.scannedChangeId);
+    query.exec();
+    QVector<int> keyframesIds;
+    while (query.next()) {
+        keyframesIds.append(query.value(0).toInt());
+    }
+    query.finish();
+
+    //
+    // Ищем серию подряд идущих старых изменений одного автора, восстанавливая содержимое
+    // документа по ходу просмотра
+    //
+    // NOTE: Серия не может продолжаться после изменения, на котором сделан снимок, иначе снимок
+    //       перестанет соответствовать патчам последующих изменений. Новые снимки не делаются,
+    //       но в проектах, сохранённых ранее, они ещё могут встречаться
+    //
+    bool isHistoryEnd = false;
+    auto content = _state.content;
+    int previousChangeId = _state.scannedChangeId;
+    int runPreviousChangeId = 0;
+    QByteArray runContentBefore;
+    QVector<int> runIds;
+    const ChangeInfo* runFirstChange = nullptr;
+    for (const auto& change : std::as_const(changes)) {
+        if (change.dateTime >= olderThan) {
+            isHistoryEnd = true;
+            break;
+        }
+
+        const auto isSuitable = change.isSynced || !isSyncedOnly;
+        const auto canContinueRun = runFirstChange != nullptr && isSuitable
+            && change.userName == runFirstChange->userName
+            && change.userEmail == runFirstChange->userEmail
+            && runFirstChange->dateTime.secsTo(change.dateTime) <= kMaximumRunDurationSecs;
+        if (canContinueRun) {
+            runIds.append(change.id);
+        } else if (runIds.size() > 1) {
+            break;
+        } else if (isSuitable) {
+            runPreviousChangeId = previousChangeId;
+            runContentBefore = content;
+            runIds = { change.id };
+            runFirstChange = &change;
+        } else {
+            runIds.clear();
+            runFirstChange = nullptr;
+        }
+        content = _dmpController.applyPatch(content, qUncompress(change.redoPatch));
+        previousChangeId = change.id;
+
+        const auto isKeyframe
+            = std::binary_search(keyframesIds.begin(), keyframesIds.end(), change.id);
+        if (isKeyframe || runIds.size() == kMaximumRunSize) {
+            if (runIds.size() > 1) {
+                break;
+            }
+            runIds.clear();
+            runFirstChange = nullptr;
+        }
+    }
+
+    //
+    // Если серии нет, то запоминаем докуда просмотрели историю, оставляя незавершённую серию
+    // для следующих шагов
+    //
+    if (runIds.size() < 2) {
+        if (runIds.size() == 1) {
+            _state = { runPreviousChangeId, runContentBefore };
+        } else {
+            _state = { previousChangeId, content };
+        }
+        return !isHistoryEnd && changes.size() == kMaximumScannedChanges;
+    }
+
+    //
+    // Заменяем серию одним изменением между состояниями документа до и после неё
+    //
+    const auto patches = _dmpController.makeUndoRedoPatches(runContentBefore, content);
+    const auto reclaimedRunSize
+        = merge(_database, _document.uuid, runIds, patches.first, patches.second);
+    _state = { runIds.constLast(), content };
+    if (reclaimedRunSize < 0) {
+        return true;
+    }
+
+    reclaimedSize += reclaimedRunSize;
+    const auto documentUuid = _document.uuid;
+    const QVector<Domain::Identifier> removedChangesIds = [&runIds] {
+        QVector<Domain::Identifier> ids;
+        ids.reserve(runIds.size() - 1);
+        for (int index = 0; index < runIds.size() - 1; ++index) {
+            ids.append(Domain::Identifier(runIds.at(index)));
+        }
+        return ids;
+    }();
+    const Domain::Identifier mergedChangeId(runIds.constLast());
+    notify([this, documentUuid, removedChangesIds, mergedChangeId] {
+        emit q->changesMerged(documentUuid, removedChangesIds, mergedChangeId);
+    });
+    return true;
+}
+
+qint64 DocumentChangesCompactor::Implementation::merge(QSqlDatabase& _database,
+                                                       const QUuid& _documentUuid,
+                                                       const QVector<int>& _changesIds,
+                                                       const QByteArray& _undoPatch,
+                                                       const QByteArray& _redoPatch)
+{
+    QSqlQuery query(_database);
+    _database.transaction();
+
+    //
+    // Определим сколько занимали патчи объединяемых изменений
+    //
+    query.prepare("SELECT SUM(LENGTH(undo_patch) + LENGTH(redo_patch)) FROM documents_changes "
+                  "WHERE fk_document_uuid = ? AND id >= ? AND id <= ? ");
+    query.addBindValue(_documentUuid.toString());
+    query.addBindValue(_changesIds.constFirst());
+    query.addBindValue(_changesIds.constLast());
+    const qint64 sizeBefore = query.exec() && query.next() ? query.value(0).toLongLong() : 0;
+
+    //
+    // Последнее изменение получает патчи всей серии, а остальные удаляются
+    //
+    const auto undoPatch = qCompress(_undoPatch);
+    const auto redoPatch = qCompress(_redoPatch);
+    query.prepare("UPDATE documents_changes SET undo_patch = ?, redo_patch = ? WHERE id = ? ");
+    query.addBindValue(undoPatch);
+    query.addBindValue(redoPatch);
+    query.addBindValue(_changesIds.constLast());
+    bool isMerged = query.exec();
+    if (isMerged) {
+        query.prepare("DELETE FROM documents_changes "
+                      "WHERE fk_document_uuid = ? AND id >= ? AND id < ? ");
+        query.addBindValue(_documentUuid.toString());
+        query.addBindValue(_changesIds.constFirst());
+        query.addBindValue(_changesIds.constLast());
+        isMerged = query.exec();
+    }
+    if (!isMerged || !_database.commit()) {
+        Log::warning("Can't merge document changes: %1", query.lastError().text());
+        _database.rollback();
+        return -1;
+    }
+
+    return sizeBefore - undoPatch.size() - redoPatch.size();
+}
+
+void DocumentChangesCompactor::Implementation::vacuum(QSqlDatabase& _database)
+{
+    //
+    // Полное сжатие пересобирает весь файл, поэтому в фоне освобождаем страницы, только если
+    // включена инкрементальная очистка
+    //
+    QSqlQuery query(_database);
+    if (!query.exec("PRAGMA auto_vacuum") || !query.next()
+        || query.value(0).toInt() != kIncrementalAutoVacuum) {
+        return;
+    }
+
+    //
+    // NOTE: За каждый шаг выполнения запроса освобождается одна страница, поэтому проходим
+    //       запрос до конца
+    //
+    query.exec("PRAGMA incremental_vacuum");
+    while (query.next()) {
+    }
+}
+
+bool DocumentChangesCompactor::Implementation::waitNextStep()
+{
+    QMutexLocker locker(&mutex);
+    if (!isCancelRequested) {
+        cancelRequested.wait(&mutex, kStepIntervalMs);
+    }
+    return !isCancelRequested;
+}
+
+void DocumentChangesCompactor::Implementation::notify(const std::function<void()>& _action)
+{
+    const auto pass = passNumber;
+    QMetaObject::invokeMethod(
+        q,
+        [this, pass, _action] {
+            if (pass == passNumber) {
+                _action();
+            }
+        },
+        Qt::QueuedConnection);
+}
+
+
+// ****
+
+
+DocumentChangesCompactor::DocumentChangesCompactor(QObject* _parent)
+    : QThread(_parent)
+    , d(new Implementation(this))
+{
+}
+
+DocumentChangesCompactor::~DocumentChangesCompactor()
+{
+    cancel();
+}
+
+void DocumentChangesCompactor::compact(const QString& _databaseName,
+                                       const QVector<Document>& _documents,
+                                       const QDateTime& _olderThan, bool _isSyncedOnly)
+{
+    if (isRunning()) {
+        return;
+    }
+
+    d->databaseName = _databaseName;
+    d->documents = _documents;
+    d->olderThan = _olderThan;
+    d->isSyncedOnly = _isSyncedOnly;
+    d->reclaimedSize = 0;
+    ++d->passNumber;
+    {
+        QMutexLocker locker(&d->mutex);
+        d->isCancelRequested = false;
+    }
+
+    start(QThread::LowestPriority);
+}
+
+void DocumentChangesCompactor::cancel()
+{
+    {
+        QMutexLocker locker(&d->mutex);
+        d->isCancelRequested = true;
+        d->cancelRequested.wakeAll();
+    }
+    wait();
+
+    //
+    // Результаты прерванного прохода, ожидающие доставки, больше не актуальны
+    //
+    ++d->passNumber;
+}
+
+void DocumentChangesCompactor::run()
+{
+    //
+    // Состояния просмотра истории относятся к конкретному файлу
+    //
+    if (d->statesDatabaseName != d->databaseName) {
+        d->statesDatabaseName = d->databaseName;
+        d->states.clear();
+    }
+
+    const auto connectionName = QString("documents_changes_compactor [%1]").arg(d->databaseName);
+    {
+        auto database = QSqlDatabase::addDatabase(kSqlDriver, connectionName);
+        database.setDatabaseName(d->databaseName);
+        if (database.open()) {
+            Database::applyStorageProfile(database);
+
+            bool canContinue = true;
+            for (const auto& document : std::as_const(d->documents)) {
+                const DiffMatchPatchController dmpController(document.tags);
+                auto& state = d->states[document.uuid];
+                while (canContinue && d->compactStep(database, document, dmpController, state)) {
+                    canContinue = d->waitNextStep();
+                }
+                if (!canContinue) {
+                    break;
+                }
+            }
+
+            if (canContinue && d->reclaimedSize > 0) {
+                d->vacuum(database);
+            }
+        } else {
+            Log::warning("Can't open database for changes compaction: %1",
+                         database.lastError().text());
+        }
+    }
+    QSqlDatabase::removeDatabase(connectionName);
+
+    const auto reclaimedSize = d->reclaimedSize;
+    d->notify([this, reclaimedSize] { emit compactionFinished(reclaimedSize); });
+}
+
+} // namespace DatabaseLayer
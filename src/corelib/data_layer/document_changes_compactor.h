@@ -0,0 +1,89 @@
+#pragma once
+
+#include <QScopedPointer>
+#include <QThread>
+#include <QUuid>
+#include <QVector>
+
+#include <corelib_global.h>
+#include <domain/identifier.h>
+
+class QDateTime;
+
+
+namespace DatabaseLayer {
+
+/**
+ * @brief Поток объединения старых изменений документов
+ *
+ * Через собственное соединение с базой данных постепенно просматривает историю изменений
+ * документов и заменяет серии идущих подряд старых изменений одного автора одним изменением.
+ * Содержимое документа восстанавливается по мере просмотра истории, поэтому за один шаг
+ * накладывается не больше заданного количества патчей, а следующий шаг продолжает с того же
+ * места. О каждом объединении поток сообщает в главном потоке, чтобы хранилище изменений
+ * актуализировало загруженные данные.
+ */
+class CORE_LIBRARY_EXPORT DocumentChangesCompactor : public QThread
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief Документ, историю изменений которого нужно объединить
+     */
+    struct Document {
+        QUuid uuid;
+
+        /**
+         * @brief Тэги документа, по которым формируются патчи его изменений
+         */
+        QVector<QString> tags;
+    };
+
+public:
+    explicit DocumentChangesCompactor(QObject* _parent = nullptr);
+    ~DocumentChangesCompactor() override;
+
+    /**
+     * @brief Запустить проход объединения истории изменений заданных документов
+     * @param _olderThan Изменения, сделанные после этого момента, не объединяются
+     * @param _isSyncedOnly Объединять только синхронизированные изменения
+     * @note Если предыдущий проход ещё не завершён, то новый не запускается
+     */
+    void compact(const QString& _databaseName, const QVector<Document>& _documents,
+                 const QDateTime& _olderThan, bool _isSyncedOnly);
+
+    /**
+     * @brief Прервать текущий проход и дождаться его завершения
+     * @note О результатах прерванного прохода, которые ещё не были доставлены, уже не сообщается
+     */
+    void cancel();
+
+signals:
+    /**
+     * @brief Серия изменений документа была объединена в последнее изменение серии
+     * @param _removedChangesIds Идентификаторы удалённых изменений серии
+     * @param _mergedChangeId Идентификатор изменения, которое получило патчи всей серии
+     */
+    void changesMerged(const QUuid& _documentUuid,
+                       const QVector<Domain::Identifier>& _removedChangesIds,
+                       const Domain::Identifier& _mergedChangeId);
+
+    /**
+     * @brief Проход объединения завершён
+     * @param _reclaimedSize Сколько байт освобождено в истории изменений за проход
+     */
+    void compactionFinished(qint64 _reclaimedSize);
+
+protected:
+    /**
+     * @brief Переопределяем для выполнения прохода объединения
+     */
+    void run() override;
+
+private:
+    class Implementation;
+    QScopedPointer<Implementation> d;
+};
+
+} // namespace DatabaseLayer
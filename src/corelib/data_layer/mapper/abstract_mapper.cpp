@@ -25,6 +25,8 @@ void AbstractMapper::clear()
         value = nullptr;
     }
     m_loadedObjectsMap.clear();
+    qDeleteAll(m_forgottenObjects);
+    m_forgottenObjects.clear();
 }
 
 DomainObject* AbstractMapper::abstractFind(const Identifier& _id)
@@ -39,17 +41,28 @@ DomainObject* AbstractMapper::abstractFind(const Identifier& _id)
     return result;
 }
 
-QVector<Domain::DomainObject*> AbstractMapper::abstractFind(const QString& _filter)
+QVector<Domain::DomainObject*> AbstractMapper::abstractFind(const QString& _filter,
+                                                            const QVariantList& _filterValues)
 {
-    QSqlQuery query = Database::query();
-    query.prepare(findAllStatement() + _filter);
-    query.exec();
+    //
+    // Значения фильтра передаём параметрами, чтобы текст запроса не менялся и его можно было
+    // подготовить лишь однажды
+    //
+    QSqlQuery& query = Database::preparedQuery(findAllStatement() + _filter);
+    for (int index = 0; index < _filterValues.size(); ++index) {
+        query.bindValue(index, _filterValues.at(index));
+    }
+    executeSql(query);
     QVector<Domain::DomainObject*> result;
     while (query.next()) {
         QSqlRecord record = query.record();
         DomainObject* domainObject = load(record);
         result.append(domainObject);
     }
+    //
+    // ... и освобождаем запрос, чтобы он не удерживал базу данных до следующего выполнения
+    //
+    query.finish();
     return result;
 }
 
@@ -72,18 +85,36 @@ void AbstractMapper::abstractInsert(DomainObject* _object)
     QString insertQueryString = insertStatement(_object, insertValues);
 
     //
-    // Сформируем запрос на добавление данных в базу
+    // Добавим данные в базу
+    //
+    Database::write(insertQueryString, insertValues);
+}
+
+void AbstractMapper::abstractInsert(const QVector<Domain::DomainObject*>& _objects)
+{
+    if (_objects.isEmpty()) {
+        return;
+    }
+
+    //
+    // Устанавливаем идентификаторы и собираем данные всех новых объектов
     //
-    QSqlQuery insertQuery = Database::query();
-    insertQuery.prepare(insertQueryString);
-    for (const QVariant& value : std::as_const(insertValues)) {
-        insertQuery.addBindValue(value);
+    QString insertQueryString;
+    QVector<QVariantList> insertRows;
+    insertRows.reserve(_objects.size());
+    for (auto object : _objects) {
+        object->setId(findNextIdentifier());
+        m_loadedObjectsMap.emplace(object->id(), object);
+
+        QVariantList insertValues;
+        insertQueryString = insertStatement(object, insertValues);
+        insertRows.append(insertValues);
     }
 
     //
-    // Добавим данные в базу
+    // Добавим данные в базу одним пакетным запросом
     //
-    executeSql(insertQuery);
+    Database::writeBatch(insertQueryString, insertRows);
 }
 
 bool AbstractMapper::abstractUpdate(DomainObject* _object)
@@ -95,6 +126,14 @@ bool AbstractMapper::abstractUpdate(DomainObject* _object)
         return false;
     }
 
+    //
+    // Забытый объект больше не соответствует данным в базе, поэтому его не сохраняем
+    //
+    if (const auto objectIter = m_loadedObjectsMap.find(_object->id());
+        objectIter == m_loadedObjectsMap.end() || objectIter->second != _object) {
+        return false;
+    }
+
     //
     // т.к. в m_loadedObjectsMap хранится список указателей, то после обновления элементов
     // обновлять элемент непосредственно в списке не нужно
@@ -106,19 +145,21 @@ bool AbstractMapper::abstractUpdate(DomainObject* _object)
     QVariantList updateValues;
     const QString updateQueryString = updateStatement(_object, updateValues);
 
-    //
-    // Сформируем запрос на обновление данных в базе
-    //
-    QSqlQuery updateQuery = Database::query();
-    updateQuery.prepare(updateQueryString);
-    for (const QVariant& value : std::as_const(updateValues)) {
-        updateQuery.addBindValue(value);
-    }
-
     //
     // Обновим данные в базе
     //
-    const bool isUpdateSuccesful = executeSql(updateQuery);
+    // NOTE: Отложенная запись может завершиться ошибкой уже после того, как изменения были
+    //       помечены сохранёнными, тогда помечаем их несохранёнными снова. Объект ищем по
+    //       идентификатору, т.к. к этому моменту он мог быть уже удалён
+    //
+    const auto id = _object->id();
+    const bool isUpdateSuccesful
+        = Database::write(updateQueryString, updateValues, [this, id] {
+              const auto objectIter = m_loadedObjectsMap.find(id);
+              if (objectIter != m_loadedObjectsMap.end()) {
+                  objectIter->second->markChangesNotStored();
+              }
+          });
     if (isUpdateSuccesful) {
         _object->markChangesStored();
     }
@@ -133,19 +174,10 @@ void AbstractMapper::abstractDelete(DomainObject* _object)
     QVariantList deleteValues;
     QString deleteQueryString = deleteStatement(_object, deleteValues);
 
-    //
-    // Сформируем запрос на удаление данных из базы
-    //
-    QSqlQuery deleteQuery = Database::query();
-    deleteQuery.prepare(deleteQueryString);
-    for (const QVariant& value : std::as_const(deleteValues)) {
-        deleteQuery.addBindValue(value);
-    }
-
     //
     // Удалим данные из базы
     //
-    const bool isDeleteSuccesful = executeSql(deleteQuery);
+    const bool isDeleteSuccesful = Database::write(deleteQueryString, deleteValues);
     if (isDeleteSuccesful) {
         //
         // Удалим объекст из списка загруженных
@@ -156,6 +188,17 @@ void AbstractMapper::abstractDelete(DomainObject* _object)
     }
 }
 
+void AbstractMapper::abstractForget(const Identifier& _id)
+{
+    const auto objectIter = m_loadedObjectsMap.find(_id);
+    if (objectIter == m_loadedObjectsMap.end()) {
+        return;
+    }
+
+    m_forgottenObjects.append(objectIter->second);
+    m_loadedObjectsMap.erase(objectIter);
+}
+
 bool AbstractMapper::executeSql(QSqlQuery& _sqlQuery)
 {
     const bool isExecutionSuccesful = _sqlQuery.exec();
@@ -192,11 +235,11 @@ Identifier AbstractMapper::findNextIdentifier()
         //
         // Если нет ещё последнего индекса по таблице, загрузим его
         //
-        QSqlQuery query = Database::query();
-        query.prepare(findLastOneStatement());
+        QSqlQuery& query = Database::preparedQuery(findLastOneStatement());
         query.exec();
         query.next();
         const QSqlRecord record = query.record();
+        query.finish();
         load(record);
 
         m_isLastIdentifierLoaded = true;
@@ -25,7 +25,7 @@ public:
     /**
      * @brief Очистить все загруженные ранее данные
      */
-    void clear();
+    virtual void clear();
 
 protected:
     virtual QString findStatement(const Domain::Identifier& _id) const = 0;
@@ -49,11 +49,20 @@ protected:
 
 protected:
     Domain::DomainObject* abstractFind(const Domain::Identifier& _id);
-    QVector<Domain::DomainObject*> abstractFind(const QString& _filter);
+    QVector<Domain::DomainObject*> abstractFind(const QString& _filter,
+                                                const QVariantList& _filterValues = {});
     void abstractInsert(Domain::DomainObject* _object);
+    void abstractInsert(const QVector<Domain::DomainObject*>& _objects);
     bool abstractUpdate(Domain::DomainObject* _object);
     void abstractDelete(Domain::DomainObject* _object);
 
+    /**
+     * @brief Забыть загруженный объект, данные которого были изменены в обход маппера
+     * @note Объект не удаляется, т.к. на него могут ссылаться хранилища, но и не сохраняется
+     *       больше в базу данных, а при следующем поиске вместо него будет загружен новый
+     */
+    void abstractForget(const Domain::Identifier& _id);
+
     /**
      * @brief Выполнить запрос
      */
@@ -91,6 +100,11 @@ private:
      * @brief Загруженные объекты из базы данных
      */
     std::map<Domain::Identifier, Domain::DomainObject*> m_loadedObjectsMap;
+
+    /**
+     * @brief Забытые объекты, которые удаляются только при очистке маппера
+     */
+    QVector<Domain::DomainObject*> m_forgottenObjects;
 };
 
 } // namespace DataMappingLayer
@@ -19,37 +19,11 @@ const QString kColumns = " id, fk_document_uuid, uuid, undo_patch, redo_patch, d
                          "user_name, user_email, is_synced ";
 const QString kTableName = " documents_changes ";
 const QString kDateTimeFormat = "yyyy-MM-dd hh:mm:ss:zzz";
-QString uuidFilter(const QUuid& _uuid)
-{
-    return QString(" WHERE uuid = '%1' ").arg(_uuid.toString());
-}
-QString documentFilter(const QUuid& _documentUuid)
-{
-    return QString(" WHERE fk_document_uuid = '%1'").arg(_documentUuid.toString());
-}
-QString documentFilter(const QUuid& _documentUuid, int _changeIndex)
-{
-    //
-    // Игнорируем самое первое изменнеие документа, т.к. это добавление стандартной разметки
-    // элемента в пустой документ
-    //
-    return QString(" WHERE fk_document_uuid = '%1'"
-                   " AND id not in (SELECT id FROM %3 WHERE fk_document_uuid = '%1' ORDER BY id "
-                   "ASC LIMIT 0, 1) "
-                   " ORDER BY id DESC LIMIT %2, 1")
-        .arg(_documentUuid.toString())
-        .arg(_changeIndex)
-        .arg(kTableName);
-}
-QString unsyncedFilter(const QUuid& _documentUuid)
-{
-    return QString(" WHERE fk_document_uuid = '%1' AND is_synced = 0")
-        .arg(_documentUuid.toString());
-}
-QString unsyncedFilter()
-{
-    return QString(" WHERE is_synced = 0 GROUP BY fk_document_uuid");
-}
+const QString kUuidFilter = " WHERE uuid = ? ";
+const QString kDocumentFilter = " WHERE fk_document_uuid = ? ";
+const QString kDocumentUnsyncedFilter = " WHERE fk_document_uuid = ? AND is_synced = 0";
+const QString kUnsyncedFilter = " WHERE is_synced = 0 GROUP BY fk_document_uuid";
+const QString kKeyframesTableName = " documents_keyframes ";
 } // namespace
 
 bool DataMappingLayer::DocumentChangeMapper::isEmpty()
@@ -71,18 +45,7 @@ DocumentChangeObject* DocumentChangeMapper::find(const Domain::Identifier& _id)
 
 DocumentChangeObject* DocumentChangeMapper::find(const QUuid& _uuid)
 {
-    const auto domainObjects = abstractFind(uuidFilter(_uuid));
-    if (domainObjects.isEmpty()) {
-        return nullptr;
-    }
-
-    return static_cast<DocumentChangeObject*>(domainObjects.first());
-}
-
-Domain::DocumentChangeObject* DocumentChangeMapper::find(const QUuid& _documentUuid,
-                                                         int _changeIndex)
-{
-    const auto domainObjects = abstractFind(documentFilter(_documentUuid, _changeIndex));
+    const auto domainObjects = abstractFind(kUuidFilter, { _uuid.toString() });
     if (domainObjects.isEmpty()) {
         return nullptr;
     }
@@ -92,7 +55,7 @@ Domain::DocumentChangeObject* DocumentChangeMapper::find(const QUuid& _documentU
 
 QVector<Domain::DocumentChangeObject*> DocumentChangeMapper::findAll(const QUuid& _documentUuid)
 {
-    const auto domainObjects = abstractFind(documentFilter(_documentUuid));
+    const auto domainObjects = abstractFind(kDocumentFilter, { _documentUuid.toString() });
     if (domainObjects.isEmpty()) {
         return {};
     }
@@ -104,10 +67,27 @@ QVector<Domain::DocumentChangeObject*> DocumentChangeMapper::findAll(const QUuid
     return changes;
 }
 
+QVector<Domain::Identifier> DocumentChangeMapper::findAllIds(const QUuid& _documentUuid)
+{
+    //
+    // Идентификаторы берутся прямо из индекса, без чтения самих изменений
+    //
+    QSqlQuery& query = DatabaseLayer::Database::preparedQuery(
+        "SELECT id FROM " + kTableName + kDocumentFilter + " ORDER BY id ");
+    query.bindValue(0, _documentUuid.toString());
+    executeSql(query);
+    QVector<Domain::Identifier> ids;
+    while (query.next()) {
+        ids.append(Domain::Identifier(query.value(0).toInt()));
+    }
+    query.finish();
+    return ids;
+}
+
 QVector<Domain::DocumentChangeObject*> DocumentChangeMapper::findAllUnsynced(
     const QUuid& _documentUuid)
 {
-    const auto domainObjects = abstractFind(unsyncedFilter(_documentUuid));
+    const auto domainObjects = abstractFind(kDocumentUnsyncedFilter, { _documentUuid.toString() });
     if (domainObjects.isEmpty()) {
         return {};
     }
@@ -121,7 +101,7 @@ QVector<Domain::DocumentChangeObject*> DocumentChangeMapper::findAllUnsynced(
 
 QVector<QUuid> DocumentChangeMapper::unsyncedDocuments()
 {
-    const auto domainObjects = abstractFind(unsyncedFilter());
+    const auto domainObjects = abstractFind(kUnsyncedFilter);
     if (domainObjects.isEmpty()) {
         return {};
     }
@@ -133,11 +113,81 @@ QVector<QUuid> DocumentChangeMapper::unsyncedDocuments()
     return documents;
 }
 
+Identifier DocumentChangeMapper::findLastId(const QUuid& _documentUuid, const QDateTime& _dateTime)
+{
+    QSqlQuery& query = DatabaseLayer::Database::preparedQuery(
+        "SELECT id FROM " + kTableName + kDocumentFilter
+        + " AND date_time <= ? ORDER BY id DESC LIMIT 1 ");
+    query.bindValue(0, _documentUuid.toString());
+    query.bindValue(1, _dateTime.toUTC().toString(kDateTimeFormat));
+    executeSql(query);
+    const auto id = query.next() ? Identifier(query.value(0).toInt()) : Identifier();
+    query.finish();
+    return id;
+}
+
+QVector<QByteArray> DocumentChangeMapper::findRedoPatches(const QUuid& _documentUuid,
+                                                          const Identifier& _fromId,
+                                                          const Identifier& _toId)
+{
+    QSqlQuery& query = DatabaseLayer::Database::preparedQuery(
+        "SELECT redo_patch FROM " + kTableName + kDocumentFilter
+        + " AND id > ? AND id <= ? ORDER BY id ");
+    query.bindValue(0, _documentUuid.toString());
+    query.bindValue(1, _fromId.value());
+    query.bindValue(2, _toId.value());
+    executeSql(query);
+    QVector<QByteArray> patches;
+    while (query.next()) {
+        patches.append(qUncompress(query.value(0).toByteArray()));
+    }
+    query.finish();
+    return patches;
+}
+
+DocumentChangeMapper::Keyframe DocumentChangeMapper::findKeyframe(const QUuid& _documentUuid,
+                                                                  const Identifier& _changeId)
+{
+    QSqlQuery& query = DatabaseLayer::Database::preparedQuery(
+        "SELECT fk_document_change_id, content, date_time FROM " + kKeyframesTableName
+        + kDocumentFilter + " AND fk_document_change_id <= ? "
+        + " ORDER BY fk_document_change_id DESC LIMIT 1 ");
+    query.bindValue(0, _documentUuid.toString());
+    query.bindValue(1, _changeId.value());
+    executeSql(query);
+    Keyframe keyframe;
+    if (query.next()) {
+        keyframe.changeId = Identifier(query.value(0).toInt());
+        keyframe.content = qUncompress(query.value(1).toByteArray());
+        keyframe.dateTime = QDateTime::fromString(query.value(2).toString(), kDateTimeFormat);
+        keyframe.dateTime.setTimeSpec(Qt::UTC);
+    }
+    query.finish();
+    return keyframe;
+}
+
+void DocumentChangeMapper::forget(const QVector<Identifier>& _ids)
+{
+    for (const auto& id : _ids) {
+        abstractForget(id);
+    }
+}
+
 void DocumentChangeMapper::insert(DocumentChangeObject* _object)
 {
     abstractInsert(_object);
 }
 
+void DocumentChangeMapper::insert(const QVector<Domain::DocumentChangeObject*>& _objects)
+{
+    QVector<Domain::DomainObject*> domainObjects;
+    domainObjects.reserve(_objects.size());
+    for (auto object : _objects) {
+        domainObjects.append(object);
+    }
+    abstractInsert(domainObjects);
+}
+
 bool DocumentChangeMapper::update(DocumentChangeObject* _object)
 {
     return abstractUpdate(_object);
@@ -150,10 +200,8 @@ void DocumentChangeMapper::remove(DocumentChangeObject* _object)
 
 void DocumentChangeMapper::removeAll()
 {
-    QSqlQuery query = DatabaseLayer::Database::query();
-    query.prepare(QString("DELETE FROM %1").arg(kTableName));
-
-    executeSql(query);
+    DatabaseLayer::Database::write(QString("DELETE FROM %1").arg(kTableName), {});
+    DatabaseLayer::Database::write(QString("DELETE FROM %1").arg(kKeyframesTableName), {});
 }
 
 QString DocumentChangeMapper::findStatement(const Domain::Identifier& _id) const
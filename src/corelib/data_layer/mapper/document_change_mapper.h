@@ -2,6 +2,8 @@
 
 #include "abstract_mapper.h"
 
+#include <QDateTime>
+
 namespace Domain {
 class DocumentChangeObject;
 }
@@ -14,17 +16,60 @@ namespace DataMappingLayer {
  */
 class DocumentChangeMapper : public AbstractMapper
 {
+public:
+    /**
+     * @brief Снимок содержимого документа после одного из его изменений
+     */
+    struct Keyframe {
+        /**
+         * @brief Изменение, после которого сделан снимок
+         */
+        Domain::Identifier changeId;
+
+        QByteArray content;
+        QDateTime dateTime;
+    };
+
 public:
     bool isEmpty();
     Domain::DocumentChangeObject* find(const Domain::Identifier& _id);
     Domain::DocumentChangeObject* find(const QUuid& _uuid);
-    Domain::DocumentChangeObject* find(const QUuid& _documentUuid, int _changeIndex);
     QVector<Domain::DocumentChangeObject*> findAll(const QUuid& _documentUuid);
+
+    /**
+     * @brief Получить идентификаторы всех изменений документа в порядке их добавления
+     */
+    QVector<Domain::Identifier> findAllIds(const QUuid& _documentUuid);
+
     QVector<Domain::DocumentChangeObject*> findAllUnsynced(const QUuid& _documentUuid);
 
     QVector<QUuid> unsyncedDocuments();
 
+    /**
+     * @brief Получить идентификатор последнего изменения документа, сделанного не позднее
+     *        заданного момента
+     */
+    Domain::Identifier findLastId(const QUuid& _documentUuid, const QDateTime& _dateTime);
+
+    /**
+     * @brief Получить патчи повтора изменений документа с идентификаторами из (_fromId, _toId]
+     */
+    QVector<QByteArray> findRedoPatches(const QUuid& _documentUuid,
+                                        const Domain::Identifier& _fromId,
+                                        const Domain::Identifier& _toId);
+
+    /**
+     * @brief Получить ближайший снимок документа, сделанный не позднее заданного изменения
+     */
+    Keyframe findKeyframe(const QUuid& _documentUuid, const Domain::Identifier& _changeId);
+
+    /**
+     * @brief Забыть загруженные изменения, данные которых были изменены в обход маппера
+     */
+    void forget(const QVector<Domain::Identifier>& _ids);
+
     void insert(Domain::DocumentChangeObject* _object);
+    void insert(const QVector<Domain::DocumentChangeObject*>& _objects);
     bool update(Domain::DocumentChangeObject* _object);
     void remove(Domain::DocumentChangeObject* _object);
     void removeAll();
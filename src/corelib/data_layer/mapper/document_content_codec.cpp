@@ -0,0 +1,395 @@
+#include "document_content_codec.h"
+
+#include <data_layer/database.h>
+#include <domain/document_object.h>
+#include <utils/logging.h>
+
+#include <QHash>
+#include <QtEndian>
+
+#ifndef Q_OS_WIN
+#include <zlib.h>
+#else
+#include <QtZlib/zlib.h>
+#endif
+
+
+namespace DataMappingLayer {
+
+namespace {
+
+/**
+ * @brief Сигнатура закодированного содержимого
+ * @note Содержимое документов в исходном виде никогда не начинается с нулевого байта
+ */
+const QByteArray kSignature = QByteArrayLiteral("\x00"
+                                                "STZ");
+
+/**
+ * @brief Форматы закодированного содержимого
+ * @note Словари являются частью формата файла, поэтому менять существующие нельзя, вместо этого
+ *       нужно добавлять новый формат со своими словарями
+ */
+enum class ContentFormat : char {
+    //! Сжатие без словаря
+    Deflate = 1,
+    //! Сжатие со словарём для типа документа
+    DeflateWithDictionaryV1 = 2,
+};
+
+/**
+ * @brief Размер заголовка: сигнатура, байт формата и размер исходных данных
+ */
+const int kHeaderSize = kSignature.size() + 1 + static_cast<int>(sizeof(quint32));
+
+/**
+ * @brief Сформировать словарь из ключей xml-документа заданного майм-типа
+ * @note Повторяет разметку, которую формируют модели документов, чтобы даже небольшие документы,
+ *       состоящие в основном из неё, хорошо сжимались
+ */
+QByteArray buildDictionary(const QByteArray& _mimeType, const QVector<QByteArray>& _keys)
+{
+    QByteArray dictionary = "<?xml version=\"1.0\"?>\n<document mime-type=\"" + _mimeType
+        + "\" version=\"1.0\">\n";
+    for (const auto& key : _keys) {
+        dictionary += "<" + key + "><![CDATA[]]></" + key + ">\n";
+    }
+    dictionary += "</document>";
+    return dictionary;
+}
+
+/**
+ * @brief Получить словарь первой версии для документов заданного типа
+ * @return Пустой массив, если для типа словаря нет
+ */
+const QByteArray& dictionaryV1(Domain::DocumentObjectType _type)
+{
+    static const QHash<Domain::DocumentObjectType, QByteArray> kDictionaries = {
+        { Domain::DocumentObjectType::Character,
+          buildDictionary(
+              "application/x-starc/document/character",
+              { "name",
+                "color",
+                "story_role",
+                "age",
+                "gender",
+                "one_sentence_description",
+                "long_description",
+                "photos",
+                "photo",
+                "relations",
+                "relation",
+                "with",
+                "line_type",
+                "feeling",
+                "details",
+                "nickname",
+                "date_of_birth",
+                "place_of_birth",
+                "ethnicity",
+                "family",
+                "height",
+                "weight",
+                "body",
+                "skin_tone",
+                "hair_style",
+                "hair_color",
+                "eye_shape",
+                "eye_color",
+                "facial_shape",
+                "distinguish_feature",
+                "other_facial_features",
+                "posture",
+                "other_phisical_appearance",
+                "skills",
+                "how_it_developed",
+                "incompetence",
+                "strength",
+                "weakness",
+                "hobbies",
+                "habits",
+                "health",
+                "speech",
+                "pet",
+                "dress",
+                "something_always_carried",
+                "accessories",
+                "area_of_residence",
+                "home_description",
+                "neighborhood",
+                "organization_involved",
+                "income",
+                "job_occupation",
+                "job_rank",
+                "job_satisfaction",
+                "personality",
+                "moral",
+                "motivation",
+                "discouragement",
+                "philosophy",
+                "greatest_fear",
+                "self_control",
+                "intelligence_level",
+                "confidence_level",
+                "childhood",
+                "important_past_event",
+                "best_accomplishment",
+                "other_accomplishment",
+                "worst_moment",
+                "failure",
+                "secrets",
+                "best_memories",
+                "worst_memories",
+                "short_term_goal",
+                "long_term_goal",
+                "initial_beliefs",
+                "changed_beliefs",
+                "what_leads_to_change",
+                "first_appearance",
+                "plot_involvement",
+                "conflict",
+                "mostDefiningMoment" }) },
+        { Domain::DocumentObjectType::Location,
+          buildDictionary("application/x-starc/document/location",
+                          { "name",
+                            "color",
+                            "story_role",
+                            "one_sentence_description",
+                            "long_description",
+                            "photos",
+                            "photo",
+                            "routes",
+                            "route",
+                            "to",
+                            "line_type",
+                            "details",
+                            "sight",
+                            "smell",
+                            "sound",
+                            "taste",
+                            "touch",
+                            "location",
+                            "climate",
+                            "landmark",
+                            "nearby_places",
+                            "history" }) },
+        { Domain::DocumentObjectType::World,
+          buildDictionary("application/x-starc/document/world",
+                          { "name",
+                            "one_sentence_description",
+                            "long_description",
+                            "photos",
+                            "photo",
+                            "routes",
+                            "route",
+                            "to",
+                            "line_type",
+                            "color",
+                            "details",
+                            "overview",
+                            "earth_like",
+                            "history",
+                            "mood",
+                            "biology",
+                            "physics",
+                            "astronomy",
+                            "geography",
+                            "races",
+                            "race",
+                            "floras",
+                            "flora",
+                            "animals",
+                            "animal",
+                            "naturalResources",
+                            "naturalResource",
+                            "climates",
+                            "climate",
+                            "religons",
+                            "religon",
+                            "ethics",
+                            "ethic",
+                            "languages",
+                            "language",
+                            "castes",
+                            "caste",
+                            "technology",
+                            "economy",
+                            "trade",
+                            "business",
+                            "industry",
+                            "currency",
+                            "education",
+                            "communication",
+                            "art",
+                            "entertainment",
+                            "travel",
+                            "science",
+                            "government_format",
+                            "government_history",
+                            "laws",
+                            "foreign_rRelations",
+                            "perception_of_government",
+                            "propaganda",
+                            "anti_government_organisations",
+                            "past_war",
+                            "current_war",
+                            "potential_war",
+                            "magic_rule",
+                            "who_can_use",
+                            "effect_to_world",
+                            "effect_to_society",
+                            "effect_to_technology",
+                            "magic_types",
+                            "magic_type" }) },
+    };
+    static const QByteArray kEmptyDictionary;
+
+    const auto dictionary = kDictionaries.constFind(_type);
+    return dictionary != kDictionaries.constEnd() ? dictionary.value() : kEmptyDictionary;
+}
+
+/**
+ * @brief Сжать данные с использованием заданного словаря
+ * @return Пустой массив, если сжать не удалось
+ */
+QByteArray compress(const QByteArray& _data, const QByteArray& _dictionary)
+{
+    z_stream stream = {};
+    if (deflateInit(&stream, Z_BEST_COMPRESSION) != Z_OK) {
+        return {};
+    }
+
+    if (!_dictionary.isEmpty()) {
+        deflateSetDictionary(&stream, reinterpret_cast<const Bytef*>(_dictionary.constData()),
+                             static_cast<uInt>(_dictionary.size()));
+    }
+
+    QByteArray result(static_cast<int>(deflateBound(&stream, static_cast<uLong>(_data.size()))),
+                      Qt::Uninitialized);
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(_data.constData()));
+    stream.avail_in = static_cast<uInt>(_data.size());
+    stream.next_out = reinterpret_cast<Bytef*>(result.data());
+    stream.avail_out = static_cast<uInt>(result.size());
+    const auto status = deflate(&stream, Z_FINISH);
+    deflateEnd(&stream);
+    if (status != Z_STREAM_END) {
+        return {};
+    }
+
+    result.resize(static_cast<int>(stream.total_out));
+    return result;
+}
+
+/**
+ * @brief Распаковать данные заданного размера с использованием заданного словаря
+ * @return Пустой массив, если распаковать не удалось
+ */
+QByteArray uncompress(const char* _data, int _dataSize, int _size, const QByteArray& _dictionary)
+{
+    z_stream stream = {};
+    if (inflateInit(&stream) != Z_OK) {
+        return {};
+    }
+
+    QByteArray result(_size, Qt::Uninitialized);
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(_data));
+    stream.avail_in = static_cast<uInt>(_dataSize);
+    stream.next_out = reinterpret_cast<Bytef*>(result.data());
+    stream.avail_out = static_cast<uInt>(result.size());
+    auto status = inflate(&stream, Z_FINISH);
+    if (status == Z_NEED_DICT && !_dictionary.isEmpty()) {
+        inflateSetDictionary(&stream, reinterpret_cast<const Bytef*>(_dictionary.constData()),
+                             static_cast<uInt>(_dictionary.size()));
+        status = inflate(&stream, Z_FINISH);
+    }
+    inflateEnd(&stream);
+    if (status != Z_STREAM_END || static_cast<int>(stream.total_out) != _size) {
+        return {};
+    }
+
+    return result;
+}
+
+} // namespace
+
+
+QByteArray DocumentContentCodec::encode(const QByteArray& _content,
+                                        Domain::DocumentObjectType _type)
+{
+    //
+    // Изображения уже сжаты, поэтому их сохраняем как есть
+    //
+    if (_content.isEmpty() || _type == Domain::DocumentObjectType::ImageData) {
+        return _content;
+    }
+
+    const auto& dictionary = dictionaryV1(_type);
+    const auto compressed = compress(_content, dictionary);
+    if (compressed.isEmpty() || kHeaderSize + compressed.size() >= _content.size()) {
+        return _content;
+    }
+
+    const auto format = dictionary.isEmpty() ? ContentFormat::Deflate
+                                             : ContentFormat::DeflateWithDictionaryV1;
+    QByteArray encoded;
+    encoded.reserve(kHeaderSize + compressed.size());
+    encoded += kSignature;
+    encoded += static_cast<char>(format);
+    encoded += QByteArray(sizeof(quint32), Qt::Uninitialized);
+    qToBigEndian(static_cast<quint32>(_content.size()),
+                 encoded.data() + kSignature.size() + 1);
+    encoded += compressed;
+    return encoded;
+}
+
+QByteArray DocumentContentCodec::decode(const QByteArray& _content,
+                                        Domain::DocumentObjectType _type)
+{
+    const auto content = tryDecode(_content, _type);
+    if (!content.has_value()) {
+        Log::warning("Can't decode document content");
+        DatabaseLayer::Database::setLastError("Can't decode document content");
+        return {};
+    }
+
+    return *content;
+}
+
+std::optional<QByteArray> DocumentContentCodec::tryDecode(const QByteArray& _content,
+                                                          Domain::DocumentObjectType _type)
+{
+    //
+    // Содержимое без сигнатуры хранится в исходном виде
+    //
+    if (_content.size() < kHeaderSize || !_content.startsWith(kSignature)) {
+        return _content;
+    }
+
+    const auto format = static_cast<ContentFormat>(_content.at(kSignature.size()));
+    const auto size
+        = static_cast<int>(qFromBigEndian<quint32>(_content.constData() + kSignature.size() + 1));
+    QByteArray dictionary;
+    switch (format) {
+    case ContentFormat::Deflate: {
+        break;
+    }
+
+    case ContentFormat::DeflateWithDictionaryV1: {
+        dictionary = dictionaryV1(_type);
+        break;
+    }
+
+    default: {
+        return std::nullopt;
+    }
+    }
+
+    const auto content = uncompress(_content.constData() + kHeaderSize,
+                                    _content.size() - kHeaderSize, size, dictionary);
+    if (content.isEmpty() && size > 0) {
+        return std::nullopt;
+    }
+    return content;
+}
+
+} // namespace DataMappingLayer
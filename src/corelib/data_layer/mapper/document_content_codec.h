@@ -0,0 +1,44 @@
+#pragma once
+
+#include <QByteArray>
+
+#include <optional>
+
+namespace Domain {
+enum class DocumentObjectType;
+}
+
+
+namespace DataMappingLayer {
+
+/**
+ * @brief Кодировщик содержимого документов для хранения в базе данных
+ *
+ * Закодированное содержимое начинается с сигнатуры и байта формата, за которыми следует размер
+ * исходных данных и сжатый поток. Данные без сигнатуры считаются записанными в исходном виде,
+ * поэтому файлы старого формата читаются без преобразований.
+ */
+class DocumentContentCodec
+{
+public:
+    /**
+     * @brief Закодировать содержимое документа заданного типа
+     * @note Если сжатие не даёт выигрыша в размере, то содержимое сохраняется как есть
+     */
+    static QByteArray encode(const QByteArray& _content, Domain::DocumentObjectType _type);
+
+    /**
+     * @brief Раскодировать содержимое документа заданного типа
+     */
+    static QByteArray decode(const QByteArray& _content, Domain::DocumentObjectType _type);
+
+    /**
+     * @brief Раскодировать содержимое документа заданного типа, не сообщая об ошибке
+     * @note Можно вызывать из любого потока
+     * @return Пустое значение, если содержимое раскодировать не удалось
+     */
+    static std::optional<QByteArray> tryDecode(const QByteArray& _content,
+                                               Domain::DocumentObjectType _type);
+};
+
+} // namespace DataMappingLayer
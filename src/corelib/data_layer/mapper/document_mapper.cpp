@@ -1,9 +1,13 @@
 #include "document_mapper.h"
 
+#include "document_content_codec.h"
+
 #include <data_layer/database.h>
 #include <domain/document_object.h>
 #include <domain/objects_builder.h>
 
+#include <QSqlDatabase>
+#include <QSqlQuery>
 #include <QSqlRecord>
 
 using Domain::DocumentObject;
@@ -16,15 +20,25 @@ namespace DataMappingLayer {
 
 namespace {
 const QString kColumns = " id, uuid, type, content, synced_at ";
+//
+// Содержимое документов может быть очень большим, поэтому при поиске документов загружаем только
+// их описание, а содержимое подгружаем по мере обращения к нему
+//
+const QString kMetadataColumns = " id, uuid, type, synced_at ";
 const QString kTableName = " documents ";
 const QString kDateTimeFormat = "yyyy-MM-dd hh:mm:ss:zzz";
-QString uuidFilter(const QUuid& _uuid)
-{
-    return QString(" WHERE uuid = '%1' ").arg(_uuid.toString());
-}
-QString typeFilter(Domain::DocumentObjectType _type)
+const QString kUuidFilter = " WHERE uuid = ? ";
+const QString kTypeFilter = " WHERE type = ? ";
+/**
+ * @brief Получить содержимое документа в виде для сохранения в базу данных
+ */
+QByteArray encodedContent(const DocumentObject* _document)
 {
-    return QString(" WHERE type = %1 ").arg(static_cast<int>(_type));
+    if (!DatabaseLayer::Database::isDocumentsContentCompressionEnabled()) {
+        return _document->content();
+    }
+
+    return DocumentContentCodec::encode(_document->content(), _document->type());
 }
 } // namespace
 
@@ -36,7 +50,16 @@ DocumentObject* DocumentMapper::find(const Identifier& _id)
 
 DocumentObject* DocumentMapper::find(const QUuid& _uuid)
 {
-    const auto domainObjects = abstractFind(uuidFilter(_uuid));
+    //
+    // Если документ уже загружен, то в базу данных не обращаемся
+    //
+    const auto document = m_loadedDocumentsByUuid.value(_uuid);
+    if (document != nullptr && document->uuid() == _uuid) {
+        return document;
+    }
+
+    const auto domainObjects = abstractFind(kUuidFilter, { _uuid.toString() });
+    indexDocuments(domainObjects);
     if (domainObjects.isEmpty()) {
         return nullptr;
     }
@@ -46,7 +69,8 @@ DocumentObject* DocumentMapper::find(const QUuid& _uuid)
 
 Domain::DocumentObject* DocumentMapper::findFirst(Domain::DocumentObjectType _type)
 {
-    const auto domainObjects = abstractFind(typeFilter(_type));
+    const auto domainObjects = abstractFind(kTypeFilter, { static_cast<int>(_type) });
+    indexDocuments(domainObjects);
     if (domainObjects.isEmpty()) {
         return nullptr;
     }
@@ -56,7 +80,8 @@ Domain::DocumentObject* DocumentMapper::findFirst(Domain::DocumentObjectType _ty
 
 QVector<Domain::DocumentObject*> DocumentMapper::findAll(Domain::DocumentObjectType _type)
 {
-    const auto domainObjects = abstractFind(typeFilter(_type));
+    const auto domainObjects = abstractFind(kTypeFilter, { static_cast<int>(_type) });
+    indexDocuments(domainObjects);
     if (domainObjects.isEmpty()) {
         return {};
     }
@@ -71,6 +96,7 @@ QVector<Domain::DocumentObject*> DocumentMapper::findAll(Domain::DocumentObjectT
 QVector<Domain::DocumentObject*> DocumentMapper::findAll()
 {
     const auto domainObjects = abstractFind("");
+    indexDocuments(domainObjects);
     if (domainObjects.isEmpty()) {
         return {};
     }
@@ -85,6 +111,7 @@ QVector<Domain::DocumentObject*> DocumentMapper::findAll()
 void DocumentMapper::insert(DocumentObject* _object)
 {
     abstractInsert(_object);
+    m_loadedDocumentsByUuid.insert(_object->uuid(), _object);
 }
 
 bool DocumentMapper::update(DocumentObject* _object)
@@ -94,20 +121,36 @@ bool DocumentMapper::update(DocumentObject* _object)
 
 void DocumentMapper::remove(DocumentObject* _object)
 {
+    //
+    // Удаляем документ из индекса по любому из ключей, т.к. uuid документа мог смениться
+    //
+    for (auto iter = m_loadedDocumentsByUuid.begin(); iter != m_loadedDocumentsByUuid.end();) {
+        if (iter.value() == _object) {
+            iter = m_loadedDocumentsByUuid.erase(iter);
+        } else {
+            ++iter;
+        }
+    }
     abstractDelete(_object);
 }
 
+void DocumentMapper::clear()
+{
+    m_loadedDocumentsByUuid.clear();
+    AbstractMapper::clear();
+}
+
 QString DocumentMapper::findStatement(const Identifier& _id) const
 {
     QString findStatement
-        = QString("SELECT " + kColumns + " FROM " + kTableName + " WHERE id = %1 ")
+        = QString("SELECT " + kMetadataColumns + " FROM " + kTableName + " WHERE id = %1 ")
               .arg(_id.value());
     return findStatement;
 }
 
 QString DocumentMapper::findAllStatement() const
 {
-    return "SELECT " + kColumns + " FROM  " + kTableName;
+    return "SELECT " + kMetadataColumns + " FROM  " + kTableName;
 }
 
 QString DocumentMapper::findLastOneStatement() const
@@ -129,7 +172,7 @@ QString DocumentMapper::insertStatement(DomainObject* _object, QVariantList& _in
     _insertValues.append(documentObject->id().value());
     _insertValues.append(documentObject->uuid().toString());
     _insertValues.append(static_cast<int>(documentObject->type()));
-    _insertValues.append(documentObject->content());
+    _insertValues.append(encodedContent(documentObject));
     _insertValues.append(documentObject->syncedAt().isValid()
                              ? documentObject->syncedAt().toString(kDateTimeFormat)
                              : QVariant());
@@ -150,7 +193,7 @@ QString DocumentMapper::updateStatement(DomainObject* _object, QVariantList& _up
     _updateValues.clear();
     _updateValues.append(documentObject->uuid().toString());
     _updateValues.append(static_cast<int>(documentObject->type()));
-    _updateValues.append(documentObject->content());
+    _updateValues.append(encodedContent(documentObject));
     _updateValues.append(documentObject->syncedAt().isValid()
                              ? documentObject->syncedAt().toString(kDateTimeFormat)
                              : QVariant());
@@ -173,11 +216,12 @@ DomainObject* DocumentMapper::doLoad(const Identifier& _id, const QSqlRecord& _r
 {
     const auto uuid = QUuid::fromString(_record.value("uuid").toString());
     const auto type = static_cast<DocumentObjectType>(_record.value("type").toInt());
-    const auto content = _record.value("content").toByteArray();
     const auto syncedAt
         = QDateTime::fromString(_record.value("synced_at").toString(), kDateTimeFormat);
 
-    return Domain::ObjectsBuilder::createDocument(_id, uuid, type, content, syncedAt);
+    auto document = Domain::ObjectsBuilder::createDocument(_id, uuid, type, {}, syncedAt);
+    document->setContentLoader([this, _id] { return loadContent(_id); });
+    return document;
 }
 
 void DocumentMapper::doLoad(DomainObject* _object, const QSqlRecord& _record)
@@ -193,12 +237,69 @@ void DocumentMapper::doLoad(DomainObject* _object, const QSqlRecord& _record)
     const DocumentObjectType type = static_cast<DocumentObjectType>(_record.value("type").toInt());
     documentObject->setType(type);
 
-    const auto content = _record.value("content").toByteArray();
-    documentObject->setContent(content);
+    //
+    // NOTE: Содержимое уже загруженного документа не перечитываем, в памяти оно всегда актуально
+    //
 
     const auto syncedAt
         = QDateTime::fromString(_record.value("synced_at").toString(), kDateTimeFormat);
     documentObject->setSyncedAt(syncedAt);
 }
 
+std::function<std::optional<QByteArray>()> DocumentMapper::concurrentContentLoader(
+    const DocumentObject* _document) const
+{
+    const auto databaseName = DatabaseLayer::Database::currentFile();
+    if (_document->isContentLoaded() || databaseName == ":memory:") {
+        return {};
+    }
+
+    //
+    // Дожидаться записи изменений не нужно, т.к. любое изменение документа, попадающее в базу
+    // данных, сохраняет и его содержимое, а для этого оно загружается
+    //
+    return [databaseName, id = _document->id(), type = _document->type()] {
+        const auto connectionName
+            = QString("document_content_loader [%1]").arg(QUuid::createUuid().toString());
+        std::optional<QByteArray> content;
+        {
+            auto database = QSqlDatabase::addDatabase("QSQLITE", connectionName);
+            database.setDatabaseName(databaseName);
+            if (database.open()) {
+                QSqlQuery query(database);
+                query.prepare("SELECT content FROM " + kTableName + " WHERE id = ? ");
+                query.addBindValue(id.value());
+                if (query.exec() && query.next()) {
+                    content = DocumentContentCodec::tryDecode(query.value(0).toByteArray(), type);
+                }
+            }
+        }
+        QSqlDatabase::removeDatabase(connectionName);
+        return content;
+    };
+}
+
+QByteArray DocumentMapper::loadContent(const Identifier& _id)
+{
+    QSqlQuery& query = DatabaseLayer::Database::preparedQuery(
+        "SELECT type, content FROM " + kTableName + " WHERE id = ? ");
+    query.bindValue(0, _id.value());
+    executeSql(query);
+    QByteArray content;
+    if (query.next()) {
+        const auto type = static_cast<DocumentObjectType>(query.value(0).toInt());
+        content = DocumentContentCodec::decode(query.value(1).toByteArray(), type);
+    }
+    query.finish();
+    return content;
+}
+
+void DocumentMapper::indexDocuments(const QVector<Domain::DomainObject*>& _objects)
+{
+    for (auto object : _objects) {
+        auto document = static_cast<DocumentObject*>(object);
+        m_loadedDocumentsByUuid.insert(document->uuid(), document);
+    }
+}
+
 } // namespace DataMappingLayer
@@ -2,6 +2,12 @@
 
 #include "abstract_mapper.h"
 
+#include <QHash>
+#include <QUuid>
+
+#include <functional>
+#include <optional>
+
 namespace Domain {
 class DocumentObject;
 enum class DocumentObjectType;
@@ -26,6 +32,18 @@ public:
     bool update(Domain::DocumentObject* _object);
     void remove(Domain::DocumentObject* _object);
 
+    void clear() override;
+
+    /**
+     * @brief Получить функцию загрузки содержимого документа, которую можно выполнить в любом
+     *        потоке
+     * @note Функция читает содержимое через собственное соединение с базой данных и возвращает
+     *       пустое значение, если прочитать его не удалось
+     * @return Пустую функцию, если содержимое уже загружено, или база данных размещена в памяти
+     */
+    std::function<std::optional<QByteArray>()> concurrentContentLoader(
+        const Domain::DocumentObject* _document) const;
+
 protected:
     QString findStatement(const Domain::Identifier& _id) const override;
     QString findAllStatement() const override;
@@ -44,6 +62,23 @@ protected:
 private:
     DocumentMapper() = default;
     friend class MapperFacade;
+
+    /**
+     * @brief Загрузить содержимое документа с заданным идентификатором
+     */
+    QByteArray loadContent(const Domain::Identifier& _id);
+
+    /**
+     * @brief Добавить документы в индекс по uuid'ам
+     */
+    void indexDocuments(const QVector<Domain::DomainObject*>& _objects);
+
+    /**
+     * @brief Загруженные документы по их uuid'ам
+     * @note Индекс может отставать от смены uuid'а документа, поэтому найденный в нём документ
+     *       нужно перепроверять
+     */
+    QHash<QUuid, Domain::DocumentObject*> m_loadedDocumentsByUuid;
 };
 
 } // namespace DataMappingLayer
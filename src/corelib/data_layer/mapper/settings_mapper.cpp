@@ -11,21 +11,19 @@ namespace DataMappingLayer {
 
 void SettingsMapper::setValue(const QString& _key, const QString& _value)
 {
-    QSqlQuery q_loader = DatabaseLayer::Database::query();
-    q_loader.prepare("INSERT INTO system_variables VALUES (?, ?)");
-    q_loader.addBindValue(_key);
-    q_loader.addBindValue(_value);
-    q_loader.exec();
+    DatabaseLayer::Database::write("INSERT INTO system_variables VALUES (?, ?)", { _key, _value });
 }
 
 QString SettingsMapper::value(const QString& _key)
 {
-    QSqlQuery q_loader = DatabaseLayer::Database::query();
-    q_loader.prepare("SELECT value FROM system_variables WHERE variable = ?");
-    q_loader.addBindValue(_key);
+    QSqlQuery& q_loader = DatabaseLayer::Database::preparedQuery(
+        "SELECT value FROM system_variables WHERE variable = ?");
+    q_loader.bindValue(0, _key);
     q_loader.exec();
     q_loader.next();
-    return q_loader.value("value").toString();
+    const auto value = q_loader.value("value").toString();
+    q_loader.finish();
+    return value;
 }
 
 SettingsMapper::SettingsMapper() = default;
@@ -7,15 +7,43 @@
 #include <domain/objects_builder.h>
 #include <utils/shugar.h>
 
+#include <QHash>
+
+#include <algorithm>
+
 
 namespace DataStorageLayer {
 
 class DocumentChangeStorage::Implementation
 {
 public:
+    /**
+     * @brief Получить идентификаторы сохранённых изменений документа
+     * @note При первом обращении загружаются из базы данных, а затем поддерживаются в памяти
+     */
+    QVector<Domain::Identifier>& storedChangesIds(const QUuid& _documentUuid);
+
+
     QVector<Domain::DocumentChangeObject*> newDocumentChanges;
+
+    /**
+     * @brief Идентификаторы сохранённых изменений документов в порядке их добавления
+     */
+    QHash<QUuid, QVector<Domain::Identifier>> storedDocumentsChangesIds;
 };
 
+QVector<Domain::Identifier>& DocumentChangeStorage::Implementation::storedChangesIds(
+    const QUuid& _documentUuid)
+{
+    auto iter = storedDocumentsChangesIds.find(_documentUuid);
+    if (iter == storedDocumentsChangesIds.end()) {
+        iter = storedDocumentsChangesIds.insert(
+            _documentUuid,
+            DataMappingLayer::MapperFacade::documentChangeMapper()->findAllIds(_documentUuid));
+    }
+    return iter.value();
+}
+
 
 // ****
 
@@ -50,6 +78,10 @@ void DocumentChangeStorage::removeDocumentChange(Domain::DocumentChangeObject* _
         delete d->newDocumentChanges[changeIndex];
         d->newDocumentChanges.removeAt(changeIndex);
     } else {
+        if (auto ids = d->storedDocumentsChangesIds.find(_change->documentUuid());
+            ids != d->storedDocumentsChangesIds.end()) {
+            ids->removeOne(_change->id());
+        }
         DataMappingLayer::MapperFacade::documentChangeMapper()->remove(_change);
     }
 }
@@ -74,8 +106,56 @@ Domain::DocumentChangeObject* DocumentChangeStorage::documentChangeAt(const QUui
         }
     }
 
-    return DataMappingLayer::MapperFacade::documentChangeMapper()->find(_documentUuid,
-                                                                        correctedChangeIndex);
+    //
+    // ... а если нет, то идём по идентификаторам сохранённых изменений от последнего к первому
+    //
+    // NOTE: Игнорируем самое первое изменение документа, т.к. это добавление стандартной разметки
+    //       элемента в пустой документ
+    //
+    const auto& ids = d->storedChangesIds(_documentUuid);
+    const auto idIndex = ids.size() - 1 - correctedChangeIndex;
+    if (correctedChangeIndex < 0 || idIndex < 1) {
+        return nullptr;
+    }
+
+    return DataMappingLayer::MapperFacade::documentChangeMapper()->find(ids.at(idIndex));
+}
+
+DocumentHistoryState DocumentChangeStorage::documentStateAt(const QUuid& _documentUuid,
+                                                            const QDateTime& _dateTime)
+{
+    auto mapper = DataMappingLayer::MapperFacade::documentChangeMapper();
+    const auto changeId = mapper->findLastId(_documentUuid, _dateTime);
+    if (!changeId.isValid()) {
+        return {};
+    }
+
+    //
+    // Берём ближайший снимок и патчи только тех изменений, которые были сделаны после него
+    //
+    const auto keyframe = mapper->findKeyframe(_documentUuid, changeId);
+    return { keyframe.content,
+             mapper->findRedoPatches(_documentUuid, keyframe.changeId, changeId) };
+}
+
+void DocumentChangeStorage::forgetMergedDocumentChanges(
+    const QUuid& _documentUuid, const QVector<Domain::Identifier>& _removedChangesIds,
+    const Domain::Identifier& _mergedChangeId)
+{
+    //
+    // Удалённые изменения идут в списке сохранённых подряд, перед объединённым изменением
+    //
+    if (auto ids = d->storedDocumentsChangesIds.find(_documentUuid);
+        !_removedChangesIds.isEmpty() && ids != d->storedDocumentsChangesIds.end()) {
+        const auto first
+            = std::lower_bound(ids->begin(), ids->end(), _removedChangesIds.constFirst());
+        const auto last = std::lower_bound(first, ids->end(), _mergedChangeId);
+        ids->erase(first, last);
+    }
+
+    auto mapper = DataMappingLayer::MapperFacade::documentChangeMapper();
+    mapper->forget(_removedChangesIds);
+    mapper->forget({ _mergedChangeId });
 }
 
 QVector<QUuid> DocumentChangeStorage::unsyncedDocuments()
@@ -119,11 +199,18 @@ QVector<Domain::DocumentChangeObject*> DocumentChangeStorage::unsyncedDocumentCh
 
 void DocumentChangeStorage::store()
 {
+    //
+    // Все новые изменения сохраняем одним пакетным запросом
+    //
     DatabaseLayer::Database::transaction();
-    while (!d->newDocumentChanges.isEmpty()) {
-        auto change = d->newDocumentChanges.takeFirst();
-        DataMappingLayer::MapperFacade::documentChangeMapper()->insert(change);
+    DataMappingLayer::MapperFacade::documentChangeMapper()->insert(d->newDocumentChanges);
+    for (const auto change : std::as_const(d->newDocumentChanges)) {
+        if (auto ids = d->storedDocumentsChangesIds.find(change->documentUuid());
+            ids != d->storedDocumentsChangesIds.end()) {
+            ids->append(change->id());
+        }
     }
+    d->newDocumentChanges.clear();
     DatabaseLayer::Database::commit();
 }
 
@@ -131,6 +218,7 @@ void DocumentChangeStorage::removeAll()
 {
     qDeleteAll(d->newDocumentChanges);
     d->newDocumentChanges.clear();
+    d->storedDocumentsChangesIds.clear();
     DataMappingLayer::MapperFacade::documentChangeMapper()->removeAll();
     DatabaseLayer::Database::vacuum();
 }
@@ -139,6 +227,7 @@ void DocumentChangeStorage::clear()
 {
     qDeleteAll(d->newDocumentChanges);
     d->newDocumentChanges.clear();
+    d->storedDocumentsChangesIds.clear();
     DataMappingLayer::MapperFacade::documentChangeMapper()->clear();
 }
 
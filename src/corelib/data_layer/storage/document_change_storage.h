@@ -1,8 +1,11 @@
 #pragma once
 
+#include <QByteArray>
 #include <QScopedPointer>
+#include <QVector>
 
 #include <corelib_global.h>
+#include <domain/identifier.h>
 
 class QDateTime;
 class QUuid;
@@ -14,6 +17,21 @@ class DocumentChangeObject;
 
 namespace DataStorageLayer {
 
+/**
+ * @brief Данные для восстановления документа в состоянии после одного из его изменений
+ */
+struct CORE_LIBRARY_EXPORT DocumentHistoryState {
+    /**
+     * @brief Содержимое ближайшего предшествующего снимка документа, пустое, если снимка нет
+     */
+    QByteArray content;
+
+    /**
+     * @brief Патчи повтора изменений, которые нужно по порядку наложить на содержимое снимка
+     */
+    QVector<QByteArray> redoPatches;
+};
+
 /**
  * @brief Хранилище изменений документов
  */
@@ -49,6 +67,21 @@ public:
      */
     Domain::DocumentChangeObject* documentChangeAt(const QUuid& _documentUuid, int _changeIndex);
 
+    /**
+     * @brief Получить данные для восстановления документа в состоянии на заданный момент
+     * @note Учитываются только сохранённые изменения
+     */
+    DocumentHistoryState documentStateAt(const QUuid& _documentUuid, const QDateTime& _dateTime);
+
+    /**
+     * @brief Учесть, что серия изменений документа была объединена в последнее её изменение
+     * @note Изменения объединяются в обход хранилища, поэтому удалённые изменения убираются из
+     *       списка сохранённых, а их загруженные объекты перестают использоваться маппером
+     */
+    void forgetMergedDocumentChanges(const QUuid& _documentUuid,
+                                     const QVector<Domain::Identifier>& _removedChangesIds,
+                                     const Domain::Identifier& _mergedChangeId);
+
     /**
      * @brief Список не синхронизированных документов
      */
@@ -5,13 +5,112 @@
 #include <domain/document_object.h>
 #include <utils/helpers/image_helper.h>
 
+#include <QBuffer>
 #include <QCache>
+#include <QFutureWatcher>
 #include <QHash>
+#include <QImageReader>
 #include <QPixmap>
+#include <QSet>
+#include <QtConcurrentRun>
+
+#include <algorithm>
+#include <limits>
 
 
 namespace DataStorageLayer {
 
+namespace {
+
+/**
+ * @brief Максимальный объём памяти, занимаемый кэшем полноразмерных изображений
+ */
+const int kImagesCacheMaxCost = 256 * 1024 * 1024;
+
+/**
+ * @brief Максимальный объём памяти, занимаемый кэшем миниатюр
+ */
+const int kThumbnailsCacheMaxCost = 32 * 1024 * 1024;
+
+/**
+ * @brief Размер миниатюры изображения
+ */
+const QSize kThumbnailSize(256, 256);
+
+/**
+ * @brief Сформировать миниатюру изображения
+ */
+template<typename Image>
+Image makeThumbnail(const Image& _image)
+{
+    if (_image.width() <= kThumbnailSize.width() && _image.height() <= kThumbnailSize.height()) {
+        return _image;
+    }
+
+    return _image.scaled(kThumbnailSize, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+}
+
+/**
+ * @brief Декодированное изображение вместе с его миниатюрой
+ */
+struct DecodedImage {
+    QImage image;
+    QImage thumbnail;
+};
+
+/**
+ * @brief Декодировать изображение из массива байт
+ * @note Выполняется в фоновом потоке, поэтому работаем только с QImage
+ */
+DecodedImage decodeImageData(const QByteArray& _imageData)
+{
+    QBuffer buffer;
+    buffer.setData(_imageData);
+    buffer.open(QIODevice::ReadOnly);
+    QImageReader reader(&buffer);
+
+    DecodedImage result;
+    result.image = reader.read();
+    if (result.image.isNull()) {
+        return result;
+    }
+
+    result.thumbnail = makeThumbnail(result.image);
+    return result;
+}
+
+/**
+ * @brief Декодировать из массива байт сразу миниатюру изображения
+ * @note Многие форматы (например JPEG) умеют декодироваться сразу в уменьшенном размере, что
+ *       намного быстрее полного декодирования, поэтому миниатюра будет готова заметно раньше
+ */
+QImage decodeThumbnailData(const QByteArray& _imageData)
+{
+    QBuffer buffer;
+    buffer.setData(_imageData);
+    buffer.open(QIODevice::ReadOnly);
+    QImageReader reader(&buffer);
+
+    const auto size = reader.size();
+    if (size.isValid()
+        && (size.width() > kThumbnailSize.width() || size.height() > kThumbnailSize.height())) {
+        reader.setScaledSize(size.scaled(kThumbnailSize, Qt::KeepAspectRatio));
+    }
+    return reader.read();
+}
+
+/**
+ * @brief Определить сколько памяти занимает изображение
+ */
+int imageCost(const QPixmap& _image)
+{
+    const qint64 cost = qint64(_image.width()) * _image.height() * _image.depth() / 8;
+    return static_cast<int>(std::clamp<qint64>(cost, 1, std::numeric_limits<int>::max()));
+}
+
+} // namespace
+
+
 class DocumentImageStorage::Implementation
 {
 public:
@@ -22,18 +121,51 @@ public:
      */
     void notifyImageRequested(const QUuid& _uuid) const;
 
+    /**
+     * @brief Запустить декодирование изображения в фоновом потоке
+     * @param _isUpdated Изображение было обновлено, а не просто загружено из базы
+     */
+    void decodeImage(const QUuid& _uuid, const QByteArray& _imageData, bool _isUpdated);
+
+    /**
+     * @brief Отменить декодирование изображения, если оно было запущено
+     */
+    void cancelDecoding(const QUuid& _uuid);
+
+    /**
+     * @brief Поместить изображение и его миниатюру в кэш
+     */
+    void cacheImage(const QUuid& _uuid, const QPixmap& _image, const QPixmap& _thumbnail);
+
 
     DocumentImageStorage* q = nullptr;
 
     /**
-     * @brief Кэш загруженных изображений
+     * @brief Кэш загруженных изображений, стоимость элемента - объём занимаемой им памяти
      */
     mutable QCache<QUuid, QPixmap> cachedImages;
 
+    /**
+     * @brief Кэш миниатюр изображений, используемых в качестве заглушек, пока изображение
+     *        декодируется
+     */
+    QCache<QUuid, QPixmap> cachedThumbnails;
+
+    /**
+     * @brief Изображения, декодируемые в данный момент
+     */
+    QHash<QUuid, QFutureWatcher<DecodedImage>*> decodingImages;
+
+    /**
+     * @brief Миниатюры, декодируемые параллельно с ещё не загруженными изображениями
+     */
+    QHash<QUuid, QFutureWatcher<QImage>*> decodingThumbnails;
+
     /**
      * @brief Список новых изображений
+     * @note Сами данные изображений хранятся в их документах
      */
-    mutable QHash<QUuid, QPixmap> newImages;
+    QSet<QUuid> newImages;
 
     /**
      * @brief Список изображений на удаление
@@ -44,6 +176,8 @@ public:
 DocumentImageStorage::Implementation::Implementation(DocumentImageStorage* _q)
     : q(_q)
 {
+    cachedImages.setMaxCost(kImagesCacheMaxCost);
+    cachedThumbnails.setMaxCost(kThumbnailsCacheMaxCost);
 }
 
 void DocumentImageStorage::Implementation::notifyImageRequested(const QUuid& _uuid) const
@@ -52,6 +186,100 @@ void DocumentImageStorage::Implementation::notifyImageRequested(const QUuid& _uu
         q, [this, _uuid] { emit q->imageRequested(_uuid); }, Qt::QueuedConnection);
 }
 
+void DocumentImageStorage::Implementation::decodeImage(const QUuid& _uuid,
+                                                       const QByteArray& _imageData,
+                                                       bool _isUpdated)
+{
+    //
+    // Результат ранее запущенного декодирования уже не актуален
+    //
+    cancelDecoding(_uuid);
+
+    auto watcher = new QFutureWatcher<DecodedImage>(q);
+    QObject::connect(watcher, &QFutureWatcher<DecodedImage>::finished, q,
+                     [this, _uuid, _isUpdated, watcher] {
+                         decodingImages.remove(_uuid);
+                         watcher->deleteLater();
+
+                         //
+                         // Конвертируем в QPixmap уже в потоке интерфейса
+                         //
+                         const auto decodedImage = watcher->result();
+                         const auto image = QPixmap::fromImage(decodedImage.image);
+                         const auto thumbnail = QPixmap::fromImage(decodedImage.thumbnail);
+                         cacheImage(_uuid, image, thumbnail);
+
+                         if (_isUpdated) {
+                             emit q->imageUpdated(_uuid, image);
+                         } else {
+                             emit q->imageLoaded(_uuid, image);
+                         }
+                     });
+    decodingImages.insert(_uuid, watcher);
+    watcher->setFuture(QtConcurrent::run(decodeImageData, _imageData));
+
+    //
+    // Если миниатюры ещё нет, то параллельно декодируем и её, чтобы показать хотя бы уменьшенное
+    // изображение, пока полноразмерное декодируется
+    //
+    if (_isUpdated || cachedThumbnails.contains(_uuid)) {
+        return;
+    }
+
+    auto thumbnailWatcher = new QFutureWatcher<QImage>(q);
+    QObject::connect(thumbnailWatcher, &QFutureWatcher<QImage>::finished, q,
+                     [this, _uuid, thumbnailWatcher] {
+                         decodingThumbnails.remove(_uuid);
+                         thumbnailWatcher->deleteLater();
+
+                         //
+                         // Если полноразмерное изображение уже готово, то миниатюра не нужна
+                         //
+                         const auto thumbnailImage = thumbnailWatcher->result();
+                         if (!decodingImages.contains(_uuid) || thumbnailImage.isNull()) {
+                             return;
+                         }
+
+                         const auto thumbnail = QPixmap::fromImage(thumbnailImage);
+                         cachedThumbnails.insert(_uuid, new QPixmap(thumbnail),
+                                                 imageCost(thumbnail));
+                         emit q->imageLoaded(_uuid, thumbnail);
+                     });
+    decodingThumbnails.insert(_uuid, thumbnailWatcher);
+    thumbnailWatcher->setFuture(QtConcurrent::run(decodeThumbnailData, _imageData));
+}
+
+void DocumentImageStorage::Implementation::cancelDecoding(const QUuid& _uuid)
+{
+    //
+    // Сам поток прервать нельзя, поэтому просто не ждём его результата
+    //
+    if (auto watcher = decodingThumbnails.take(_uuid); watcher != nullptr) {
+        watcher->disconnect(q);
+        watcher->deleteLater();
+    }
+
+    auto watcher = decodingImages.take(_uuid);
+    if (watcher == nullptr) {
+        return;
+    }
+
+    watcher->disconnect(q);
+    watcher->deleteLater();
+}
+
+void DocumentImageStorage::Implementation::cacheImage(const QUuid& _uuid, const QPixmap& _image,
+                                                      const QPixmap& _thumbnail)
+{
+    //
+    // NOTE: Если изображение больше всего кэша, то QCache его просто не сохранит
+    //
+    cachedImages.insert(_uuid, new QPixmap(_image), imageCost(_image));
+    if (!_thumbnail.isNull()) {
+        cachedThumbnails.insert(_uuid, new QPixmap(_thumbnail), imageCost(_thumbnail));
+    }
+}
+
 
 // ****
 
@@ -70,10 +298,6 @@ QPixmap DocumentImageStorage::load(const QUuid& _uuid) const
         return {};
     }
 
-    if (auto imageIter = d->newImages.find(_uuid); imageIter != d->newImages.end()) {
-        return imageIter.value();
-    }
-
     if (d->cachedImages.contains(_uuid)) {
         auto cachedImage = d->cachedImages[_uuid];
         if (cachedImage == nullptr) {
@@ -82,14 +306,32 @@ QPixmap DocumentImageStorage::load(const QUuid& _uuid) const
         return *cachedImage;
     }
 
+    //
+    // Пока изображение декодируется, отдаём его миниатюру, если она есть
+    //
+    const auto placeholder = [this, &_uuid]() -> QPixmap {
+        auto thumbnail = d->cachedThumbnails[_uuid];
+        if (thumbnail == nullptr) {
+            return {};
+        }
+        return *thumbnail;
+    };
+    if (d->decodingImages.contains(_uuid)) {
+        return placeholder();
+    }
+
     //
     // Загружаем изображение
     //
     auto imageDocument = StorageFacade::documentStorage()->document(_uuid);
     //
-    // ... подписываемся на его обновления (и загружаем, если не был ещё загружен из облака)
+    // ... подписываемся на его обновления (и загружаем, если не был ещё загружен из облака),
+    //     но только для изображений, которые ещё не загружали, т.к. вытесненные из кэша
+    //     изображения уже есть в базе и их нужно лишь декодировать повторно
     //
-    d->notifyImageRequested(_uuid);
+    if (!d->cachedThumbnails.contains(_uuid) && !d->newImages.contains(_uuid)) {
+        d->notifyImageRequested(_uuid);
+    }
     //
     // ... если изображения пока нет в базе, то поставим в кэш заглушку для него
     //
@@ -101,12 +343,45 @@ QPixmap DocumentImageStorage::load(const QUuid& _uuid) const
     Q_ASSERT(imageDocument->type() == Domain::DocumentObjectType::ImageData);
 
     //
-    // NOTE: тут грузим вручную, а не через Imagehelper т.к. в кэш нужен именно указатель
+    // ... а само декодирование выполняем в фоновом потоке, результат придёт через imageLoaded
+    //
+    d->decodeImage(_uuid, imageDocument->content(), false);
+    return placeholder();
+}
+
+QPixmap DocumentImageStorage::loadFullSize(const QUuid& _uuid) const
+{
+    if (_uuid.isNull()) {
+        return {};
+    }
+
+    if (auto cachedImage = d->cachedImages.object(_uuid); cachedImage != nullptr) {
+        return *cachedImage;
+    }
+
+    //
+    // Если изображение уже декодируется, то дожидаемся окончания, а в кэш его поместит
+    // обработчик завершения декодирования
+    //
+    if (auto watcher = d->decodingImages.value(_uuid); watcher != nullptr) {
+        watcher->waitForFinished();
+        return QPixmap::fromImage(watcher->result().image);
+    }
+
     //
-    QPixmap* image = new QPixmap;
-    image->loadFromData(imageDocument->content());
-    d->cachedImages.insert(_uuid, image);
-    return *image;
+    // Если изображения ещё нет в базе, то запрашиваем его как обычно
+    //
+    auto imageDocument = StorageFacade::documentStorage()->document(_uuid);
+    if (imageDocument == nullptr) {
+        return load(_uuid);
+    }
+
+    Q_ASSERT(imageDocument->type() == Domain::DocumentObjectType::ImageData);
+
+    const auto decodedImage = decodeImageData(imageDocument->content());
+    const auto image = QPixmap::fromImage(decodedImage.image);
+    d->cacheImage(_uuid, image, QPixmap::fromImage(decodedImage.thumbnail));
+    return image;
 }
 
 QUuid DocumentImageStorage::save(const QPixmap& _image)
@@ -116,10 +391,14 @@ QUuid DocumentImageStorage::save(const QPixmap& _image)
     }
 
     //
-    // Сохраним изображение во временный буфер
+    // Запомним новое изображение
     //
     const QUuid uuid = QUuid::createUuid();
-    d->newImages.insert(uuid, _image);
+    d->newImages.insert(uuid);
+    //
+    // ... положим в кэш, т.к. изображение уже декодировано
+    //
+    d->cacheImage(uuid, _image, makeThumbnail(_image));
     //
     // ... положим в хранилище
     //
@@ -146,18 +425,7 @@ void DocumentImageStorage::save(const QUuid& _uuid, const QByteArray& _imageData
     }
 
     //
-    // Сохраним изображение во временный буфер
-    //
-    const auto image = ImageHelper::imageFromBytes(_imageData);
-    d->newImages.insert(_uuid, image);
-    //
-    // ... уберём заглушку из кэша, если она там была
-    //
-    if (d->cachedImages.contains(_uuid)) {
-        d->cachedImages.remove(_uuid);
-    }
-    //
-    // ... положим в хранилище, если ещё не был сохранён
+    // Положим в хранилище, если ещё не был сохранён
     //
     auto document = StorageFacade::documentStorage()->document(_uuid);
     if (document == nullptr) {
@@ -171,10 +439,15 @@ void DocumentImageStorage::save(const QUuid& _uuid, const QByteArray& _imageData
         return;
     }
     document->setContent(_imageData);
+    d->newImages.insert(_uuid);
+    //
+    // ... уберём из кэша заглушку, или прежнюю версию изображения
+    //
+    d->cachedImages.remove(_uuid);
     //
-    // ... уведомляем об обновлении изображения
+    // ... и декодируем новое, по окончании уведомим об обновлении изображения
     //
-    emit imageUpdated(_uuid, image);
+    d->decodeImage(_uuid, _imageData, true);
 }
 
 void DocumentImageStorage::remove(const QUuid& _uuid)
@@ -186,6 +459,7 @@ void DocumentImageStorage::remove(const QUuid& _uuid)
     if (!d->newImages.remove(_uuid)) {
         d->imagesToRemove.append(_uuid);
     }
+    d->cancelDecoding(_uuid);
     emit imageRemoved(_uuid);
 }
 
@@ -202,8 +476,8 @@ void DocumentImageStorage::clear()
 
 void DocumentImageStorage::saveChanges()
 {
-    for (auto imageIter = d->newImages.begin(); imageIter != d->newImages.end(); ++imageIter) {
-        StorageFacade::documentStorage()->saveDocument(imageIter.key());
+    for (const auto& uuid : std::as_const(d->newImages)) {
+        StorageFacade::documentStorage()->saveDocument(uuid);
     }
     d->newImages.clear();
 
@@ -25,9 +25,17 @@ public:
      *        - из кэша
      *        - загрузить из базы
      *        - если нигде нет, то запросить у внешнего сервиса
+     * @note Из базы изображение декодируется в фоновом потоке, а пока этого не произошло
+     *       возвращается его миниатюра, если она есть
      */
     QPixmap load(const QUuid& _uuid) const override;
 
+    /**
+     * @brief Получить изображение в полном разрешении
+     * @note Если изображения нет в кэше, то оно декодируется прямо в текущем потоке
+     */
+    QPixmap loadFullSize(const QUuid& _uuid) const override;
+
     /**
      * @brief Сохранить новое изображение
      */
@@ -85,6 +85,12 @@ QVector<Domain::DocumentObject*> DocumentStorage::documents()
     return documents;
 }
 
+std::function<std::optional<QByteArray>()> DocumentStorage::concurrentContentLoader(
+    const Domain::DocumentObject* _document) const
+{
+    return DataMappingLayer::MapperFacade::documentMapper()->concurrentContentLoader(_document);
+}
+
 Domain::DocumentObject* DocumentStorage::createDocument(const QUuid& _uuid,
                                                         Domain::DocumentObjectType _type)
 {
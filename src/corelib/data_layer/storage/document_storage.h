@@ -1,11 +1,14 @@
 #pragma once
 
+#include <QByteArray>
 #include <QScopedPointer>
 #include <QtContainerFwd>
 
 #include <corelib_global.h>
 
-class QByteArray;
+#include <functional>
+#include <optional>
+
 class QUuid;
 
 namespace Domain {
@@ -45,6 +48,14 @@ public:
      */
     QVector<Domain::DocumentObject*> documents();
 
+    /**
+     * @brief Получить функцию загрузки содержимого документа, которую можно выполнить в любом
+     *        потоке
+     * @return Пустую функцию, если содержимое нужно получать у самого документа
+     */
+    std::function<std::optional<QByteArray>()> concurrentContentLoader(
+        const Domain::DocumentObject* _document) const;
+
     /**
      * @brief Сохранить документ
      */
@@ -3,6 +3,7 @@
 #include <business_layer/templates/comic_book_template.h>
 #include <business_layer/templates/screenplay_template.h>
 #include <business_layer/templates/simple_text_template.h>
+#include <data_layer/database.h>
 #include <data_layer/mapper/mapper_facade.h>
 #include <data_layer/mapper/settings_mapper.h>
 #include <ui/design_system/design_system.h>
@@ -103,6 +104,14 @@ SettingsStorage::Implementation::Implementation()
                          QStandardPaths::writableLocation(QStandardPaths::DocumentsLocation)
                              + "/starc/backups");
     defaultValues.insert(kApplicationBackupsQtyKey, 7);
+    {
+        const DatabaseLayer::Database::StorageProfile storageProfile;
+        defaultValues.insert(kApplicationUseWriteAheadLogKey, storageProfile.useWriteAheadLog);
+        defaultValues.insert(kApplicationStorageCacheSizeKey, storageProfile.cacheSizeKib);
+        defaultValues.insert(kApplicationStorageMmapSizeKey, storageProfile.mmapSize);
+        defaultValues.insert(kApplicationCompressDocumentsContentKey,
+                             storageProfile.compressDocumentsContent);
+    }
     defaultValues.insert(kApplicationShowDocumentsPagesKey, true);
     defaultValues.insert(kApplicationUseTypewriterSoundKey, false);
     defaultValues.insert(kApplicationUseSpellCheckerKey, false);
@@ -61,6 +61,15 @@ const QString kApplicationSaveBackupsKey = kApplicationGroupKey + "/save-backups
 const QString kApplicationBackupsFolderKey = kApplicationGroupKey + "/backups-folder";
 // максимальное кол-во бекапов для сохранения
 const QString kApplicationBackupsQtyKey = kApplicationGroupKey + "/backups-qty";
+// вести ли журнал упреждающей записи в файлах проектов
+const QString kApplicationUseWriteAheadLogKey = kApplicationGroupKey + "/use-write-ahead-log";
+// размер кэша страниц файла проекта в килобайтах
+const QString kApplicationStorageCacheSizeKey = kApplicationGroupKey + "/storage-cache-size";
+// размер отображаемой в память части файла проекта в байтах, 0 - не отображать
+const QString kApplicationStorageMmapSizeKey = kApplicationGroupKey + "/storage-mmap-size";
+// сохранять ли содержимое документов проектов в сжатом виде
+const QString kApplicationCompressDocumentsContentKey
+    = kApplicationGroupKey + "/compress-documents-content";
 // показывать ли страницы текстовых документов
 const QString kApplicationShowDocumentsPagesKey = kApplicationGroupKey + "/show-documents-pages";
 // включены ли звуки печатной машинки при наборе текста
@@ -177,11 +177,26 @@ void DocumentObject::setType(DocumentObjectType _type)
 
 const QByteArray& DocumentObject::content() const
 {
+    if (m_contentLoader) {
+        m_content = m_contentLoader();
+        m_contentLoader = {};
+    }
+
     return m_content;
 }
 
 void DocumentObject::setContent(const QByteArray& _content)
 {
+    //
+    // Если содержимое ещё не загружено, то и сравнивать новое не с чем
+    //
+    if (m_contentLoader) {
+        m_contentLoader = {};
+        m_content = _content;
+        markChangesNotStored();
+        return;
+    }
+
     //
     // NOTE: Тут специально нет проверки, т.к. данные могут быть очень большими
     //
@@ -195,6 +210,16 @@ void DocumentObject::setContent(const QByteArray& _content)
     markChangesNotStored();
 }
 
+void DocumentObject::setContentLoader(const std::function<QByteArray()>& _loader)
+{
+    m_contentLoader = _loader;
+}
+
+bool DocumentObject::isContentLoaded() const
+{
+    return !m_contentLoader;
+}
+
 const QDateTime& DocumentObject::syncedAt() const
 {
     return m_syncedAt;
@@ -6,6 +6,8 @@
 #include <QPixmap>
 #include <QUuid>
 
+#include <functional>
+
 namespace Domain {
 
 /**
@@ -154,6 +156,17 @@ public:
     const QByteArray& content() const;
     void setContent(const QByteArray& _content);
 
+    /**
+     * @brief Задать функцию отложенной загрузки содержимого
+     * @note Содержимое загружается единожды, при первом обращении к нему
+     */
+    void setContentLoader(const std::function<QByteArray()>& _loader);
+
+    /**
+     * @brief Загружено ли содержимое документа
+     */
+    bool isContentLoaded() const;
+
     /**
      * @brief Дата и время последней синхронизации
      */
@@ -178,7 +191,12 @@ private:
     /**
      * @brief Содержимое объекта
      */
-    QByteArray m_content;
+    mutable QByteArray m_content;
+
+    /**
+     * @brief Функция загрузки содержимого, если оно ещё не было загружено
+     */
+    mutable std::function<QByteArray()> m_contentLoader;
 
     /**
      * @brief Дата время последней синхронизации содержимого документа
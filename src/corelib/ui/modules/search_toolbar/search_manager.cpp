@@ -4,13 +4,17 @@
 
 #include <business_layer/document/text/text_block_data.h>
 #include <business_layer/document/text/text_cursor.h>
+#include <business_layer/document/text/text_document.h>
+#include <business_layer/model/text/text_model.h>
 #include <business_layer/model/text/text_model_group_item.h>
 #include <business_layer/model/text/text_model_text_item.h>
+#include <business_layer/search/search_index.h>
 #include <business_layer/templates/novel_template.h>
 #include <business_layer/templates/text_template.h>
 #include <utils/helpers/text_helper.h>
 #include <utils/shugar.h>
 
+#include <QPointer>
 #include <QTextBlock>
 
 
@@ -33,6 +37,12 @@ public:
     void findText(bool _backward);
     void findNumber();
 
+    /**
+     * @brief Найти текст при помощи индекса
+     * @return Удалось ли найти вхождение, если нет, то нужно искать прямо в документе
+     */
+    bool findTextInIndex(bool _backward);
+
 
     /**
      * @brief Панель поиска
@@ -44,6 +54,11 @@ public:
      */
     BaseTextEdit* textEdit = nullptr;
 
+    /**
+     * @brief Индекс для поиска по тексту документов проекта
+     */
+    QPointer<SearchIndex> searchIndex;
+
     /**
      * @brief Последний искомый текст
      */
@@ -83,7 +98,7 @@ void SearchManager::Implementation::find(bool _backward)
 
     if (searchText.startsWith("#")) {
         findNumber();
-    } else {
+    } else if (!findTextInIndex(_backward)) {
         findText(_backward);
     }
 
@@ -167,6 +182,116 @@ void SearchManager::Implementation::findText(bool _backward)
     m_lastSearchText = searchText;
 }
 
+bool SearchManager::Implementation::findTextInIndex(bool _backward)
+{
+    //
+    // Индекс ищет без учёта регистра и только от начала слов, поэтому поиск с учётом регистра
+    // выполняем прямо в документе
+    //
+    if (searchIndex.isNull() || toolbar->isCaseSensitive()) {
+        return false;
+    }
+
+    auto document = qobject_cast<TextDocument*>(textEdit->document());
+    if (document == nullptr || document->model() == nullptr) {
+        return false;
+    }
+
+    const QString searchText = toolbar->searchText();
+    const auto searchType = searchInType();
+    QSet<TextParagraphType> types;
+    if (searchType != TextParagraphType::Undefined) {
+        types.insert(searchType);
+    }
+
+    //
+    // Индекс сравнивает слова без учёта знаков препинания между ними
+    //
+    auto normalized = [](const QString& _text) {
+        QString result;
+        for (const auto& character : _text) {
+            if (character.isLetterOrNumber()) {
+                result.append(character);
+            }
+        }
+        return TextHelper::smartToLower(result);
+    };
+    const auto normalizedSearchText = normalized(searchText);
+
+    //
+    // Определяем позиции вхождений в текущем документе, пропуская скрытые блоки, а также те,
+    // текст которых в документе уже не соответствует индексу
+    //
+    struct Match {
+        int position = 0;
+        int length = 0;
+    };
+    QVector<Match> matches;
+    const auto model = document->model();
+    const auto results = searchIndex->find(searchText, types);
+    for (const auto& result : results) {
+        if (result.model != model || result.item == nullptr) {
+            continue;
+        }
+
+        const auto itemPosition = document->itemStartPosition(model->indexForItem(result.item));
+        if (itemPosition < 0) {
+            continue;
+        }
+
+        const auto block = document->findBlock(itemPosition);
+        if (!block.isValid() || !block.isVisible()
+            || normalized(block.text().mid(result.position, result.length))
+                != normalizedSearchText) {
+            continue;
+        }
+
+        matches.append({ itemPosition + result.position, result.length });
+    }
+    if (matches.isEmpty()) {
+        return false;
+    }
+
+    //
+    // Берём ближайшее к курсору вхождение в направлении поиска, а если достигнут конец, или
+    // начало документа, то зацикливаем поиск
+    //
+    const TextCursor cursor = textEdit->textCursor();
+    const auto selectionInterval = cursor.selectionInterval();
+    //
+    // ... новый текст ищем от начала выделения, а при повторном поиске пропускаем выделенное
+    //
+    const auto from = _backward || searchText != m_lastSearchText ? selectionInterval.from
+                                                                  : selectionInterval.to;
+    auto match = _backward ? matches.constLast() : matches.constFirst();
+    if (_backward) {
+        for (auto iter = matches.crbegin(); iter != matches.crend(); ++iter) {
+            if (iter->position < from) {
+                match = *iter;
+                break;
+            }
+        }
+    } else {
+        for (const auto& candidate : std::as_const(matches)) {
+            if (candidate.position >= from) {
+                match = candidate;
+                break;
+            }
+        }
+    }
+
+    TextCursor matchCursor = cursor;
+    matchCursor.setPosition(match.position);
+    matchCursor.setPosition(match.position + match.length, QTextCursor::KeepAnchor);
+    textEdit->ensureCursorVisible(matchCursor);
+
+    //
+    // Сохраняем искомый текст
+    //
+    m_lastSearchText = searchText;
+    return true;
+}
+
 void SearchManager::Implementation::findNumber()
 {
     //
@@ -324,6 +449,11 @@ void SearchManager::setSearchInBlockTypes(
     d->toolbar->setPopupStringList(list);
 }
 
+void SearchManager::setSearchIndex(SearchIndex* _index)
+{
+    d->searchIndex = _index;
+}
+
 void SearchManager::setReadOnly(bool _readOnly)
 {
     d->toolbar->setReadOnly(_readOnly);
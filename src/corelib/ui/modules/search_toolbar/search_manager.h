@@ -12,6 +12,7 @@ class SearchToolbar;
 
 namespace BusinessLayer {
 
+class SearchIndex;
 enum class TextParagraphType;
 
 class CORE_LIBRARY_EXPORT SearchManager : public QObject
@@ -32,6 +33,12 @@ public:
      */
     void setSearchInBlockTypes(const QVector<QPair<QString, TextParagraphType>>& _blockTypes);
 
+    /**
+     * @brief Задать индекс для поиска по тексту документов проекта
+     * @note Если индекс не задан, или в нём нет подходящих вхождений, то ищем прямо в документе
+     */
+    void setSearchIndex(SearchIndex* _index);
+
     /**
      * @brief Настроить режим редактирования
      */
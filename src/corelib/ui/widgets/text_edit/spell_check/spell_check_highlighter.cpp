@@ -2,20 +2,92 @@
 
 #include "spell_checker.h"
 
+#include <QFutureWatcher>
+#include <QPointer>
 #include <QRegularExpression>
+#include <QSet>
 #include <QTextDocument>
 #include <QTimer>
+#include <QtConcurrentRun>
+
+#include <algorithm>
 
 
 namespace {
 const int kInvalidCursorPosition = -1;
+
+/**
+ * @brief Количество слов, проверяемых в фоне за один раз
+ */
+const int kWordsToCheckBatchSize = 500;
+
+/**
+ * @brief Слово текста вместе с его позицией
+ */
+struct Word {
+    int position = 0;
+    QString text;
+};
+
+/**
+ * @brief Разбить текст на слова, которые нужно проверять
+ */
+QVector<Word> wordsToCheck(const QString& _text)
+{
+    if (_text.simplified().isEmpty()) {
+        return {};
+    }
+
+    //
+    // Убираем пустоты из проверяемого текста
+    //
+    const static QRegularExpression notWord("([^\\w'’-]|·)+",
+                                            QRegularExpression::UseUnicodePropertiesOption);
+    //
+    // Собираем каждое слово
+    //
+    QVector<Word> words;
+    int wordPos = 0;
+    int notWordLength = 1;
+    int notWordPos = 0;
+    for (wordPos = 0; wordPos < _text.length(); wordPos = notWordPos + notWordLength) {
+        //
+        // Получим окончание слова
+        //
+        const auto match = notWord.match(_text, wordPos);
+        if (match.hasMatch()) {
+            notWordPos = match.capturedStart();
+            notWordLength = std::max(1, match.capturedLength());
+        } else {
+            notWordPos = _text.length();
+        }
+
+        //
+        // Проверяем слова длинной более одного символа
+        //
+        if (notWordPos - wordPos > 1) {
+            words.append({ wordPos, _text.mid(wordPos, notWordPos - wordPos) });
+        }
+    }
+    return words;
 }
 
+} // namespace
+
 
 class SpellCheckHighlighter::Implementation
 {
 public:
-    explicit Implementation(const SpellChecker& _checker);
+    Implementation(SpellCheckHighlighter* _q, const SpellChecker& _checker);
+
+    /**
+     * @brief Запустить фоновую проверку слов из очередных блоков, ожидающих проверки
+     */
+    void checkNextBlocks();
+
+
+    SpellCheckHighlighter* q = nullptr;
+
     /**
      * @brief Проверяющий орфографию
      */
@@ -43,10 +115,45 @@ public:
      * @brief Таймер перепроверки текущего абзаца после изменения положения курсора
      */
     QTimer recheckTimer;
+
+    /**
+     * @brief Видимая на экране область документа
+     */
+    struct {
+        int from = 0;
+        int to = 0;
+    } visibleRange;
+
+    /**
+     * @brief Документ, к которому относятся блоки, ожидающие проверки
+     */
+    QPointer<QTextDocument> blocksDocument;
+
+    /**
+     * @brief Блоки, в которых есть ещё не проверенные слова
+     */
+    QVector<QTextBlock> blocksToCheck;
+
+    /**
+     * @brief Блоки, слова которых проверяются в данный момент
+     */
+    QVector<QTextBlock> checkingBlocks;
+
+    /**
+     * @brief Таймер запуска фоновой проверки
+     */
+    QTimer checkTimer;
+
+    /**
+     * @brief Наблюдатель за фоновой проверкой слов
+     */
+    QFutureWatcher<void> checkingWatcher;
 };
 
-SpellCheckHighlighter::Implementation::Implementation(const SpellChecker& _checker)
-    : spellChecker(_checker)
+SpellCheckHighlighter::Implementation::Implementation(SpellCheckHighlighter* _q,
+                                                      const SpellChecker& _checker)
+    : q(_q)
+    , spellChecker(_checker)
 {
     //
     // Настроим стиль выделения текста не прошедшего проверку
@@ -56,6 +163,69 @@ SpellCheckHighlighter::Implementation::Implementation(const SpellChecker& _check
 
     recheckTimer.setInterval(1600);
     recheckTimer.setSingleShot(true);
+
+    //
+    // Проверку запускаем после того, как будут обработаны все блоки, ожидающие подсветки,
+    // чтобы успеть выбрать среди них видимые на экране
+    //
+    checkTimer.setInterval(0);
+    checkTimer.setSingleShot(true);
+}
+
+void SpellCheckHighlighter::Implementation::checkNextBlocks()
+{
+    if (checkingWatcher.isRunning() || blocksToCheck.isEmpty()) {
+        return;
+    }
+
+    //
+    // Если документ сменился, то ожидающие проверки блоки уже не актуальны
+    //
+    if (blocksDocument != q->document()) {
+        blocksToCheck.clear();
+        return;
+    }
+
+    //
+    // Сначала проверяем блоки, которые видны на экране
+    //
+    const auto isVisible = [this](const QTextBlock& _block) {
+        return _block.position() + _block.length() >= visibleRange.from
+            && _block.position() <= visibleRange.to;
+    };
+    std::stable_partition(blocksToCheck.begin(), blocksToCheck.end(), isVisible);
+
+    //
+    // Собираем ещё не проверенные слова пачкой, чтобы результаты для первых блоков
+    // появлялись не дожидаясь проверки всего документа
+    //
+    QStringList words;
+    QSet<QString> uniqueWords;
+    int blockIndex = 0;
+    for (; blockIndex < blocksToCheck.size() && words.size() < kWordsToCheckBatchSize;
+         ++blockIndex) {
+        const auto& block = blocksToCheck.at(blockIndex);
+        if (!block.isValid()) {
+            continue;
+        }
+
+        for (const auto& word : wordsToCheck(block.text())) {
+            if (!uniqueWords.contains(word.text)
+                && !spellChecker.cachedSpellCheckWord(word.text).has_value()) {
+                uniqueWords.insert(word.text);
+                words.append(word.text);
+            }
+        }
+        checkingBlocks.append(block);
+    }
+    blocksToCheck.remove(0, blockIndex);
+
+    const auto& checker = spellChecker;
+    checkingWatcher.setFuture(QtConcurrent::run([&checker, words] {
+        for (const auto& word : words) {
+            checker.spellCheckWord(word);
+        }
+    }));
 }
 
 
@@ -64,7 +234,7 @@ SpellCheckHighlighter::Implementation::Implementation(const SpellChecker& _check
 
 SpellCheckHighlighter::SpellCheckHighlighter(QTextDocument* _parent, const SpellChecker& _checker)
     : SyntaxHighlighter(_parent)
-    , d(new Implementation(_checker))
+    , d(new Implementation(this, _checker))
 {
     connect(&d->recheckTimer, &QTimer::timeout, this, [this] {
         if (d->cursorPosition.inDocument == kInvalidCursorPosition) {
@@ -75,6 +245,32 @@ SpellCheckHighlighter::SpellCheckHighlighter(QTextDocument* _parent, const Spell
         d->cursorPosition = {};
         rehighlightBlock(blockToRecheck);
     });
+    connect(&d->checkTimer, &QTimer::timeout, this, [this] { d->checkNextBlocks(); });
+    connect(&d->checkingWatcher, &QFutureWatcher<void>::finished, this, [this] {
+        const auto blocks = d->checkingBlocks;
+        d->checkingBlocks.clear();
+        if (d->blocksDocument != document()) {
+            d->blocksToCheck.clear();
+            return;
+        }
+
+        //
+        // Перепроверяем блоки, слова которых уже есть в кэше проверяющего
+        //
+        const bool isChanged = this->isChanged();
+        QSet<int> rehighlightedBlocks;
+        for (const auto& block : blocks) {
+            if (!block.isValid() || rehighlightedBlocks.contains(block.blockNumber())) {
+                continue;
+            }
+
+            rehighlightedBlocks.insert(block.blockNumber());
+            rehighlightBlock(block);
+        }
+        setChanged(isChanged);
+
+        d->checkNextBlocks();
+    });
 }
 
 SpellCheckHighlighter::~SpellCheckHighlighter() = default;
@@ -86,6 +282,7 @@ void SpellCheckHighlighter::setUseSpellChecker(bool _use)
     }
 
     d->useSpellChecker = _use;
+    d->blocksToCheck.clear();
 
     //
     // Если документ создан и не пуст, перепроверить его
@@ -107,64 +304,53 @@ void SpellCheckHighlighter::setCursorPosition(int _position)
     d->recheckTimer.start();
 }
 
+void SpellCheckHighlighter::setVisibleRange(int _fromPosition, int _toPosition)
+{
+    d->visibleRange = { _fromPosition, _toPosition };
+}
+
 void SpellCheckHighlighter::highlightBlock(const QString& _text)
 {
     if (!d->useSpellChecker) {
         return;
     }
 
-    if (_text.simplified().isEmpty()) {
-        return;
-    }
-
-    //
-    // Убираем пустоты из проверяемого текста
-    //
-    const static QRegularExpression notWord("([^\\w'’-]|·)+",
-                                            QRegularExpression::UseUnicodePropertiesOption);
     //
     // Проверяем каждое слово
     //
-    int wordPos = 0;
-    int notWordLength = 1;
-    int notWordPos = 0;
-    for (wordPos = 0; wordPos < _text.length(); wordPos = notWordPos + notWordLength) {
+    bool hasUncheckedWords = false;
+    for (const auto& word : wordsToCheck(_text)) {
         //
-        // Получим окончание слова
+        // Не проверяем слово, которое сейчас пишется
         //
-        const auto match = notWord.match(_text, wordPos);
-        if (match.hasMatch()) {
-            notWordPos = match.capturedStart();
-            notWordLength = std::max(1, match.capturedLength());
-        } else {
-            notWordPos = _text.length();
+        if (word.position <= d->cursorPosition.inBlock
+            && word.position + word.text.length() > d->cursorPosition.inBlock) {
+            continue;
         }
 
         //
-        // Получим само слово
+        // Слова, которые ещё не проверялись, проверим в фоне
         //
-        const QString wordToCheck = _text.mid(wordPos, notWordPos - wordPos);
+        const auto isCorrect = d->spellChecker.cachedSpellCheckWord(word.text);
+        if (!isCorrect.has_value()) {
+            hasUncheckedWords = true;
+            continue;
+        }
 
         //
-        // Проверяем слова длинной более одного символа
+        // Если слово не прошло проверку
         //
-        if (wordToCheck.length() > 1) {
-            int positionInText = wordPos;
-            //
-            // Не проверяем слово, которое сейчас пишется
-            //
-            if (positionInText <= d->cursorPosition.inBlock
-                && positionInText + wordToCheck.length() > d->cursorPosition.inBlock) {
-                continue;
-            }
+        if (!isCorrect.value()) {
+            setFormat(word.position, word.text.length(), d->misspeledCharFormat);
+        }
+    }
 
-            //
-            // Если слово не прошло проверку
-            //
-            if (!d->spellChecker.spellCheckWord(wordToCheck)) {
-                const int wordLength = wordToCheck.length();
-                setFormat(positionInText, wordLength, d->misspeledCharFormat);
-            }
+    if (hasUncheckedWords) {
+        if (d->blocksDocument != document()) {
+            d->blocksDocument = document();
+            d->blocksToCheck.clear();
         }
+        d->blocksToCheck.append(currentBlock());
+        d->checkTimer.start();
     }
 }
@@ -33,8 +33,15 @@ public:
      */
     void setCursorPosition(int position);
 
+    /**
+     * @brief Задать видимую на экране область документа, блоки из неё проверяются в первую очередь
+     */
+    void setVisibleRange(int _fromPosition, int _toPosition);
+
     /**
      * @brief Подсветить текст не прошедший проверку орфографии
+     * @note Ещё не проверявшиеся слова проверяются в фоне, а блок подсвечивается повторно, когда
+     *       проверка будет завершена
      */
     void highlightBlock(const QString& _text) override;
 
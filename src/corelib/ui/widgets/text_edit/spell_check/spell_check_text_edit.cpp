@@ -12,6 +12,7 @@
 #include <QDir>
 #include <QMenu>
 #include <QRegularExpression>
+#include <QScrollBar>
 #include <QTimer>
 #include <QtGui/private/qtextdocument_p.h>
 
@@ -83,6 +84,8 @@ SpellCheckTextEdit::SpellCheckTextEdit(QWidget* _parent)
 {
     connect(this, &SpellCheckTextEdit::cursorPositionChanged, this,
             &SpellCheckTextEdit::rehighlighWithNewCursor);
+    connect(verticalScrollBar(), &QScrollBar::valueChanged, this,
+            &SpellCheckTextEdit::updateSpellCheckVisibleRange);
 }
 
 SpellCheckTextEdit::~SpellCheckTextEdit() = default;
@@ -130,6 +133,7 @@ void SpellCheckTextEdit::setSpellCheckLanguage(const QString& _languageCode)
     //
     // Заново выделим слова не проходящие проверку орфографии вновь заданного языка
     //
+    updateSpellCheckVisibleRange();
     d->spellCheckHighlighter(document())->rehighlight();
 }
 
@@ -331,6 +335,7 @@ void SpellCheckTextEdit::ignoreWord() const
     //
     // Уберём выделение с игнорируемых слов
     //
+    updateSpellCheckVisibleRange();
     d->spellCheckHighlighter(document())->rehighlight();
 }
 
@@ -360,6 +365,7 @@ void SpellCheckTextEdit::addWordToUserDictionary() const
     //
     // Уберём выделение со слов добавленных в словарь
     //
+    updateSpellCheckVisibleRange();
     d->spellCheckHighlighter(document())->rehighlight();
 }
 
@@ -502,3 +508,11 @@ QString SpellCheckTextEdit::removePunctutaion(const QString& _word) const
     }
     return wordWithoutPunct;
 }
+
+void SpellCheckTextEdit::updateSpellCheckVisibleRange() const
+{
+    const int fromPosition = cursorForPosition({ 0, 0 }).position();
+    const int toPosition
+        = cursorForPosition({ viewport()->width(), viewport()->height() }).position();
+    d->spellCheckHighlighter(document())->setVisibleRange(fromPosition, toPosition);
+}
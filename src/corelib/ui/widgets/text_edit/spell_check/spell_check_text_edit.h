@@ -129,6 +129,11 @@ private:
      */
     QTextCursor moveCursorToEndWord(QTextCursor cursor) const;
 
+    /**
+     * @brief Сообщить подсвечивающему, какая часть текста сейчас видна на экране
+     */
+    void updateSpellCheckVisibleRange() const;
+
 private:
     class Implementation;
     QScopedPointer<Implementation> d;
@@ -2,8 +2,10 @@
 
 #include <hunspell/hunspell.hxx>
 
+#include <QCache>
 #include <QDir>
 #include <QFile>
+#include <QMutex>
 #include <QStandardPaths>
 #include <QStringList>
 #include <QTextCodec>
@@ -14,6 +16,11 @@ namespace {
  * @brief Тип словаря
  */
 enum class SpellCheckerFileType { Affinity, Indexes, Dictionary };
+
+/**
+ * @brief Максимальное количество слов, результаты проверки которых хранятся в кэше
+ */
+const int kCheckedWordsCacheMaxSize = 100000;
 } // namespace
 
 
@@ -40,6 +47,11 @@ public:
      */
     void addWordToChecker(const QString& _word) const;
 
+    /**
+     * @brief Убрать из кэша результаты проверки заданного слова во всех регистрах
+     */
+    void removeFromCache(const QString& _word) const;
+
 
     /**
      * @brief Текущий язык проверки орфографии
@@ -60,10 +72,22 @@ public:
      * @brief Путь к файлу со словарём пользователя
      */
     QString userDictionaryPath;
+
+    /**
+     * @brief Кэш результатов проверки слов
+     */
+    mutable QCache<QString, bool> checkedWords;
+
+    /**
+     * @brief Мьютекс для доступа к проверяющему и кэшу из разных потоков
+     */
+    mutable QMutex mutex;
 };
 
 SpellChecker::Implementation::Implementation()
 {
+    checkedWords.setMaxCost(kCheckedWordsCacheMaxSize);
+
     const QString appDataFolderPath
         = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
     const QString hunspellDictionariesFolderPath
@@ -110,6 +134,22 @@ void SpellChecker::Implementation::addWordToChecker(const QString& _word) const
     //
     const auto encodedWord = checkerTextCodec->fromUnicode(_word);
     checker->add(encodedWord.constData());
+
+    removeFromCache(_word);
+}
+
+void SpellChecker::Implementation::removeFromCache(const QString& _word) const
+{
+    //
+    // Добавленное в словарь слово становится корректным и в других регистрах
+    //
+    const auto word = _word.toLower();
+    const auto cachedWords = checkedWords.keys();
+    for (const auto& cachedWord : cachedWords) {
+        if (cachedWord.toLower() == word) {
+            checkedWords.remove(cachedWord);
+        }
+    }
 }
 
 
@@ -126,6 +166,7 @@ SpellChecker::~SpellChecker() = default;
 
 bool SpellChecker::isAvailable() const
 {
+    QMutexLocker locker(&d->mutex);
     return !d->checker.isNull();
 }
 
@@ -136,15 +177,18 @@ QString SpellChecker::spellingLanguage() const
 
 void SpellChecker::setSpellingLanguage(const QString& _languageCode)
 {
+    QMutexLocker locker(&d->mutex);
+
     if (d->languageCode == _languageCode && !d->checker.isNull()
         && d->checkerTextCodec != nullptr) {
         return;
     }
 
     //
-    // Удаляем предыдущего проверяющего
+    // Удаляем предыдущего проверяющего вместе с результатами его проверок
     //
     d->checker.reset();
+    d->checkedWords.clear();
 
     //
     // Получаем пути к файлам словарей
@@ -193,6 +237,8 @@ void SpellChecker::setSpellingLanguage(const QString& _languageCode)
 
 bool SpellChecker::spellCheckWord(const QString& _word) const
 {
+    QMutexLocker locker(&d->mutex);
+
     //
     // Если проверяющего орфографию не удалось настроить, то и проверять нет смысла
     //
@@ -207,6 +253,13 @@ bool SpellChecker::spellCheckWord(const QString& _word) const
         return true;
     }
 
+    //
+    // Если слово уже проверялось, то используем сохранённый результат
+    //
+    if (const auto isCorrect = d->checkedWords.object(_word); isCorrect != nullptr) {
+        return *isCorrect;
+    }
+
     //
     // Собственно проверка
     //
@@ -226,7 +279,28 @@ bool SpellChecker::spellCheckWord(const QString& _word) const
     //
     const auto encodedWordData = d->checkerTextCodec->fromUnicode(correctedWord);
     const auto encodedWord = encodedWordData.constData();
-    return d->checker->spell(encodedWord);
+    const bool isCorrect = d->checker->spell(encodedWord);
+    d->checkedWords.insert(_word, new bool(isCorrect));
+    return isCorrect;
+}
+
+std::optional<bool> SpellChecker::cachedSpellCheckWord(const QString& _word) const
+{
+    QMutexLocker locker(&d->mutex);
+
+    if (d->checker == nullptr || d->checkerTextCodec == nullptr) {
+        return false;
+    }
+
+    if (_word == "--") {
+        return true;
+    }
+
+    if (const auto isCorrect = d->checkedWords.object(_word); isCorrect != nullptr) {
+        return *isCorrect;
+    }
+
+    return std::nullopt;
 }
 
 QStringList SpellChecker::suggestionsForWord(const QString& _word) const
@@ -245,6 +319,7 @@ QStringList SpellChecker::suggestionsForWord(const QString& _word) const
     //
     // Получим массив вариантов
     //
+    QMutexLocker locker(&d->mutex);
     char** suggestionsArray;
     const auto encodedWordData = d->checkerTextCodec->fromUnicode(_word);
     const auto encodedWord = encodedWordData.constData();
@@ -272,6 +347,7 @@ void SpellChecker::ignoreWord(const QString& _word) const
     //
     // Добавим слово в словарный запас проверяющего на текущую сессию
     //
+    QMutexLocker locker(&d->mutex);
     d->addWordToChecker(_word);
 }
 
@@ -280,6 +356,7 @@ void SpellChecker::addWordToDictionary(const QString& _word) const
     //
     // Добавим слово в словарный запас проверяющего
     //
+    QMutexLocker locker(&d->mutex);
     d->addWordToChecker(_word);
 
     //
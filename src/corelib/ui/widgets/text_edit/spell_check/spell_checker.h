@@ -6,6 +6,8 @@
 
 #include <corelib_global.h>
 
+#include <optional>
+
 class Hunspell;
 class QTextCodec;
 
@@ -17,6 +19,7 @@ class QTextCodec;
 
 /**
  * @brief Класс проверяющего орфографию
+ * @note Методы проверки можно вызывать из любого потока
  */
 class CORE_LIBRARY_EXPORT SpellChecker
 {
@@ -47,6 +50,13 @@ public:
      */
     bool spellCheckWord(const QString& _word) const;
 
+    /**
+     * @brief Получить результат проверки слова, если оно уже проверялось
+     * @note В отличие от spellCheckWord никогда не обращается к словарю, поэтому позволяет
+     *       быстро определить, какие слова нужно проверить отдельно
+     */
+    std::optional<bool> cachedSpellCheckWord(const QString& _word) const;
+
     /**
      * @brief Получить список близких слов (вариантов исправления ошибки)
      * @param Некоректное слово, для которого ищется список
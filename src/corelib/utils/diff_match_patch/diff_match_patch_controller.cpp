@@ -2,9 +2,22 @@
 
 #include "diff_match_patch.h"
 
+#include <algorithm>
+
 
 namespace {
 
+/**
+ * @brief Первый символ зарезервированной секции юникода, используемой для служебных символов
+ */
+constexpr int kFirstTagCharacter = 0xE000;
+
+/**
+ * @brief Сколько неизменённых символов xml оставлять вокруг изменения при сравнении документов
+ * @note Нужно, чтобы в патчах был контекст изменения, как если бы сравнивались документы целиком
+ */
+constexpr int kChangeContextLength = 64;
+
 /**
  * @brief Является ли строка тэгом
  */
@@ -38,11 +51,23 @@ class DiffMatchPatchController::Implementation
 public:
     explicit Implementation(const QVector<QString>& _tags);
 
+    /**
+     * @brief Найти известный тэг, начинающийся в заданной позиции xml
+     * @return Элемент карты тэгов, либо конец карты, если в этой позиции нет тэга
+     */
+    QHash<QString, QChar>::const_iterator tagAt(const QChar* _data, int _length,
+                                                int _position) const;
+
     /**
      * @brief Преобразовать xml в плоский текст, заменяя тэги спецсимволами
      */
     QString xmlToPlain(const QString& _xml);
 
+    /**
+     * @brief Определить длину плоского текста для заданного количества первых символов xml
+     */
+    int plainLength(const QString& _xml, int _length) const;
+
     /**
      * @brief Преобразовать плоский текст в xml, заменяя спецсимволы на тэги
      */
@@ -68,8 +93,28 @@ public:
      */
     QString applyPatchXml(const QString& _xml, const QString& _patch);
 
+    /**
+     * @brief Получить тэг по его служебному символу
+     * @note Если символ не является служебным, возвращается пустая строка
+     */
+    QString tagForCharacter(QChar _character) const;
+
 
+    /**
+     * @brief Карта тэгов в служебные символы
+     */
     QHash<QString, QChar> tagsMap;
+
+    /**
+     * @brief Обратная карта служебных символов в тэги, индексом является смещение символа
+     *        относительно начала зарезервированной секции
+     */
+    QVector<QString> charactersMap;
+
+    /**
+     * @brief Максимальная длина тэга
+     */
+    int maximumTagLength = 0;
 };
 
 DiffMatchPatchController::Implementation::Implementation(const QVector<QString>& _tags)
@@ -78,36 +123,116 @@ DiffMatchPatchController::Implementation::Implementation(const QVector<QString>&
     // Используем зарезервированную секцию кодов юникода U+E000–U+F8FF,
     // для генерации служебных символов для карты тэгов
     //
-    uint characterIndex = 0xE000;
+    uint characterIndex = kFirstTagCharacter;
     auto nextCharacter = [&characterIndex] { return QChar(characterIndex++); };
 
     //
-    // Добавить заданный тэг в карту служебных символов
+    // Добавить заданный тэг в карты служебных символов
     //
     auto addTag = [this, nextCharacter](const QString& _tag) {
-        tagsMap.insert("<" + _tag + ">", nextCharacter());
-        tagsMap.insert("</" + _tag + ">", nextCharacter());
+        for (const auto& tag : { "<" + _tag + ">", "</" + _tag + ">" }) {
+            const auto character = nextCharacter();
+            tagsMap.insert(tag, character);
+            charactersMap.append(tag);
+            maximumTagLength = std::max(maximumTagLength, static_cast<int>(tag.length()));
+        }
     };
     for (const auto& tag : _tags) {
         addTag(tag);
     }
 }
 
+QHash<QString, QChar>::const_iterator DiffMatchPatchController::Implementation::tagAt(
+    const QChar* _data, int _length, int _position) const
+{
+    if (_data[_position] != QLatin1Char('<')) {
+        return tagsMap.constEnd();
+    }
+
+    //
+    // Ищем конец тэга, но не дальше, чем может быть самый длинный тэг
+    //
+    const int maximumTagEnd = std::min(_length, _position + maximumTagLength);
+    int tagEnd = _position + 1;
+    while (tagEnd < maximumTagEnd && _data[tagEnd] != QLatin1Char('>')
+           && _data[tagEnd] != QLatin1Char('<')) {
+        ++tagEnd;
+    }
+    if (tagEnd == maximumTagEnd || _data[tagEnd] != QLatin1Char('>')) {
+        return tagsMap.constEnd();
+    }
+
+    //
+    // Ищем тэг в карте без копирования данных
+    //
+    return tagsMap.constFind(QString::fromRawData(_data + _position, tagEnd - _position + 1));
+}
+
 QString DiffMatchPatchController::Implementation::xmlToPlain(const QString& _xml)
 {
-    QString plain = _xml;
-    for (auto iter = tagsMap.begin(); iter != tagsMap.end(); ++iter) {
-        plain.replace(iter.key(), iter.value());
+    //
+    // Проходим по тексту один раз, заменяя встреченные тэги на служебные символы
+    //
+    QString plain;
+    plain.reserve(_xml.length());
+    const auto data = _xml.constData();
+    const int length = _xml.length();
+    int copyFrom = 0;
+    for (int position = 0; position < length; ++position) {
+        const auto iter = tagAt(data, length, position);
+        if (iter == tagsMap.constEnd()) {
+            continue;
+        }
+
+        plain.append(data + copyFrom, position - copyFrom);
+        plain.append(iter.value());
+        position += iter.key().length() - 1;
+        copyFrom = position + 1;
     }
+    plain.append(data + copyFrom, length - copyFrom);
     return plain;
 }
 
+int DiffMatchPatchController::Implementation::plainLength(const QString& _xml, int _length) const
+{
+    //
+    // Каждый тэг в плоском тексте занимает один символ
+    //
+    const auto data = _xml.constData();
+    int plainLength = _length;
+    for (int position = 0; position < _length; ++position) {
+        const auto iter = tagAt(data, _length, position);
+        if (iter == tagsMap.constEnd()) {
+            continue;
+        }
+
+        plainLength -= iter.key().length() - 1;
+        position += iter.key().length() - 1;
+    }
+    return plainLength;
+}
+
 QString DiffMatchPatchController::Implementation::plainToXml(const QString& _plain)
 {
-    QString xml = _plain;
-    for (auto iter = tagsMap.begin(); iter != tagsMap.end(); ++iter) {
-        xml.replace(iter.value(), iter.key());
+    //
+    // Проходим по тексту один раз, заменяя служебные символы на соответствующие им тэги
+    //
+    QString xml;
+    xml.reserve(_plain.length() * 2);
+    const auto data = _plain.constData();
+    const int length = _plain.length();
+    int copyFrom = 0;
+    for (int position = 0; position < length; ++position) {
+        const auto characterIndex = data[position].unicode() - kFirstTagCharacter;
+        if (characterIndex < 0 || characterIndex >= charactersMap.size()) {
+            continue;
+        }
+
+        xml.append(data + copyFrom, position - copyFrom);
+        xml.append(charactersMap.at(characterIndex));
+        copyFrom = position + 1;
     }
+    xml.append(data + copyFrom, length - copyFrom);
     return xml;
 }
 
@@ -138,6 +263,16 @@ QString DiffMatchPatchController::Implementation::applyPatchXml(const QString& _
     return plainToXml(applyPatchPlain(xmlToPlain(_xml), xmlToPlain(_patch)));
 }
 
+QString DiffMatchPatchController::Implementation::tagForCharacter(QChar _character) const
+{
+    const auto characterIndex = _character.unicode() - kFirstTagCharacter;
+    if (characterIndex < 0 || characterIndex >= charactersMap.size()) {
+        return {};
+    }
+
+    return charactersMap.at(characterIndex);
+}
+
 
 // ****
 
@@ -154,6 +289,90 @@ QByteArray DiffMatchPatchController::makePatch(const QString& _lhs, const QStrin
     return d->makePatchXml(_lhs, _rhs).toUtf8();
 }
 
+QPair<QByteArray, QByteArray> DiffMatchPatchController::makeUndoRedoPatches(
+    const QString& _before, const QString& _after, int _plainOffset) const
+{
+    //
+    // Общие начало и конец документов в сравнении не участвуют, поэтому сложность сравнения
+    // определяется размером изменения, а не размером документа
+    //
+    const auto beforeData = _before.constData();
+    const auto afterData = _after.constData();
+    const int minimumLength = std::min(_before.length(), _after.length());
+    int prefixLength = 0;
+    while (prefixLength < minimumLength && beforeData[prefixLength] == afterData[prefixLength]) {
+        ++prefixLength;
+    }
+    int suffixLength = 0;
+    while (suffixLength < minimumLength - prefixLength
+           && beforeData[_before.length() - suffixLength - 1]
+               == afterData[_after.length() - suffixLength - 1]) {
+        ++suffixLength;
+    }
+    //
+    // ... оставляем вокруг изменения немного контекста и расширяем границы до начала тэгов,
+    //     чтобы не разрезать ни один из них
+    //
+    prefixLength = std::max(0, prefixLength - kChangeContextLength);
+    while (prefixLength > 0 && beforeData[prefixLength] != QLatin1Char('<')) {
+        --prefixLength;
+    }
+    suffixLength = std::max(0, suffixLength - kChangeContextLength);
+    while (suffixLength > 0 && beforeData[_before.length() - suffixLength] != QLatin1Char('<')) {
+        --suffixLength;
+    }
+
+    const auto beforePlain = d->xmlToPlain(
+        _before.mid(prefixLength, _before.length() - prefixLength - suffixLength));
+    const auto afterPlain
+        = d->xmlToPlain(_after.mid(prefixLength, _after.length() - prefixLength - suffixLength));
+    const auto plainPrefixLength = _plainOffset + d->plainLength(_before, prefixLength);
+
+    //
+    // Сформировать патч из списка изменений, сдвинув его на длину общего начала документов
+    //
+    diff_match_patch dmp;
+    auto makePatch = [&dmp, plainPrefixLength](const QString& _text, const QList<Diff>& _diffs) {
+        auto patches = dmp.patch_make(_text, _diffs);
+        for (auto& patch : patches) {
+            patch.start1 += plainPrefixLength;
+            patch.start2 += plainPrefixLength;
+        }
+        return dmp.patch_toText(patches);
+    };
+
+    //
+    // Сравниваем документы один раз, формируя список изменений для повтора
+    //
+    auto diffs = dmp.diff_main(beforePlain, afterPlain, true);
+    if (diffs.size() > 2) {
+        dmp.diff_cleanupSemantic(diffs);
+        dmp.diff_cleanupEfficiency(diffs);
+    }
+    const auto redoPatch = d->plainToXml(makePatch(beforePlain, diffs));
+
+    //
+    // ... а список изменений для отмены получаем инвертированием операций вставки и удаления,
+    //     после чего нормализуем его, чтобы удаления шли перед вставками, как того ожидает dmp
+    //
+    for (auto& diff : diffs) {
+        if (diff.operation == INSERT) {
+            diff.operation = DELETE;
+        } else if (diff.operation == DELETE) {
+            diff.operation = INSERT;
+        }
+    }
+    dmp.diff_cleanupMerge(diffs);
+    const auto undoPatch = d->plainToXml(makePatch(afterPlain, diffs));
+
+    return { undoPatch.toUtf8(), redoPatch.toUtf8() };
+}
+
+int DiffMatchPatchController::plainLength(const QString& _xml) const
+{
+    return d->plainLength(_xml, _xml.length());
+}
+
 QByteArray DiffMatchPatchController::applyPatch(const QByteArray& _content,
                                                 const QByteArray& _patch) const
 {
@@ -235,7 +454,7 @@ QPair<DiffMatchPatchController::Change, DiffMatchPatchController::Change> DiffMa
         //
         // Идём до открывающего тега
         //
-        if (isOpenTag(d->tagsMap.key(oldXmlPlain.at(oldStartPosForXmlPlain)))) {
+        if (isOpenTag(d->tagForCharacter(oldXmlPlain.at(oldStartPosForXmlPlain)))) {
             break;
         }
     }
@@ -244,7 +463,7 @@ QPair<DiffMatchPatchController::Change, DiffMatchPatchController::Change> DiffMa
         //
         // Идём до закрывающего тэга, он находится в конце строки
         //
-        if (isCloseTag(d->tagsMap.key(oldXmlPlain.at(oldEndPosForXml)))) {
+        if (isCloseTag(d->tagForCharacter(oldXmlPlain.at(oldEndPosForXml)))) {
             ++oldEndPosForXml;
             break;
         }
@@ -261,7 +480,7 @@ QPair<DiffMatchPatchController::Change, DiffMatchPatchController::Change> DiffMa
         //
         // Идём до открывающего тега
         //
-        if (isOpenTag(d->tagsMap.key(newXmlPlain.at(newStartPosForXmlPlain)))) {
+        if (isOpenTag(d->tagForCharacter(newXmlPlain.at(newStartPosForXmlPlain)))) {
             break;
         }
     }
@@ -270,7 +489,7 @@ QPair<DiffMatchPatchController::Change, DiffMatchPatchController::Change> DiffMa
         //
         // Идём до закрывающего тэга, он находится в конце строки
         //
-        if (isCloseTag(d->tagsMap.key(newXmlPlain.at(newEndPosForXml)))) {
+        if (isCloseTag(d->tagForCharacter(newXmlPlain.at(newEndPosForXml)))) {
             ++newEndPosForXml;
             break;
         }
@@ -23,6 +23,21 @@ public:
      */
     QByteArray makePatch(const QString& _lhs, const QString& _rhs) const;
 
+    /**
+     * @brief Сформировать патчи отмены и повтора изменения за одно сравнение документов
+     * @param _plainOffset Смещение сравниваемых фрагментов в плоском тексте документа, если
+     *        сравниваются не документы целиком, а только их изменившиеся части
+     * @return Пара: 1) патч отмены (из _after в _before); 2) патч повтора (из _before в _after)
+     */
+    QPair<QByteArray, QByteArray> makeUndoRedoPatches(const QString& _before,
+                                                      const QString& _after,
+                                                      int _plainOffset = 0) const;
+
+    /**
+     * @brief Определить длину xml в плоском тексте, в котором позиционируются патчи
+     */
+    int plainLength(const QString& _xml) const;
+
     /**
      * @brief Применить патч
      */
@@ -21,6 +21,7 @@
 #include <domain/document_object.h>
 
 #include <QDomDocument>
+#include <QStandardItemModel>
 
 using namespace BusinessLayer;
 
@@ -41,6 +42,39 @@ int ModelHelper::recursiveRowCount(QAbstractItemModel* _model)
     return count;
 }
 
+void ModelHelper::moveContent(QStandardItemModel* _source, QStandardItemModel* _target)
+{
+    if (_source == nullptr || _target == nullptr) {
+        return;
+    }
+
+    _target->clear();
+
+    //
+    // Сначала переносим заголовки, чтобы у целевой модели сразу было нужное число колонок
+    //
+    for (int column = 0; column < _source->columnCount(); ++column) {
+        if (auto header = _source->takeHorizontalHeaderItem(column)) {
+            _target->setHorizontalHeaderItem(column, header);
+        }
+    }
+
+    //
+    // ... а затем строки вместе с вложенными в них элементами, забирая их с конца, чтобы не
+    //     сдвигать оставшиеся строки исходной модели
+    //
+    QVector<QList<QStandardItem*>> rows;
+    rows.reserve(_source->rowCount());
+    for (int row = _source->rowCount() - 1; row >= 0; --row) {
+        rows.append(_source->takeRow(row));
+    }
+    for (auto row = rows.crbegin(); row != rows.crend(); ++row) {
+        _target->appendRow(*row);
+    }
+
+    _source->clear();
+}
+
 void ModelHelper::initTitlePageModel(BusinessLayer::SimpleTextModel* _model)
 {
     if (_model == nullptr || _model->rowCount() != 1) {
@@ -5,6 +5,7 @@
 #include <corelib_global.h>
 
 class QAbstractItemModel;
+class QStandardItemModel;
 
 namespace BusinessLayer {
 class SimpleTextModel;
@@ -22,6 +23,12 @@ public:
      */
     static int recursiveRowCount(QAbstractItemModel* _model);
 
+    /**
+     * @brief Перенести строки и заголовки из одной модели в другую, заменив ими содержимое
+     *        целевой модели
+     */
+    static void moveContent(QStandardItemModel* _source, QStandardItemModel* _target);
+
     /**
      * @brief Инициилизировать модель титульной страницы
      */
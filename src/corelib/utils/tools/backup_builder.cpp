@@ -1,14 +1,316 @@
 #include "backup_builder.h"
 
 #include <utils/helpers/text_helper.h>
+#include <utils/logging.h>
 
+#include <QCryptographicHash>
 #include <QDate>
 #include <QDir>
+#include <QDirIterator>
+#include <QLockFile>
+#include <QRegularExpression>
+#include <QSaveFile>
+#include <QSet>
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QSqlQuery>
 #include <QString>
+#include <QUuid>
+#include <QtEndian>
 
+#include <algorithm>
 #include <set>
 
 
+namespace {
+
+/**
+ * @brief Плагин используемый для работы с базой
+ */
+const QString kSqlDriver = "QSQLITE";
+
+/**
+ * @brief Таблица снимка, в которой хранятся хэши содержимого документов и их изменений
+ */
+const QString kContentsTableName = "backup_contents";
+
+/**
+ * @brief Столбец таблицы проекта, данные которого выносятся в хранилище содержимого
+ * @note Строки всех таких таблиц идентифицируются по столбцу uuid
+ */
+struct ContentColumn {
+    QString table;
+    QString column;
+};
+const QVector<ContentColumn> kContentColumns = {
+    { "documents", "content" },
+    { "documents_changes", "undo_patch" },
+    { "documents_changes", "redo_patch" },
+};
+
+/**
+ * @brief Идентификатор приложения, которым помечается заголовок файла резервной копии
+ * @note Хранится в поле application_id заголовка SQLite, поэтому резервную копию можно отличить
+ *       от обычного проекта, прочитав лишь заголовок файла
+ */
+const quint32 kBackupApplicationId = 0x53544243;
+const int kApplicationIdOffset = 68;
+
+/**
+ * @brief Формат даты в названии резервной копии
+ */
+const QString kBackupDateTimeFormat = "yyyy_MM_dd_hh_mm_ss";
+
+/**
+ * @brief Получить папку с содержимым документов резервных копий проекта
+ */
+QString contentsDirFor(const QString& _backupPath, const QString& _backupBaseName)
+{
+    return QString("%1%2.contents").arg(_backupPath, _backupBaseName);
+}
+
+/**
+ * @brief Получить путь к файлу блокировки хранилища содержимого резервных копий проекта
+ */
+QString contentsLockPathFor(const QString& _contentsDir)
+{
+    return _contentsDir + ".lock";
+}
+
+/**
+ * @brief Захватить хранилище содержимого резервных копий проекта
+ * @note Блокировка файловая, поэтому копии не пересекаются ни между потоками, ни между разными
+ *       запущенными экземплярами приложения. Время устаревания не задаём, т.к. снимок большого
+ *       проекта может делаться долго, а блокировку завершившегося процесса Qt определяет сам
+ */
+void lockContents(QLockFile& _lock)
+{
+    _lock.setStaleLockTime(0);
+    _lock.lock();
+}
+
+/**
+ * @brief Получить путь к файлу с содержимым, имеющим заданный хэш
+ * @note Файлы раскладываются по подпапкам, чтобы ни в одной папке не было слишком много файлов
+ */
+QString contentPathFor(const QString& _contentsDir, const QString& _hash)
+{
+    return QString("%1/%2/%3").arg(_contentsDir, _hash.left(2), _hash);
+}
+
+/**
+ * @brief Получить базовое имя проекта из имени резервной копии
+ */
+QString backupBaseNameFor(const QFileInfo& _backupInfo)
+{
+    return _backupInfo.completeBaseName().remove(QRegularExpression("_\\d{4}(_\\d{2}){5}$"));
+}
+
+/**
+ * @brief Выполнить действие над базой данных в отдельном соединении
+ * @note Соединение создаётся в текущем потоке и удаляется сразу после выполнения
+ */
+template<typename Action>
+bool withDatabase(const QString& _databasePath, Action _action)
+{
+    const auto connectionName
+        = QString("backup_builder_%1").arg(QUuid::createUuid().toString(QUuid::WithoutBraces));
+    bool isSucceed = false;
+    {
+        auto database = QSqlDatabase::addDatabase(kSqlDriver, connectionName);
+        database.setDatabaseName(_databasePath);
+        if (database.open()) {
+            isSucceed = _action(database);
+        }
+        database.close();
+    }
+    QSqlDatabase::removeDatabase(connectionName);
+    return isSucceed;
+}
+
+/**
+ * @brief Сохранить содержимое в файл, если содержимого с таким хэшем ещё нет
+ */
+bool saveContent(const QString& _contentsDir, const QString& _hash, const QByteArray& _content)
+{
+    const auto contentPath = contentPathFor(_contentsDir, _hash);
+    if (QFile::exists(contentPath)) {
+        return true;
+    }
+
+    QDir::root().mkpath(QFileInfo(contentPath).absolutePath());
+    QSaveFile file(contentPath);
+    return file.open(QIODevice::WriteOnly) && file.write(_content) == _content.size()
+        && file.commit();
+}
+
+/**
+ * @brief Сделать снимок базы данных проекта, вынеся содержимое документов в хранилище
+ */
+bool makeSnapshot(QSqlDatabase& _database, const QString& _snapshotPath,
+                  const QString& _contentsDir)
+{
+    QSqlQuery query(_database);
+    query.prepare("ATTACH DATABASE ? AS backup");
+    query.addBindValue(_snapshotPath);
+    if (!query.exec()) {
+        return false;
+    }
+
+    //
+    // Все данные читаем в рамках одной транзакции, поэтому снимок согласован, а т.к. в сам
+    // проект при этом ничего не пишется, то запись в него не блокируется
+    //
+    _database.transaction();
+    auto copyData = [&_database, &query, &_contentsDir] {
+        //
+        // Воссоздаём схему проекта, индексы создадим уже после копирования данных
+        //
+        if (!query.exec("SELECT type, name, sql FROM main.sqlite_master "
+                        "WHERE sql IS NOT NULL AND name NOT LIKE 'sqlite_%' "
+                        "ORDER BY type = 'table' DESC")) {
+            return false;
+        }
+        const QRegularExpression createRx(
+            "^(CREATE\\s+(UNIQUE\\s+)?(TABLE|INDEX)\\s+(IF\\s+NOT\\s+EXISTS\\s+)?)",
+            QRegularExpression::CaseInsensitiveOption);
+        QVector<QString> tables;
+        QVector<QString> tablesStatements;
+        QVector<QString> indexesStatements;
+        while (query.next()) {
+            const auto statement = query.value(2).toString().replace(createRx, "\\1backup.");
+            if (query.value(0).toString() == "table") {
+                tables.append(query.value(1).toString());
+                tablesStatements.append(statement);
+            } else if (query.value(0).toString() == "index") {
+                indexesStatements.append(statement);
+            }
+        }
+        for (const auto& statement : std::as_const(tablesStatements)) {
+            if (!query.exec(statement)) {
+                return false;
+            }
+        }
+
+        //
+        // Копируем данные всех таблиц, кроме содержимого документов
+        //
+        for (const auto& table : std::as_const(tables)) {
+            if (!query.exec(QString("PRAGMA main.table_info(\"%1\")").arg(table))) {
+                return false;
+            }
+            QStringList columns;
+            QStringList values;
+            while (query.next()) {
+                const auto columnName = query.value(1).toString();
+                const auto column = QString("\"%1\"").arg(columnName);
+                columns.append(column);
+                const auto isContentColumn = std::any_of(
+                    kContentColumns.begin(), kContentColumns.end(),
+                    [&table, &columnName](const ContentColumn& _contentColumn) {
+                        return _contentColumn.table == table
+                            && _contentColumn.column == columnName;
+                    });
+                values.append(isContentColumn
+                                  ? QString("CASE WHEN %1 IS NULL THEN NULL ELSE X'' END")
+                                        .arg(column)
+                                  : column);
+            }
+            if (!query.exec(QString("INSERT INTO backup.\"%1\" (%2) SELECT %3 FROM main.\"%1\"")
+                                .arg(table, columns.join(", "), values.join(", ")))) {
+                return false;
+            }
+        }
+        if (query.exec("SELECT name FROM main.sqlite_master WHERE name = 'sqlite_sequence'")
+            && query.next()) {
+            query.exec("INSERT INTO backup.sqlite_sequence SELECT * FROM main.sqlite_sequence");
+        }
+        for (const auto& statement : std::as_const(indexesStatements)) {
+            query.exec(statement);
+        }
+
+        //
+        // Содержимое документов и патчи их изменений сохраняем в хранилище по хэшу, а в снимке
+        // оставляем только хэши
+        //
+        if (!query.exec(QString("CREATE TABLE backup.%1 (table_name TEXT NOT NULL, "
+                                "column_name TEXT NOT NULL, uuid TEXT NOT NULL, "
+                                "hash TEXT NOT NULL, "
+                                "PRIMARY KEY (table_name, column_name, uuid))")
+                            .arg(kContentsTableName))) {
+            return false;
+        }
+        QSqlQuery insertQuery(_database);
+        insertQuery.prepare(QString("INSERT INTO backup.%1 (table_name, column_name, uuid, hash) "
+                                    "VALUES(?, ?, ?, ?)")
+                                .arg(kContentsTableName));
+        for (const auto& contentColumn : kContentColumns) {
+            if (!tables.contains(contentColumn.table)) {
+                continue;
+            }
+
+            if (!query.exec(QString("SELECT uuid, \"%2\" FROM main.\"%1\" "
+                                    "WHERE \"%2\" IS NOT NULL")
+                                .arg(contentColumn.table, contentColumn.column))) {
+                return false;
+            }
+            while (query.next()) {
+                const auto content = query.value(1).toByteArray();
+                const auto hash = QString::fromLatin1(
+                    QCryptographicHash::hash(content, QCryptographicHash::Sha256).toHex());
+                if (!saveContent(_contentsDir, hash, content)) {
+                    return false;
+                }
+
+                insertQuery.bindValue(0, contentColumn.table);
+                insertQuery.bindValue(1, contentColumn.column);
+                insertQuery.bindValue(2, query.value(0));
+                insertQuery.bindValue(3, hash);
+                if (!insertQuery.exec()) {
+                    return false;
+                }
+            }
+        }
+
+        //
+        // Помечаем снимок как резервную копию, чтобы не открывать его для проверки
+        //
+        return query.exec(
+            QString("PRAGMA backup.application_id = %1").arg(kBackupApplicationId));
+    };
+    const auto isCopied = copyData();
+    if (isCopied) {
+        _database.commit();
+    } else {
+        Log::warning("Can't make backup snapshot: %1", query.lastError().text());
+        _database.rollback();
+    }
+
+    query.exec("DETACH DATABASE backup");
+    return isCopied;
+}
+
+/**
+ * @brief Добавить хэши содержимого, на которое ссылается резервная копия
+ * @return Удалось ли прочитать хэши
+ */
+bool readContentsHashes(const QString& _backupPath, QSet<QString>& _hashes)
+{
+    return withDatabase(_backupPath, [&_hashes](QSqlDatabase& _database) {
+        QSqlQuery query(_database);
+        if (!query.exec(QString("SELECT hash FROM %1").arg(kContentsTableName))) {
+            return false;
+        }
+        while (query.next()) {
+            _hashes.insert(query.value(0).toString());
+        }
+        return true;
+    });
+}
+
+} // namespace
+
+
 void BackupBuilder::save(const QString& _filePath, const QString& _backupDir,
                          const QString& _newName, int _maximumBackups)
 {
@@ -33,26 +335,42 @@ void BackupBuilder::save(const QString& _filePath, const QString& _backupDir,
     const QString backupBaseName = _newName.isEmpty() ? fileInfo.completeBaseName() : _newName;
     auto backupFileNameFor = [backupPath, backupBaseName, fileInfo](const QDateTime& _dateTime) {
         return QString("%1%2_%3.%4")
-            .arg(backupPath, backupBaseName, _dateTime.toString("yyyy_MM_dd_hh_mm_ss"),
+            .arg(backupPath, backupBaseName, _dateTime.toString(kBackupDateTimeFormat),
                  fileInfo.completeSuffix());
     };
+    const auto contentsDir = contentsDirFor(backupPath, backupBaseName);
+
+    //
+    // Копии одного проекта делаем строго по очереди, иначе очистка хранилища в конце одной
+    // копии может удалить содержимое, которое другая уже записала, но ещё не сослалась на него
+    //
+    QLockFile contentsLock(contentsLockPathFor(contentsDir));
+    lockContents(contentsLock);
 
     //
     // Создаём копию
     //
     const auto rightNow = QDateTime::currentDateTime();
-    const QString tmpBackupFileName
-        = QString("%1%2.tmp.%3").arg(backupPath, backupBaseName, fileInfo.completeSuffix());
+    const QString tmpBackupFileName = QString("%1%2.tmp.%3.%4")
+                                          .arg(backupPath, backupBaseName,
+                                               QUuid::createUuid().toString(QUuid::WithoutBraces),
+                                               fileInfo.completeSuffix());
     //
-    // ... копируем файл во временную резервную копию
+    // ... делаем снимок проекта во временную резервную копию
     //
-    if (QFile::copy(_filePath, tmpBackupFileName)) {
+    const auto isSnapshotSaved
+        = withDatabase(_filePath, [&tmpBackupFileName, &contentsDir](QSqlDatabase& _database) {
+              return makeSnapshot(_database, tmpBackupFileName, contentsDir);
+          });
+    if (isSnapshotSaved) {
         //
-        // ... если скопировать удалось, переименовываем временную копию
+        // ... если снимок удался, переименовываем временную копию
         //
         const QString backupFileName = backupFileNameFor(rightNow);
         QFile::remove(backupFileName);
         QFile::rename(tmpBackupFileName, backupFileName);
+    } else {
+        QFile::remove(tmpBackupFileName);
     }
 
     //
@@ -77,4 +395,133 @@ void BackupBuilder::save(const QString& _filePath, const QString& _backupDir,
         const auto backupToRemove = backups.takeLast();
         QFile::remove(backupToRemove);
     }
+
+    //
+    // Удаляем содержимое, на которое не ссылается ни одна из оставшихся копий
+    //
+    // NOTE: Если хотя бы одну копию прочитать не удалось, то ничего не удаляем, чтобы не
+    //       потерять её содержимое
+    //
+    QSet<QString> usedHashes;
+    for (const auto& backup : std::as_const(backups)) {
+        if (isBackup(backup) && !readContentsHashes(backup, usedHashes)) {
+            return;
+        }
+    }
+    QDirIterator contentsIterator(contentsDir, QDir::Files, QDirIterator::Subdirectories);
+    while (contentsIterator.hasNext()) {
+        const auto contentPath = contentsIterator.next();
+        if (!usedHashes.contains(contentsIterator.fileName())) {
+            QFile::remove(contentPath);
+        }
+    }
+}
+
+bool BackupBuilder::isBackup(const QString& _filePath)
+{
+    QFile file(_filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    const auto header = file.read(kApplicationIdOffset + sizeof(kBackupApplicationId));
+    if (header.size() < kApplicationIdOffset + static_cast<int>(sizeof(kBackupApplicationId))) {
+        return false;
+    }
+
+    return qFromBigEndian<quint32>(header.constData() + kApplicationIdOffset)
+        == kBackupApplicationId;
+}
+
+QString BackupBuilder::contentsDir(const QString& _backupPath)
+{
+    const QFileInfo backupInfo(_backupPath);
+    return contentsDirFor(backupInfo.absolutePath() + QDir::separator(),
+                          backupBaseNameFor(backupInfo));
+}
+
+QString BackupBuilder::restore(const QString& _backupPath)
+{
+    const QFileInfo backupInfo(_backupPath);
+    const auto contentsDir = BackupBuilder::contentsDir(_backupPath);
+
+    //
+    // Восстанавливаем копию в отдельную папку, чтобы восстановленные проекты не смешивались
+    // с резервными копиями. Каждый раз восстанавливаем в новый файл, т.к. ранее восстановленный
+    // мог быть изменён после восстановления и уже не соответствовать копии
+    //
+    const auto restoredDir = QDir(backupInfo.absoluteDir().filePath("restored"));
+    QDir::root().mkpath(restoredDir.absolutePath());
+    const auto restoredBaseName = QString("%1 (restored %2)")
+                                      .arg(backupInfo.completeBaseName(),
+                                           QDateTime::currentDateTime().toString(
+                                               kBackupDateTimeFormat));
+    auto restoredPath = restoredDir.filePath(
+        QString("%1.%2").arg(restoredBaseName, backupInfo.completeSuffix()));
+    for (int index = 2; QFileInfo::exists(restoredPath); ++index) {
+        restoredPath = restoredDir.filePath(
+            QString("%1 %2.%3").arg(restoredBaseName).arg(index).arg(backupInfo.completeSuffix()));
+    }
+
+    //
+    // Пока содержимое возвращается на место, хранилище не должно очищаться
+    //
+    QLockFile contentsLock(contentsLockPathFor(contentsDir));
+    lockContents(contentsLock);
+
+    const auto tmpRestoredPath = restoredPath + ".tmp";
+    QFile::remove(tmpRestoredPath);
+    if (!QFile::copy(_backupPath, tmpRestoredPath)) {
+        return {};
+    }
+
+    //
+    // Возвращаем содержимое документов и патчи их изменений из хранилища на место
+    //
+    const auto isRestored = withDatabase(tmpRestoredPath, [&contentsDir](QSqlDatabase& _database) {
+        QSqlQuery query(_database);
+        QSqlQuery updateQuery(_database);
+        _database.transaction();
+        bool isSucceed = true;
+        for (const auto& contentColumn : kContentColumns) {
+            query.prepare(QString("SELECT uuid, hash FROM %1 "
+                                  "WHERE table_name = ? AND column_name = ?")
+                              .arg(kContentsTableName));
+            query.addBindValue(contentColumn.table);
+            query.addBindValue(contentColumn.column);
+            updateQuery.prepare(QString("UPDATE \"%1\" SET \"%2\" = ? WHERE uuid = ?")
+                                    .arg(contentColumn.table, contentColumn.column));
+            isSucceed = query.exec();
+            while (isSucceed && query.next()) {
+                QFile contentFile(contentPathFor(contentsDir, query.value(1).toString()));
+                isSucceed = contentFile.open(QIODevice::ReadOnly);
+                if (!isSucceed) {
+                    Log::warning("Backup content %1 is missing", contentFile.fileName());
+                    break;
+                }
+
+                updateQuery.bindValue(0, contentFile.readAll());
+                updateQuery.bindValue(1, query.value(0));
+                isSucceed = updateQuery.exec();
+            }
+            query.finish();
+            if (!isSucceed) {
+                break;
+            }
+        }
+        isSucceed = isSucceed && query.exec(QString("DROP TABLE %1").arg(kContentsTableName))
+            && query.exec("PRAGMA application_id = 0");
+        if (isSucceed) {
+            _database.commit();
+        } else {
+            _database.rollback();
+        }
+        return isSucceed;
+    });
+    if (!isRestored || !QFile::rename(tmpRestoredPath, restoredPath)) {
+        QFile::remove(tmpRestoredPath);
+        return {};
+    }
+
+    return restoredPath;
 }
@@ -7,13 +7,41 @@ class QString;
 
 /**
  * @brief Класс для организации создания резервных копий
+ *
+ * Резервная копия - это снимок базы данных проекта, в котором вместо содержимого документов и
+ * патчей их изменений хранятся лишь хэши. Сами данные складываются в общее для всех копий проекта
+ * хранилище (папка "<проект>.contents" рядом с копиями), где каждый уникальный блок данных
+ * хранится лишь однажды, поэтому неизменившиеся документы, изображения и история не занимают места
+ * в каждой новой копии.
+ *
+ * @note Без хранилища резервная копия не может быть восстановлена, поэтому переносить её нужно
+ *       вместе с папкой содержимого
  */
 namespace BackupBuilder {
 
 /**
  * @brief Сохранить бэкап
+ * @note Снимок делается через отдельное соединение в рамках одной читающей транзакции, поэтому
+ *       он согласован и не блокирует запись в проект
  */
 CORE_LIBRARY_EXPORT extern void save(const QString& _filePath, const QString& _backupDir,
                                      const QString& _newName, int _maximumBackups);
 
+/**
+ * @brief Является ли заданный файл резервной копией, содержимое которой нужно восстановить
+ * @note Определяется по метке в заголовке файла, без открытия базы данных
+ */
+CORE_LIBRARY_EXPORT extern bool isBackup(const QString& _filePath);
+
+/**
+ * @brief Получить папку хранилища, в которой лежат данные заданной резервной копии
+ */
+CORE_LIBRARY_EXPORT extern QString contentsDir(const QString& _backupPath);
+
+/**
+ * @brief Восстановить резервную копию в отдельный файл проекта
+ * @return Путь к восстановленному файлу, или пустая строка, если восстановить не удалось
+ */
+CORE_LIBRARY_EXPORT extern QString restore(const QString& _backupPath);
+
 } // namespace BackupBuilder
@@ -1,146 +1,171 @@
 #pragma once
 
-#include <utils/shugar.h>
-
+#include <QHash>
 #include <QVector>
 
+#include <algorithm>
+#include <limits>
+
 namespace edit_distance {
 
 //
-// Реализация взята из https://www.geeksforgeeks.org/edit-distance-dp-5/
+// Реализация основана на https://www.geeksforgeeks.org/edit-distance-dp-5/
+// В ячейках таблицы храним только вес пути и направление, откуда в ячейку пришли, а сам путь
+// восстанавливаем обратным проходом по направлениям, что даёт O(n·m) по времени и памяти
 //
 
-enum class OperationType { Skip, Insert, Remove, Replace };
+enum class OperationType : quint8 { Skip, Insert, Remove, Replace };
 
 template<typename T>
 struct Operation {
     OperationType type = OperationType::Skip;
     T* value = nullptr;
-    int weight = 0;
 };
 
 namespace {
 
+/**
+ * @brief Тип разделителя таблицы, которым является элемент
+ */
+enum class SplitterType : quint8 { None, Start, End };
+
 template<typename T>
-QVector<Operation<T>> minimumDistance(const QVector<Operation<T>>& _x,
-                                      const QVector<Operation<T>>& _y,
-                                      const QVector<Operation<T>>& _z)
+SplitterType splitterType(T* _item)
 {
-    auto operationWeight = [](const QVector<Operation<T>>& _operations) {
-        int weight = 0;
-        for (const auto& operation : _operations) {
-            //
-            // Из-за того, что для некоторых кейсов вес может быть максимальным значением int,
-            // берём максимум, чтобы не было переполнения
-            //
-            weight = std::max(weight + operation.weight, operation.weight);
-        }
-        return weight;
-    };
-
-    const auto xWeight = operationWeight(_x);
-    const auto yWeight = operationWeight(_y);
-    const auto zWeight = operationWeight(_z);
-    const auto minimumWeight = std::min({ xWeight, yWeight, zWeight });
-    if (minimumWeight == xWeight) {
-        return _x;
-    } else if (minimumWeight == yWeight) {
-        return _y;
-    } else {
-        return _z;
+    //
+    // FIXME: придумать, как это более изящно обыграть (перенести в элемент модели)
+    //
+    const auto xml = _item->toXml();
+    if (!xml.startsWith("<splitter type=")) {
+        return SplitterType::None;
     }
+
+    return xml == "<splitter type=\"start\"/>\n" ? SplitterType::Start : SplitterType::End;
+}
+
+/**
+ * @brief Ячейка таблицы расстояний
+ */
+struct Cell {
+    /**
+     * @brief Вес наилучшего пути, ведущего в ячейку
+     */
+    int weight = 0;
+
+    /**
+     * @brief Тип последнего вставленного и удалённого разделителя на этом пути
+     */
+    SplitterType lastInsertedSplitter = SplitterType::None;
+    SplitterType lastRemovedSplitter = SplitterType::None;
 };
 
-template<typename T>
-bool isItemsParentsEqual(T* _lhs, T* _rhs)
+/**
+ * @brief Сложить веса, не допуская переполнения
+ */
+inline int addWeight(int _weight, int _operationWeight)
 {
-    return (_lhs->parent() == nullptr && _rhs->parent() == nullptr)
-        || (_lhs->parent() != nullptr && _rhs->parent() != nullptr
-            && _lhs->parent()->isEqual(_rhs->parent()));
+    return static_cast<int>(std::min<qint64>(static_cast<qint64>(_weight) + _operationWeight,
+                                             std::numeric_limits<int>::max()));
 }
 
-template<typename T>
-bool isItemsEqual(T* _lhs, T* _rhs)
+/**
+ * @brief Вес вставки или удаления элемента
+ * @note Закрывающий разделитель таблицы дорого вставлять/удалять отдельно от открывающего
+ */
+inline int insertOrRemoveWeight(SplitterType _lastSplitter, SplitterType _itemSplitter)
 {
-    return _lhs->isEqual(_rhs) && isItemsParentsEqual(_lhs, _rhs);
+    if (_itemSplitter != SplitterType::End) {
+        return 1;
+    }
+
+    return _lastSplitter == SplitterType::Start ? 1 : 100;
 }
 
-template<typename T>
-Operation<T> skipOperation(T* _item)
+inline Cell insertCell(const Cell& _from, SplitterType _itemSplitter)
 {
-    return { OperationType::Skip, _item, 0 };
+    Cell cell = _from;
+    cell.weight = addWeight(_from.weight,
+                            insertOrRemoveWeight(_from.lastInsertedSplitter, _itemSplitter));
+    if (_itemSplitter != SplitterType::None) {
+        cell.lastInsertedSplitter = _itemSplitter;
+    }
+    return cell;
 }
 
-template<typename T>
-Operation<T> insertOperation(const QVector<Operation<T>>& _operations, T* _item)
+inline Cell removeCell(const Cell& _from, SplitterType _itemSplitter)
 {
-    int weight = 1;
+    Cell cell = _from;
+    cell.weight
+        = addWeight(_from.weight, insertOrRemoveWeight(_from.lastRemovedSplitter, _itemSplitter));
+    if (_itemSplitter != SplitterType::None) {
+        cell.lastRemovedSplitter = _itemSplitter;
+    }
+    return cell;
+}
 
-    //
-    // FIXME: придумать, как это более изящно обыграть (перенести в элемент модели)
-    //
-    if (_item->toXml() == "<splitter type=\"end\"/>\n") {
-        weight = 100;
-        for (const auto& operation : reversed(_operations)) {
-            if (operation.type != OperationType::Insert) {
-                continue;
-            }
+template<typename T>
+int replaceWeight(T* _lhs, SplitterType _lhsSplitter, T* _rhs, SplitterType _rhsSplitter)
+{
+    if (_lhs->type() != _rhs->type() || _lhs->subtype() != _rhs->subtype()) {
+        return std::numeric_limits<int>::max();
+    }
 
-            const QString operationValueXml = operation.value->toXml();
-            if (operationValueXml.startsWith("<splitter type=")) {
-                if (operationValueXml == "<splitter type=\"start\"/>\n") {
-                    weight = 1;
-                }
-                break;
-            }
-        }
+    if (_lhsSplitter != SplitterType::None || _rhsSplitter != SplitterType::None) {
+        return 100;
     }
 
-    return { OperationType::Insert, _item, weight };
+    return 1;
 }
 
 template<typename T>
-Operation<T> removeOperation(const QVector<Operation<T>>& _operations, T* _item)
+bool isItemsParentsEqual(T* _lhs, T* _rhs)
 {
-    int weight = 1;
-
-    //
-    // FIXME: придумать, как это более изящно обыграть (перенести в элемент модели)
-    //
-    if (_item->toXml() == "<splitter type=\"end\"/>\n") {
-        weight = 100;
-        for (const auto& operation : reversed(_operations)) {
-            if (operation.type != OperationType::Remove) {
-                continue;
-            }
-
-            const QString operationValueXml = operation.value->toXml();
-            if (operationValueXml.startsWith("<splitter type=")) {
-                if (operation.value->toXml() == "<splitter type=\"start\"/>\n") {
-                    weight = 1;
-                }
-                break;
-            }
-        }
-    }
+    return (_lhs->parent() == nullptr && _rhs->parent() == nullptr)
+        || (_lhs->parent() != nullptr && _rhs->parent() != nullptr
+            && _lhs->parent()->isEqual(_rhs->parent()));
+}
 
-    return { OperationType::Remove, _item, weight };
+template<typename T>
+bool isItemsEqual(T* _lhs, T* _rhs)
+{
+    return _lhs->isEqual(_rhs) && isItemsParentsEqual(_lhs, _rhs);
 }
 
+/**
+ * @brief Разбить элементы на классы равных между собой элементов
+ * @note Элементы с разными хэшами заведомо не равны, поэтому полностью элемент сравнивается
+ *       только с представителями классов с тем же хэшем, как правило, с одним
+ */
 template<typename T>
-Operation<T> replaceOperation(T* _lhs, T* _rhs)
+QPair<QVector<int>, QVector<int>> equalityClasses(const QVector<T*>& _source,
+                                                  const QVector<T*>& _target)
 {
-    int weight = 1;
+    QHash<quint64, QVector<QPair<T*, int>>> representatives;
+    int classesCount = 0;
+    auto equalityClass = [&representatives, &classesCount](T* _item) {
+        const auto parent = _item->parent();
+        const quint64 hash = (static_cast<quint64>(_item->equalityHash()) << 32)
+            ^ (parent != nullptr ? parent->equalityHash() : 0);
+        auto& items = representatives[hash];
+        for (const auto& item : std::as_const(items)) {
+            if (isItemsEqual(item.first, _item)) {
+                return item.second;
+            }
+        }
+        items.append({ _item, classesCount });
+        return classesCount++;
+    };
 
-    if (_lhs->toXml().startsWith("<splitter type=")
-        || _rhs->toXml().startsWith("<splitter type=")) {
-        weight = 100;
+    QPair<QVector<int>, QVector<int>> classes;
+    classes.first.reserve(_source.size());
+    for (auto item : _source) {
+        classes.first.append(equalityClass(item));
     }
-    if (_lhs->type() != _rhs->type() || _lhs->subtype() != _rhs->subtype()) {
-        weight = std::numeric_limits<int>::max();
+    classes.second.reserve(_target.size());
+    for (auto item : _target) {
+        classes.second.append(equalityClass(item));
     }
-
-    return { OperationType::Replace, _rhs, weight };
+    return classes;
 }
 
 } // namespace
@@ -149,88 +174,135 @@ Operation<T> replaceOperation(T* _lhs, T* _rhs)
 template<typename T>
 QVector<Operation<T>> editDistance(const QVector<T*>& _source, const QVector<T*>& _target)
 {
+    const int sourceSize = _source.size();
+    const int targetSize = _target.size();
+
     //
-    // Определим хранилище для кеша просчитанных путей
+    // Заранее определяем, какие из элементов являются разделителями таблиц,
+    // чтобы не формировать их xml в каждой ячейке таблицы
     //
-    QVector<QVector<QVector<Operation<T>>>> opertionsCache;
-    opertionsCache.resize(2);
-    opertionsCache[0].resize(_source.size() + 1);
-    opertionsCache[1].resize(_source.size() + 1);
+    QVector<SplitterType> sourceSplitters;
+    sourceSplitters.reserve(sourceSize);
+    for (auto item : _source) {
+        sourceSplitters.append(splitterType(item));
+    }
+    QVector<SplitterType> targetSplitters;
+    targetSplitters.reserve(targetSize);
+    for (auto item : _target) {
+        targetSplitters.append(splitterType(item));
+    }
+
+    //
+    // ... и сравниваем элементы между собой один раз, а не в каждой ячейке таблицы
+    //
+    const auto [sourceClasses, targetClasses] = equalityClasses(_source, _target);
+
+    //
+    // Две строки таблицы весов (текущая и предыдущая) и полная таблица направлений
+    //
+    QVector<QVector<Cell>> cells(2, QVector<Cell>(sourceSize + 1));
+    QVector<OperationType> operations((targetSize + 1) * (sourceSize + 1), OperationType::Skip);
+    auto operationAt = [&operations, sourceSize](int _i, int _j) -> OperationType& {
+        return operations[_i * (sourceSize + 1) + _j];
+    };
 
     //
     // Базовое состояние, когда вторая строка пуста - значит нужно просто удалить все символы
     //
-    for (int i = 1; i <= _source.size(); i++) {
-        auto operations = opertionsCache[0][i - 1];
-        operations.append(removeOperation(operations, _source[i - 1]));
-        opertionsCache[0][i] = operations;
+    for (int j = 1; j <= sourceSize; ++j) {
+        cells[0][j] = removeCell(cells[0][j - 1], sourceSplitters[j - 1]);
+        operationAt(0, j) = OperationType::Remove;
     }
 
     //
-    // Начинаем обсчитывать пути и заполнять кэш
+    // Начинаем обсчитывать пути и заполнять таблицу
     //
-    for (int i = 1; i <= _target.size(); i++) {
+    for (int i = 1; i <= targetSize; ++i) {
+        const auto& previousRow = cells[(i - 1) % 2];
+        auto& currentRow = cells[i % 2];
+
         //
-        // Сравниваем посимвольно вторую строку с первой
+        // Если первая строка пуста, значит нужно просто добавлять символы второй
         //
-        for (int j = 0; j <= _source.size(); j++) {
-            //
-            // Если первая строка пуста, значит нужно просто добавлять символы второй
-            //
-            if (j == 0) {
-                auto operations = opertionsCache[(i - 1) % 2][j];
-                operations.append(insertOperation(operations, _target[i - 1]));
-                opertionsCache[i % 2][j] = operations;
-            }
+        currentRow[0] = insertCell(previousRow[0], targetSplitters[i - 1]);
+        operationAt(i, 0) = OperationType::Insert;
+
+        for (int j = 1; j <= sourceSize; ++j) {
             //
-            // Если символы обеих строк равны, то берём минимальную из трёх операций
+            // Берём минимальную из трёх операций
             // 1. Вставка символа второй строки
             // 2. Удаление символа первой строки
-            // 3. Пропуск текущего символа
+            // 3. Пропуск текущего символа, если символы обеих строк равны, или замена символа
+            //    первой строки на символ второй, если они разные
             //
-            // NOTE: В базовой реализации, в этом кейсе просто используется операция пропуска
-            //       текущего символа, но нам она не подходит, из-за того, что у нас разные операции
-            //       имеют разные веса
+            // NOTE: В базовой реализации, при равенстве символов просто используется операция
+            //       пропуска текущего символа, но нам она не подходит, из-за того, что у нас
+            //       разные операции имеют разные веса
             //
-            else if (isItemsEqual(_source[j - 1], _target[i - 1])) {
-                auto operationsWithInsert = opertionsCache[(i - 1) % 2][j];
-                operationsWithInsert.append(insertOperation(operationsWithInsert, _target[i - 1]));
-                //
-                auto operationsWithRemove = opertionsCache[i % 2][j - 1];
-                operationsWithRemove.append(removeOperation(operationsWithRemove, _source[j - 1]));
-                //
-                auto operationsWithSkip = opertionsCache[(i - 1) % 2][j - 1];
-                operationsWithSkip.append(skipOperation(_target[i - 1]));
-                //
-                opertionsCache[i % 2][j] = minimumDistance(
-                    operationsWithInsert, operationsWithRemove, operationsWithSkip);
+            const auto withInsert = insertCell(previousRow[j], targetSplitters[i - 1]);
+            const auto withRemove = removeCell(currentRow[j - 1], sourceSplitters[j - 1]);
+            auto withSkipOrReplace = previousRow[j - 1];
+            OperationType skipOrReplace = OperationType::Skip;
+            if (sourceClasses[j - 1] != targetClasses[i - 1]) {
+                skipOrReplace = OperationType::Replace;
+                withSkipOrReplace.weight = addWeight(
+                    withSkipOrReplace.weight,
+                    replaceWeight(_source[j - 1], sourceSplitters[j - 1], _target[i - 1],
+                                  targetSplitters[i - 1]));
             }
+
             //
-            // Если символы разные, то берём минимальную из трёх операций
-            // 1. Вставка символа второй строки
-            // 2. Удаление символа первой строки
-            // 3. Замена символа первой строки на символ второй
+            // При равных весах предпочитаем вставку, затем удаление, затем пропуск или замену
             //
-            else {
-                auto operationsWithInsert = opertionsCache[(i - 1) % 2][j];
-                operationsWithInsert.append(insertOperation(operationsWithInsert, _target[i - 1]));
-                //
-                auto operationsWithRemove = opertionsCache[i % 2][j - 1];
-                operationsWithRemove.append(removeOperation(operationsWithRemove, _source[j - 1]));
-                //
-                auto operationsWithReplace = opertionsCache[(i - 1) % 2][j - 1];
-                operationsWithReplace.append(replaceOperation(_source[j - 1], _target[i - 1]));
-                //
-                opertionsCache[i % 2][j] = minimumDistance(
-                    operationsWithInsert, operationsWithRemove, operationsWithReplace);
+            if (withInsert.weight <= withRemove.weight
+                && withInsert.weight <= withSkipOrReplace.weight) {
+                currentRow[j] = withInsert;
+                operationAt(i, j) = OperationType::Insert;
+            } else if (withRemove.weight <= withSkipOrReplace.weight) {
+                currentRow[j] = withRemove;
+                operationAt(i, j) = OperationType::Remove;
+            } else {
+                currentRow[j] = withSkipOrReplace;
+                operationAt(i, j) = skipOrReplace;
             }
         }
     }
 
     //
-    // В итоге получим кратчайший и самый оптимальный набор операций для замены строк
+    // Восстанавливаем кратчайший и самый оптимальный набор операций для замены строк,
+    // проходя по направлениям от конца таблицы к её началу
     //
-    return opertionsCache[_target.size() % 2][_source.size()];
+    QVector<Operation<T>> result;
+    result.reserve(std::max(sourceSize, targetSize));
+    int i = targetSize;
+    int j = sourceSize;
+    while (i > 0 || j > 0) {
+        const auto operation = operationAt(i, j);
+        switch (operation) {
+        case OperationType::Insert: {
+            result.append({ operation, _target[i - 1] });
+            --i;
+            break;
+        }
+
+        case OperationType::Remove: {
+            result.append({ operation, _source[j - 1] });
+            --j;
+            break;
+        }
+
+        case OperationType::Skip:
+        case OperationType::Replace: {
+            result.append({ operation, _target[i - 1] });
+            --i;
+            --j;
+            break;
+        }
+        }
+    }
+    std::reverse(result.begin(), result.end());
+
+    return result;
 }
 
 } // namespace edit_distance
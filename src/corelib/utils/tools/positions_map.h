@@ -0,0 +1,480 @@
+#pragma once
+
+#include <QHash>
+#include <QVector>
+
+#include <iterator>
+
+
+/**
+ * @brief Упорядоченная карта позиций в документе на значения
+ *
+ * Позиции хранятся в сбалансированном дереве (декартовом) относительно позиции родительского
+ * узла, благодаря чему сдвиг всех позиций начиная с заданной выполняется за O(log n), а не
+ * перестройкой всех идущих после правки узлов. Позиция конкретного узла определяется суммой
+ * смещений на пути от него к корню дерева.
+ *
+ * @note Сдвиг позиций не должен менять их взаимный порядок
+ */
+template<typename T>
+class PositionsMap
+{
+    struct Node {
+        int offset = 0;
+        T value;
+        quint32 priority = 0;
+        Node* left = nullptr;
+        Node* right = nullptr;
+        Node* parent = nullptr;
+    };
+
+public:
+    /**
+     * @brief Итератор по элементам карты в порядке возрастания позиций
+     */
+    class iterator
+    {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using difference_type = std::ptrdiff_t;
+        using value_type = T;
+        using pointer = T*;
+        using reference = T&;
+
+        iterator() = default;
+
+        /**
+         * @brief Позиция элемента
+         * @note Вычисляется за O(log n)
+         */
+        int key() const
+        {
+            int key = 0;
+            for (auto node = m_node; node != nullptr; node = node->parent) {
+                key += node->offset;
+            }
+            return key;
+        }
+
+        T& value() const
+        {
+            return m_node->value;
+        }
+
+        T& operator*() const
+        {
+            return m_node->value;
+        }
+
+        iterator& operator++()
+        {
+            if (m_node->right != nullptr) {
+                m_node = m_node->right;
+                while (m_node->left != nullptr) {
+                    m_node = m_node->left;
+                }
+                return *this;
+            }
+
+            auto parent = m_node->parent;
+            while (parent != nullptr && parent->right == m_node) {
+                m_node = parent;
+                parent = parent->parent;
+            }
+            m_node = parent;
+            return *this;
+        }
+
+        iterator operator++(int)
+        {
+            auto iter = *this;
+            ++(*this);
+            return iter;
+        }
+
+        bool operator==(const iterator& _other) const
+        {
+            return m_node == _other.m_node;
+        }
+
+        bool operator!=(const iterator& _other) const
+        {
+            return m_node != _other.m_node;
+        }
+
+    private:
+        explicit iterator(Node* _node)
+            : m_node(_node)
+        {
+        }
+
+        Node* m_node = nullptr;
+
+        friend class PositionsMap;
+    };
+
+public:
+    PositionsMap() = default;
+    PositionsMap(const PositionsMap&) = delete;
+    PositionsMap& operator=(const PositionsMap&) = delete;
+    ~PositionsMap()
+    {
+        clear();
+    }
+
+    /**
+     * @brief Итераторы начала и конца карты
+     */
+    iterator begin() const
+    {
+        auto node = m_root;
+        while (node != nullptr && node->left != nullptr) {
+            node = node->left;
+        }
+        return iterator(node);
+    }
+    iterator end() const
+    {
+        return iterator();
+    }
+
+    /**
+     * @brief Пуста ли карта
+     */
+    bool isEmpty() const
+    {
+        return m_root == nullptr;
+    }
+
+    /**
+     * @brief Первый элемент с позицией не меньше заданной
+     */
+    iterator lowerBound(int _position) const
+    {
+        Node* result = nullptr;
+        int base = 0;
+        for (auto node = m_root; node != nullptr;) {
+            const int key = base + node->offset;
+            if (key >= _position) {
+                result = node;
+                base = key;
+                node = node->left;
+            } else {
+                base = key;
+                node = node->right;
+            }
+        }
+        return iterator(result);
+    }
+
+    /**
+     * @brief Элемент с заданной позицией
+     */
+    iterator find(int _position) const
+    {
+        const auto iter = lowerBound(_position);
+        if (iter == end() || iter.key() != _position) {
+            return end();
+        }
+        return iter;
+    }
+
+    /**
+     * @brief Значение для заданной позиции, или значение по умолчанию, если позиции нет в карте
+     */
+    T value(int _position) const
+    {
+        const auto iter = find(_position);
+        return iter == end() ? T() : iter.value();
+    }
+
+    /**
+     * @brief Наименьшая позиция заданного значения, или -1, если такого значения нет в карте
+     * @note Одно и то же значение может находиться сразу в нескольких позициях
+     */
+    int position(const T& _value) const
+    {
+        const auto nodes = m_nodes.constFind(_value);
+        if (nodes == m_nodes.constEnd()) {
+            return -1;
+        }
+
+        int position = -1;
+        for (auto node : nodes.value()) {
+            const int key = iterator(node).key();
+            if (position == -1 || key < position) {
+                position = key;
+            }
+        }
+        return position;
+    }
+
+    /**
+     * @brief Добавить значение в заданную позицию, если она ещё не занята
+     */
+    void insert(int _position, const T& _value)
+    {
+        insertNode(_position, _value, false);
+    }
+
+    /**
+     * @brief Добавить значение в заданную позицию, или заменить значение в ней
+     */
+    void insertOrAssign(int _position, const T& _value)
+    {
+        insertNode(_position, _value, true);
+    }
+
+    /**
+     * @brief Удалить элемент в заданной позиции
+     */
+    void remove(int _position)
+    {
+        const auto iter = find(_position);
+        if (iter != end()) {
+            erase(iter);
+        }
+    }
+
+    /**
+     * @brief Удалить элемент и вернуть итератор на следующий за ним
+     */
+    iterator erase(iterator _iter)
+    {
+        auto next = _iter;
+        ++next;
+        removeNode(_iter.m_node);
+        return next;
+    }
+
+    /**
+     * @brief Удалить элементы в диапазоне [_from, _to)
+     */
+    void erase(iterator _from, iterator _to)
+    {
+        while (_from != _to) {
+            _from = erase(_from);
+        }
+    }
+
+    /**
+     * @brief Сдвинуть на заданное расстояние позиции всех элементов начиная с заданной позиции
+     */
+    void shift(int _fromPosition, int _distance)
+    {
+        if (_distance == 0) {
+            return;
+        }
+
+        int base = 0;
+        for (auto node = m_root; node != nullptr;) {
+            const int key = base + node->offset;
+            if (key >= _fromPosition) {
+                //
+                // Сдвигаем узел вместе со всем поддеревом, но левое поддерево возвращаем на место,
+                // т.к. в нём могут быть позиции меньше заданной, и продолжаем разбираться с ним
+                //
+                node->offset += _distance;
+                if (node->left != nullptr) {
+                    node->left->offset -= _distance;
+                }
+                base = key + _distance;
+                node = node->left;
+            } else {
+                base = key;
+                node = node->right;
+            }
+        }
+    }
+
+    /**
+     * @brief Очистить карту
+     */
+    void clear()
+    {
+        deleteSubtree(m_root);
+        m_root = nullptr;
+        m_nodes.clear();
+    }
+
+private:
+    void insertNode(int _position, const T& _value, bool _assign)
+    {
+        Node* parent = nullptr;
+        int parentKey = 0;
+        int base = 0;
+        bool isLeft = false;
+        for (auto node = m_root; node != nullptr;) {
+            const int key = base + node->offset;
+            if (key == _position) {
+                if (_assign) {
+                    unindexNode(node);
+                    node->value = _value;
+                    m_nodes[_value].append(node);
+                }
+                return;
+            }
+
+            parent = node;
+            parentKey = key;
+            base = key;
+            isLeft = _position < key;
+            node = isLeft ? node->left : node->right;
+        }
+
+        auto node = new Node;
+        node->offset = _position - parentKey;
+        node->value = _value;
+        node->priority = nextPriority();
+        node->parent = parent;
+        if (parent == nullptr) {
+            m_root = node;
+        } else if (isLeft) {
+            parent->left = node;
+        } else {
+            parent->right = node;
+        }
+        m_nodes[_value].append(node);
+
+        //
+        // Поднимаем узел, пока не восстановится порядок приоритетов
+        //
+        while (node->parent != nullptr && node->parent->priority < node->priority) {
+            if (node->parent->left == node) {
+                rotateRight(node->parent);
+            } else {
+                rotateLeft(node->parent);
+            }
+        }
+    }
+
+    void removeNode(Node* _node)
+    {
+        //
+        // Опускаем узел, пока он не станет листом, после чего отсоединяем его
+        //
+        while (_node->left != nullptr || _node->right != nullptr) {
+            if (_node->right == nullptr
+                || (_node->left != nullptr && _node->left->priority > _node->right->priority)) {
+                rotateRight(_node);
+            } else {
+                rotateLeft(_node);
+            }
+        }
+
+        if (_node->parent == nullptr) {
+            m_root = nullptr;
+        } else if (_node->parent->left == _node) {
+            _node->parent->left = nullptr;
+        } else {
+            _node->parent->right = nullptr;
+        }
+
+        unindexNode(_node);
+        delete _node;
+    }
+
+    /**
+     * @brief Убрать узел из индекса значений
+     */
+    void unindexNode(Node* _node)
+    {
+        auto nodes = m_nodes.find(_node->value);
+        if (nodes == m_nodes.end()) {
+            return;
+        }
+
+        nodes->removeOne(_node);
+        if (nodes->isEmpty()) {
+            m_nodes.erase(nodes);
+        }
+    }
+
+    /**
+     * @brief Повороты дерева с сохранением абсолютных позиций узлов
+     */
+    void rotateRight(Node* _node)
+    {
+        auto left = _node->left;
+        const int leftOffset = left->offset;
+
+        replaceChild(_node, left);
+        left->offset += _node->offset;
+
+        _node->left = left->right;
+        if (_node->left != nullptr) {
+            _node->left->parent = _node;
+            _node->left->offset += leftOffset;
+        }
+
+        left->right = _node;
+        _node->parent = left;
+        _node->offset = -leftOffset;
+    }
+    void rotateLeft(Node* _node)
+    {
+        auto right = _node->right;
+        const int rightOffset = right->offset;
+
+        replaceChild(_node, right);
+        right->offset += _node->offset;
+
+        _node->right = right->left;
+        if (_node->right != nullptr) {
+            _node->right->parent = _node;
+            _node->right->offset += rightOffset;
+        }
+
+        right->left = _node;
+        _node->parent = right;
+        _node->offset = -rightOffset;
+    }
+
+    /**
+     * @brief Поставить узел _with на место узла _node в его родителе
+     */
+    void replaceChild(Node* _node, Node* _with)
+    {
+        _with->parent = _node->parent;
+        if (_node->parent == nullptr) {
+            m_root = _with;
+        } else if (_node->parent->left == _node) {
+            _node->parent->left = _with;
+        } else {
+            _node->parent->right = _with;
+        }
+    }
+
+    void deleteSubtree(Node* _node)
+    {
+        if (_node == nullptr) {
+            return;
+        }
+
+        deleteSubtree(_node->left);
+        deleteSubtree(_node->right);
+        delete _node;
+    }
+
+    quint32 nextPriority()
+    {
+        //
+        // xorshift32 - для приоритетов декартова дерева нам достаточно простого генератора
+        //
+        m_seed ^= m_seed << 13;
+        m_seed ^= m_seed >> 17;
+        m_seed ^= m_seed << 5;
+        return m_seed;
+    }
+
+private:
+    Node* m_root = nullptr;
+
+    /**
+     * @brief Индекс узлов по значениям для быстрого определения позиции значения
+     * @note Значение может встречаться в нескольких узлах, как правило же он один
+     */
+    QHash<T, QVector<Node*>> m_nodes;
+
+    quint32 m_seed = 2463534242;
+};
@@ -11,7 +11,7 @@ RunOnceLock::RunOnceLock(const QString& _key)
 
 RunOnceLock::~RunOnceLock()
 {
-    RunOnce::s_lockedKeys.remove(m_key);
+    RunOnce::lockedKeys().remove(m_key);
 }
 
 
@@ -20,13 +20,13 @@ const RunOnceLock RunOnce::tryRun(const QString& _key)
     if (isRunned(_key))
         return RunOnceLock();
 
-    s_lockedKeys.insert(_key);
+    lockedKeys().insert(_key);
     return RunOnceLock(_key);
 }
 
 bool RunOnce::isRunned(const QString& _key)
 {
-    return s_lockedKeys.contains(_key);
+    return lockedKeys().contains(_key);
 }
 
 bool RunOnce::canRun(const QString& _key)
@@ -34,4 +34,8 @@ bool RunOnce::canRun(const QString& _key)
     return !isRunned(_key);
 }
 
-QSet<QString> RunOnce::s_lockedKeys;
+QSet<QString>& RunOnce::lockedKeys()
+{
+    thread_local QSet<QString> keys;
+    return keys;
+}
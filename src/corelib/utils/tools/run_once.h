@@ -59,8 +59,10 @@ public:
 private:
     /**
      * @brief Ключи от заблокированных замков
+     * @note У каждого потока свой набор ключей, т.к. замок защищает от повторного входа, а
+     *       функции с ним могут одновременно выполняться в разных потоках
      */
-    static QSet<QString> s_lockedKeys;
+    static QSet<QString>& lockedKeys();
 
     /**
      * Дружим с классом RunOnceLock для доступа к списку ключей
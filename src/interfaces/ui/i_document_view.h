@@ -7,6 +7,10 @@ class QModelIndex;
 class QPixmap;
 class QWidget;
 
+namespace BusinessLayer {
+class SearchIndex;
+}
+
 namespace Domain {
 struct CursorInfo;
 }
@@ -87,6 +91,13 @@ public:
     {
     }
 
+    /**
+     * @brief Задать индекс для поиска по тексту документов проекта
+     */
+    virtual void setSearchIndex(BusinessLayer::SearchIndex* _index)
+    {
+    }
+
     /**
      * @brief Задать сгенерированный текст
      */